@@ -0,0 +1,388 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <chrono>
+#include <stdexcept>
+
+#include "calculators/cuda/hdr/framework/CUDA/error.h"
+
+#include "EdgeDetector.h"
+#include "calculators/cuda/edge/edge_pipeline_cpu.h"
+
+namespace {
+std::size_t align_up(std::size_t size, std::size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+// device row pitch of the BGR frames
+std::size_t frame_pitch(unsigned int width) {
+  return align_up(std::size_t{width} * 3, 128);
+}
+
+// byte offsets of the device buffers, zero sized buffers are absent
+struct DeviceBuffers {
+  std::size_t frame, result, gray, gauss, gradient, theta, magnitude,
+      direction, state, changed, size;
+
+  DeviceBuffers(unsigned int width, unsigned int height, EdgeMode mode) {
+    const std::size_t pixels = std::size_t{width} * height;
+    const bool staged = mode == EdgeMode::staged;
+    size = 0;
+    auto add = [this](std::size_t bytes) {
+      const std::size_t at = size;
+      size += align_up(bytes, 256);
+      return at;
+    };
+    frame = add(frame_pitch(width) * height);
+    result = add(frame_pitch(width) * height);
+    gray = add(staged ? pixels * sizeof(double) : 0);
+    gauss = add(staged ? pixels * sizeof(double) : 0);
+    gradient = add(staged ? pixels * sizeof(double) : 0);
+    theta = add(staged ? pixels * sizeof(double) : 0);
+    magnitude = add(staged ? 0 : pixels * sizeof(std::uint16_t));
+    direction = add(staged ? 0 : pixels);
+    state = add(staged ? 0 : pixels);
+    changed = add(staged ? 0 : sizeof(int));
+  }
+};
+
+// whether the kernels can access ptr in place, host memory unknown to CUDA
+// is an error before CUDA 11
+bool device_accessible(const void *ptr) {
+  cudaPointerAttributes attributes;
+  if (cudaPointerGetAttributes(&attributes, ptr) != cudaSuccess) {
+    cudaGetLastError();
+    return false;
+  }
+  return attributes.type == cudaMemoryTypeDevice ||
+         attributes.type == cudaMemoryTypeManaged;
+}
+
+float elapsed_ms(std::chrono::steady_clock::time_point &since) {
+  const auto now = std::chrono::steady_clock::now();
+  const float ms =
+      std::chrono::duration<float, std::milli>(now - since).count();
+  since = now;
+  return ms;
+}
+} // namespace
+
+void check_edge_settings(const EdgeSettings &settings) {
+  if (settings.threshold_lo < 0 || settings.threshold_hi > 255 ||
+      settings.threshold_lo > settings.threshold_hi)
+    throw std::invalid_argument(
+        "the thresholds must satisfy 0 <= low <= high <= 255");
+  if (settings.block_size < 32 || settings.block_size > 1024)
+    throw std::invalid_argument(
+        "the block size must be between 32 and 1024");
+}
+
+namespace {
+void check_mode(EdgeMode mode, const EdgeSettings &settings) {
+  if (mode != EdgeMode::staged)
+    return;
+  if (settings.thresholding == EdgeThresholding::hysteresis)
+    throw std::invalid_argument(
+        "hysteresis thresholding needs the fused mode");
+  if (settings.input != EdgeInput::bgr ||
+      settings.output != EdgeOutput::bgr)
+    throw std::invalid_argument("the staged mode only supports BGR frames");
+}
+} // namespace
+
+EdgeDetector::EdgeDetector(unsigned int width, unsigned int height,
+                           EdgeBackend backend, EdgeMode mode,
+                           cudaStream_t stream, const EdgeSettings &settings)
+    : width(width), height(height), backend(backend), mode(mode),
+      settings(settings), stream(stream) {
+  check_edge_settings(settings);
+  check_mode(mode, settings);
+  layoutBuffers();
+  if (backend == EdgeBackend::cuda) {
+    for (cudaEvent_t &event : events)
+      throw_error(cudaEventCreate(&event));
+  }
+}
+
+EdgeDetector::EdgeDetector(unsigned int width, unsigned int height,
+                           cudaStream_t stream, EdgeMode mode,
+                           const EdgeSettings &settings)
+    : EdgeDetector(width, height, EdgeBackend::cuda, mode, stream, settings) {}
+
+EdgeDetector::EdgeDetector(unsigned int width, unsigned int height,
+                           EdgeBackend backend, EdgeMode mode,
+                           const EdgeSettings &settings)
+    : EdgeDetector(width, height, backend, mode, 0, settings) {}
+
+EdgeDetector::~EdgeDetector() {
+  if (backend == EdgeBackend::cuda) {
+    cudaStreamSynchronize(stream);
+    for (cudaEvent_t event : events)
+      if (event)
+        cudaEventDestroy(event);
+  }
+}
+
+void EdgeDetector::layoutBuffers() {
+  if (backend == EdgeBackend::cpu) {
+    // resize() keeps the capacity when shrinking
+    if (mode == EdgeMode::staged) {
+      h_gray.resize(pixels());
+      h_gauss.resize(pixels());
+      h_gradient.resize(pixels());
+      h_theta.resize(pixels());
+    } else {
+      h_magnitude.resize(pixels());
+      h_direction.resize(pixels());
+      // atomics can't be moved, the states are replaced if they don't fit
+      if (h_state.size() < pixels())
+        h_state = std::vector<std::atomic<unsigned char>>(pixels());
+    }
+    return;
+  }
+
+  const DeviceBuffers at(width, height, mode);
+  if (at.size > d_capacity) {
+    void *ptr = nullptr;
+    d_memory.reset();
+    d_capacity = 0;
+    throw_error(cudaMalloc(&ptr, at.size));
+    d_memory.reset(ptr);
+    d_capacity = at.size;
+  }
+
+  const bool staged = mode == EdgeMode::staged;
+  unsigned char *base = static_cast<unsigned char *>(d_memory.get());
+  auto image = [&](std::size_t offset, bool used) {
+    return used ? base + offset : nullptr;
+  };
+  d_frame_pitch = frame_pitch(width);
+  d_frame = base + at.frame;
+  d_result = base + at.result;
+  d_gray = reinterpret_cast<double *>(image(at.gray, staged));
+  d_gauss = reinterpret_cast<double *>(image(at.gauss, staged));
+  d_gradient = reinterpret_cast<double *>(image(at.gradient, staged));
+  d_theta = reinterpret_cast<double *>(image(at.theta, staged));
+  d_magnitude =
+      reinterpret_cast<std::uint16_t *>(image(at.magnitude, !staged));
+  d_direction = image(at.direction, !staged);
+  d_state = image(at.state, !staged);
+  d_changed = reinterpret_cast<int *>(image(at.changed, !staged));
+}
+
+void EdgeDetector::configure(const EdgeSettings &settings) {
+  check_edge_settings(settings);
+  check_mode(mode, settings);
+  this->settings = settings;
+}
+
+void EdgeDetector::reconfigure(unsigned int width, unsigned int height) {
+  if (backend == EdgeBackend::cuda)
+    throw_error(cudaStreamSynchronize(stream));
+  this->width = width;
+  this->height = height;
+  layoutBuffers();
+}
+
+void EdgeDetector::process(const std::uint8_t *frame, std::size_t pitch,
+                           std::uint8_t *out, std::size_t out_pitch) {
+  if (pitch < input_pixel_size(settings.input) * width ||
+      out_pitch < output_row_size(settings.output, width))
+    throw std::invalid_argument("the row pitch is smaller than a row");
+  if (pixels() == 0)
+    return;
+
+  if (backend == EdgeBackend::cuda)
+    processCUDA(frame, pitch, out, out_pitch);
+  else
+    processCPU(frame, pitch, out, out_pitch);
+}
+
+void EdgeDetector::processCUDA(const std::uint8_t *frame, std::size_t pitch,
+                               std::uint8_t *out, std::size_t out_pitch) {
+  void edge_grayscale(double *gray, const unsigned char *bgr,
+                      std::size_t pitch, unsigned int width,
+                      unsigned int height, unsigned int block_size,
+                      cudaStream_t stream);
+  void edge_gauss(double *gauss, const double *gray, unsigned int width,
+                  unsigned int height, unsigned int block_size,
+                  cudaStream_t stream);
+  void edge_sobel(double *gradient, double *theta, const double *gauss,
+                  unsigned int width, unsigned int height,
+                  unsigned int block_size, cudaStream_t stream);
+  void edge_threshold(unsigned char *out, std::size_t pitch,
+                      const double *gradient, const double *theta,
+                      unsigned int width, unsigned int height,
+                      int threshold_lo, int threshold_hi,
+                      unsigned int block_size, cudaStream_t stream);
+  void edge_gradient(std::uint16_t *magnitude, unsigned char *direction,
+                     const unsigned char *frame, std::size_t pitch,
+                     EdgeInput input, unsigned int width, unsigned int height,
+                     cudaStream_t stream);
+  void edge_threshold(unsigned char *out, std::size_t pitch,
+                      EdgeOutput output, const std::uint16_t *magnitude,
+                      const unsigned char *direction, unsigned int width,
+                      unsigned int height, int threshold_lo, int threshold_hi,
+                      unsigned int block_size, cudaStream_t stream);
+  void edge_suppress(unsigned char *state, const std::uint16_t *magnitude,
+                     const unsigned char *direction, unsigned int width,
+                     unsigned int height, int threshold_lo, int threshold_hi,
+                     unsigned int block_size, cudaStream_t stream);
+  void edge_hysteresis_pass(unsigned char *state, int *changed,
+                            unsigned int width, unsigned int height,
+                            cudaStream_t stream);
+  void edge_map(unsigned char *out, std::size_t pitch, EdgeOutput output,
+                const unsigned char *state, unsigned int width,
+                unsigned int height, unsigned int block_size,
+                cudaStream_t stream);
+
+  const unsigned int block = settings.block_size;
+  const int lo = settings.threshold_lo;
+  const int hi = settings.threshold_hi;
+
+  // every stage ends with the next event, its time is measured from the
+  // event before
+  last_timings = EdgeTimings();
+  float *stages[6];
+  int count = 0;
+  auto stage = [&](float &ms) {
+    stages[count] = &ms;
+    throw_error(cudaEventRecord(events[++count], stream));
+  };
+
+  // device memory is read and written in place, host memory goes through
+  // the frame and result buffers
+  const unsigned char *d_input = frame;
+  std::size_t input_pitch = pitch;
+  unsigned char *d_output = out;
+  std::size_t output_pitch = out_pitch;
+  const bool upload = !device_accessible(frame);
+  const bool download = !device_accessible(out);
+  if (upload) {
+    d_input = d_frame;
+    input_pitch = d_frame_pitch;
+  }
+  if (download) {
+    d_output = d_result;
+    output_pitch = d_frame_pitch;
+  }
+
+  throw_error(cudaEventRecord(events[0], stream));
+  if (upload)
+    throw_error(cudaMemcpy2DAsync(
+        d_frame, d_frame_pitch, frame, pitch,
+        input_pixel_size(settings.input) * width, height, cudaMemcpyDefault,
+        stream));
+  stage(last_timings.upload);
+  if (mode == EdgeMode::staged) {
+    edge_grayscale(d_gray, d_input, input_pitch, width, height, block,
+                   stream);
+    stage(last_timings.grayscale);
+    edge_gauss(d_gauss, d_gray, width, height, block, stream);
+    stage(last_timings.gauss);
+    edge_sobel(d_gradient, d_theta, d_gauss, width, height, block, stream);
+    stage(last_timings.sobel);
+    edge_threshold(d_output, output_pitch, d_gradient, d_theta, width,
+                   height, lo, hi, block, stream);
+    stage(last_timings.threshold);
+  } else {
+    edge_gradient(d_magnitude, d_direction, d_input, input_pitch,
+                  settings.input, width, height, stream);
+    stage(last_timings.gradient);
+    if (settings.thresholding == EdgeThresholding::hysteresis) {
+      edge_suppress(d_state, d_magnitude, d_direction, width, height, lo, hi,
+                    block, stream);
+      stage(last_timings.suppression);
+      // every pass grows the edges through whole tiles, the host waits for
+      // the flag of a pass before it decides on the next. a pass that
+      // changes something promotes a pixel, so the passes end once the
+      // edges are complete.
+      do {
+        throw_error(cudaMemsetAsync(d_changed, 0, sizeof(int), stream));
+        edge_hysteresis_pass(d_state, d_changed, width, height, stream);
+        throw_error(cudaMemcpyAsync(&h_changed, d_changed, sizeof(int),
+                                    cudaMemcpyDeviceToHost, stream));
+        throw_error(cudaStreamSynchronize(stream));
+        ++last_timings.hysteresis_passes;
+      } while (h_changed);
+      stage(last_timings.hysteresis);
+      edge_map(d_output, output_pitch, settings.output, d_state, width,
+               height, block, stream);
+    } else {
+      edge_threshold(d_output, output_pitch, settings.output, d_magnitude,
+                     d_direction, width, height, lo, hi, block, stream);
+    }
+    stage(last_timings.threshold);
+  }
+  if (download)
+    throw_error(cudaMemcpy2DAsync(
+        out, out_pitch, d_result, d_frame_pitch,
+        output_row_size(settings.output, width), height, cudaMemcpyDefault,
+        stream));
+  stage(last_timings.download);
+  throw_error(cudaEventSynchronize(events[count]));
+
+  for (int i = 0; i < count; ++i)
+    throw_error(cudaEventElapsedTime(stages[i], events[i], events[i + 1]));
+}
+
+void EdgeDetector::processCPU(const std::uint8_t *frame, std::size_t pitch,
+                              std::uint8_t *out, std::size_t out_pitch) {
+  const int lo = settings.threshold_lo;
+  const int hi = settings.threshold_hi;
+  last_timings = EdgeTimings();
+  auto t = std::chrono::steady_clock::now();
+  if (mode == EdgeMode::staged) {
+    cpu::edge_grayscale(h_gray.data(), frame, pitch, width, height);
+    last_timings.grayscale = elapsed_ms(t);
+    cpu::edge_gauss(h_gauss.data(), h_gray.data(), width, height);
+    last_timings.gauss = elapsed_ms(t);
+    cpu::edge_sobel(h_gradient.data(), h_theta.data(), h_gauss.data(), width,
+                    height);
+    last_timings.sobel = elapsed_ms(t);
+    cpu::edge_threshold(out, out_pitch, h_gradient.data(), h_theta.data(),
+                        width, height, lo, hi);
+    last_timings.threshold = elapsed_ms(t);
+  } else {
+    cpu::edge_gradient(h_magnitude.data(), h_direction.data(), frame, pitch,
+                       settings.input, width, height);
+    last_timings.gradient = elapsed_ms(t);
+    if (settings.thresholding == EdgeThresholding::hysteresis) {
+      cpu::edge_suppress(h_state.data(), h_magnitude.data(),
+                         h_direction.data(), width, height, lo, hi);
+      last_timings.suppression = elapsed_ms(t);
+      const cpu::HysteresisCounters counters =
+          cpu::edge_hysteresis(h_state.data(), width, height);
+      last_timings.hysteresis_passes =
+          static_cast<unsigned int>(counters.levels);
+      last_timings.hysteresis_steals = counters.steals;
+      last_timings.hysteresis = elapsed_ms(t);
+      cpu::edge_map(out, out_pitch, settings.output, h_state.data(), width,
+                    height);
+    } else {
+      cpu::edge_threshold(out, out_pitch, settings.output, h_magnitude.data(),
+                          h_direction.data(), width, height, lo, hi);
+    }
+    last_timings.threshold = elapsed_ms(t);
+  }
+}
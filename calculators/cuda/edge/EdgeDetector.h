@@ -0,0 +1,207 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef INCLUDED_EDGEDETECTOR
+#define INCLUDED_EDGEDETECTOR
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <cuda_runtime_api.h>
+
+#include "calculators/cuda/edge/edge_format.h"
+
+enum class EdgeBackend { cuda, cpu };
+
+// staged runs the grayscale, gaussian, sobel and threshold stages one by one
+// on full frames of doubles, the reference for fused. fused computes the
+// gradient of tiles in one pass in integer and float arithmetic and keeps
+// only a u16 magnitude and a u8 direction per pixel, see edge_gradient.h.
+enum class EdgeMode { staged, fused };
+
+// neighbour keeps a pixel between the thresholds if a direct neighbour is
+// above threshold_hi. hysteresis is the Canny edge detector: non-maximum
+// suppression along the gradient, then every pixel above threshold_lo that
+// is connected to one above threshold_hi through such pixels is an edge.
+enum class EdgeThresholding { neighbour, hysteresis };
+
+// thresholds on the gradient magnitude between no edge and edge, the
+// threads per block of the CUDA kernels and the thresholding. both backends
+// follow the chains of hysteresis to their ends and give the same edges.
+// input and output are the formats of the frames and edge maps of
+// process().
+struct EdgeSettings {
+  int threshold_lo = 50;
+  int threshold_hi = 100;
+  unsigned int block_size = 256;
+  EdgeThresholding thresholding = EdgeThresholding::neighbour;
+  EdgeInput input = EdgeInput::bgr;
+  EdgeOutput output = EdgeOutput::bgr;
+};
+
+// throws std::invalid_argument unless 0 <= threshold_lo <= threshold_hi <=
+// 255 and 32 <= block_size <= 1024
+void check_edge_settings(const EdgeSettings &settings);
+
+// milliseconds spent in the stages of the last process() call. the copies
+// are 0 on the CPU backend and for device memory, gradient is the fused
+// front end and 0 in staged mode, grayscale, gauss and sobel are 0 in fused
+// mode. suppression and hysteresis are only spent with
+// EdgeThresholding::hysteresis, threshold is then the conversion to the
+// output. hysteresis_passes counts the passes of the CUDA backend over the
+// image or the frontiers of the search on the CPU, and hysteresis_steals the
+// work the CPU threads took from each other.
+struct EdgeTimings {
+  float upload = 0.0f;
+  float grayscale = 0.0f;
+  float gauss = 0.0f;
+  float sobel = 0.0f;
+  float gradient = 0.0f;
+  float suppression = 0.0f;
+  float hysteresis = 0.0f;
+  float threshold = 0.0f;
+  float download = 0.0f;
+  unsigned int hysteresis_passes = 0;
+  std::size_t hysteresis_steals = 0;
+
+  float kernels() const {
+    return grayscale + gauss + sobel + gradient + suppression + hysteresis +
+           threshold;
+  }
+  float total() const { return upload + kernels() + download; }
+};
+
+// edge detection of frames of a fixed size: grayscale, 5x5 gaussian, sobel
+// gradient and thresholding. hysteresis thresholding, luma input and the
+// compact edge maps need EdgeMode::fused. the working set is allocated
+// once when the detector is created or resized, so process() on a stream of
+// frames only copies and computes. a detector keeps no state outside of
+// itself, separate instances may be used from different threads.
+class EdgeDetector {
+  struct cudaFreeDeleter {
+    void operator()(void *ptr) const { cudaFree(ptr); }
+  };
+
+  unsigned int width;
+  unsigned int height;
+
+  const EdgeBackend backend;
+  const EdgeMode mode;
+  EdgeSettings settings;
+  cudaStream_t stream = 0;
+  EdgeTimings last_timings;
+
+  // CUDA backend: one block of device memory with the frame, the result and
+  // the intermediate images of the mode, grown only if a resize needs more.
+  // stage boundaries are recorded on the events, which live as long as the
+  // detector. the images of the other mode are null.
+  std::unique_ptr<void, cudaFreeDeleter> d_memory;
+  std::size_t d_capacity = 0;
+  unsigned char *d_frame = nullptr;
+  unsigned char *d_result = nullptr;
+  std::size_t d_frame_pitch = 0;
+  double *d_gray = nullptr;
+  double *d_gauss = nullptr;
+  double *d_gradient = nullptr;
+  double *d_theta = nullptr;
+  std::uint16_t *d_magnitude = nullptr;
+  unsigned char *d_direction = nullptr;
+  unsigned char *d_state = nullptr;
+  int *d_changed = nullptr;
+  int h_changed = 0;
+  cudaEvent_t events[7] = {};
+
+  // CPU backend: the intermediate images of the mode
+  std::vector<double> h_gray;
+  std::vector<double> h_gauss;
+  std::vector<double> h_gradient;
+  std::vector<double> h_theta;
+  std::vector<std::uint16_t> h_magnitude;
+  std::vector<unsigned char> h_direction;
+  std::vector<std::atomic<unsigned char>> h_state;
+
+  EdgeDetector(unsigned int width, unsigned int height, EdgeBackend backend,
+               EdgeMode mode, cudaStream_t stream,
+               const EdgeSettings &settings);
+
+  std::size_t pixels() const { return std::size_t{width} * height; }
+  // places the buffers for the current size, allocating only if they no
+  // longer fit
+  void layoutBuffers();
+  void processCUDA(const std::uint8_t *frame, std::size_t pitch,
+                   std::uint8_t *out, std::size_t out_pitch);
+  void processCPU(const std::uint8_t *frame, std::size_t pitch,
+                  std::uint8_t *out, std::size_t out_pitch);
+
+public:
+  // CUDA backend, all work is enqueued on the given stream
+  EdgeDetector(unsigned int width, unsigned int height,
+               cudaStream_t stream = 0, EdgeMode mode = EdgeMode::fused,
+               const EdgeSettings &settings = EdgeSettings());
+  // CPU backend, the stages are spread over ThreadPool::shared()
+  EdgeDetector(unsigned int width, unsigned int height, EdgeBackend backend,
+               EdgeMode mode = EdgeMode::fused,
+               const EdgeSettings &settings = EdgeSettings());
+  ~EdgeDetector();
+
+  EdgeDetector(const EdgeDetector &) = delete;
+  EdgeDetector &operator=(const EdgeDetector &) = delete;
+
+  unsigned int getWidth() const { return width; }
+  unsigned int getHeight() const { return height; }
+  EdgeBackend getBackend() const { return backend; }
+  EdgeMode getMode() const { return mode; }
+
+  // settings of the frames processed from now on, throws
+  // std::invalid_argument for unsupported values, see check_edge_settings(),
+  // and for the fused only features in staged mode
+  void configure(const EdgeSettings &settings);
+  const EdgeSettings &getSettings() const { return settings; }
+
+  // changes the frame size. the buffers are only reallocated if they no
+  // longer fit.
+  void reconfigure(unsigned int width, unsigned int height);
+
+  // detects the edges of frame with rows of pitch bytes and writes them to
+  // out, rows of out_pitch bytes, in the formats of the settings. the
+  // padding of the rows is left alone. on the CUDA backend frame and out may
+  // be host or device memory, device memory is read and written in place.
+  // returns once out is written.
+  void process(const std::uint8_t *frame, std::size_t pitch,
+               std::uint8_t *out, std::size_t out_pitch);
+  // same with rows of equal pitch in and out
+  void process(const std::uint8_t *frame, std::size_t pitch,
+               std::uint8_t *out) {
+    process(frame, pitch, out, pitch);
+  }
+
+  // stage timings of the last process()
+  const EdgeTimings &timings() const { return last_timings; }
+};
+
+#endif // INCLUDED_EDGEDETECTOR
@@ -0,0 +1,231 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// kernel timings and memory traffic of the staged and the fused edge
+// detection and of the fused one with hysteresis thresholding on a synthetic
+// frame, on the CPU backend or with --cuda on the device
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <cuda_runtime_api.h>
+
+#include "calculators/cuda/hdr/framework/CUDA/error.h"
+#include "calculators/cuda/hdr/framework/cmd_args.h"
+
+#include "calculators/cuda/edge/EdgeDetector.h"
+
+namespace {
+// bytes every stage has to read and write per pixel at least, neighbours
+// being served by the caches. staged: the BGR frame in, the gray doubles
+// out and back in, the gaussian doubles out and back in, gradient and angle
+// doubles out and back in, the BGR result out. fused: the BGR frame in,
+// magnitude and direction out and back in, the BGR result out. hysteresis:
+// the fused front end, the states out, through one pass of the hysteresis
+// and back in.
+constexpr std::size_t staged_bytes_per_pixel =
+    (3 + 8) + (8 + 8) + (8 + 2 * 8) + (2 * 8 + 3);
+constexpr std::size_t fused_bytes_per_pixel = (3 + 2 + 1) + (2 + 1 + 3);
+constexpr std::size_t hysteresis_bytes_per_pixel =
+    (3 + 2 + 1) + (2 + 1 + 1) + (1 + 1) + (1 + 3);
+
+// average stage timings of runs frames, after an untimed one warming up the
+// caches, the thread pool and the device
+EdgeTimings benchmark(EdgeDetector &detector,
+                      const std::vector<std::uint8_t> &frame,
+                      std::vector<std::uint8_t> &edges, std::size_t pitch,
+                      int runs) {
+  detector.process(frame.data(), pitch, edges.data());
+
+  EdgeTimings sum;
+  for (int i = 0; i < runs; ++i) {
+    detector.process(frame.data(), pitch, edges.data());
+    const EdgeTimings &t = detector.timings();
+    sum.upload += t.upload;
+    sum.grayscale += t.grayscale;
+    sum.gauss += t.gauss;
+    sum.sobel += t.sobel;
+    sum.gradient += t.gradient;
+    sum.suppression += t.suppression;
+    sum.hysteresis += t.hysteresis;
+    sum.threshold += t.threshold;
+    sum.download += t.download;
+    sum.hysteresis_passes += t.hysteresis_passes;
+    sum.hysteresis_steals += t.hysteresis_steals;
+  }
+
+  for (float *t : {&sum.upload, &sum.grayscale, &sum.gauss, &sum.sobel,
+                   &sum.gradient, &sum.suppression, &sum.hysteresis,
+                   &sum.threshold, &sum.download})
+    *t /= runs;
+  sum.hysteresis_passes /= runs;
+  sum.hysteresis_steals /= runs;
+  return sum;
+}
+
+void report(const EdgeTimings &staged, const EdgeTimings &fused,
+            const EdgeTimings &hysteresis, std::size_t pixels) {
+  auto row = [](const char *name, float a, float b, float c) {
+    std::cout << std::left << std::setw(16) << name << std::right
+              << std::setw(10) << a << " ms" << std::setw(10) << b << " ms"
+              << std::setw(10) << c << " ms\n";
+  };
+  auto bandwidth = [pixels](std::size_t bytes_per_pixel, float ms) {
+    return bytes_per_pixel * pixels / (ms * 1.0e6);
+  };
+  auto traffic = [&](std::size_t bytes_per_pixel, const EdgeTimings &t) {
+    std::cout << std::setw(8) << bandwidth(bytes_per_pixel, t.kernels())
+              << " GB/s";
+  };
+
+  std::cout << "stage               staged         fused    hysteresis\n";
+  row("upload", staged.upload, fused.upload, hysteresis.upload);
+  row("grayscale", staged.grayscale, fused.grayscale, hysteresis.grayscale);
+  row("gauss", staged.gauss, fused.gauss, hysteresis.gauss);
+  row("sobel", staged.sobel, fused.sobel, hysteresis.sobel);
+  row("gradient", staged.gradient, fused.gradient, hysteresis.gradient);
+  row("suppression", staged.suppression, fused.suppression,
+      hysteresis.suppression);
+  row("hysteresis", staged.hysteresis, fused.hysteresis,
+      hysteresis.hysteresis);
+  row("threshold", staged.threshold, fused.threshold, hysteresis.threshold);
+  row("download", staged.download, fused.download, hysteresis.download);
+  row("kernels", staged.kernels(), fused.kernels(), hysteresis.kernels());
+  std::cout << std::left << std::setw(16) << "bytes/pixel" << std::right
+            << std::setw(13) << staged_bytes_per_pixel << std::setw(13)
+            << fused_bytes_per_pixel << std::setw(13)
+            << hysteresis_bytes_per_pixel << "\n"
+            << std::left << std::setw(16) << "kernel traffic" << std::right;
+  traffic(staged_bytes_per_pixel, staged);
+  traffic(fused_bytes_per_pixel, fused);
+  traffic(hysteresis_bytes_per_pixel, hysteresis);
+  std::cout << "\n"
+            << std::left << std::setw(16) << "speedup" << std::right
+            << std::setw(26) << staged.kernels() / fused.kernels() << "x"
+            << std::setw(12) << staged.kernels() / hysteresis.kernels()
+            << "x\n"
+            << std::left << std::setw(16) << "hysteresis" << std::right
+            << std::setw(39) << hysteresis.hysteresis_passes << " passes, "
+            << hysteresis.hysteresis_steals << " steals\n";
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  try {
+    int image_width = 3840;
+    int image_height = 2160;
+    int runs = 10;
+    bool cuda = false;
+    int cuda_device = 0;
+
+    for (char **a = &argv[1]; *a; ++a) {
+      if (!checkArgument("--width", a, image_width))
+        if (!checkArgument("--height", a, image_height))
+          if (!checkArgument("--runs", a, runs))
+            if (!checkArgument("--cuda", a, cuda))
+              if (!checkArgument("--device", a, cuda_device))
+                throw usage_error("unknown argument");
+    }
+
+    if (image_width < 1 || image_height < 1 || runs < 1)
+      throw usage_error("width, height and runs must be positive");
+
+    const auto width = static_cast<unsigned int>(image_width);
+    const auto height = static_cast<unsigned int>(image_height);
+    const std::size_t pixels = std::size_t{width} * height;
+    const std::size_t pitch = std::size_t{width} * 3;
+
+    // diagonal stripes with some noise, so that all thresholding branches
+    // are taken
+    std::vector<std::uint8_t> frame(pitch * height);
+    std::uint32_t noise = 1;
+    for (std::size_t y = 0; y < height; ++y) {
+      for (std::size_t x = 0; x < pitch; ++x) {
+        noise = noise * 1664525U + 1013904223U;
+        const bool stripe = (x / 3 / 7 + y / 5) % 3 == 0;
+        frame[y * pitch + x] =
+            static_cast<std::uint8_t>((stripe ? 200 : 30) + (noise >> 27));
+      }
+    }
+    std::vector<std::uint8_t> edges(frame.size());
+
+    EdgeSettings canny;
+    canny.thresholding = EdgeThresholding::hysteresis;
+
+    EdgeTimings staged;
+    EdgeTimings fused;
+    EdgeTimings hysteresis;
+    if (cuda) {
+      throw_error(cudaSetDevice(cuda_device));
+      cudaStream_t stream;
+      throw_error(cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking));
+      {
+        EdgeDetector a(width, height, stream, EdgeMode::staged);
+        EdgeDetector b(width, height, stream, EdgeMode::fused);
+        EdgeDetector c(width, height, stream, EdgeMode::fused, canny);
+        staged = benchmark(a, frame, edges, pitch, runs);
+        fused = benchmark(b, frame, edges, pitch, runs);
+        hysteresis = benchmark(c, frame, edges, pitch, runs);
+      }
+      throw_error(cudaStreamDestroy(stream));
+    } else {
+      EdgeDetector a(width, height, EdgeBackend::cpu, EdgeMode::staged);
+      EdgeDetector b(width, height, EdgeBackend::cpu, EdgeMode::fused);
+      EdgeDetector c(width, height, EdgeBackend::cpu, EdgeMode::fused,
+                     canny);
+      staged = benchmark(a, frame, edges, pitch, runs);
+      fused = benchmark(b, frame, edges, pitch, runs);
+      hysteresis = benchmark(c, frame, edges, pitch, runs);
+    }
+
+    std::cout << (cuda ? "cuda" : "cpu") << " backend, " << width << "x"
+              << height << ", " << runs << " runs\n"
+              << std::fixed << std::setprecision(2);
+    report(staged, fused, hysteresis, pixels);
+  } catch (const usage_error &e) {
+    std::cout << "error: " << e.what() << std::endl;
+    std::cout << "usage: edge_benchmark {options}\n"
+                 "\toptions:\n"
+                 "\t  --width <w>            image width, default: 3840\n"
+                 "\t  --height <h>           image height, default: 2160\n"
+                 "\t  --runs <N>             average over <N> runs, "
+                 "default: 10\n"
+                 "\t  --cuda                 run on the device instead of the "
+                 "cpu\n"
+                 "\t  --device <i>           use cuda device <i>, default: 0\n";
+    return -127;
+  } catch (std::exception &e) {
+    std::cout << "error: " << e.what() << std::endl;
+    return -1;
+  } catch (...) {
+    std::cout << "unknown exception" << std::endl;
+    return -128;
+  }
+
+  return 0;
+}
@@ -0,0 +1,54 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef INCLUDED_EDGE_FORMAT
+#define INCLUDED_EDGE_FORMAT
+
+#pragma once
+
+#include <cstddef>
+
+// the frames of EdgeDetector. bgr is 24 bit BGR. luma is one byte per
+// pixel, the Y plane of NV12 and I420 frames, which both start with it.
+// it is read in place without any conversion, a luma value counts as much
+// as the average of B, G and R.
+enum class EdgeInput { bgr, luma };
+
+// the edge maps of EdgeDetector. bgr has 3 equal bytes and gray one byte
+// per pixel, 0 on an edge and 255 elsewhere. bits packs 8 pixels into a
+// byte, the most significant bit first, set on an edge. the rows of bits
+// are those of a PBM (P4) image.
+enum class EdgeOutput { bgr, gray, bits };
+
+constexpr std::size_t input_pixel_size(EdgeInput input) {
+  return input == EdgeInput::bgr ? 3 : 1;
+}
+
+// bytes of a row of width pixels without padding
+constexpr std::size_t output_row_size(EdgeOutput output, std::size_t width) {
+  return output == EdgeOutput::bgr    ? 3 * width
+         : output == EdgeOutput::gray ? width
+                                      : (width + 7) / 8;
+}
+
+#endif // INCLUDED_EDGE_FORMAT
@@ -0,0 +1,187 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef INCLUDED_EDGE_GRADIENT
+#define INCLUDED_EDGE_GRADIENT
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "calculators/cuda/edge/edge_format.h"
+
+// the fused front end below is compiled into the CUDA kernel as well as into
+// the host loops
+#if defined(__CUDACC__)
+#define EDGE_HOST_DEVICE __host__ __device__
+#else
+#define EDGE_HOST_DEVICE
+#endif
+
+// the fused front end works in integers: a gray value is B + G + R and the
+// gaussian is the 5x5 table of the staged kernels without the division by
+// 159. the sobel sums are exact and edge_gradient_scale times those of the
+// staged pipeline.
+constexpr int edge_gradient_scale = 3 * 159;
+
+// magnitudes are stored as 16 bit fixed point with 4 fractional bits, the
+// largest one of 8 bit input is below 1443
+constexpr int edge_magnitude_fraction_bits = 4;
+constexpr float edge_magnitude_scale =
+    static_cast<float>(1 << edge_magnitude_fraction_bits) /
+    edge_gradient_scale;
+
+// the pair of neighbours a pixel is compared with along its gradient, as
+// chosen by the angle atan(gx / gy) of the staged kernels
+enum EdgeDirection : unsigned char {
+  edge_left_right = 0,   // |angle| > 67.5
+  edge_rising = 1,       // 22.5 < angle <= 67.5, upper right and lower left
+  edge_top_bottom = 2,   // |angle| <= 22.5
+  edge_falling = 3,      // -67.5 <= angle < -22.5, upper left and lower right
+};
+
+// threshold on the magnitudes of edge_magnitude()
+EDGE_HOST_DEVICE inline int edge_magnitude_threshold(int threshold) {
+  return threshold << edge_magnitude_fraction_bits;
+}
+
+EDGE_HOST_DEVICE inline int edge_gray(const unsigned char *bgr) {
+  return bgr[0] + bgr[1] + bgr[2];
+}
+
+// the gray value of a pixel of the input, luma on the scale of B + G + R
+template <EdgeInput input>
+EDGE_HOST_DEVICE inline int edge_gray(const unsigned char *pixel) {
+  return input == EdgeInput::bgr ? edge_gray(pixel) : 3 * pixel[0];
+}
+
+// 5 taps of a row of the symmetric gaussian centered on p
+EDGE_HOST_DEVICE inline int edge_gauss_row(const int *p, int w0, int w1,
+                                           int w2) {
+  return w0 * (p[-2] + p[2]) + w1 * (p[-1] + p[1]) + w2 * p[0];
+}
+
+// the 5x5 gaussian of the staged kernels times 159, centered on p in rows of
+// stride ints
+EDGE_HOST_DEVICE inline int edge_gauss(const int *p, std::ptrdiff_t stride) {
+  return edge_gauss_row(p - 2 * stride, 2, 4, 5) +
+         edge_gauss_row(p - stride, 4, 9, 12) + edge_gauss_row(p, 5, 12, 15) +
+         edge_gauss_row(p + stride, 4, 9, 12) +
+         edge_gauss_row(p + 2 * stride, 2, 4, 5);
+}
+
+// the 3x3 sobel sums centered on p in rows of stride ints
+EDGE_HOST_DEVICE inline void edge_sobel(const int *p, std::ptrdiff_t stride,
+                                        int &gx, int &gy) {
+  const int *up = p - stride;
+  const int *down = p + stride;
+  gx = (up[1] + 2 * p[1] + down[1]) - (up[-1] + 2 * p[-1] + down[-1]);
+  gy = (down[-1] + 2 * down[0] + down[1]) - (up[-1] + 2 * up[0] + up[1]);
+}
+
+// the explicit fused multiply-adds round the same on host and device
+// whatever the compilers contract, so both store the same magnitudes
+EDGE_HOST_DEVICE inline std::uint16_t edge_magnitude(int gx, int gy) {
+  const float x = static_cast<float>(gx);
+  const float y = static_cast<float>(gy);
+  const float m = fmaf(sqrtf(fmaf(x, x, y * y)), edge_magnitude_scale, 0.5f);
+  return m < 65535.0f ? static_cast<std::uint16_t>(m) : 65535;
+}
+
+// the quadrant of atan(gx / gy) without evaluating it: the bounds at 22.5
+// and 67.5 degrees are tangents times |gy|
+EDGE_HOST_DEVICE inline unsigned char edge_direction(int gx, int gy) {
+  const float ax = static_cast<float>(gx < 0 ? -gx : gx);
+  const float ay = static_cast<float>(gy < 0 ? -gy : gy);
+  if (ax > 2.41421356f * ay)
+    return edge_left_right;
+  if (ax <= 0.41421356f * ay)
+    return edge_top_bottom;
+  return (gx < 0) == (gy < 0) ? edge_rising : edge_falling;
+}
+
+// offset of one of the two neighbours of direction in rows of stride
+// elements, the other one is at the negated offset
+EDGE_HOST_DEVICE inline std::ptrdiff_t edge_neighbour(unsigned char direction,
+                                                      std::ptrdiff_t stride) {
+  // stride - 1, stride and stride + 1 for the directions 1 to 3, selected
+  // rather than switched on
+  return direction == edge_left_right ? 1 : stride + direction - 2;
+}
+
+// offset of one of the two neighbours non-maximum suppression compares a
+// pixel of direction with, across the edge along the gradient, the other
+// one is at the negated offset. rows grow downwards, so gradients of one
+// sign in both axes point to the lower right, unlike the pairs of
+// edge_neighbour().
+EDGE_HOST_DEVICE inline std::ptrdiff_t
+edge_gradient_neighbour(unsigned char direction, std::ptrdiff_t stride) {
+  // stride + 1, stride and stride - 1 for the directions 1 to 3
+  return direction == edge_left_right ? 1 : stride + 2 - direction;
+}
+
+// the thresholding of the staged pipeline of the pixel i of the magnitudes
+// in rows of stride elements, which must not lie on the border of the image.
+// an edge at a magnitude of at least hi, or above lo next to one above hi
+// along its direction.
+EDGE_HOST_DEVICE inline bool
+edge_thresholded(const std::uint16_t *magnitude, std::size_t i,
+                 unsigned char direction, std::ptrdiff_t stride, int lo,
+                 int hi) {
+  const int m = magnitude[i];
+  if (m >= hi)
+    return true;
+  if (m <= lo)
+    return false;
+  const std::ptrdiff_t step = edge_neighbour(direction, stride);
+  return magnitude[i - step] > hi || magnitude[i + step] > hi;
+}
+
+// classes of the pixels after non-maximum suppression. hysteresis promotes
+// the weak pixels connected to a strong one to strong, only those are edges.
+enum EdgeState : unsigned char {
+  edge_none = 0,
+  edge_weak = 1,
+  edge_strong = 2,
+};
+
+// non-maximum suppression and double thresholding of the pixel i of the
+// magnitudes in rows of stride elements, which must not lie on the border of
+// the image. a pixel survives if it is the maximum of the three along its
+// gradient, see edge_gradient_neighbour(), ties going to the first one. it
+// is strong at a magnitude of at least hi and weak above lo, thresholds as
+// of edge_magnitude_threshold().
+EDGE_HOST_DEVICE inline EdgeState
+edge_state(const std::uint16_t *magnitude, std::size_t i,
+           unsigned char direction, std::ptrdiff_t stride, int lo, int hi) {
+  // without branches, they are hardly predictable on noisy images
+  const int m = magnitude[i];
+  const std::ptrdiff_t step = edge_gradient_neighbour(direction, stride);
+  const int peak =
+      (m > lo) & (m >= magnitude[i - step]) & (m > magnitude[i + step]);
+  return static_cast<EdgeState>(peak * (1 + (m >= hi)));
+}
+
+#endif // INCLUDED_EDGE_GRADIENT
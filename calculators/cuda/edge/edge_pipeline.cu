@@ -0,0 +1,493 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <cstddef>
+#include <cstdint>
+
+#include <cuda_runtime_api.h>
+
+#include "calculators/cuda/hdr/framework/CUDA/error.h"
+
+#include "calculators/cuda/edge/edge_gradient.h"
+
+#define PI 3.1415926
+#define EDGE 0
+#define NOEDGE 255
+
+namespace {
+unsigned int divup(unsigned int a, unsigned int b) {
+  return (a + b - 1) / b;
+}
+
+// one row of the image per row of blocks
+dim3 image_grid(unsigned int width, unsigned int height,
+                unsigned int block_size) {
+  return dim3(divup(width, block_size), height);
+}
+} // namespace
+
+// Kernel that calculates a B&W image from a BGR image with rows of pitch
+// bytes, resulting image has a double type for each pixel position
+__global__ void grayscale_kernel(double *gray, const unsigned char *bgr,
+                                 std::size_t pitch, unsigned int width) {
+  const unsigned int x = blockIdx.x * blockDim.x + threadIdx.x;
+  const unsigned int y = blockIdx.y;
+  if (x >= width)
+    return;
+
+  const unsigned char *src = bgr + y * pitch + 3 * x;
+  const double B = src[0];
+  const double G = src[1];
+  const double R = src[2];
+  gray[y * width + x] = (R + G + B) / 3.0;
+}
+
+void edge_grayscale(double *gray, const unsigned char *bgr, std::size_t pitch,
+                    unsigned int width, unsigned int height,
+                    unsigned int block_size, cudaStream_t stream) {
+  grayscale_kernel<<<image_grid(width, height, block_size), block_size, 0,
+                     stream>>>(gray, bgr, pitch, width);
+  throw_error(cudaGetLastError());
+}
+
+__device__ double Gauss[5][5] = {{2, 4, 5, 4, 2},
+                                 {4, 9, 12, 9, 4},
+                                 {5, 12, 15, 12, 5},
+                                 {4, 9, 12, 9, 4},
+                                 {2, 4, 5, 4, 2}};
+// Kernel that calculates a Gauss image from the B&W image
+// resulting image has a double type for each pixel position
+__global__ void gauss_kernel(double *gauss, const double *gray,
+                             unsigned int width, unsigned int height) {
+  const int x = blockIdx.x * blockDim.x + threadIdx.x;
+  const int y = blockIdx.y;
+  if (x >= width)
+    return;
+
+  double G = 0.0;
+  if (x >= 2 && y >= 2 && x + 2 < width && y + 2 < height) {
+    for (int i = -2; i <= 2; i++)
+      for (int j = -2; j <= 2; j++)
+        G += gray[(y + i) * width + x + j] * Gauss[i + 2][j + 2];
+    G /= 159.0;
+  }
+  gauss[y * width + x] = G;
+}
+
+void edge_gauss(double *gauss, const double *gray, unsigned int width,
+                unsigned int height, unsigned int block_size,
+                cudaStream_t stream) {
+  gauss_kernel<<<image_grid(width, height, block_size), block_size, 0,
+                 stream>>>(gauss, gray, width, height);
+  throw_error(cudaGetLastError());
+}
+
+__device__ double Gx[3][3] = {{-1, 0, 1}, {-2, 0, 2}, {-1, 0, 1}};
+__device__ double Gy[3][3] = {{-1, -2, -1}, {0, 0, 0}, {1, 2, 1}};
+// Kernel that calculates Gradient, Theta from the Gauss image
+// resulting image has a double type for each pixel position
+__global__ void sobel_kernel(double *gradient, double *theta,
+                             const double *gauss, unsigned int width,
+                             unsigned int height) {
+  const int x = blockIdx.x * blockDim.x + threadIdx.x;
+  const int y = blockIdx.y;
+  if (x >= width)
+    return;
+
+  const unsigned int i = y * width + x;
+  if (x < 1 || y < 1 || x + 1 >= width || y + 1 >= height) {
+    gradient[i] = 0.0;
+    theta[i] = 0.0;
+    return;
+  }
+  double GX = 0.0;
+  double GY = 0.0;
+  for (int r = -1; r <= 1; r++) {
+    for (int c = -1; c <= 1; c++) {
+      const double v = gauss[(y + r) * width + x + c];
+      GX += v * Gx[r + 1][c + 1];
+      GY += v * Gy[r + 1][c + 1];
+    }
+  }
+  gradient[i] = sqrt(GX * GX + GY * GY);
+  theta[i] = atan(GX / GY) * 180.0 / PI;
+}
+
+void edge_sobel(double *gradient, double *theta, const double *gauss,
+                unsigned int width, unsigned int height,
+                unsigned int block_size, cudaStream_t stream) {
+  sobel_kernel<<<image_grid(width, height, block_size), block_size, 0,
+                 stream>>>(gradient, theta, gauss, width, height);
+  throw_error(cudaGetLastError());
+}
+
+// Kernel that calculates the threshold image from Gradient, Theta
+// resulting image has an RGB for each pixel, same RGB for each pixel
+__global__ void threshold_kernel(unsigned char *out, std::size_t pitch,
+                                 const double *gradient, const double *theta,
+                                 unsigned int width, unsigned int height,
+                                 double lo, double hi) {
+  const int x = blockIdx.x * blockDim.x + threadIdx.x;
+  const int y = blockIdx.y;
+  if (x >= width)
+    return;
+
+  unsigned char value = NOEDGE;
+  if (x >= 1 && y >= 1 && x + 1 < width && y + 1 < height) {
+    const double *G = gradient + y * width + x;
+    if (*G >= hi) {
+      value = EDGE;
+    } else if (*G > lo) {
+      // look for a strong neighbour along the gradient direction
+      const double T = theta[y * width + x];
+      const int w = width;
+      int step = 0;
+      if ((T < -67.5) || (T > 67.5))
+        step = 1; // left and right
+      else if ((T >= -22.5) && (T <= 22.5))
+        step = w; // top and bottom
+      else if ((T > 22.5) && (T <= 67.5))
+        step = w - 1; // upper right and lower left
+      else if ((T >= -67.5) && (T < -22.5))
+        step = w + 1; // upper left and lower right
+      if (step && (G[-step] > hi || G[step] > hi))
+        value = EDGE;
+    }
+  }
+  unsigned char *dest = out + y * pitch + 3 * x;
+  dest[0] = value;
+  dest[1] = value;
+  dest[2] = value;
+}
+
+void edge_threshold(unsigned char *out, std::size_t pitch,
+                    const double *gradient, const double *theta,
+                    unsigned int width, unsigned int height, int threshold_lo,
+                    int threshold_hi, unsigned int block_size,
+                    cudaStream_t stream) {
+  threshold_kernel<<<image_grid(width, height, block_size), block_size, 0,
+                     stream>>>(out, pitch, gradient, theta, width, height,
+                               threshold_lo, threshold_hi);
+  throw_error(cudaGetLastError());
+}
+
+namespace {
+// output pixels of a block of the fused kernel. the gaussian needs a border
+// of 2 and the sobel operator another one of 1 around them.
+constexpr int tile_width = 32;
+constexpr int tile_height = 8;
+constexpr int gauss_width = tile_width + 2;
+constexpr int gauss_height = tile_height + 2;
+constexpr int gray_width = tile_width + 6;
+constexpr int gray_height = tile_height + 6;
+} // namespace
+
+// grayscale, gaussian, sobel and direction of a tile in one pass: the gray
+// values and the gaussian of the tile and its border stay in shared memory,
+// only the u16 magnitude and the u8 direction of every pixel are written.
+// matches the border handling of the staged kernels, the gaussian is 0
+// within 2 pixels and the gradient within 1 pixel of the image border.
+template <EdgeInput input>
+__global__ void gradient_kernel(std::uint16_t *magnitude,
+                                unsigned char *direction,
+                                const unsigned char *frame, std::size_t pitch,
+                                unsigned int width, unsigned int height) {
+  __shared__ int gray[gray_height][gray_width];
+  __shared__ int gauss[gauss_height][gauss_width];
+
+  const int w = width;
+  const int h = height;
+  const int x0 = blockIdx.x * tile_width;
+  const int y0 = blockIdx.y * tile_height;
+  const int tid = threadIdx.y * tile_width + threadIdx.x;
+
+  for (int i = tid; i < gray_width * gray_height;
+       i += tile_width * tile_height) {
+    const int r = i / gray_width;
+    const int c = i % gray_width;
+    const int x = x0 + c - 3;
+    const int y = y0 + r - 3;
+    gray[r][c] = x >= 0 && y >= 0 && x < w && y < h
+                     ? edge_gray<input>(frame + y * pitch +
+                                        input_pixel_size(input) * x)
+                     : 0;
+  }
+  __syncthreads();
+
+  for (int i = tid; i < gauss_width * gauss_height;
+       i += tile_width * tile_height) {
+    const int r = i / gauss_width;
+    const int c = i % gauss_width;
+    const int x = x0 + c - 1;
+    const int y = y0 + r - 1;
+    gauss[r][c] = x >= 2 && y >= 2 && x + 2 < w && y + 2 < h
+                      ? edge_gauss(&gray[r + 2][c + 2], gray_width)
+                      : 0;
+  }
+  __syncthreads();
+
+  const int x = x0 + threadIdx.x;
+  const int y = y0 + threadIdx.y;
+  if (x >= w || y >= h)
+    return;
+  int gx = 0;
+  int gy = 0;
+  if (x >= 1 && y >= 1 && x + 1 < w && y + 1 < h)
+    edge_sobel(&gauss[threadIdx.y + 1][threadIdx.x + 1], gauss_width, gx, gy);
+  const std::size_t i = std::size_t(y) * w + x;
+  magnitude[i] = edge_magnitude(gx, gy);
+  direction[i] = edge_direction(gx, gy);
+}
+
+void edge_gradient(std::uint16_t *magnitude, unsigned char *direction,
+                   const unsigned char *frame, std::size_t pitch,
+                   EdgeInput input, unsigned int width, unsigned int height,
+                   cudaStream_t stream) {
+  const dim3 block(tile_width, tile_height);
+  const dim3 grid(divup(width, tile_width), divup(height, tile_height));
+  if (input == EdgeInput::bgr)
+    gradient_kernel<EdgeInput::bgr><<<grid, block, 0, stream>>>(
+        magnitude, direction, frame, pitch, width, height);
+  else
+    gradient_kernel<EdgeInput::luma><<<grid, block, 0, stream>>>(
+        magnitude, direction, frame, pitch, width, height);
+  throw_error(cudaGetLastError());
+}
+
+namespace {
+// the thresholding of threshold_kernel on the output of gradient_kernel
+struct ThresholdedEdges {
+  const std::uint16_t *magnitude;
+  const unsigned char *direction;
+  unsigned int width;
+  unsigned int height;
+  int lo;
+  int hi;
+
+  __device__ bool operator()(unsigned int x, unsigned int y) const {
+    if (x < 1 || y < 1 || x + 1 >= width || y + 1 >= height)
+      return false;
+    const std::size_t i = std::size_t(y) * width + x;
+    return edge_thresholded(magnitude, i, direction[i], width, lo, hi);
+  }
+};
+
+// the strong pixels of the hysteresis
+struct StrongEdges {
+  const unsigned char *state;
+  unsigned int width;
+
+  __device__ bool operator()(unsigned int x, unsigned int y) const {
+    return state[std::size_t(y) * width + x] == edge_strong;
+  }
+};
+} // namespace
+
+// writes the edges of row blockIdx.y as decided by edges(x, y) in the output
+// format. every thread writes one pixel, or one byte of 8 pixels of bits.
+template <EdgeOutput output, typename Edges>
+__global__ void edge_output_kernel(unsigned char *out, std::size_t pitch,
+                                   unsigned int width, Edges edges) {
+  const unsigned int x = blockIdx.x * blockDim.x + threadIdx.x;
+  const unsigned int y = blockIdx.y;
+  unsigned char *row = out + y * pitch;
+
+  if (output == EdgeOutput::bits) {
+    if (x >= (width + 7) / 8)
+      return;
+    unsigned char bits = 0;
+    for (unsigned int k = 0; k < 8 && 8 * x + k < width; ++k)
+      if (edges(8 * x + k, y))
+        bits |= 0x80 >> k;
+    row[x] = bits;
+    return;
+  }
+
+  if (x >= width)
+    return;
+  const unsigned char value = edges(x, y) ? EDGE : NOEDGE;
+  if (output == EdgeOutput::gray) {
+    row[x] = value;
+  } else {
+    unsigned char *dest = row + 3 * x;
+    dest[0] = value;
+    dest[1] = value;
+    dest[2] = value;
+  }
+}
+
+namespace {
+template <typename Edges>
+void write_edges(unsigned char *out, std::size_t pitch, EdgeOutput output,
+                 unsigned int width, unsigned int height,
+                 unsigned int block_size, cudaStream_t stream, Edges edges) {
+  const unsigned int units = output == EdgeOutput::bits ? divup(width, 8)
+                                                        : width;
+  const dim3 grid = image_grid(units, height, block_size);
+  switch (output) {
+  case EdgeOutput::bgr:
+    edge_output_kernel<EdgeOutput::bgr>
+        <<<grid, block_size, 0, stream>>>(out, pitch, width, edges);
+    break;
+  case EdgeOutput::gray:
+    edge_output_kernel<EdgeOutput::gray>
+        <<<grid, block_size, 0, stream>>>(out, pitch, width, edges);
+    break;
+  case EdgeOutput::bits:
+    edge_output_kernel<EdgeOutput::bits>
+        <<<grid, block_size, 0, stream>>>(out, pitch, width, edges);
+    break;
+  }
+  throw_error(cudaGetLastError());
+}
+} // namespace
+
+void edge_threshold(unsigned char *out, std::size_t pitch, EdgeOutput output,
+                    const std::uint16_t *magnitude,
+                    const unsigned char *direction, unsigned int width,
+                    unsigned int height, int threshold_lo, int threshold_hi,
+                    unsigned int block_size, cudaStream_t stream) {
+  write_edges(out, pitch, output, width, height, block_size, stream,
+              ThresholdedEdges{magnitude, direction, width, height,
+                               edge_magnitude_threshold(threshold_lo),
+                               edge_magnitude_threshold(threshold_hi)});
+}
+
+// non-maximum suppression and double thresholding of the output of
+// gradient_kernel, see edge_state()
+__global__ void suppress_kernel(unsigned char *state,
+                                const std::uint16_t *magnitude,
+                                const unsigned char *direction,
+                                unsigned int width, unsigned int height,
+                                int lo, int hi) {
+  const int x = blockIdx.x * blockDim.x + threadIdx.x;
+  const int y = blockIdx.y;
+  if (x >= width)
+    return;
+
+  const std::size_t i = std::size_t(y) * width + x;
+  state[i] = x >= 1 && y >= 1 && x + 1 < width && y + 1 < height
+                 ? edge_state(magnitude, i, direction[i], width, lo, hi)
+                 : edge_none;
+}
+
+void edge_suppress(unsigned char *state, const std::uint16_t *magnitude,
+                   const unsigned char *direction, unsigned int width,
+                   unsigned int height, int threshold_lo, int threshold_hi,
+                   unsigned int block_size, cudaStream_t stream) {
+  suppress_kernel<<<image_grid(width, height, block_size), block_size, 0,
+                    stream>>>(state, magnitude, direction, width, height,
+                              edge_magnitude_threshold(threshold_lo),
+                              edge_magnitude_threshold(threshold_hi));
+  throw_error(cudaGetLastError());
+}
+
+namespace {
+// pixels of a block of the hysteresis, every thread covers 4 rows
+constexpr int hysteresis_tile = 32;
+constexpr int hysteresis_rows_per_thread = 4;
+} // namespace
+
+// one pass of the hysteresis: every block loads the states of its tile and a
+// border of 1 into shared memory and promotes weak pixels next to strong
+// ones until nothing changes within the tile. chains of weak pixels through
+// the tile are thus followed in one pass, promotions across tiles are seen
+// by the neighbouring blocks in a later pass or, if those start later, in
+// this one. sets *changed if the block promoted a pixel.
+__global__ void hysteresis_kernel(unsigned char *state, int *changed,
+                                  unsigned int width, unsigned int height) {
+  __shared__ unsigned char tile[hysteresis_tile + 2][hysteresis_tile + 2];
+
+  const int w = width;
+  const int h = height;
+  const int x0 = blockIdx.x * hysteresis_tile;
+  const int y0 = blockIdx.y * hysteresis_tile;
+  const int tid = threadIdx.y * hysteresis_tile + threadIdx.x;
+  const int threads = hysteresis_tile * blockDim.y;
+
+  for (int i = tid; i < (hysteresis_tile + 2) * (hysteresis_tile + 2);
+       i += threads) {
+    const int r = i / (hysteresis_tile + 2);
+    const int c = i % (hysteresis_tile + 2);
+    const int x = x0 + c - 1;
+    const int y = y0 + r - 1;
+    tile[r][c] = x >= 0 && y >= 0 && x < w && y < h
+                     ? state[std::size_t(y) * w + x]
+                     : static_cast<unsigned char>(edge_none);
+  }
+  __syncthreads();
+
+  // the border of the image is no edge, so the neighbours of weak pixels
+  // are within the image
+  const int c = threadIdx.x + 1;
+  bool promoted = false;
+  for (;;) {
+    bool grown = false;
+    for (int k = 0; k < hysteresis_rows_per_thread; ++k) {
+      const int r = threadIdx.y + k * blockDim.y + 1;
+      if (tile[r][c] != edge_weak)
+        continue;
+      if (tile[r - 1][c - 1] == edge_strong || tile[r - 1][c] == edge_strong ||
+          tile[r - 1][c + 1] == edge_strong || tile[r][c - 1] == edge_strong ||
+          tile[r][c + 1] == edge_strong || tile[r + 1][c - 1] == edge_strong ||
+          tile[r + 1][c] == edge_strong ||
+          tile[r + 1][c + 1] == edge_strong) {
+        tile[r][c] = edge_strong;
+        grown = true;
+      }
+    }
+    promoted |= grown;
+    if (!__syncthreads_or(grown))
+      break;
+  }
+
+  for (int k = 0; k < hysteresis_rows_per_thread; ++k) {
+    const int r = threadIdx.y + k * blockDim.y + 1;
+    const int x = x0 + c - 1;
+    const int y = y0 + r - 1;
+    if (x < w && y < h && tile[r][c] == edge_strong)
+      state[std::size_t(y) * w + x] = edge_strong;
+  }
+  if (__syncthreads_or(promoted) && tid == 0)
+    *changed = 1;
+}
+
+void edge_hysteresis_pass(unsigned char *state, int *changed,
+                          unsigned int width, unsigned int height,
+                          cudaStream_t stream) {
+  const dim3 block(hysteresis_tile,
+                   hysteresis_tile / hysteresis_rows_per_thread);
+  const dim3 grid(divup(width, hysteresis_tile),
+                  divup(height, hysteresis_tile));
+  hysteresis_kernel<<<grid, block, 0, stream>>>(state, changed, width,
+                                                height);
+  throw_error(cudaGetLastError());
+}
+
+void edge_map(unsigned char *out, std::size_t pitch, EdgeOutput output,
+              const unsigned char *state, unsigned int width,
+              unsigned int height, unsigned int block_size,
+              cudaStream_t stream) {
+  write_edges(out, pitch, output, width, height, block_size, stream,
+              StrongEdges{state, width});
+}
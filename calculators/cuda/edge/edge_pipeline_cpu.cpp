@@ -0,0 +1,581 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "calculators/cuda/hdr/framework/thread_pool.h"
+
+#include "calculators/cuda/edge/edge_gradient.h"
+#include "calculators/cuda/edge/edge_pipeline_cpu.h"
+
+namespace {
+constexpr double pi = 3.1415926;
+constexpr unsigned char edge = 0;
+constexpr unsigned char no_edge = 255;
+constexpr std::size_t rows_per_task = 16;
+
+const double gauss_weights[5][5] = {{2, 4, 5, 4, 2},
+                                    {4, 9, 12, 9, 4},
+                                    {5, 12, 15, 12, 5},
+                                    {4, 9, 12, 9, 4},
+                                    {2, 4, 5, 4, 2}};
+const double sobel_x[3][3] = {{-1, 0, 1}, {-2, 0, 2}, {-1, 0, 1}};
+const double sobel_y[3][3] = {{-1, -2, -1}, {0, 0, 0}, {1, 2, 1}};
+
+// calls fn(y) for every row, rows_per_task rows per task
+template <typename F> void for_rows(std::size_t height, F &&fn) {
+  const std::size_t tasks = (height + rows_per_task - 1) / rows_per_task;
+  ThreadPool::shared().parallel_for(tasks, [&](std::size_t t) {
+    const std::size_t end = std::min(height, (t + 1) * rows_per_task);
+    for (std::size_t y = t * rows_per_task; y < end; ++y)
+      fn(y);
+  });
+}
+
+// whether (x, y) lies within border pixels of the edge of the image
+bool on_border(std::size_t x, std::size_t y, std::size_t width,
+               std::size_t height, std::size_t border) {
+  return x < border || y < border || x + border >= width ||
+         y + border >= height;
+}
+
+// pixels of a tile of the fused front end. its gray values and gaussian
+// with their borders take about 40 kB.
+constexpr std::size_t tile_columns = 256;
+constexpr std::size_t tile_rows = 16;
+constexpr std::size_t gray_stride = tile_columns + 6;
+constexpr std::size_t gauss_stride = tile_columns + 2;
+
+// [begin, end) of the columns [0, count) of a tile buffer whose first
+// column is image column x and which lie at least border pixels inside an
+// image of width columns
+void inner_columns(std::ptrdiff_t x, std::size_t count, std::size_t width,
+                   std::size_t border, std::size_t &begin,
+                   std::size_t &end) {
+  const std::ptrdiff_t lo = static_cast<std::ptrdiff_t>(border) - x;
+  const std::ptrdiff_t hi =
+      static_cast<std::ptrdiff_t>(width) - static_cast<std::ptrdiff_t>(border) -
+      x;
+  begin = static_cast<std::size_t>(
+      std::clamp<std::ptrdiff_t>(lo, 0, static_cast<std::ptrdiff_t>(count)));
+  end = static_cast<std::size_t>(std::clamp<std::ptrdiff_t>(
+      hi, static_cast<std::ptrdiff_t>(begin),
+      static_cast<std::ptrdiff_t>(count)));
+}
+
+// the gaussian of the columns [begin, end) of a row, p points to the gray
+// value at the center of the first one
+std::size_t gauss_columns(int *dest, const int *p, std::size_t begin,
+                          std::size_t end) {
+  std::size_t c = begin;
+#if defined(__AVX2__)
+  auto row = [](const int *q, int w0, int w1, int w2) {
+    auto at = [q](int i) {
+      return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(q + i));
+    };
+    const __m256i outer = _mm256_add_epi32(at(-2), at(2));
+    const __m256i inner = _mm256_add_epi32(at(-1), at(1));
+    return _mm256_add_epi32(
+        _mm256_add_epi32(_mm256_mullo_epi32(outer, _mm256_set1_epi32(w0)),
+                         _mm256_mullo_epi32(inner, _mm256_set1_epi32(w1))),
+        _mm256_mullo_epi32(at(0), _mm256_set1_epi32(w2)));
+  };
+  const std::ptrdiff_t s = gray_stride;
+  for (; c + 8 <= end; c += 8) {
+    const int *q = p + (c - begin);
+    const __m256i g = _mm256_add_epi32(
+        _mm256_add_epi32(
+            _mm256_add_epi32(row(q - 2 * s, 2, 4, 5), row(q - s, 4, 9, 12)),
+            _mm256_add_epi32(row(q + s, 4, 9, 12), row(q + 2 * s, 2, 4, 5))),
+        row(q, 5, 12, 15));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest + c), g);
+  }
+#endif
+  for (; c < end; ++c)
+    dest[c] = edge_gauss(p + (c - begin), gray_stride);
+  return c;
+}
+
+// magnitude and direction of the columns [begin, end) of a row, p points to
+// the gaussian at the center of the first one
+void sobel_columns(std::uint16_t *magnitude, unsigned char *direction,
+                   const int *p, std::size_t begin, std::size_t end) {
+  std::size_t c = begin;
+#if defined(__AVX2__)
+  const std::ptrdiff_t s = gauss_stride;
+  auto at = [](const int *q) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(q));
+  };
+  for (; c + 8 <= end; c += 8) {
+    const int *q = p + (c - begin);
+    const __m256i up = _mm256_add_epi32(at(q - s - 1), at(q - s + 1));
+    const __m256i down = _mm256_add_epi32(at(q + s - 1), at(q + s + 1));
+    const __m256i right = _mm256_add_epi32(at(q - s + 1), at(q + s + 1));
+    const __m256i left = _mm256_add_epi32(at(q - s - 1), at(q + s - 1));
+    const __m256i gx = _mm256_sub_epi32(
+        _mm256_add_epi32(right, _mm256_slli_epi32(at(q + 1), 1)),
+        _mm256_add_epi32(left, _mm256_slli_epi32(at(q - 1), 1)));
+    const __m256i gy = _mm256_sub_epi32(
+        _mm256_add_epi32(down, _mm256_slli_epi32(at(q + s), 1)),
+        _mm256_add_epi32(up, _mm256_slli_epi32(at(q - s), 1)));
+
+    // edge_magnitude()
+    const __m256 x = _mm256_cvtepi32_ps(gx);
+    const __m256 y = _mm256_cvtepi32_ps(gy);
+    const __m256 m = _mm256_fmadd_ps(
+        _mm256_sqrt_ps(_mm256_fmadd_ps(x, x, _mm256_mul_ps(y, y))),
+        _mm256_set1_ps(edge_magnitude_scale), _mm256_set1_ps(0.5f));
+    const __m256i mi =
+        _mm256_cvttps_epi32(_mm256_min_ps(m, _mm256_set1_ps(65535.0f)));
+    const __m256i m16 =
+        _mm256_permute4x64_epi64(_mm256_packus_epi32(mi, mi), 0x08);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(magnitude + c),
+                     _mm256_castsi256_si128(m16));
+
+    // edge_direction()
+    const __m256 ax = _mm256_cvtepi32_ps(_mm256_abs_epi32(gx));
+    const __m256 ay = _mm256_cvtepi32_ps(_mm256_abs_epi32(gy));
+    const __m256i steep = _mm256_castps_si256(_mm256_cmp_ps(
+        ax, _mm256_mul_ps(_mm256_set1_ps(2.41421356f), ay), _CMP_GT_OQ));
+    const __m256i flat = _mm256_castps_si256(_mm256_cmp_ps(
+        ax, _mm256_mul_ps(_mm256_set1_ps(0.41421356f), ay), _CMP_LE_OQ));
+    const __m256i opposite =
+        _mm256_cmpgt_epi32(_mm256_setzero_si256(), _mm256_xor_si256(gx, gy));
+    __m256i d = _mm256_blendv_epi8(_mm256_set1_epi32(edge_rising),
+                                   _mm256_set1_epi32(edge_falling), opposite);
+    d = _mm256_blendv_epi8(d, _mm256_set1_epi32(edge_top_bottom), flat);
+    d = _mm256_blendv_epi8(d, _mm256_set1_epi32(edge_left_right), steep);
+    const __m128i d16 = _mm256_castsi256_si128(
+        _mm256_permute4x64_epi64(_mm256_packus_epi32(d, d), 0x08));
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(direction + c),
+                     _mm_packus_epi16(d16, d16));
+  }
+#endif
+  for (; c < end; ++c) {
+    int gx, gy;
+    edge_sobel(p + (c - begin), gauss_stride, gx, gy);
+    magnitude[c] = edge_magnitude(gx, gy);
+    direction[c] = edge_direction(gx, gy);
+  }
+}
+
+// the fused front end on the tile of the image at (x0, y0)
+template <EdgeInput input>
+void gradient_tile(std::uint16_t *magnitude, unsigned char *direction,
+                   const unsigned char *frame, std::size_t pitch,
+                   std::size_t width, std::size_t height, std::size_t x0,
+                   std::size_t y0) {
+  constexpr std::size_t pixel_size = input_pixel_size(input);
+  int gray[(tile_rows + 6) * gray_stride];
+  int gauss[(tile_rows + 2) * gauss_stride];
+  const std::size_t columns = std::min(tile_columns, width - x0);
+  const std::size_t rows = std::min(tile_rows, height - y0);
+  const auto x = static_cast<std::ptrdiff_t>(x0);
+  const auto y = static_cast<std::ptrdiff_t>(y0);
+  const auto h = static_cast<std::ptrdiff_t>(height);
+
+  // gray values of the tile and a border of 3, 0 outside of the image
+  std::size_t begin, end;
+  inner_columns(x - 3, columns + 6, width, 0, begin, end);
+  for (std::size_t r = 0; r < rows + 6; ++r) {
+    int *dest = gray + r * gray_stride;
+    const std::ptrdiff_t row = y + static_cast<std::ptrdiff_t>(r) - 3;
+    if (row < 0 || row >= h) {
+      std::fill(dest, dest + columns + 6, 0);
+      continue;
+    }
+    const unsigned char *src =
+        frame + row * pitch + pixel_size * (x - 3 + begin);
+    std::fill(dest, dest + begin, 0);
+    for (std::size_t c = begin; c < end; ++c, src += pixel_size)
+      dest[c] = edge_gray<input>(src);
+    std::fill(dest + end, dest + columns + 6, 0);
+  }
+
+  // gaussian of the tile and a border of 1, 0 within 2 pixels of the image
+  // border
+  inner_columns(x - 1, columns + 2, width, 2, begin, end);
+  for (std::size_t r = 0; r < rows + 2; ++r) {
+    int *dest = gauss + r * gauss_stride;
+    const std::ptrdiff_t row = y + static_cast<std::ptrdiff_t>(r) - 1;
+    if (row < 2 || row + 2 >= h) {
+      std::fill(dest, dest + columns + 2, 0);
+      continue;
+    }
+    std::fill(dest, dest + begin, 0);
+    gauss_columns(dest, gray + (r + 2) * gray_stride + begin + 2, begin, end);
+    std::fill(dest + end, dest + columns + 2, 0);
+  }
+
+  // gradient of the tile, 0 within 1 pixel of the image border
+  inner_columns(x, columns, width, 1, begin, end);
+  for (std::size_t r = 0; r < rows; ++r) {
+    const std::size_t row = y0 + r;
+    std::uint16_t *m = magnitude + row * width + x0;
+    unsigned char *d = direction + row * width + x0;
+    std::size_t b = begin;
+    std::size_t e = end;
+    if (row < 1 || row + 1 >= height)
+      b = e = columns;
+    std::fill(m, m + b, edge_magnitude(0, 0));
+    std::fill(d, d + b, edge_direction(0, 0));
+    sobel_columns(m, d, gauss + (r + 1) * gauss_stride + b + 1, b, e);
+    std::fill(m + e, m + columns, edge_magnitude(0, 0));
+    std::fill(d + e, d + columns, edge_direction(0, 0));
+  }
+}
+
+// writes a row of width pixels in the output format, edge_at(x) deciding
+// whether pixel x is an edge
+template <typename F>
+void write_row(unsigned char *row, EdgeOutput output, std::size_t width,
+               F &&edge_at) {
+  switch (output) {
+  case EdgeOutput::bgr:
+    for (std::size_t x = 0; x < width; ++x, row += 3) {
+      const unsigned char value = edge_at(x) ? edge : no_edge;
+      row[0] = value;
+      row[1] = value;
+      row[2] = value;
+    }
+    break;
+  case EdgeOutput::gray:
+    for (std::size_t x = 0; x < width; ++x)
+      row[x] = edge_at(x) ? edge : no_edge;
+    break;
+  case EdgeOutput::bits:
+    for (std::size_t x = 0; x < width; x += 8) {
+      unsigned char bits = 0;
+      for (std::size_t k = 0; k < 8 && x + k < width; ++k)
+        if (edge_at(x + k))
+          bits |= 0x80 >> k;
+      row[x / 8] = bits;
+    }
+    break;
+  }
+}
+
+// pixels of a frontier of the hysteresis handed out at once
+constexpr std::size_t frontier_chunk = 256;
+
+// the chunks [begin, end) of a frontier left to a worker of the hysteresis,
+// others may steal them
+struct ChunkQueue {
+  std::mutex mutex;
+  std::size_t begin = 0;
+  std::size_t end = 0;
+};
+
+// takes the first chunk of queue. false if queue is empty.
+bool take_chunk(ChunkQueue &queue, std::size_t &chunk) {
+  std::lock_guard<std::mutex> lock(queue.mutex);
+  if (queue.begin == queue.end)
+    return false;
+  chunk = queue.begin++;
+  return true;
+}
+
+// moves the second half of the chunks of victim, at least one, to the empty
+// queue of the thief. false if victim is empty.
+bool steal_chunks(ChunkQueue &victim, ChunkQueue &thief) {
+  std::size_t begin, end;
+  {
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (victim.begin == victim.end)
+      return false;
+    begin = victim.begin + (victim.end - victim.begin) / 2;
+    end = victim.end;
+    victim.end = begin;
+  }
+  std::lock_guard<std::mutex> lock(thief.mutex);
+  thief.begin = begin;
+  thief.end = end;
+  return true;
+}
+} // namespace
+
+namespace cpu {
+void edge_grayscale(double *gray, const unsigned char *bgr, std::size_t pitch,
+                    std::size_t width, std::size_t height) {
+  for_rows(height, [&](std::size_t y) {
+    const unsigned char *src = bgr + y * pitch;
+    double *dest = gray + y * width;
+    for (std::size_t x = 0; x < width; ++x, src += 3) {
+      const double b = src[0];
+      const double g = src[1];
+      const double r = src[2];
+      dest[x] = (r + g + b) / 3.0;
+    }
+  });
+}
+
+void edge_gauss(double *gauss, const double *gray, std::size_t width,
+                std::size_t height) {
+  for_rows(height, [&](std::size_t y) {
+    for (std::size_t x = 0; x < width; ++x) {
+      double g = 0.0;
+      if (!on_border(x, y, width, height, 2)) {
+        for (int i = -2; i <= 2; ++i)
+          for (int j = -2; j <= 2; ++j)
+            g += gray[(y + i) * width + x + j] * gauss_weights[i + 2][j + 2];
+        g /= 159.0;
+      }
+      gauss[y * width + x] = g;
+    }
+  });
+}
+
+void edge_sobel(double *gradient, double *theta, const double *gauss,
+                std::size_t width, std::size_t height) {
+  for_rows(height, [&](std::size_t y) {
+    for (std::size_t x = 0; x < width; ++x) {
+      const std::size_t i = y * width + x;
+      if (on_border(x, y, width, height, 1)) {
+        gradient[i] = 0.0;
+        theta[i] = 0.0;
+        continue;
+      }
+      double gx = 0.0;
+      double gy = 0.0;
+      for (int r = -1; r <= 1; ++r) {
+        for (int c = -1; c <= 1; ++c) {
+          const double v = gauss[(y + r) * width + x + c];
+          gx += v * sobel_x[r + 1][c + 1];
+          gy += v * sobel_y[r + 1][c + 1];
+        }
+      }
+      gradient[i] = std::sqrt(gx * gx + gy * gy);
+      theta[i] = std::atan(gx / gy) * 180.0 / pi;
+    }
+  });
+}
+
+void edge_threshold(unsigned char *out, std::size_t pitch,
+                    const double *gradient, const double *theta,
+                    std::size_t width, std::size_t height, int threshold_lo,
+                    int threshold_hi) {
+  const double lo = threshold_lo;
+  const double hi = threshold_hi;
+  for_rows(height, [&](std::size_t y) {
+    unsigned char *dest = out + y * pitch;
+    for (std::size_t x = 0; x < width; ++x, dest += 3) {
+      unsigned char value = no_edge;
+      if (!on_border(x, y, width, height, 1)) {
+        const double *g = gradient + y * width + x;
+        const std::ptrdiff_t w = width;
+        if (*g >= hi) {
+          value = edge;
+        } else if (*g > lo) {
+          // looks for a strong neighbour along the gradient direction
+          const double t = theta[y * width + x];
+          std::ptrdiff_t step = 0;
+          if (t < -67.5 || t > 67.5)
+            step = 1;
+          else if (t >= -22.5 && t <= 22.5)
+            step = w;
+          else if (t > 22.5 && t <= 67.5)
+            step = w - 1;
+          else if (t >= -67.5 && t < -22.5)
+            step = w + 1;
+          if (step && (g[-step] > hi || g[step] > hi))
+            value = edge;
+        }
+      }
+      dest[0] = value;
+      dest[1] = value;
+      dest[2] = value;
+    }
+  });
+}
+
+void edge_gradient(std::uint16_t *magnitude, unsigned char *direction,
+                   const unsigned char *frame, std::size_t pitch,
+                   EdgeInput input, std::size_t width, std::size_t height) {
+  const std::size_t tiles_x = (width + tile_columns - 1) / tile_columns;
+  const std::size_t tiles_y = (height + tile_rows - 1) / tile_rows;
+  ThreadPool::shared().parallel_for(tiles_x * tiles_y, [&](std::size_t t) {
+    const std::size_t x0 = t % tiles_x * tile_columns;
+    const std::size_t y0 = t / tiles_x * tile_rows;
+    if (input == EdgeInput::bgr)
+      gradient_tile<EdgeInput::bgr>(magnitude, direction, frame, pitch,
+                                    width, height, x0, y0);
+    else
+      gradient_tile<EdgeInput::luma>(magnitude, direction, frame, pitch,
+                                     width, height, x0, y0);
+  });
+}
+
+void edge_threshold(unsigned char *out, std::size_t pitch, EdgeOutput output,
+                    const std::uint16_t *magnitude,
+                    const unsigned char *direction, std::size_t width,
+                    std::size_t height, int threshold_lo, int threshold_hi) {
+  const int lo = edge_magnitude_threshold(threshold_lo);
+  const int hi = edge_magnitude_threshold(threshold_hi);
+  for_rows(height, [&](std::size_t y) {
+    write_row(out + y * pitch, output, width, [&](std::size_t x) {
+      const std::size_t i = y * width + x;
+      return !on_border(x, y, width, height, 1) &&
+             edge_thresholded(magnitude, i, direction[i], width, lo, hi);
+    });
+  });
+}
+
+void edge_suppress(std::atomic<unsigned char> *state,
+                   const std::uint16_t *magnitude,
+                   const unsigned char *direction, std::size_t width,
+                   std::size_t height, int threshold_lo, int threshold_hi) {
+  const int lo = edge_magnitude_threshold(threshold_lo);
+  const int hi = edge_magnitude_threshold(threshold_hi);
+  for_rows(height, [&](std::size_t y) {
+    std::atomic<unsigned char> *dest = state + y * width;
+    if (on_border(1, y, width, height, 1)) {
+      for (std::size_t x = 0; x < width; ++x)
+        dest[x].store(edge_none, std::memory_order_relaxed);
+      return;
+    }
+    dest[0].store(edge_none, std::memory_order_relaxed);
+    for (std::size_t x = 1; x + 1 < width; ++x) {
+      const std::size_t i = y * width + x;
+      dest[x].store(edge_state(magnitude, i, direction[i], width, lo, hi),
+                    std::memory_order_relaxed);
+    }
+    dest[width - 1].store(edge_none, std::memory_order_relaxed);
+  });
+}
+
+HysteresisCounters edge_hysteresis(std::atomic<unsigned char> *state,
+                                   std::size_t width, std::size_t height) {
+  ThreadPool &pool = ThreadPool::shared();
+  const std::size_t workers = pool.size();
+
+  // the strong pixels next to weak ones are the first frontier, gathered by
+  // bands of rows
+  auto has_weak_neighbour = [&](std::size_t i) {
+    for (std::ptrdiff_t dy : {-1, 0, 1})
+      for (std::ptrdiff_t dx : {-1, 0, 1})
+        if (state[i + dy * static_cast<std::ptrdiff_t>(width) + dx].load(
+                std::memory_order_relaxed) == edge_weak)
+          return true;
+    return false;
+  };
+  const std::size_t bands = (height + rows_per_task - 1) / rows_per_task;
+  std::vector<std::vector<std::size_t>> seeds(bands);
+  pool.parallel_for(bands, [&](std::size_t b) {
+    const std::size_t end = std::min(height - 1, (b + 1) * rows_per_task);
+    for (std::size_t y = std::max<std::size_t>(1, b * rows_per_task); y < end;
+         ++y) {
+      for (std::size_t x = 1; x + 1 < width; ++x) {
+        const std::size_t i = y * width + x;
+        if (state[i].load(std::memory_order_relaxed) == edge_strong &&
+            has_weak_neighbour(i))
+          seeds[b].push_back(i);
+      }
+    }
+  });
+  std::vector<std::size_t> frontier;
+  for (const std::vector<std::size_t> &band : seeds)
+    frontier.insert(frontier.end(), band.begin(), band.end());
+
+  // every level promotes the weak neighbours of the frontier, which are
+  // the next one. its chunks are dealt to the workers in runs, a worker
+  // whose run is done steals half of the rest of another one.
+  std::vector<ChunkQueue> queues(workers);
+  std::vector<std::vector<std::size_t>> found(workers);
+  std::atomic<std::size_t> steals{0};
+  const std::ptrdiff_t stride = width;
+  const std::ptrdiff_t offsets[8] = {-stride - 1, -stride, -stride + 1, -1,
+                                     1,           stride - 1, stride,
+                                     stride + 1};
+  auto expand = [&](std::size_t w) {
+    std::size_t chunk;
+    for (;;) {
+      if (!take_chunk(queues[w], chunk)) {
+        bool stolen = false;
+        for (std::size_t k = 1; k < workers && !stolen; ++k)
+          stolen = steal_chunks(queues[(w + k) % workers], queues[w]);
+        if (!stolen)
+          return;
+        steals.fetch_add(1, std::memory_order_relaxed);
+        continue;
+      }
+      const std::size_t end =
+          std::min(frontier.size(), (chunk + 1) * frontier_chunk);
+      for (std::size_t p = chunk * frontier_chunk; p < end; ++p) {
+        // the border of the image is no edge, so all neighbours of a strong
+        // pixel are within the image
+        const std::size_t i = frontier[p];
+        for (std::ptrdiff_t offset : offsets) {
+          unsigned char expected = edge_weak;
+          if (state[i + offset].compare_exchange_strong(
+                  expected, edge_strong, std::memory_order_relaxed))
+            found[w].push_back(i + offset);
+        }
+      }
+    }
+  };
+
+  HysteresisCounters counters;
+  while (!frontier.empty()) {
+    const std::size_t chunks =
+        (frontier.size() + frontier_chunk - 1) / frontier_chunk;
+    for (std::size_t w = 0; w < workers; ++w) {
+      queues[w].begin = chunks * w / workers;
+      queues[w].end = chunks * (w + 1) / workers;
+      found[w].clear();
+    }
+    // a single chunk, as of a lone chain, is not worth waking the pool
+    if (chunks == 1)
+      expand(workers - 1);
+    else
+      pool.parallel_for(workers, expand);
+    ++counters.levels;
+
+    frontier.clear();
+    for (const std::vector<std::size_t> &pixels : found)
+      frontier.insert(frontier.end(), pixels.begin(), pixels.end());
+  }
+  counters.steals = steals.load();
+  return counters;
+}
+
+void edge_map(unsigned char *out, std::size_t pitch, EdgeOutput output,
+              const std::atomic<unsigned char> *state, std::size_t width,
+              std::size_t height) {
+  for_rows(height, [&](std::size_t y) {
+    const std::atomic<unsigned char> *src = state + y * width;
+    write_row(out + y * pitch, output, width, [src](std::size_t x) {
+      return src[x].load(std::memory_order_relaxed) == edge_strong;
+    });
+  });
+}
+} // namespace cpu
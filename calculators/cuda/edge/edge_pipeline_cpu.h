@@ -0,0 +1,93 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef INCLUDED_EDGE_PIPELINE_CPU
+#define INCLUDED_EDGE_PIPELINE_CPU
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "calculators/cuda/edge/edge_format.h"
+
+// host implementations of the kernels in edge_pipeline.cu with the same
+// arithmetic, spread over ThreadPool::shared(). the images in between are
+// dense width * height doubles, the frames and edge maps have rows of pitch
+// bytes.
+namespace cpu {
+void edge_grayscale(double *gray, const unsigned char *bgr, std::size_t pitch,
+                    std::size_t width, std::size_t height);
+
+void edge_gauss(double *gauss, const double *gray, std::size_t width,
+                std::size_t height);
+
+void edge_sobel(double *gradient, double *theta, const double *gauss,
+                std::size_t width, std::size_t height);
+
+void edge_threshold(unsigned char *out, std::size_t pitch,
+                    const double *gradient, const double *theta,
+                    std::size_t width, std::size_t height, int threshold_lo,
+                    int threshold_hi);
+
+// the fused front end of gradient_kernel, see edge_gradient.h. the image is
+// processed in tiles whose gray values and gaussian fit into the cache, the
+// sobel stage is vectorized where the target supports AVX2. magnitude and
+// direction are dense width * height images.
+void edge_gradient(std::uint16_t *magnitude, unsigned char *direction,
+                   const unsigned char *frame, std::size_t pitch,
+                   EdgeInput input, std::size_t width, std::size_t height);
+
+void edge_threshold(unsigned char *out, std::size_t pitch, EdgeOutput output,
+                    const std::uint16_t *magnitude,
+                    const unsigned char *direction, std::size_t width,
+                    std::size_t height, int threshold_lo, int threshold_hi);
+
+// non-maximum suppression and double thresholding, see edge_state()
+void edge_suppress(std::atomic<unsigned char> *state,
+                   const std::uint16_t *magnitude,
+                   const unsigned char *direction, std::size_t width,
+                   std::size_t height, int threshold_lo, int threshold_hi);
+
+// the levels of the search of edge_hysteresis() and the chunks of them the
+// workers took from each other
+struct HysteresisCounters {
+  std::size_t levels = 0;
+  std::size_t steals = 0;
+};
+
+// promotes the weak pixels connected to strong ones to strong. a breadth
+// first search from the strong pixels one frontier at a time, the chunks of
+// a frontier are dealt to the workers of the pool, which steal from each
+// other once theirs run dry. the search always runs to completion.
+HysteresisCounters edge_hysteresis(std::atomic<unsigned char> *state,
+                                   std::size_t width, std::size_t height);
+
+// the strong pixels as edges
+void edge_map(unsigned char *out, std::size_t pitch, EdgeOutput output,
+              const std::atomic<unsigned char> *state, std::size_t width,
+              std::size_t height);
+} // namespace cpu
+
+#endif // INCLUDED_EDGE_PIPELINE_CPU
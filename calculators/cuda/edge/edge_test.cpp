@@ -0,0 +1,172 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <cuda_runtime_api.h>
+#include <gtest/gtest.h>
+
+#include "calculators/cuda/edge/EdgeDetector.h"
+#include "calculators/cuda/edge/edge_gradient.h"
+#include "calculators/cuda/edge/edge_pipeline_cpu.h"
+
+namespace {
+constexpr unsigned int size = 64;
+constexpr std::uint8_t on_edge = 0;
+
+EdgeSettings canny_settings() {
+  EdgeSettings settings;
+  settings.thresholding = EdgeThresholding::hysteresis;
+  settings.input = EdgeInput::luma;
+  settings.output = EdgeOutput::gray;
+  return settings;
+}
+
+// the edge map of a size x size luma frame that is dark where dark(x, y)
+template <typename Dark>
+std::vector<std::uint8_t> detect_step(EdgeBackend backend, Dark dark) {
+  std::vector<std::uint8_t> frame(size * size);
+  for (unsigned int y = 0; y < size; ++y)
+    for (unsigned int x = 0; x < size; ++x)
+      frame[y * size + x] = dark(x, y) ? 20 : 220;
+  std::vector<std::uint8_t> edges(size * size);
+  EdgeDetector detector(size, size, backend, EdgeMode::fused,
+                        canny_settings());
+  detector.process(frame.data(), size, edges.data(), size);
+  return edges;
+}
+
+// edge pixels on the line through (x, y) along the gradient (dx, dy), away
+// from the border of the frame, where the front end pads with 0
+int edges_along(const std::vector<std::uint8_t> &edges, int x, int y, int dx,
+                int dy) {
+  auto inside = [](int x, int y) {
+    return x >= 4 && y >= 4 && x < int{size} - 4 && y < int{size} - 4;
+  };
+  while (inside(x - dx, y - dy)) {
+    x -= dx;
+    y -= dy;
+  }
+  int count = 0;
+  for (; inside(x, y); x += dx, y += dy)
+    count += edges[y * size + x] == on_edge;
+  return count;
+}
+
+// every line along the gradient crosses the step edges of the four
+// directions in exactly one pixel. a diagonal step lies between two
+// diagonals of pixels, the lines along its gradient alternate between them.
+void expect_thin_edges(EdgeBackend backend) {
+  const std::vector<std::uint8_t> vertical = detect_step(
+      backend, [](unsigned int x, unsigned int) { return x < 32; });
+  const std::vector<std::uint8_t> horizontal = detect_step(
+      backend, [](unsigned int, unsigned int y) { return y < 32; });
+  const std::vector<std::uint8_t> rising = detect_step(
+      backend, [](unsigned int x, unsigned int y) { return x + y < size; });
+  const std::vector<std::uint8_t> falling = detect_step(
+      backend, [](unsigned int x, unsigned int y) { return x < y; });
+
+  for (int t = 12; t < int{size} - 12; ++t) {
+    SCOPED_TRACE(::testing::Message() << "line " << t);
+    EXPECT_EQ(edges_along(vertical, 32, t, 1, 0), 1);
+    EXPECT_EQ(edges_along(horizontal, t, 32, 0, 1), 1);
+    EXPECT_EQ(edges_along(rising, t, size - 1 - t, 1, 1), 1);
+    EXPECT_EQ(edges_along(rising, t, size - t, 1, 1), 1);
+    EXPECT_EQ(edges_along(falling, t, t, 1, -1), 1);
+    EXPECT_EQ(edges_along(falling, t, t + 1, 1, -1), 1);
+  }
+}
+
+bool has_cuda_device() {
+  int count = 0;
+  return cudaGetDeviceCount(&count) == cudaSuccess && count > 0;
+}
+} // namespace
+
+// non-maximum suppression thins step edges of every direction to one pixel
+// across
+TEST(EdgeDetector, CpuThinsStepEdges) { expect_thin_edges(EdgeBackend::cpu); }
+
+// the search follows a chain of weak pixels to its end one frontier at a
+// time and leaves the weak pixels without a strong one alone
+TEST(EdgeHysteresis, CpuFollowsLongChains) {
+  const std::size_t width = 2000;
+  const std::size_t height = 5;
+  std::vector<std::atomic<unsigned char>> state(width * height);
+  for (std::atomic<unsigned char> &s : state)
+    s.store(edge_none);
+
+  // a chain over row 1 started by a strong pixel, and weak pixels on row 3
+  // that touch none of it
+  for (std::size_t x = 1; x + 1 < width; ++x) {
+    state[width + x].store(edge_weak);
+    state[3 * width + x].store(edge_weak);
+  }
+  state[width + 1].store(edge_strong);
+
+  const cpu::HysteresisCounters counters =
+      cpu::edge_hysteresis(state.data(), width, height);
+  for (std::size_t x = 1; x + 1 < width; ++x) {
+    ASSERT_EQ(state[width + x].load(), edge_strong) << "x " << x;
+    ASSERT_EQ(state[3 * width + x].load(), edge_weak) << "x " << x;
+  }
+  // a frontier per pixel of the chain: every one finds the next, the last
+  // finds nothing
+  EXPECT_EQ(counters.levels, width - 2);
+}
+
+TEST(EdgeDetector, CudaThinsStepEdges) {
+  if (!has_cuda_device())
+    GTEST_SKIP() << "no CUDA device";
+  expect_thin_edges(EdgeBackend::cuda);
+}
+
+// hysteresis runs to completion on both backends, so their edges agree
+TEST(EdgeDetector, CudaHysteresisMatchesCpu) {
+  if (!has_cuda_device())
+    GTEST_SKIP() << "no CUDA device";
+  const unsigned int width = 301;
+  const unsigned int height = 197;
+  std::mt19937 random(5);
+  std::vector<std::uint8_t> frame(width * height);
+  for (unsigned int y = 0; y < height; ++y)
+    for (unsigned int x = 0; x < width; ++x)
+      frame[y * width + x] = static_cast<std::uint8_t>(
+          (x / 13 + y / 11) % 2 * 90 + random() % 80);
+
+  EdgeSettings settings = canny_settings();
+  settings.threshold_lo = 20;
+  settings.threshold_hi = 120;
+  std::vector<std::uint8_t> cpu_edges(width * height);
+  std::vector<std::uint8_t> cuda_edges(width * height);
+  EdgeDetector cpu_detector(width, height, EdgeBackend::cpu, EdgeMode::fused,
+                            settings);
+  EdgeDetector cuda_detector(width, height, 0, EdgeMode::fused, settings);
+  cpu_detector.process(frame.data(), width, cpu_edges.data(), width);
+  cuda_detector.process(frame.data(), width, cuda_edges.data(), width);
+  EXPECT_EQ(cpu_edges, cuda_edges);
+}
@@ -0,0 +1,87 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "HDRAutoExposure.h"
+
+HDRAutoExposure::HDRAutoExposure(const AutoExposureSettings &settings)
+    : settings(settings) {
+  if (!(settings.low_percentile >= 0.0f &&
+        settings.low_percentile < settings.high_percentile &&
+        settings.high_percentile <= 1.0f))
+    throw std::invalid_argument(
+        "the percentiles must satisfy 0 <= low < high <= 1");
+  if (settings.subsample == 0 || settings.interval == 0)
+    throw std::invalid_argument(
+        "the histogram subsample and interval must be positive");
+  if (!(settings.speed_up >= 0.0f && settings.speed_down >= 0.0f &&
+        settings.stable_range >= 0.0f))
+    throw std::invalid_argument(
+        "the adaptation speeds and the stable range must not be negative");
+}
+
+LuminanceStats HDRAutoExposure::update(HDRPipeline &pipeline, float seconds,
+                                       unsigned int index) {
+  ++frames;
+  if (!adapted_valid || !stable ||
+      ++frames_since_histogram >= settings.interval) {
+    pipeline.computeHistogram(settings.subsample);
+    const std::vector<unsigned int> bins = pipeline.readHistogram(index);
+    scene_log2 = histogram_percentile_log2(
+        bins.data(), settings.low_percentile, settings.high_percentile);
+    frames_since_histogram = 0;
+    ++histograms;
+  }
+
+  if (!adapted_valid) {
+    adapted_log2 = scene_log2;
+    adapted_valid = true;
+  } else {
+    // the gap closes by the same fraction per second at any frame rate
+    const float speed =
+        scene_log2 > adapted_log2 ? settings.speed_up : settings.speed_down;
+    adapted_log2 += (scene_log2 - adapted_log2) *
+                    (1.0f - std::exp(-speed * std::max(seconds, 0.0f)));
+  }
+  stable = std::abs(scene_log2 - adapted_log2) <= settings.stable_range;
+
+  const float average = std::exp2(adapted_log2);
+  return {average, average};
+}
+
+void HDRAutoExposure::reset() {
+  adapted_valid = false;
+  stable = false;
+  frames_since_histogram = 0;
+}
+
+float HDRAutoExposure::adaptedLuminance() const {
+  return std::exp2(adapted_log2);
+}
+
+float HDRAutoExposure::sceneLuminance() const { return std::exp2(scene_log2); }
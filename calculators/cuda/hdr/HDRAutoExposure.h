@@ -0,0 +1,97 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef INCLUDED_HDR_AUTO_EXPOSURE
+#define INCLUDED_HDR_AUTO_EXPOSURE
+
+#pragma once
+
+#include <cstdint>
+
+#include "calculators/cuda/hdr/HDRPipeline.h"
+
+struct AutoExposureSettings {
+  // fractions of the darkest and brightest pixels left out of the average,
+  // 0 <= low < high <= 1, see histogram_percentile_log2()
+  float low_percentile = 0.5f;
+  float high_percentile = 0.95f;
+  // the histogram is built from every subsample-th pixel and row
+  unsigned int subsample = 4U;
+  // rates per second at which the adapted luminance closes the gap to that
+  // of the scene, towards brighter and towards darker scenes
+  float speed_up = 3.0f;
+  float speed_down = 1.0f;
+  // while the scene is stable a histogram is computed every interval frames
+  // only, the frames in between keep adapting towards the last one
+  unsigned int interval = 8U;
+  // the scene counts as stable while the adapted luminance is within this
+  // many stops of the measured one
+  float stable_range = 0.25f;
+};
+
+// exposure control for a sequence of frames run through an HDRPipeline. the
+// average luminance the frames are tonemapped with is the mean log2
+// luminance between two percentiles of a histogram of the frame, so a few
+// specular highlights do not darken the whole frame, and follows it with an
+// exponential adaptation over time instead of jumping with every frame.
+//
+//   LuminanceStats stats = auto_exposure.update(pipeline, frame_seconds);
+//   pipeline.run(exposure, brightpass_threshold, stats);
+class HDRAutoExposure {
+  AutoExposureSettings settings;
+
+  bool adapted_valid = false;
+  bool stable = false;
+  float adapted_log2 = 0.0f; // luminance the frames are tonemapped with
+  float scene_log2 = 0.0f;   // of the last histogram
+  unsigned int frames_since_histogram = 0;
+  std::uint64_t frames = 0;
+  std::uint64_t histograms = 0;
+
+public:
+  // throws std::invalid_argument for unsupported settings
+  explicit HDRAutoExposure(
+      const AutoExposureSettings &settings = AutoExposureSettings());
+
+  const AutoExposureSettings &getSettings() const { return settings; }
+
+  // adapts to the frame consumed by pipeline, seconds after the previous
+  // one, and returns the luminance to tonemap it with, the adapted average
+  // in both fields. computes and reads back the histogram of image index of
+  // the batch if one is due, which waits for the pipeline. the first frame
+  // is taken as it is.
+  LuminanceStats update(HDRPipeline &pipeline, float seconds,
+                        unsigned int index = 0);
+
+  // forgets the adaptation, e.g. at a scene cut
+  void reset();
+
+  float adaptedLuminance() const;
+  float sceneLuminance() const;
+  // frames updated and histograms computed for them so far
+  std::uint64_t frameCount() const { return frames; }
+  std::uint64_t histogramCount() const { return histograms; }
+};
+
+#endif // INCLUDED_HDR_AUTO_EXPOSURE
@@ -21,162 +21,995 @@
 // SOFTWARE.
 //
 
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
 #include <framework/CUDA/error.h>
 
 #include "HDRPipeline.h"
+#include "calculators/cuda/hdr/device_arena.h"
+#include "calculators/cuda/hdr/framework/thread_pool.h"
+#include "calculators/cuda/hdr/hdr_pipeline_cpu.h"
 
 namespace {
-template <typename T> auto cudaMalloc(std::size_t size) {
-  void *ptr;
-  throw_error(::cudaMalloc(&ptr, size * sizeof(T)));
-  return cuda_unique_ptr<T>{static_cast<T *>(ptr)};
+// the width and height members of the pipeline hide the functions of views
+bool has_size(const image_view<const RGB32F> &view, unsigned int w,
+              unsigned int h) {
+  return width(view) == w && height(view) == h;
 }
+} // namespace
 
-template <typename T> auto cudaMallocZeroed(std::size_t size) {
-  auto memory = cudaMalloc<T>(size);
-  throw_error(cudaMemset(memory.get(), 0, size * sizeof(T)));
-  return memory;
+void HDRPipeline::requireDebug(const char *what) const {
+  if (mode != HDRMode::debug)
+    throw std::logic_error(std::string(what) +
+                           " is only available in debug mode");
+}
+
+void HDRPipeline::checkIndex(unsigned int index) const {
+  if (index >= batch)
+    throw std::out_of_range("image " + std::to_string(index) +
+                            " is not part of a batch of " +
+                            std::to_string(batch));
+}
+
+template <typename F>
+void HDRPipeline::forEachImage(unsigned int batch, F &&fn) {
+  ThreadPool::shared().parallel_for(batch, [&](std::size_t i) {
+    fn(static_cast<unsigned int>(i));
+  });
+}
+
+HDRPipeline::HDRPipeline(unsigned int width, unsigned int height,
+                         HDRBackend backend, HDRMode mode, HDRStorage storage,
+                         HDRLayout layout, cudaStream_t stream,
+                         HostExecutor *executor)
+    : width(width), height(height), backend(backend), mode(mode),
+      layout(layout), storage(storage), stream(stream), executor(executor) {
+  if (layout == HDRLayout::planar &&
+      (mode != HDRMode::debug || storage != HDRStorage::fp32))
+    throw std::invalid_argument(
+        "the planar layout needs fp32 storage in debug mode");
+
+  if (backend == HDRBackend::cuda)
+    arena.reset(new DeviceArena);
+  else
+    arena.reset(new HostArena);
+  layoutBuffers();
+}
+
+HDRPipeline::BufferOffsets
+HDRPipeline::planBuffers(unsigned int width, unsigned int height,
+                         HDRBackend backend, HDRMode mode, HDRStorage storage,
+                         HDRLayout layout, const BloomSettings &bloom,
+                         unsigned int batch) {
+  // every image buffer holds the whole batch
+  const std::size_t pixels = std::size_t{width} * height * batch;
+  const bool debug = mode == HDRMode::debug;
+
+  ArenaLayout buffers;
+  BufferOffsets at;
+  at.input = buffers.add(pixels * 3 * sizeof(float));
+  at.luminance = buffers.add(debug ? pixels * sizeof(float) : 0);
+  at.downsample = buffers.add(debug ? pixels * sizeof(float) : 0);
+  const std::size_t intermediate =
+      debug ? pixels * intermediate_pixel_size(storage) : 0;
+  at.tonemapped = buffers.add(intermediate);
+  at.brightpass = buffers.add(intermediate);
+  at.blurred = buffers.add(intermediate);
+  at.bloom = buffers.add(BloomLayout(width, height, bloom, batch).size *
+                         sizeof(float));
+  at.output = buffers.add(pixels * output_pixel_size(storage));
+  at.stats = buffers.add(batch * sizeof(LuminanceStats));
+  at.lut = buffers.add(tonemap_lut_size * sizeof(float));
+  at.reduction = buffers.add(luminance_reduction_workspace_size(batch));
+  at.histogram = buffers.add(batch * histogram_bins * sizeof(unsigned int));
+  const bool staging =
+      layout == HDRLayout::planar && backend == HDRBackend::cuda;
+  at.staging = buffers.add(staging ? pixels * 3 * sizeof(float) : 0);
+  const bool cuda = backend == HDRBackend::cuda;
+  at.srgb_image =
+      buffers.add(cuda ? std::size_t{width} * height * sizeof(RGBA8) : 0);
+  at.srgb_table = buffers.add(cuda ? srgb8_table_size * sizeof(float) : 0);
+  at.size = buffers.size();
+  return at;
+}
+
+std::size_t HDRPipeline::memoryRequired(unsigned int width,
+                                        unsigned int height,
+                                        HDRBackend backend, HDRMode mode,
+                                        HDRStorage storage, HDRLayout layout,
+                                        const BloomSettings &bloom,
+                                        unsigned int batch) {
+  return planBuffers(width, height, backend, mode, storage, layout, bloom,
+                     batch)
+      .size;
+}
+
+void HDRPipeline::layoutBuffers() {
+  const bool debug = mode == HDRMode::debug;
+  const BufferOffsets at = planBuffers(width, height, backend, mode, storage,
+                                       layout, bloom_settings, batch);
+
+  auto base = static_cast<unsigned char *>(arena->reserve(at.size));
+  // the reduction needs a zeroed workspace, the rest is cleared so that
+  // reading an image before it was computed gives black
+  if (backend == HDRBackend::cuda)
+    throw_error(cudaMemsetAsync(base, 0, at.size, stream));
+  else
+    std::memset(base, 0, at.size);
+
+  d_input_image = reinterpret_cast<float *>(base + at.input);
+  d_luminance_image =
+      debug ? reinterpret_cast<float *>(base + at.luminance) : nullptr;
+  d_downsample_buffer =
+      debug ? reinterpret_cast<float *>(base + at.downsample) : nullptr;
+  d_tonemapped_image = debug ? base + at.tonemapped : nullptr;
+  d_brightpass_image = debug ? base + at.brightpass : nullptr;
+  d_blurred_image = debug ? base + at.blurred : nullptr;
+  d_bloom_workspace = reinterpret_cast<float *>(base + at.bloom);
+  d_output_image = base + at.output;
+  d_luminance_stats = reinterpret_cast<LuminanceStats *>(base + at.stats);
+  d_reduction_workspace = base + at.reduction;
+  d_histogram = reinterpret_cast<unsigned int *>(base + at.histogram);
+  d_tonemap_lut = reinterpret_cast<float *>(base + at.lut);
+  d_staging = layout == HDRLayout::planar && backend == HDRBackend::cuda
+                  ? reinterpret_cast<float *>(base + at.staging)
+                  : nullptr;
+  if (backend == HDRBackend::cuda) {
+    d_srgb_image = reinterpret_cast<RGBA8 *>(base + at.srgb_image);
+    d_srgb_table = reinterpret_cast<float *>(base + at.srgb_table);
+    throw_error(cudaMemcpyAsync(d_srgb_table, srgb8_table(),
+                                srgb8_table_size * sizeof(float),
+                                cudaMemcpyHostToDevice, stream));
+  }
+  uploadTonemapLUT();
+}
+
+void HDRPipeline::uploadTonemapLUT() {
+  if (!tonemap_settings.lut)
+    return;
+
+  std::vector<float> table(tonemap_lut_size);
+  tonemap_lut(table.data(), tonemap_settings);
+  float *dest = d_tonemap_lut;
+  if (backend == HDRBackend::cuda)
+    // staged before the call returns, like the statistics in run()
+    throw_error(cudaMemcpyAsync(dest, table.data(),
+                                tonemap_lut_size * sizeof(float),
+                                cudaMemcpyHostToDevice, stream));
+  else
+    executor->enqueue([=, table = std::move(table)] {
+      std::copy(table.begin(), table.end(), dest);
+    });
+}
+
+void HDRPipeline::configureTonemap(const TonemapSettings &settings) {
+  // throws for unsupported settings before anything is touched
+  check_tonemap(settings);
+
+  // the table is replaced in order with the work queued before, which
+  // captured the old settings already
+  tonemap_settings = settings;
+  uploadTonemapLUT();
+}
+
+void HDRPipeline::reconfigure(unsigned int width, unsigned int height) {
+  // the buffers may still be in use by work queued before
+  synchronize();
+  this->width = width;
+  this->height = height;
+  layoutBuffers();
+}
+
+void HDRPipeline::configureBatch(unsigned int batch) {
+  if (batch == 0)
+    throw std::invalid_argument("a batch needs at least one image");
+  if (batch > 1 && layout == HDRLayout::planar)
+    throw std::invalid_argument("the planar layout does not support batches");
+
+  // the buffers may still be in use by work queued before
+  synchronize();
+  this->batch = batch;
+  layoutBuffers();
 }
-} // namespace
 
-void *downsample_buffer;
 HDRPipeline::HDRPipeline(unsigned int width, unsigned int height)
-    : width(width), height(height),
-      d_input_image(cudaMalloc<float>(width * height * 3)),
-      d_luminance_image(cudaMallocZeroed<float>(width * height)),
-      d_downsample_buffer(cudaMallocZeroed<float>(width * height)),
-      d_tonemapped_image(cudaMallocZeroed<float>(width * height * 3)),
-      d_brightpass_image(cudaMallocZeroed<float>(width * height * 3)),
-      d_blurred_image(cudaMallocZeroed<float>(width * height * 3)),
-      d_output_image(cudaMallocZeroed<float>(width * height * 3)) {
-  // we need a memory buffer on the GPU to store the intermediate images we
-  // compute while downscaling -> CudaMalloc we use floats, and only one color
-  // channel (luminance). Image is half size in width, and half in height -> 1/4
-  // of original size
-
-  //	cudaError_t res = cudaMalloc(&downsample_buffer, width*height / 4.0f *
-  // sizeof(float)); 	if (res != cudaSuccess){ 		throw
-  // std::runtime_error("something went wrong with downscaling memory
-  // allocation");
-  //	}
-
-  // this function does the same thing as the above, but a lot more concise
-  throw_error(
-      cudaMalloc(&downsample_buffer, width * height * sizeof(float) / 4));
+    : HDRPipeline(width, height, HDRBackend::cuda, HDRMode::debug,
+                  HDRStorage::fp32, HDRLayout::interleaved, 0, nullptr) {}
+
+HDRPipeline::HDRPipeline(unsigned int width, unsigned int height,
+                         cudaStream_t stream, HDRMode mode, HDRStorage storage,
+                         HDRLayout layout)
+    : HDRPipeline(width, height, HDRBackend::cuda, mode, storage, layout,
+                  stream, nullptr) {}
+
+HDRPipeline::HDRPipeline(unsigned int width, unsigned int height,
+                         HostExecutor &executor, HDRMode mode,
+                         HDRStorage storage, HDRLayout layout)
+    : HDRPipeline(width, height, HDRBackend::cpu, mode, storage, layout, 0,
+                  &executor) {}
+
+template <typename F> void HDRPipeline::withStorage(F &&fn) const {
+  switch (storage) {
+  case HDRStorage::fp32:
+    fn(HDRStorageFormat<HDRStorage::fp32>{});
+    break;
+  case HDRStorage::fp16:
+    fn(HDRStorageFormat<HDRStorage::fp16>{});
+    break;
+  case HDRStorage::fp16_rgb10a2:
+    fn(HDRStorageFormat<HDRStorage::fp16_rgb10a2>{});
+    break;
+  }
+}
+
+void HDRPipeline::download(void *dest, const void *src, std::size_t size) {
+  if (backend == HDRBackend::cuda) {
+    throw_error(
+        cudaMemcpyAsync(dest, src, size, cudaMemcpyDeviceToHost, stream));
+    throw_error(cudaStreamSynchronize(stream));
+  } else {
+    executor->synchronize();
+    std::memcpy(dest, src, size);
+  }
+}
+
+void HDRPipeline::downloadAsync(void *dest, const void *src,
+                                std::size_t size) {
+  if (backend == HDRBackend::cuda)
+    throw_error(cudaMemcpyAsync(dest, src, size, cudaMemcpyDefault, stream));
+  else
+    executor->enqueue([=] { std::memcpy(dest, src, size); });
+}
+
+template <typename T>
+image<RGB32F> HDRPipeline::downloadRGB(const void *src) {
+  if constexpr (std::is_same<T, float>::value) {
+    image<RGB32F> rgb(width, height);
+    if (layout == HDRLayout::planar)
+      downloadPlanar(reinterpret_cast<float *>(data(rgb)),
+                     static_cast<const float *>(src));
+    else
+      download(data(rgb), src, width * height * sizeof(RGB32F));
+    return rgb;
+  } else {
+    image<T> stored(width, height);
+    download(data(stored), src, width * height * sizeof(T));
+    return convert<RGB32F>(stored);
+  }
+}
+
+void HDRPipeline::downloadPlanar(float *dest, const float *src) {
+  void interleave(float *rgb, const float *planes, unsigned int pixels,
+                  cudaStream_t stream);
+
+  if (backend == HDRBackend::cuda) {
+    interleave(d_staging, src, width * height, stream);
+    download(dest, d_staging, width * height * sizeof(RGB32F));
+  } else {
+    executor->synchronize();
+    cpu::interleave(dest, src, width, height);
+  }
+}
+
+void HDRPipeline::synchronize() {
+  if (backend == HDRBackend::cuda)
+    throw_error(cudaStreamSynchronize(stream));
+  else
+    executor->synchronize();
 }
 
 void HDRPipeline::consume(const float *input_image) {
-  // upload input data to GPU
-  throw_error(cudaMemcpy(d_input_image.get(), input_image,
-                         width * height * 3 * 4U, cudaMemcpyHostToDevice));
+  consumeAsync(input_image);
+  // like an upload from pageable memory, the caller may reuse input_image as
+  // soon as this returns, so wait for the host copy to happen
+  if (backend == HDRBackend::cpu)
+    executor->synchronize();
+}
+
+void HDRPipeline::consume(const float *input_image, unsigned int index) {
+  consumeAsync(input_image, index);
+  if (backend == HDRBackend::cpu)
+    executor->synchronize();
+}
+
+void HDRPipeline::consumeAsync(const float *input_image, unsigned int index) {
+  checkIndex(index);
+  // a planar pipeline has a batch of one
+  if (layout == HDRLayout::planar) {
+    consumeAsync(input_image);
+    return;
+  }
+
+  const std::size_t size = pixels() * 3 * 4U;
+  float *dest = d_input_image + index * 3 * pixels();
+  if (backend == HDRBackend::cuda)
+    throw_error(cudaMemcpyAsync(dest, input_image, size, cudaMemcpyDefault,
+                                stream));
+  else
+    executor->enqueue([=] { std::memcpy(dest, input_image, size); });
+}
+
+void HDRPipeline::consume(const image_view<const RGB32F> &input_image,
+                          unsigned int index) {
+  consumeAsync(input_image, index);
+  if (backend == HDRBackend::cpu)
+    executor->synchronize();
+}
+
+void HDRPipeline::consumeAsync(const image_view<const RGB32F> &input_image,
+                               unsigned int index) {
+  void deinterleave(float *planes, const float *rgb, unsigned int pixels,
+                    cudaStream_t stream);
+
+  checkIndex(index);
+  if (!has_size(input_image, width, height))
+    throw std::invalid_argument(
+        "the input image does not have the size of the pipeline");
+
+  const auto src = reinterpret_cast<const float *>(data(input_image));
+  const std::size_t src_pitch = pitch(input_image);
+  const std::size_t row_size = std::size_t{width} * 3 * 4U;
+  if (layout == HDRLayout::planar) {
+    // the upload packs the rows for the planes to be split off on the
+    // device, the host splits them straight from input_image
+    float *dest = d_input_image;
+    if (backend == HDRBackend::cuda) {
+      throw_error(cudaMemcpy2DAsync(d_staging, row_size, src, src_pitch,
+                                    row_size, height, cudaMemcpyDefault,
+                                    stream));
+      deinterleave(dest, d_staging, width * height, stream);
+    } else {
+      executor->enqueue([=, w = width, h = height] {
+        cpu::deinterleave(dest, src, w, h, src_pitch);
+      });
+    }
+    return;
+  }
+
+  float *dest = d_input_image + index * 3 * pixels();
+  if (backend == HDRBackend::cuda)
+    throw_error(cudaMemcpy2DAsync(dest, row_size, src, src_pitch, row_size,
+                                  height, cudaMemcpyDefault, stream));
+  else
+    executor->enqueue([=, h = height] {
+      auto rows = reinterpret_cast<const unsigned char *>(src);
+      auto out = reinterpret_cast<unsigned char *>(dest);
+      for (unsigned int y = 0; y < h; ++y)
+        std::memcpy(out + y * row_size, rows + y * src_pitch, row_size);
+    });
+}
+
+void HDRPipeline::consumeAsync(const float *input_image) {
+  void deinterleave(float *planes, const float *rgb, unsigned int pixels,
+                    cudaStream_t stream);
+
+  const std::size_t size = batch * pixels() * 3 * 4U;
+  float *dest = d_input_image;
+  if (layout == HDRLayout::planar) {
+    // the planes are split off on the device after the upload, or straight
+    // from input_image on the host
+    if (backend == HDRBackend::cuda) {
+      throw_error(cudaMemcpyAsync(d_staging, input_image, size,
+                                  cudaMemcpyDefault, stream));
+      deinterleave(dest, d_staging, width * height, stream);
+    } else {
+      executor->enqueue([=, w = width, h = height] {
+        cpu::deinterleave(dest, input_image, w, h, std::size_t{w} * 3 * 4U);
+      });
+    }
+    return;
+  }
+
+  if (backend == HDRBackend::cuda)
+    // upload input data to GPU
+    throw_error(cudaMemcpyAsync(dest, input_image, size, cudaMemcpyDefault,
+                                stream));
+  else
+    executor->enqueue([=] { std::memcpy(dest, input_image, size); });
+}
+
+void HDRPipeline::run(float exposure, float brightpass_threshold) {
+  process(exposure, brightpass_threshold, true);
+}
+
+void HDRPipeline::run(float exposure, float brightpass_threshold,
+                      const LuminanceStats &stats) {
+  LuminanceStats *dest = d_luminance_stats;
+  if (backend == HDRBackend::cuda) {
+    // staged before the call returns, the copies need not outlive it
+    const std::vector<LuminanceStats> copies(batch, stats);
+    throw_error(cudaMemcpyAsync(dest, copies.data(),
+                                batch * sizeof(LuminanceStats),
+                                cudaMemcpyHostToDevice, stream));
+  } else {
+    executor->enqueue(
+        [=, n = batch, value = stats] { std::fill_n(dest, n, value); });
+  }
+  process(exposure, brightpass_threshold, false);
+}
+
+void HDRPipeline::process(float exposure, float brightpass_threshold,
+                          bool reduce) {
+  void fused_tonemap_bloom(float *output, float *workspace, const float *src,
+                           unsigned int width, unsigned int height,
+                           const LuminanceStats *average, float exposure,
+                           float brightpass_threshold,
+                           const BloomSettings &settings,
+                           const TonemapSettings &tonemap, const float *lut,
+                           cudaStream_t stream, unsigned int batch);
+  void fused_tonemap_bloom(RGB16F *output, float *workspace, const float *src,
+                           unsigned int width, unsigned int height,
+                           const LuminanceStats *average, float exposure,
+                           float brightpass_threshold,
+                           const BloomSettings &settings,
+                           const TonemapSettings &tonemap, const float *lut,
+                           cudaStream_t stream, unsigned int batch);
+  void fused_tonemap_bloom(RGB10A2 *output, float *workspace,
+                           const float *src, unsigned int width,
+                           unsigned int height, const LuminanceStats *average,
+                           float exposure, float brightpass_threshold,
+                           const BloomSettings &settings,
+                           const TonemapSettings &tonemap, const float *lut,
+                           cudaStream_t stream, unsigned int batch);
+
+  if (mode == HDRMode::debug) {
+    if (reduce) {
+      computeLuminance();
+      downsampleAsync();
+    }
+    tonemapResident(exposure, brightpass_threshold);
+    blur();
+    compose();
+    return;
+  }
+
+  withStorage([&](auto format) {
+    using O = typename decltype(format)::output;
+    O *output = reinterpret_cast<O *>(d_output_image);
+    float *workspace = d_bloom_workspace;
+    const float *src = d_input_image;
+    LuminanceStats *stats = d_luminance_stats;
+    const float *lut = d_tonemap_lut;
+    if (backend == HDRBackend::cuda) {
+      if (reduce)
+        reduce_luminance_rgb(stats, d_reduction_workspace, src, width,
+                             height, stream, batch);
+      fused_tonemap_bloom(output, workspace, src, width, height, stats,
+                          exposure, brightpass_threshold, bloom_settings,
+                          tonemap_settings, lut, stream, batch);
+    } else {
+      executor->enqueue([=, w = width, h = height, n = batch,
+                         bloom = bloom_settings, curve = tonemap_settings] {
+        // the batched workspace holds one single image workspace per image
+        const std::size_t floats = BloomLayout(w, h, bloom).size;
+        forEachImage(n, [&](unsigned int i) {
+          const float *image = src + 3 * std::size_t{w} * h * i;
+          if (reduce)
+            stats[i] = cpu::reduce_luminance_rgb(image, w, h);
+          cpu::fused_tonemap_bloom(cpu::pixel_row(output, w, h * i),
+                                   workspace + floats * i, image, w, h,
+                                   exposure / stats[i].average,
+                                   brightpass_threshold, bloom, curve, lut);
+        });
+      });
+    }
+  });
 }
 
 void HDRPipeline::computeLuminance() {
   void luminance(float *dest, const float *src, unsigned int width,
-                 unsigned int height);
+                 unsigned int height, cudaStream_t stream);
+  void luminance_planar(float *dest, const float *input, unsigned int pixels,
+                        cudaStream_t stream);
 
-  luminance(d_luminance_image.get(), d_input_image.get(), width, height);
+  requireDebug("computeLuminance()");
+
+  // a per pixel stage, the images of a batch are processed as one image of
+  // batch * height rows
+  float *dest = d_luminance_image;
+  const float *src = d_input_image;
+  const bool planar = layout == HDRLayout::planar;
+  if (backend == HDRBackend::cuda) {
+    if (planar)
+      luminance_planar(dest, src, width * height, stream);
+    else
+      luminance(dest, src, width, height * batch, stream);
+  } else {
+    executor->enqueue([=, w = width, h = height * batch] {
+      if (planar)
+        cpu::luminance_planar(dest, src, w, h);
+      else
+        cpu::luminance(dest, src, w, h);
+    });
+  }
 }
 
-// float HDRPipeline::downsample()
-//{
-//	float downsample(float* buffer, float* src, unsigned int width, unsigned
-// int height);
-//
-//	return downsample(d_downsample_buffer.get(), d_luminance_image.get(),
-// width, height);
-// }
+void HDRPipeline::downsampleAsync() {
+  requireDebug("downsample()");
+
+  LuminanceStats *stats = d_luminance_stats;
+  const float *src = d_luminance_image;
+  if (backend == HDRBackend::cuda)
+    reduce_luminance(stats, d_reduction_workspace, src, width, height, stream,
+                     batch);
+  else
+    executor->enqueue([=, w = width, h = height, n = batch] {
+      forEachImage(n, [&](unsigned int i) {
+        stats[i] = cpu::reduce_luminance(src + std::size_t{w} * h * i, w, h);
+      });
+    });
+}
+
+void HDRPipeline::computeStatistics() {
+  if (mode == HDRMode::debug || layout == HDRLayout::planar) {
+    computeLuminance();
+    downsampleAsync();
+    return;
+  }
+
+  LuminanceStats *stats = d_luminance_stats;
+  const float *src = d_input_image;
+  if (backend == HDRBackend::cuda)
+    reduce_luminance_rgb(stats, d_reduction_workspace, src, width, height,
+                         stream, batch);
+  else
+    executor->enqueue([=, w = width, h = height, n = batch] {
+      forEachImage(n, [&](unsigned int i) {
+        stats[i] =
+            cpu::reduce_luminance_rgb(src + 3 * std::size_t{w} * h * i, w, h);
+      });
+    });
+}
+
+void HDRPipeline::computeHistogram(unsigned int subsample) {
+  if (subsample == 0)
+    throw std::invalid_argument("the histogram subsample must be positive");
+
+  unsigned int *bins = d_histogram;
+  const float *src = d_input_image;
+  const bool planar = layout == HDRLayout::planar;
+  if (backend == HDRBackend::cuda) {
+    // the launch adds to the counts of the previous one
+    throw_error(cudaMemsetAsync(
+        bins, 0, batch * histogram_bins * sizeof(unsigned int), stream));
+    if (planar)
+      luminance_histogram_planar(bins, src, width, height, subsample, stream);
+    else
+      luminance_histogram(bins, src, width, height, subsample, stream, batch);
+  } else {
+    executor->enqueue([=, w = width, h = height, n = batch] {
+      if (planar) {
+        cpu::luminance_histogram_planar(bins, src, w, h, subsample);
+        return;
+      }
+      forEachImage(n, [&](unsigned int i) {
+        cpu::luminance_histogram(bins + histogram_bins * i,
+                                 src + 3 * std::size_t{w} * h * i, w, h,
+                                 subsample);
+      });
+    });
+  }
+}
 
 float HDRPipeline::downsample() {
-  // implement downsampling and return average luminance
-  // call the function from hdr_pipeline.cu
-  // dest and input buffers: see HDRPipeline declaration in header file
+  downsampleAsync();
+  return luminanceStatistics().average;
+}
 
-  float downsample(float *dest, float *input, unsigned int width,
-                   unsigned int height);
-  float lum = downsample((float *)downsample_buffer, d_luminance_image.get(),
-                         width, height);
-  printf("LUM: %f \n", lum);
+LuminanceStats HDRPipeline::luminanceStatistics(unsigned int index) {
+  checkIndex(index);
 
-  return lum;
+  LuminanceStats stats;
+  download(&stats, d_luminance_stats + index, sizeof(LuminanceStats));
+  return stats;
+}
+
+std::vector<LuminanceStats> HDRPipeline::batchStatistics() {
+  std::vector<LuminanceStats> stats(batch);
+  download(stats.data(), d_luminance_stats, batch * sizeof(LuminanceStats));
+  return stats;
+}
+
+std::vector<unsigned int> HDRPipeline::readHistogram(unsigned int index) {
+  checkIndex(index);
+
+  std::vector<unsigned int> bins(histogram_bins);
+  download(bins.data(), d_histogram + histogram_bins * index,
+           histogram_bins * sizeof(unsigned int));
+  return bins;
 }
 
 void HDRPipeline::tonemap(float exposure, float brightpass_threshold) {
   void tonemap(float *tonemapped, float *brightpass, const float *src,
-               unsigned int width, unsigned int height, float exposure,
-               float brightpass_threshold);
+               unsigned int width, unsigned int height,
+               const LuminanceStats *average, float exposure,
+               float brightpass_threshold, const TonemapSettings &tonemap,
+               const float *lut, cudaStream_t stream, unsigned int batch);
+  void tonemap(RGB16F *tonemapped, RGB16F *brightpass, const float *src,
+               unsigned int width, unsigned int height,
+               const LuminanceStats *average, float exposure,
+               float brightpass_threshold, const TonemapSettings &tonemap,
+               const float *lut, cudaStream_t stream, unsigned int batch);
+  void tonemap_planar(float *tonemapped, float *brightpass, const float *src,
+                      unsigned int pixels, const LuminanceStats *average,
+                      float exposure, float brightpass_threshold,
+                      const TonemapSettings &tonemap, const float *lut,
+                      cudaStream_t stream);
+
+  requireDebug("tonemap()");
 
-  tonemap(d_tonemapped_image.get(), d_brightpass_image.get(),
-          d_input_image.get(), width, height, exposure, brightpass_threshold);
+  if (layout == HDRLayout::planar) {
+    float *tonemapped = reinterpret_cast<float *>(d_tonemapped_image);
+    float *brightpass = reinterpret_cast<float *>(d_brightpass_image);
+    const float *src = d_input_image;
+    const float *lut = d_tonemap_lut;
+    if (backend == HDRBackend::cuda)
+      tonemap_planar(tonemapped, brightpass, src, width * height, nullptr,
+                     exposure, brightpass_threshold, tonemap_settings, lut,
+                     stream);
+    else
+      executor->enqueue([=, w = width, h = height, curve = tonemap_settings] {
+        cpu::tonemap_planar(tonemapped, brightpass, src, w, h, exposure,
+                            brightpass_threshold, curve, lut);
+      });
+    return;
+  }
+
+  // the same exposure for every image, so a batch is one tall image here
+  withStorage([&](auto format) {
+    using I = typename decltype(format)::intermediate;
+    I *tonemapped = reinterpret_cast<I *>(d_tonemapped_image);
+    I *brightpass = reinterpret_cast<I *>(d_brightpass_image);
+    const float *src = d_input_image;
+    const float *lut = d_tonemap_lut;
+    if (backend == HDRBackend::cuda)
+      tonemap(tonemapped, brightpass, src, width, height * batch, nullptr,
+              exposure, brightpass_threshold, tonemap_settings, lut, stream,
+              1);
+    else
+      executor->enqueue(
+          [=, w = width, h = height * batch, curve = tonemap_settings] {
+            cpu::tonemap(tonemapped, brightpass, src, w, h, exposure,
+                         brightpass_threshold, curve, lut);
+          });
+  });
+}
+
+void HDRPipeline::tonemapResident(float exposure, float brightpass_threshold) {
+  void tonemap(float *tonemapped, float *brightpass, const float *src,
+               unsigned int width, unsigned int height,
+               const LuminanceStats *average, float exposure,
+               float brightpass_threshold, const TonemapSettings &tonemap,
+               const float *lut, cudaStream_t stream, unsigned int batch);
+  void tonemap(RGB16F *tonemapped, RGB16F *brightpass, const float *src,
+               unsigned int width, unsigned int height,
+               const LuminanceStats *average, float exposure,
+               float brightpass_threshold, const TonemapSettings &tonemap,
+               const float *lut, cudaStream_t stream, unsigned int batch);
+  void tonemap_planar(float *tonemapped, float *brightpass, const float *src,
+                      unsigned int pixels, const LuminanceStats *average,
+                      float exposure, float brightpass_threshold,
+                      const TonemapSettings &tonemap, const float *lut,
+                      cudaStream_t stream);
+
+  requireDebug("tonemap()");
+
+  if (layout == HDRLayout::planar) {
+    float *tonemapped = reinterpret_cast<float *>(d_tonemapped_image);
+    float *brightpass = reinterpret_cast<float *>(d_brightpass_image);
+    const float *src = d_input_image;
+    const LuminanceStats *stats = d_luminance_stats;
+    const float *lut = d_tonemap_lut;
+    if (backend == HDRBackend::cuda)
+      tonemap_planar(tonemapped, brightpass, src, width * height, stats,
+                     exposure, brightpass_threshold, tonemap_settings, lut,
+                     stream);
+    else
+      executor->enqueue([=, w = width, h = height, curve = tonemap_settings] {
+        cpu::tonemap_planar(tonemapped, brightpass, src, w, h,
+                            exposure / stats->average, brightpass_threshold,
+                            curve, lut);
+      });
+    return;
+  }
+
+  withStorage([&](auto format) {
+    using I = typename decltype(format)::intermediate;
+    I *tonemapped = reinterpret_cast<I *>(d_tonemapped_image);
+    I *brightpass = reinterpret_cast<I *>(d_brightpass_image);
+    const float *src = d_input_image;
+    const LuminanceStats *stats = d_luminance_stats;
+    const float *lut = d_tonemap_lut;
+    if (backend == HDRBackend::cuda)
+      tonemap(tonemapped, brightpass, src, width, height, stats, exposure,
+              brightpass_threshold, tonemap_settings, lut, stream, batch);
+    else
+      // the reduction queued before has finished by the time this runs
+      executor->enqueue([=, w = width, h = height, n = batch,
+                         curve = tonemap_settings] {
+        forEachImage(n, [&](unsigned int i) {
+          cpu::tonemap(cpu::pixel_row(tonemapped, w, h * i),
+                       cpu::pixel_row(brightpass, w, h * i),
+                       src + 3 * std::size_t{w} * h * i, w, h,
+                       exposure / stats[i].average, brightpass_threshold,
+                       curve, lut);
+        });
+      });
+  });
+}
+
+void HDRPipeline::configureBloom(const BloomSettings &settings) {
+  // throws for unsupported settings before anything is touched
+  bloom_weights(settings);
+  BloomLayout(width, height, settings);
+
+  // the workspace may still be in use by work queued before
+  synchronize();
+  bloom_settings = settings;
+  layoutBuffers();
 }
 
 void HDRPipeline::blur() {
-  void gaussian_blur(float *dest, const float *src, unsigned int width,
-                     unsigned int height);
-  gaussian_blur(d_blurred_image.get(), d_tonemapped_image.get(), width,
-                height); // d_brightpass_image
+  requireDebug("blur()");
+
+  if (layout == HDRLayout::planar) {
+    float *dest = reinterpret_cast<float *>(d_blurred_image);
+    float *workspace = d_bloom_workspace;
+    const float *src = reinterpret_cast<const float *>(d_brightpass_image);
+    if (backend == HDRBackend::cuda)
+      bloom_planar(dest, workspace, src, width, height, bloom_settings,
+                   stream);
+    else
+      executor->enqueue([=, w = width, h = height, bloom = bloom_settings] {
+        cpu::bloom_planar(dest, workspace, src, w, h, bloom);
+      });
+    return;
+  }
+
+  withStorage([&](auto format) {
+    using I = typename decltype(format)::intermediate;
+    I *dest = reinterpret_cast<I *>(d_blurred_image);
+    float *workspace = d_bloom_workspace;
+    const I *src = reinterpret_cast<const I *>(d_brightpass_image);
+    if (backend == HDRBackend::cuda)
+      bloom(dest, workspace, src, width, height, bloom_settings, stream,
+            batch);
+    else
+      executor->enqueue([=, w = width, h = height, n = batch,
+                         bloom = bloom_settings] {
+        const std::size_t floats = BloomLayout(w, h, bloom).size;
+        forEachImage(n, [&](unsigned int i) {
+          cpu::bloom(cpu::pixel_row(dest, w, h * i), workspace + floats * i,
+                     cpu::pixel_row(src, w, h * i), w, h, bloom);
+        });
+      });
+  });
 }
 
 void HDRPipeline::compose() {
   void compose(float *output, const float *tonemapped, const float *blurred,
-               unsigned int width, unsigned int height);
+               unsigned int width, unsigned int height, cudaStream_t stream);
+  void compose(RGB16F *output, const RGB16F *tonemapped,
+               const RGB16F *blurred, unsigned int width, unsigned int height,
+               cudaStream_t stream);
+  void compose(RGB10A2 *output, const RGB16F *tonemapped,
+               const RGB16F *blurred, unsigned int width, unsigned int height,
+               cudaStream_t stream);
+
+  requireDebug("compose()");
 
-  compose(d_output_image.get(), d_tonemapped_image.get(),
-          d_brightpass_image.get(), width, height);
+  // the sum is taken per float, so fp32 compose works on planar images as is
+  // and on a batch as one image of batch * height rows
+  withStorage([&](auto format) {
+    using I = typename decltype(format)::intermediate;
+    using O = typename decltype(format)::output;
+    O *output = reinterpret_cast<O *>(d_output_image);
+    const I *tonemapped =
+        reinterpret_cast<const I *>(d_tonemapped_image);
+    const I *blurred = reinterpret_cast<const I *>(d_blurred_image);
+    if (backend == HDRBackend::cuda)
+      compose(output, tonemapped, blurred, width, height * batch, stream);
+    else
+      executor->enqueue([=, w = width, h = height * batch] {
+        cpu::compose(output, tonemapped, blurred, w, h);
+      });
+  });
 }
 
-image<float> HDRPipeline::readLuminance() {
+unsigned int HDRPipeline::imageWidth(HDRImage image) const {
+  return image == HDRImage::downsample ? (width + 1) / 2 : width;
+}
+
+unsigned int HDRPipeline::imageHeight(HDRImage image) const {
+  return image == HDRImage::downsample ? (height + 1) / 2 : height;
+}
+
+const unsigned char *HDRPipeline::storedImage(HDRImage image,
+                                              unsigned int index) {
+  void downsample(float *dest, float *luminance, unsigned int width,
+                  unsigned int height, cudaStream_t stream);
+
+  if (image != HDRImage::output)
+    requireDebug("reading an intermediate image");
+  checkIndex(index);
+
+  const std::size_t intermediate = pixels() * intermediate_pixel_size(storage);
+  switch (image) {
+  case HDRImage::luminance:
+    return reinterpret_cast<const unsigned char *>(d_luminance_image +
+                                                   index * pixels());
+  case HDRImage::downsample: {
+    // the reduction no longer produces a pyramid, so build the first level
+    // on demand for inspection
+    float *dest = d_downsample_buffer;
+    float *src = d_luminance_image + index * pixels();
+    if (backend == HDRBackend::cuda)
+      downsample(dest, src, width, height, stream);
+    else
+      executor->enqueue([=, w = width, h = height] {
+        cpu::downsample(dest, src, w, h);
+      });
+    return reinterpret_cast<const unsigned char *>(dest);
+  }
+  case HDRImage::tonemapped:
+    return d_tonemapped_image + index * intermediate;
+  case HDRImage::brightpass:
+    return d_brightpass_image + index * intermediate;
+  case HDRImage::blurred:
+    return d_blurred_image + index * intermediate;
+  case HDRImage::output:
+    break;
+  }
+  return d_output_image + index * pixels() * output_pixel_size(storage);
+}
+
+void HDRPipeline::readAsync(HDRImage image, void *dest, unsigned int index) {
+  const std::size_t count =
+      std::size_t{imageWidth(image)} * imageHeight(image);
+  const std::size_t pixel_size =
+      image == HDRImage::luminance || image == HDRImage::downsample
+          ? sizeof(float)
+      : image == HDRImage::output ? output_pixel_size(storage)
+                                  : intermediate_pixel_size(storage);
+  downloadAsync(dest, storedImage(image, index), count * pixel_size);
+}
+
+void HDRPipeline::readSRGBAsync(HDRImage image, RGBA8 *dest,
+                                unsigned int index) {
+  void gray_to_srgb8(RGBA8 *dest, const float *src, unsigned int pixels,
+                     const float *table, cudaStream_t stream);
+  void to_srgb8(RGBA8 *dest, const float *src, unsigned int pixels,
+                const float *table, cudaStream_t stream);
+  void to_srgb8(RGBA8 *dest, const RGB16F *src, unsigned int pixels,
+                const float *table, cudaStream_t stream);
+  void to_srgb8(RGBA8 *dest, const RGB10A2 *src, unsigned int pixels,
+                const float *table, cudaStream_t stream);
+  void planar_to_srgb8(RGBA8 *dest, const float *src, unsigned int pixels,
+                       const float *table, cudaStream_t stream);
+
+  const unsigned char *stored = storedImage(image, index);
+  const unsigned int w = imageWidth(image);
+  const unsigned int h = imageHeight(image);
+  const bool gray =
+      image == HDRImage::luminance || image == HDRImage::downsample;
+  const bool planar = layout == HDRLayout::planar;
+
+  // on the CUDA backend the image is converted next to it and only the 8 bit
+  // pixels are copied
+  const bool cuda = backend == HDRBackend::cuda;
+  RGBA8 *converted = cuda ? d_srgb_image : dest;
+  const float *table = d_srgb_table;
+  if (gray || planar) {
+    const float *src = reinterpret_cast<const float *>(stored);
+    if (cuda && gray)
+      gray_to_srgb8(converted, src, w * h, table, stream);
+    else if (cuda)
+      planar_to_srgb8(converted, src, w * h, table, stream);
+    else
+      executor->enqueue([=] {
+        if (gray)
+          cpu::gray_to_srgb8(converted, src, w, h);
+        else
+          cpu::planar_to_srgb8(converted, src, w, h);
+      });
+  } else {
+    withStorage([&](auto format) {
+      using I = typename decltype(format)::intermediate;
+      using O = typename decltype(format)::output;
+      const bool output = image == HDRImage::output;
+      const I *intermediate_src = reinterpret_cast<const I *>(stored);
+      const O *output_src = reinterpret_cast<const O *>(stored);
+      if (cuda && output)
+        to_srgb8(converted, output_src, w * h, table, stream);
+      else if (cuda)
+        to_srgb8(converted, intermediate_src, w * h, table, stream);
+      else
+        executor->enqueue([=] {
+          if (output)
+            cpu::to_srgb8(converted, output_src, w, h);
+          else
+            cpu::to_srgb8(converted, intermediate_src, w, h);
+        });
+    });
+  }
+  if (cuda)
+    downloadAsync(dest, converted, std::size_t{w} * h * sizeof(RGBA8));
+}
+
+image<float> HDRPipeline::readLuminance(unsigned int index) {
   image<float> luminance(width, height);
-  // download output data from GPU
-  throw_error(cudaMemcpy(data(luminance), d_luminance_image.get(),
-                         width * height * 4U, cudaMemcpyDeviceToHost));
+  readAsync(HDRImage::luminance, data(luminance), index);
+  synchronize();
   return luminance;
 }
 
-// image<float> HDRPipeline::readDownsample()
-//{
-//	image<float> downsample(width, height);
-//	// download output data from GPU
-//	throw_error(cudaMemcpy(data(downsample), d_downsample_buffer.get(),
-// width * height * 4U, cudaMemcpyDeviceToHost)); 	return downsample;
-// }
-
-image<float> HDRPipeline::readDownsample() {
-  image<float> output(width / 2, height / 2);
-  // copy back output data from GPU
-  throw_error(cudaMemcpy(data(output), downsample_buffer,
-                         width / 2 * height / 2 * 4U, cudaMemcpyDeviceToHost));
+image<float> HDRPipeline::readDownsample(unsigned int index) {
+  image<float> output(imageWidth(HDRImage::downsample),
+                      imageHeight(HDRImage::downsample));
+  readAsync(HDRImage::downsample, data(output), index);
+  synchronize();
   return output;
 }
 
-image<RGB32F> HDRPipeline::readTonemapped() {
-  image<RGB32F> tonemapped(width, height);
-  // download output data from GPU
-  throw_error(cudaMemcpy(data(tonemapped), d_tonemapped_image.get(),
-                         width * height * 3 * 4U, cudaMemcpyDeviceToHost));
+image<RGB32F> HDRPipeline::readTonemapped(unsigned int index) {
+  requireDebug("readTonemapped()");
+  checkIndex(index);
+
+  image<RGB32F> tonemapped(0, 0);
+  withStorage([&](auto format) {
+    using I = typename decltype(format)::intermediate;
+    tonemapped = downloadRGB<I>(
+        cpu::pixel_row(reinterpret_cast<I *>(d_tonemapped_image), width,
+                       height * index));
+  });
   return tonemapped;
 }
 
-image<RGB32F> HDRPipeline::readBrightpass() {
-  image<RGB32F> brightpass(width, height);
-  // download output data from GPU
-  throw_error(cudaMemcpy(data(brightpass), d_brightpass_image.get(),
-                         width * height * 3 * 4U, cudaMemcpyDeviceToHost));
+image<RGB32F> HDRPipeline::readBrightpass(unsigned int index) {
+  requireDebug("readBrightpass()");
+  checkIndex(index);
+
+  image<RGB32F> brightpass(0, 0);
+  withStorage([&](auto format) {
+    using I = typename decltype(format)::intermediate;
+    brightpass = downloadRGB<I>(
+        cpu::pixel_row(reinterpret_cast<I *>(d_brightpass_image), width,
+                       height * index));
+  });
   return brightpass;
 }
 
-image<RGB32F> HDRPipeline::readBlurred() {
-  image<RGB32F> blurred(width, height);
-  // download output data from GPU
-  throw_error(cudaMemcpy(data(blurred), d_blurred_image.get(),
-                         width * height * 3 * 4U, cudaMemcpyDeviceToHost));
+image<RGB32F> HDRPipeline::readBlurred(unsigned int index) {
+  requireDebug("readBlurred()");
+  checkIndex(index);
+
+  image<RGB32F> blurred(0, 0);
+  withStorage([&](auto format) {
+    using I = typename decltype(format)::intermediate;
+    blurred = downloadRGB<I>(
+        cpu::pixel_row(reinterpret_cast<I *>(d_blurred_image), width,
+                       height * index));
+  });
   return blurred;
 }
 
-image<RGB32F> HDRPipeline::readOutput() {
-  image<RGB32F> output(width, height);
-  // download output data from GPU
-  throw_error(cudaMemcpy(data(output), d_output_image.get(),
-                         width * height * 3 * 4U, cudaMemcpyDeviceToHost));
+image<RGB32F> HDRPipeline::readOutput(unsigned int index) {
+  checkIndex(index);
+
+  image<RGB32F> output(0, 0);
+  withStorage([&](auto format) {
+    using O = typename decltype(format)::output;
+    output = downloadRGB<O>(cpu::pixel_row(
+        reinterpret_cast<O *>(d_output_image), width, height * index));
+  });
   return output;
 }
+
+void HDRPipeline::readOutputAsync(void *dest) {
+  downloadAsync(dest, d_output_image,
+                batch * pixels() * output_pixel_size(storage));
+}
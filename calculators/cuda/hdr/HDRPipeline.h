@@ -26,12 +26,22 @@
 
 #pragma once
 
+#include <cstddef>
 #include <memory>
+#include <vector>
 
 #include <cuda_runtime_api.h>
 
+#include "calculators/cuda/hdr/bloom.h"
+#include "calculators/cuda/hdr/exposure_histogram.h"
+#include "calculators/cuda/hdr/framework/host_executor.h"
 #include "calculators/cuda/hdr/framework/image.h"
 #include "calculators/cuda/hdr/framework/rgb32f.h"
+#include "calculators/cuda/hdr/framework/rgba8.h"
+#include "calculators/cuda/hdr/hdr_storage.h"
+#include "calculators/cuda/hdr/luminance_reduction.h"
+#include "calculators/cuda/hdr/memory_arena.h"
+#include "calculators/cuda/hdr/tonemap.h"
 
 struct cudaFreeDeleter {
   void operator()(void *ptr) const { cudaFree(ptr); }
@@ -40,34 +50,275 @@ struct cudaFreeDeleter {
 template <typename T>
 using cuda_unique_ptr = std::unique_ptr<T, cudaFreeDeleter>;
 
+enum class HDRBackend { cuda, cpu };
+
+// debug runs every stage on its own and keeps all intermediate images for the
+// read*() accessors. fused merges the per-pixel stages into two passes over
+// the image, only the horizontally blurred brightpass is kept in between.
+enum class HDRMode { debug, fused };
+
+// how the float RGB images are laid out. interleaved stores RGB triples,
+// planar keeps every channel in a plane of width * height floats so that
+// neighbouring pixels of a channel are neighbours in memory. planar needs
+// HDRStorage::fp32 and debug mode. consume() and the read*() accessors take
+// and return interleaved images either way.
+enum class HDRLayout { interleaved, planar };
+
+// the images of the read*() accessors, for readAsync() and readSRGBAsync()
+enum class HDRImage {
+  luminance,
+  downsample,
+  tonemapped,
+  brightpass,
+  blurred,
+  output
+};
+
+// every stage is enqueued on the pipeline's stream (CUDA backend) or host
+// executor (CPU backend) and returns immediately. only downsample() and the
+// read*() accessors wait for the work queued before them.
+//
+// a pipeline may process a batch of images of the same size at once, see
+// configureBatch(). every stage then covers all images with the same
+// launches on the CUDA backend and a parallel loop over the images on the
+// CPU backend, each image being tonemapped with its own average luminance.
 class HDRPipeline {
-  const unsigned int width;
-  const unsigned int height;
+  unsigned int width;
+  unsigned int height;
+  unsigned int batch = 1;
+
+  const HDRBackend backend;
+  const HDRMode mode;
+  const HDRLayout layout;
+  const HDRStorage storage;
+  cudaStream_t stream = 0;
+  HostExecutor *executor = nullptr;
+  BloomSettings bloom_settings;
+  TonemapSettings tonemap_settings;
 
-  cuda_unique_ptr<float> d_input_image;
-  cuda_unique_ptr<float> d_luminance_image;
-  cuda_unique_ptr<float> d_downsample_buffer;
-  cuda_unique_ptr<float> d_tonemapped_image;
-  cuda_unique_ptr<float> d_brightpass_image;
-  cuda_unique_ptr<float> d_blurred_image;
-  cuda_unique_ptr<float> d_output_image;
+  // all buffers are carved out of one block of device memory (CUDA backend)
+  // or host memory (CPU backend). the debug-only images are null in fused
+  // mode.
+  std::unique_ptr<MemoryArena> arena;
+  float *d_input_image = nullptr;
+  float *d_luminance_image = nullptr;
+  float *d_downsample_buffer = nullptr;
+  // stored in the formats of the storage policy, see HDRStorage
+  unsigned char *d_tonemapped_image = nullptr;
+  unsigned char *d_brightpass_image = nullptr;
+  unsigned char *d_blurred_image = nullptr;
+  float *d_bloom_workspace = nullptr;
+  unsigned char *d_output_image = nullptr;
+  LuminanceStats *d_luminance_stats = nullptr;
+  unsigned char *d_reduction_workspace = nullptr;
+  // histogram_bins counts per image, see computeHistogram()
+  unsigned int *d_histogram = nullptr;
+  // tonemap_lut_size floats, filled if the operator is evaluated by table
+  float *d_tonemap_lut = nullptr;
+  // interleaved copy of the input or of an image being read, only for the
+  // planar layout on the CUDA backend
+  float *d_staging = nullptr;
+  // an image converted by readSRGBAsync() and the thresholds of
+  // srgb8_table(), only on the CUDA backend
+  RGBA8 *d_srgb_image = nullptr;
+  float *d_srgb_table = nullptr;
+
+  HDRPipeline(unsigned int width, unsigned int height, HDRBackend backend,
+              HDRMode mode, HDRStorage storage, HDRLayout layout,
+              cudaStream_t stream, HostExecutor *executor);
+
+  // byte offsets of the buffers in the arena, zero sized buffers are absent
+  struct BufferOffsets {
+    std::size_t input, luminance, downsample, tonemapped, brightpass, blurred,
+        bloom, output, stats, lut, reduction, histogram, staging, srgb_image,
+        srgb_table, size;
+  };
+  static BufferOffsets planBuffers(unsigned int width, unsigned int height,
+                                   HDRBackend backend, HDRMode mode,
+                                   HDRStorage storage, HDRLayout layout,
+                                   const BloomSettings &bloom,
+                                   unsigned int batch);
+  std::size_t pixels() const { return std::size_t{width} * height; }
+
+  // places all buffers for the current size and settings in the arena and
+  // zeroes them. the caller makes sure no queued work uses the old ones.
+  void layoutBuffers();
+  // enqueues filling the table of the tonemap operator if it uses one
+  void uploadTonemapLUT();
+  void requireDebug(const char *what) const;
+  void checkIndex(unsigned int index) const;
+  void download(void *dest, const void *src, std::size_t size);
+  // enqueues the copy without waiting, dest may be host or device memory
+  void downloadAsync(void *dest, const void *src, std::size_t size);
+  // image index of the batch as stored, after building it in the case of the
+  // downsample image, and its size in pixels
+  const unsigned char *storedImage(HDRImage image, unsigned int index);
+  unsigned int imageWidth(HDRImage image) const;
+  unsigned int imageHeight(HDRImage image) const;
+  // luminance to compose, with or without reducing the consumed image first
+  void process(float exposure, float brightpass_threshold, bool reduce);
+  // calls fn(HDRStorageFormat<storage>{})
+  template <typename F> void withStorage(F &&fn) const;
+  // calls fn(i) for every image of the batch on the shared thread pool, for
+  // the host stages that work on one image at a time
+  template <typename F> static void forEachImage(unsigned int batch, F &&fn);
+  template <typename T> image<RGB32F> downloadRGB(const void *src);
+  // reinterleaves the planar image src into the host buffer dest
+  void downloadPlanar(float *dest, const float *src);
 
 public:
+  // CUDA backend on the legacy default stream
   HDRPipeline(unsigned int width, unsigned int height);
+  // CUDA backend, all work is enqueued on the given stream
+  HDRPipeline(unsigned int width, unsigned int height, cudaStream_t stream,
+              HDRMode mode = HDRMode::debug,
+              HDRStorage storage = HDRStorage::fp32,
+              HDRLayout layout = HDRLayout::interleaved);
+  // CPU backend, all work is enqueued on the given executor
+  HDRPipeline(unsigned int width, unsigned int height, HostExecutor &executor,
+              HDRMode mode = HDRMode::debug,
+              HDRStorage storage = HDRStorage::fp32,
+              HDRLayout layout = HDRLayout::interleaved);
+
+  unsigned int getWidth() const { return width; }
+  unsigned int getHeight() const { return height; }
+  unsigned int getBatch() const { return batch; }
+  HDRBackend getBackend() const { return backend; }
+  HDRMode getMode() const { return mode; }
+  HDRStorage getStorage() const { return storage; }
+  HDRLayout getLayout() const { return layout; }
+
+  // blur radius and pyramid levels of the bloom, the default is a 33 tap
+  // gaussian at full resolution. waits for the queued work and reallocates
+  // the bloom workspace, throws std::invalid_argument for unsupported values.
+  void configureBloom(const BloomSettings &settings);
+  const BloomSettings &getBloom() const { return bloom_settings; }
+
+  // tonemap operator of the stages enqueued from now on, Uncharted 2 by
+  // default. every operator runs kernels specialized for it. with
+  // settings.lut the operator is sampled into a table on the host once and
+  // looked up from then on. throws std::invalid_argument for unsupported
+  // values, see check_tonemap().
+  void configureTonemap(const TonemapSettings &settings);
+  const TonemapSettings &getTonemap() const { return tonemap_settings; }
 
+  // changes the frame size. waits for the queued work, the buffers are
+  // carved anew and only reallocated if they no longer fit. all images
+  // including the last output are lost.
+  void reconfigure(unsigned int width, unsigned int height);
+
+  // number of images processed at once, 1 by default. waits for the queued
+  // work and lays out the buffers anew, throws std::invalid_argument for 0
+  // or a batch of planar images.
+  void configureBatch(unsigned int batch);
+
+  // used, allocated and peak bytes of the buffers
+  const MemoryArena &memory() const { return *arena; }
+
+  // bytes of the arena a pipeline with these parameters uses
+  static std::size_t memoryRequired(unsigned int width, unsigned int height,
+                                    HDRBackend backend, HDRMode mode,
+                                    HDRStorage storage,
+                                    HDRLayout layout = HDRLayout::interleaved,
+                                    const BloomSettings &bloom =
+                                        BloomSettings(),
+                                    unsigned int batch = 1);
+
+  // copies all images of the batch, stored one after the other
   void consume(const float *input_image);
+  // enqueues the copy without waiting for it. input_image may be host or
+  // device memory and has to stay valid until the copy has run, so pinned
+  // host memory is needed for it to overlap with other work.
+  void consumeAsync(const float *input_image);
+  // same for the single image index of the batch
+  void consume(const float *input_image, unsigned int index);
+  void consumeAsync(const float *input_image, unsigned int index);
+  // same for an image of the size of the pipeline with any row pitch, e.g. a
+  // region of a larger image or a camera buffer with padded rows. the rows
+  // are copied straight from input_image, throws std::invalid_argument for
+  // another size.
+  void consume(const image_view<const RGB32F> &input_image,
+               unsigned int index = 0);
+  void consumeAsync(const image_view<const RGB32F> &input_image,
+                    unsigned int index = 0);
+
+  // processes the consumed image from luminance to compose without blocking,
+  // exposure is divided by the average luminance where the work runs. runs
+  // the stages below one by one in debug mode and the fused passes otherwise.
+  void run(float exposure, float brightpass_threshold);
+  // same, but tonemaps with the given statistics instead of those of the
+  // consumed image, e.g. of a whole image the consumed one is a tile of. the
+  // statistics apply to every image of a batch.
+  void run(float exposure, float brightpass_threshold,
+           const LuminanceStats &stats);
+
+  // only reduces the consumed image to its luminance statistics, see
+  // luminanceStatistics(). available in both modes, in debug mode the
+  // luminance image is computed on the way.
+  void computeStatistics();
+
+  // only counts the pixels of the consumed images per log2 luminance bin,
+  // every subsample-th pixel of every subsample-th row, see
+  // luminance_histogram(). available in both modes and layouts, the CPU and
+  // the CUDA backend give identical counts. throws std::invalid_argument for
+  // a subsample of 0.
+  void computeHistogram(unsigned int subsample);
+
+  // the single stages, debug mode only
   void computeLuminance();
+  // blocks until the reduction is done and returns the arithmetic mean
+  // luminance of the first image, see luminanceStatistics()
   float downsample();
+  // exposure applies to every image of a batch as it is
   void tonemap(float exposure, float brightpass_threshold);
   void blur();
   void compose();
 
-  image<float> readLuminance();
-  image<float> readDownsample();
-  image<RGB32F> readTonemapped();
-  image<RGB32F> readBrightpass();
-  image<RGB32F> readBlurred();
-  image<RGB32F> readOutput();
+  // stream-ordered variants: the average luminance stays where the pipeline
+  // keeps its buffers and tonemapResident() divides exposure by it when it
+  // runs, so no call blocks the host
+  void downsampleAsync();
+  void tonemapResident(float exposure, float brightpass_threshold);
+
+  // waits for all work enqueued so far
+  void synchronize();
+
+  // both averages computed by the last downsample()/downsampleAsync()/run()/
+  // computeStatistics() or passed to run(), for image index of the batch
+  LuminanceStats luminanceStatistics(unsigned int index = 0);
+  // the same for all images of the batch
+  std::vector<LuminanceStats> batchStatistics();
+  // the histogram_bins counts of the last computeHistogram() for image index
+  // of the batch, blocks until they are done
+  std::vector<unsigned int> readHistogram(unsigned int index = 0);
+
+  // intermediate images of image index, debug mode only. the RGB images are
+  // converted to float from the storage format.
+  image<float> readLuminance(unsigned int index = 0);
+  image<float> readDownsample(unsigned int index = 0);
+  image<RGB32F> readTonemapped(unsigned int index = 0);
+  image<RGB32F> readBrightpass(unsigned int index = 0);
+  image<RGB32F> readBlurred(unsigned int index = 0);
+
+  image<RGB32F> readOutput(unsigned int index = 0);
+  // enqueues a copy of the composed images to dest, which may be host or
+  // device memory, cf. consumeAsync(). dest receives batch * width * height
+  // pixels in the output format, output_pixel_size(getStorage()) bytes each.
+  // planar output is copied as is, one plane after the other.
+  void readOutputAsync(void *dest);
+
+  // enqueues a copy of image index of the batch to dest without allocating
+  // or waiting, cf. readOutputAsync(). the image is copied as stored: floats
+  // for the luminance images, intermediate_pixel_size(getStorage()) or
+  // output_pixel_size(getStorage()) bytes per pixel for the others, planar
+  // images one plane after the other. the downsample image is built on the
+  // way and has (width + 1) / 2 by (height + 1) / 2 pixels. all images but
+  // the output need debug mode.
+  void readAsync(HDRImage image, void *dest, unsigned int index = 0);
+  // the same converted to 8 bit RGBA where the pipeline runs, see
+  // srgb8_table(). the luminance images become gray, planar images are
+  // interleaved. dest receives one RGBA8 per pixel.
+  void readSRGBAsync(HDRImage image, RGBA8 *dest, unsigned int index = 0);
 };
 
 #endif // INCLUDED_HDRPIPELINE
@@ -0,0 +1,188 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include "HDRTiledPipeline.h"
+
+namespace {
+// tiles start at multiples of this, so the pyramid levels of a tile line up
+// with those of the whole image
+unsigned int tile_alignment(const BloomSettings &bloom) {
+  return 1U << bloom.levels;
+}
+
+unsigned int align_tile(unsigned int tile_size, const BloomSettings &bloom) {
+  const unsigned int alignment = tile_alignment(bloom);
+  return std::max((tile_size + alignment - 1) / alignment * alignment,
+                  alignment);
+}
+} // namespace
+
+HDRTiledPipeline::HDRTiledPipeline(unsigned int tile_size, HDRStorage storage,
+                                   const BloomSettings &bloom)
+    : storage(storage), bloom(bloom), tile_size(align_tile(tile_size, bloom)),
+      halo(bloom_halo(bloom)) {}
+
+HDRTiledPipeline::HDRTiledPipeline(unsigned int tile_size,
+                                   cudaStream_t stream, HDRStorage storage,
+                                   const BloomSettings &bloom)
+    : HDRTiledPipeline(tile_size, storage, bloom) {
+  // sized for the largest tile once the bloom is set, smaller ones reuse its
+  // buffers. the default bloom needs more memory than a pyramid, so sizing
+  // it first would allocate more than tileSizeFor() plans for.
+  const unsigned int extent = this->tile_size + 2 * halo;
+  pipeline.reset(new HDRPipeline(1, 1, stream, HDRMode::fused, storage));
+  pipeline->configureBloom(bloom);
+  pipeline->reconfigure(extent, extent);
+}
+
+HDRTiledPipeline::HDRTiledPipeline(unsigned int tile_size,
+                                   HostExecutor &executor, HDRStorage storage,
+                                   const BloomSettings &bloom)
+    : HDRTiledPipeline(tile_size, storage, bloom) {
+  const unsigned int extent = this->tile_size + 2 * halo;
+  pipeline.reset(new HDRPipeline(1, 1, executor, HDRMode::fused, storage));
+  pipeline->configureBloom(bloom);
+  pipeline->reconfigure(extent, extent);
+}
+
+unsigned int HDRTiledPipeline::tileSizeFor(std::size_t budget,
+                                           HDRBackend backend,
+                                           HDRStorage storage,
+                                           const BloomSettings &bloom) {
+  const unsigned int alignment = tile_alignment(bloom);
+  const unsigned int halo = bloom_halo(bloom);
+  auto fits = [&](unsigned int steps) {
+    const unsigned int extent = steps * alignment + 2 * halo;
+    return HDRPipeline::memoryRequired(extent, extent, backend,
+                                       HDRMode::fused, storage,
+                                       HDRLayout::interleaved,
+                                       bloom) <= budget;
+  };
+
+  if (!fits(1))
+    throw std::invalid_argument("the memory budget is too small for a tile");
+  // binary search for the largest number of alignment steps that fits
+  unsigned int lo = 1;
+  unsigned int hi = 2;
+  while (hi < (1U << 16) && fits(hi))
+    lo = hi, hi *= 2;
+  while (hi - lo > 1) {
+    const unsigned int mid = lo + (hi - lo) / 2;
+    (fits(mid) ? lo : hi) = mid;
+  }
+  return lo * alignment;
+}
+
+void HDRTiledPipeline::consumeTile(const image_view<const RGB32F> &input,
+                                   std::size_t x, std::size_t y,
+                                   unsigned int tile_width,
+                                   unsigned int tile_height) {
+  // reconfigure() waits for the previous tile and clears the buffers, only
+  // pay for it where the tile size changes at the image borders
+  if (tile_width != pipeline->getWidth() ||
+      tile_height != pipeline->getHeight())
+    pipeline->reconfigure(tile_width, tile_height);
+
+  pipeline->consume(subview(input, x, y, tile_width, tile_height));
+}
+
+LuminanceStats HDRTiledPipeline::statistics(const float *input,
+                                            std::size_t width,
+                                            std::size_t height) {
+  if (width == 0 || height == 0)
+    throw std::invalid_argument("cannot reduce an empty image");
+
+  const image_view<const RGB32F> input_view(
+      reinterpret_cast<const RGB32F *>(input), width, height);
+  // no halo is needed here, so the tiles take up the whole pipeline
+  const std::size_t extent = tile_size + 2 * halo;
+  double sum = 0.0;
+  double log_sum = 0.0;
+  for (std::size_t y = 0; y < height; y += extent)
+    for (std::size_t x = 0; x < width; x += extent) {
+      const auto w = static_cast<unsigned int>(std::min(extent, width - x));
+      const auto h = static_cast<unsigned int>(std::min(extent, height - y));
+      consumeTile(input_view, x, y, w, h);
+      pipeline->computeStatistics();
+      const LuminanceStats tile = pipeline->luminanceStatistics();
+      const double pixels = static_cast<double>(w) * h;
+      sum += tile.average * pixels;
+      log_sum += std::log(tile.log_average) * pixels;
+    }
+
+  const double pixels = double(width) * double(height);
+  return {static_cast<float>(sum / pixels),
+          static_cast<float>(std::exp(log_sum / pixels))};
+}
+
+void HDRTiledPipeline::process(void *output, const float *input,
+                               std::size_t width, std::size_t height,
+                               float exposure, float brightpass_threshold) {
+  process(output, input, width, height, statistics(input, width, height),
+          exposure, brightpass_threshold);
+}
+
+void HDRTiledPipeline::process(void *output, const float *input,
+                               std::size_t width, std::size_t height,
+                               const LuminanceStats &stats, float exposure,
+                               float brightpass_threshold) {
+  const std::size_t pixel_size = output_pixel_size(storage);
+  auto dest = static_cast<unsigned char *>(output);
+  const image_view<const RGB32F> input_view(
+      reinterpret_cast<const RGB32F *>(input), width, height);
+
+  for (std::size_t y = 0; y < height; y += tile_size)
+    for (std::size_t x = 0; x < width; x += tile_size) {
+      // the tile grown by the halo and clipped to the image. the bloom counts
+      // pixels outside the tile as black, which is right at the image border
+      // and out of reach of the inner part everywhere else.
+      const std::size_t x0 = x - std::min<std::size_t>(x, halo);
+      const std::size_t y0 = y - std::min<std::size_t>(y, halo);
+      const std::size_t x1 = std::min(x + tile_size + halo, width);
+      const std::size_t y1 = std::min(y + tile_size + halo, height);
+      const auto w = static_cast<unsigned int>(x1 - x0);
+      const auto h = static_cast<unsigned int>(y1 - y0);
+      consumeTile(input_view, x0, y0, w, h);
+      pipeline->run(exposure, brightpass_threshold, stats);
+
+      tile_output.resize(std::size_t{w} * h * pixel_size);
+      pipeline->readOutputAsync(tile_output.data());
+      pipeline->synchronize();
+
+      const std::size_t inner_width = std::min<std::size_t>(tile_size,
+                                                            width - x);
+      const std::size_t inner_height = std::min<std::size_t>(tile_size,
+                                                             height - y);
+      for (std::size_t r = 0; r < inner_height; ++r)
+        std::memcpy(dest + ((y + r) * width + x) * pixel_size,
+                    tile_output.data() +
+                        ((y - y0 + r) * w + (x - x0)) * pixel_size,
+                    inner_width * pixel_size);
+    }
+}
@@ -0,0 +1,111 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef INCLUDED_HDR_TILED_PIPELINE
+#define INCLUDED_HDR_TILED_PIPELINE
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <cuda_runtime_api.h>
+
+#include "calculators/cuda/hdr/HDRPipeline.h"
+#include "calculators/cuda/hdr/framework/host_executor.h"
+
+// processes host images of any size through one HDRPipeline sized for a
+// single tile, so the memory used is bounded by the tile size and not by the
+// image size. a first pass reduces the image tile by tile to the luminance
+// statistics of the whole image. the second runs every tile together with a
+// halo of bloom_halo() pixels on each side through the fused passes and keeps
+// the inner part, so the tiles stitch without seams. tiles are cut at
+// multiples of 2^levels of the bloom pyramid.
+class HDRTiledPipeline {
+  const HDRStorage storage;
+  const BloomSettings bloom;
+  const unsigned int tile_size;
+  const unsigned int halo;
+
+  std::unique_ptr<HDRPipeline> pipeline;
+  // host copy of the output of the tile being processed
+  std::vector<unsigned char> tile_output;
+
+  HDRTiledPipeline(unsigned int tile_size, HDRStorage storage,
+                   const BloomSettings &bloom);
+
+  // sizes the pipeline for the tile and copies its rows there straight from
+  // the image
+  void consumeTile(const image_view<const RGB32F> &input, std::size_t x,
+                   std::size_t y, unsigned int tile_width,
+                   unsigned int tile_height);
+
+public:
+  // CUDA backend on the given stream. tile_size is the edge of the square
+  // tiles without the halo, rounded up to a multiple of 2^bloom.levels.
+  HDRTiledPipeline(unsigned int tile_size, cudaStream_t stream,
+                   HDRStorage storage = HDRStorage::fp32,
+                   const BloomSettings &bloom = BloomSettings());
+  // CPU backend on the given executor
+  HDRTiledPipeline(unsigned int tile_size, HostExecutor &executor,
+                   HDRStorage storage = HDRStorage::fp32,
+                   const BloomSettings &bloom = BloomSettings());
+
+  // largest tile size whose pipeline fits into budget bytes, throws
+  // std::invalid_argument if not even the smallest tile does
+  static unsigned int tileSizeFor(std::size_t budget, HDRBackend backend,
+                                  HDRStorage storage,
+                                  const BloomSettings &bloom = BloomSettings());
+
+  unsigned int getTileSize() const { return tile_size; }
+  unsigned int getHalo() const { return halo; }
+  HDRStorage getStorage() const { return storage; }
+
+  // buffers of the pipeline, the host copies of the tile come on top
+  const MemoryArena &memory() const { return pipeline->memory(); }
+
+  // tonemap operator of every tile, see HDRPipeline::configureTonemap()
+  void configureTonemap(const TonemapSettings &settings) {
+    pipeline->configureTonemap(settings);
+  }
+  const TonemapSettings &getTonemap() const { return pipeline->getTonemap(); }
+
+  // luminance statistics of the interleaved RGB image input, reduced tile by
+  // tile and combined weighted by the pixels of every tile
+  LuminanceStats statistics(const float *input, std::size_t width,
+                            std::size_t height);
+
+  // tonemaps and blooms input like HDRPipeline::run() would. output receives
+  // width * height pixels in the output format, output_pixel_size(storage)
+  // bytes each. blocks until the last tile is written.
+  void process(void *output, const float *input, std::size_t width,
+               std::size_t height, float exposure, float brightpass_threshold);
+  // same with statistics from an earlier statistics() call
+  void process(void *output, const float *input, std::size_t width,
+               std::size_t height, const LuminanceStats &stats, float exposure,
+               float brightpass_threshold);
+};
+
+#endif // INCLUDED_HDR_TILED_PIPELINE
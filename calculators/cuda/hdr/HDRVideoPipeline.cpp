@@ -0,0 +1,274 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#include <clim/aligned_malloc.h>
+#include <framework/CUDA/error.h>
+
+#include "HDRVideoPipeline.h"
+
+namespace {
+constexpr std::size_t host_alignment = 64U;
+
+cuda_stream createStream() {
+  cudaStream_t stream;
+  throw_error(cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking));
+  return cuda_stream(stream);
+}
+
+cuda_event createEvent() {
+  cudaEvent_t event;
+  throw_error(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+  return cuda_event(event);
+}
+
+double milliseconds(std::chrono::steady_clock::duration d) {
+  return std::chrono::duration<double, std::milli>(d).count();
+}
+} // namespace
+
+void FrameBufferDeleter::operator()(float *ptr) const {
+  switch (memory) {
+  case Memory::device:
+    cudaFree(ptr);
+    break;
+  case Memory::pinned:
+    cudaFreeHost(ptr);
+    break;
+  case Memory::host:
+    aligned_free(ptr);
+    break;
+  }
+}
+
+frame_buffer HDRVideoPipeline::allocate(FrameBufferDeleter::Memory memory) {
+  void *ptr = nullptr;
+  switch (memory) {
+  case FrameBufferDeleter::Memory::device:
+    throw_error(cudaMalloc(&ptr, frameSize()));
+    break;
+  case FrameBufferDeleter::Memory::pinned:
+    throw_error(cudaMallocHost(&ptr, frameSize()));
+    break;
+  case FrameBufferDeleter::Memory::host:
+    ptr = aligned_malloc<void *>(frameSize(), host_alignment);
+    if (!ptr)
+      throw std::bad_alloc();
+    break;
+  }
+  return frame_buffer(static_cast<float *>(ptr), {memory});
+}
+
+HDRVideoPipeline::HDRVideoPipeline(unsigned int width, unsigned int height,
+                                   HDRBackend backend, float exposure,
+                                   float brightpass_threshold,
+                                   unsigned int frames_in_flight, HDRMode mode,
+                                   const BloomSettings &bloom,
+                                   const TonemapSettings &tonemap)
+    : width(width), height(height), backend(backend), exposure(exposure),
+      brightpass_threshold(brightpass_threshold) {
+  if (frames_in_flight == 0)
+    throw std::invalid_argument("video pipeline needs at least one slot");
+
+  using Memory = FrameBufferDeleter::Memory;
+  Memory staging = Memory::host;
+  Memory resident = Memory::host;
+
+  if (backend == HDRBackend::cuda) {
+    upload_stream = createStream();
+    compute_stream = createStream();
+    download_stream = createStream();
+    pipeline = std::make_unique<HDRPipeline>(width, height,
+                                             compute_stream.get(), mode);
+    staging = Memory::pinned;
+    resident = Memory::device;
+  } else {
+    upload_executor = std::make_unique<HostExecutor>();
+    compute_executor = std::make_unique<HostExecutor>();
+    download_executor = std::make_unique<HostExecutor>();
+    pipeline =
+        std::make_unique<HDRPipeline>(width, height, *compute_executor, mode);
+  }
+  pipeline->configureBloom(bloom);
+  pipeline->configureTonemap(tonemap);
+
+  for (unsigned int i = 0; i < frames_in_flight; ++i) {
+    auto slot = std::make_unique<Slot>();
+    slot->staging_in = allocate(staging);
+    slot->input = allocate(resident);
+    slot->output = allocate(resident);
+    slot->staging_out = allocate(staging);
+    if (backend == HDRBackend::cuda) {
+      slot->uploaded = createEvent();
+      slot->processed = createEvent();
+      slot->downloaded = createEvent();
+    }
+    slots.push_back(std::move(slot));
+  }
+}
+
+HDRVideoPipeline::~HDRVideoPipeline() {
+  // the queues may still be working on slot buffers, drain them before
+  // anything is freed
+  if (backend == HDRBackend::cuda) {
+    cudaStreamSynchronize(upload_stream.get());
+    cudaStreamSynchronize(compute_stream.get());
+    cudaStreamSynchronize(download_stream.get());
+  } else {
+    for (HostExecutor *executor : {upload_executor.get(),
+                                   compute_executor.get(),
+                                   download_executor.get()}) {
+      try {
+        executor->synchronize();
+      } catch (...) {
+      }
+    }
+  }
+}
+
+bool HDRVideoPipeline::submit(const float *frame) {
+  if (in_flight == slots.size())
+    return false;
+
+  Slot &slot = *slots[(oldest + in_flight) % slots.size()];
+  const std::size_t size = frameSize();
+
+  // a slot is only reused after its frame has been retrieved, so none of its
+  // buffers is in use anymore
+  std::memcpy(slot.staging_in.get(), frame, size);
+  slot.submitted = std::chrono::steady_clock::now();
+  if (frames_retrieved == 0 && in_flight == 0)
+    first_submit = slot.submitted;
+
+  float *staging_in = slot.staging_in.get();
+  float *input = slot.input.get();
+  float *output = slot.output.get();
+  float *staging_out = slot.staging_out.get();
+
+  // upload
+  if (backend == HDRBackend::cuda) {
+    throw_error(cudaMemcpyAsync(input, staging_in, size, cudaMemcpyHostToDevice,
+                                upload_stream.get()));
+    throw_error(cudaEventRecord(slot.uploaded.get(), upload_stream.get()));
+    throw_error(
+        cudaStreamWaitEvent(compute_stream.get(), slot.uploaded.get(), 0));
+  } else {
+    upload_executor->enqueue(
+        [=] { std::memcpy(input, staging_in, size); });
+    slot.host_uploaded.record(*upload_executor);
+    slot.host_uploaded.wait(*compute_executor);
+  }
+
+  // process, the exposure never leaves the compute queue
+  pipeline->consumeAsync(input);
+  pipeline->run(exposure, brightpass_threshold);
+  pipeline->readOutputAsync(output);
+
+  // download
+  if (backend == HDRBackend::cuda) {
+    throw_error(cudaEventRecord(slot.processed.get(), compute_stream.get()));
+    throw_error(
+        cudaStreamWaitEvent(download_stream.get(), slot.processed.get(), 0));
+    throw_error(cudaMemcpyAsync(staging_out, output, size,
+                                cudaMemcpyDeviceToHost, download_stream.get()));
+    throw_error(cudaEventRecord(slot.downloaded.get(), download_stream.get()));
+  } else {
+    slot.host_processed.record(*compute_executor);
+    slot.host_processed.wait(*download_executor);
+    download_executor->enqueue(
+        [=] { std::memcpy(staging_out, output, size); });
+    slot.host_downloaded.record(*download_executor);
+  }
+
+  ++in_flight;
+  return true;
+}
+
+bool HDRVideoPipeline::finished(Slot &slot) {
+  if (backend == HDRBackend::cuda) {
+    cudaError err = cudaEventQuery(slot.downloaded.get());
+    if (err == cudaErrorNotReady)
+      return false;
+    throw_error(err);
+    return true;
+  }
+
+  if (!slot.host_downloaded.query())
+    return false;
+  upload_executor->check();
+  compute_executor->check();
+  download_executor->check();
+  return true;
+}
+
+void HDRVideoPipeline::retire(float *output) {
+  Slot &slot = *slots[oldest];
+  std::memcpy(output, slot.staging_out.get(), frameSize());
+
+  last_retrieve = std::chrono::steady_clock::now();
+  const double latency = milliseconds(last_retrieve - slot.submitted);
+  latency_sum_ms += latency;
+  latency_max_ms = std::max(latency_max_ms, latency);
+  ++frames_retrieved;
+
+  oldest = (oldest + 1) % slots.size();
+  --in_flight;
+}
+
+bool HDRVideoPipeline::poll(float *output) {
+  if (in_flight == 0 || !finished(*slots[oldest]))
+    return false;
+  retire(output);
+  return true;
+}
+
+bool HDRVideoPipeline::retrieve(float *output) {
+  if (in_flight == 0)
+    return false;
+
+  Slot &slot = *slots[oldest];
+  if (backend == HDRBackend::cuda)
+    throw_error(cudaEventSynchronize(slot.downloaded.get()));
+  else
+    slot.host_downloaded.synchronize();
+  finished(slot);
+  retire(output);
+  return true;
+}
+
+VideoPipelineStats HDRVideoPipeline::statistics() const {
+  VideoPipelineStats stats = {frames_retrieved, 0.0, latency_max_ms, 0.0};
+  if (frames_retrieved == 0)
+    return stats;
+
+  stats.average_latency_ms = latency_sum_ms / frames_retrieved;
+  const double elapsed = milliseconds(last_retrieve - first_submit);
+  if (elapsed > 0.0)
+    stats.throughput_fps = frames_retrieved * 1000.0 / elapsed;
+  return stats;
+}
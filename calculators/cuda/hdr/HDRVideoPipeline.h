@@ -0,0 +1,157 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef INCLUDED_HDR_VIDEO_PIPELINE
+#define INCLUDED_HDR_VIDEO_PIPELINE
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <cuda_runtime_api.h>
+
+#include "calculators/cuda/hdr/HDRPipeline.h"
+#include "calculators/cuda/hdr/framework/host_executor.h"
+
+struct cudaStreamDeleter {
+  void operator()(cudaStream_t stream) const { cudaStreamDestroy(stream); }
+};
+
+struct cudaEventDeleter {
+  void operator()(cudaEvent_t event) const { cudaEventDestroy(event); }
+};
+
+using cuda_stream = std::unique_ptr<CUstream_st, cudaStreamDeleter>;
+using cuda_event = std::unique_ptr<CUevent_st, cudaEventDeleter>;
+
+// frees the frame buffers of the video pipeline
+struct FrameBufferDeleter {
+  enum class Memory { device, pinned, host } memory;
+  void operator()(float *ptr) const;
+};
+
+using frame_buffer = std::unique_ptr<float, FrameBufferDeleter>;
+
+struct VideoPipelineStats {
+  std::uint64_t frames;      // frames retrieved so far
+  double average_latency_ms; // from submit() to the frame being retrieved
+  double max_latency_ms;
+  double throughput_fps; // frames over the time since the first submit()
+};
+
+// runs a sequence of frames through an HDRPipeline with up to
+// frames_in_flight frames in the pipe. every frame is uploaded, processed and
+// downloaded on a queue of its own, so the upload of frame N+1, the
+// processing of frame N and the download of frame N-1 overlap. the CUDA
+// backend uses three streams and pinned staging buffers, the CPU backend
+// three host executors with the same dependencies between them.
+class HDRVideoPipeline {
+  // one entry of the frame ring
+  struct Slot {
+    frame_buffer staging_in;  // host side of the upload
+    frame_buffer input;       // uploaded frame
+    frame_buffer output;      // processed frame
+    frame_buffer staging_out; // host side of the download
+
+    cuda_event uploaded;
+    cuda_event processed;
+    cuda_event downloaded;
+    HostEvent host_uploaded;
+    HostEvent host_processed;
+    HostEvent host_downloaded;
+
+    std::chrono::steady_clock::time_point submitted;
+  };
+
+  const unsigned int width;
+  const unsigned int height;
+  const HDRBackend backend;
+  const float exposure;
+  const float brightpass_threshold;
+
+  cuda_stream upload_stream;
+  cuda_stream compute_stream;
+  cuda_stream download_stream;
+  std::unique_ptr<HostExecutor> upload_executor;
+  std::unique_ptr<HostExecutor> compute_executor;
+  std::unique_ptr<HostExecutor> download_executor;
+
+  std::unique_ptr<HDRPipeline> pipeline;
+  std::vector<std::unique_ptr<Slot>> slots;
+  std::size_t oldest = 0; // slot of the oldest frame in flight
+  std::size_t in_flight = 0;
+
+  std::chrono::steady_clock::time_point first_submit;
+  std::chrono::steady_clock::time_point last_retrieve;
+  std::uint64_t frames_retrieved = 0;
+  double latency_sum_ms = 0.0;
+  double latency_max_ms = 0.0;
+
+  std::size_t frameSize() const {
+    return std::size_t{width} * height * 3 * sizeof(float);
+  }
+  frame_buffer allocate(FrameBufferDeleter::Memory memory);
+  bool finished(Slot &slot);
+  void retire(float *output);
+
+public:
+  // exposure and brightpass_threshold are applied to every frame, exposure is
+  // divided by the average luminance of the frame on the device. frames are
+  // processed by HDRPipeline::run() in the given mode.
+  HDRVideoPipeline(unsigned int width, unsigned int height, HDRBackend backend,
+                   float exposure, float brightpass_threshold,
+                   unsigned int frames_in_flight = 3,
+                   HDRMode mode = HDRMode::fused,
+                   const BloomSettings &bloom = BloomSettings(),
+                   const TonemapSettings &tonemap = TonemapSettings());
+  ~HDRVideoPipeline();
+
+  HDRVideoPipeline(const HDRVideoPipeline &) = delete;
+  HDRVideoPipeline &operator=(const HDRVideoPipeline &) = delete;
+
+  std::size_t capacity() const { return slots.size(); }
+  std::size_t framesInFlight() const { return in_flight; }
+
+  // copies the interleaved RGB frame into the ring and enqueues its upload,
+  // processing and download. returns false without doing anything if all
+  // frames_in_flight slots are taken, retrieve a frame with poll() first.
+  bool submit(const float *frame);
+
+  // writes the oldest frame in flight to output if it has been downloaded
+  // already, frames come out in submission order. never blocks, returns
+  // false if there is no such frame yet.
+  bool poll(float *output);
+
+  // like poll(), but waits for the oldest frame. returns false only if no
+  // frame is in flight at all.
+  bool retrieve(float *output);
+
+  VideoPipelineStats statistics() const;
+};
+
+#endif // INCLUDED_HDR_VIDEO_PIPELINE
@@ -0,0 +1,116 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <cstddef>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "calculators/cuda/hdr/HDRPipeline.h"
+#include "calculators/cuda/hdr/framework/host_executor.h"
+#include "calculators/cuda/hdr/memory_arena.h"
+
+namespace {
+std::size_t required(unsigned int width, unsigned int height) {
+  return HDRPipeline::memoryRequired(width, height, HDRBackend::cpu,
+                                     HDRMode::debug, HDRStorage::fp32);
+}
+} // namespace
+
+TEST(ArenaLayout, AlignsEveryBuffer) {
+  ArenaLayout layout;
+  EXPECT_EQ(layout.add(1), 0U);
+  EXPECT_EQ(layout.add(0), MemoryArena::alignment);
+  EXPECT_EQ(layout.add(MemoryArena::alignment + 1), MemoryArena::alignment);
+  EXPECT_EQ(layout.size(), 3 * MemoryArena::alignment);
+}
+
+TEST(MemoryArena, HostReusesTheBlockUntilItGrows) {
+  HostArena arena;
+  EXPECT_EQ(arena.allocations(), 0U);
+  EXPECT_EQ(arena.capacity(), 0U);
+
+  void *block = arena.reserve(1000);
+  EXPECT_EQ(arena.allocations(), 1U);
+  EXPECT_EQ(arena.capacity(), 1000U);
+  EXPECT_EQ(arena.peak(), 1000U);
+
+  // shrinking and growing back within the capacity keeps the block
+  EXPECT_EQ(arena.reserve(400), block);
+  EXPECT_EQ(arena.used(), 400U);
+  EXPECT_EQ(arena.reserve(1000), block);
+  EXPECT_EQ(arena.allocations(), 1U);
+  EXPECT_EQ(arena.capacity(), 1000U);
+
+  arena.reserve(3000);
+  EXPECT_EQ(arena.allocations(), 2U);
+  EXPECT_EQ(arena.capacity(), 3000U);
+  EXPECT_EQ(arena.peak(), 3000U);
+
+  arena.reserve(500);
+  arena.shrinkToFit();
+  EXPECT_EQ(arena.allocations(), 3U);
+  EXPECT_EQ(arena.capacity(), 500U);
+  EXPECT_EQ(arena.peak(), 3000U);
+  arena.shrinkToFit();
+  EXPECT_EQ(arena.allocations(), 3U);
+}
+
+TEST(MemoryArena, CpuPipelineReusesTheBlockAcrossReconfigure) {
+  HostExecutor executor;
+  HDRPipeline pipeline(640, 480, executor);
+  const MemoryArena &memory = pipeline.memory();
+  EXPECT_EQ(memory.allocations(), 1U);
+  EXPECT_EQ(memory.used(), required(640, 480));
+  EXPECT_EQ(memory.capacity(), required(640, 480));
+
+  // smaller frames and the first size again fit the block
+  for (unsigned int size : {320U, 17U, 640U, 100U}) {
+    pipeline.reconfigure(size, size * 3 / 4);
+    EXPECT_EQ(memory.allocations(), 1U) << size;
+    EXPECT_EQ(memory.used(), required(size, size * 3 / 4)) << size;
+    EXPECT_EQ(memory.capacity(), required(640, 480)) << size;
+    EXPECT_EQ(memory.peak(), required(640, 480)) << size;
+  }
+
+  // a larger one reallocates once, shrinking again keeps the larger block
+  pipeline.reconfigure(1280, 720);
+  EXPECT_EQ(memory.allocations(), 2U);
+  EXPECT_EQ(memory.capacity(), required(1280, 720));
+  EXPECT_EQ(memory.peak(), required(1280, 720));
+  pipeline.reconfigure(640, 480);
+  pipeline.reconfigure(1280, 720);
+  EXPECT_EQ(memory.allocations(), 2U);
+  EXPECT_EQ(memory.capacity(), required(1280, 720));
+  EXPECT_EQ(memory.used(), required(1280, 720));
+
+  // the pipeline still works at the size carved out of the larger block
+  pipeline.reconfigure(33, 21);
+  const std::vector<float> input(33 * 21 * 3, 0.5f);
+  pipeline.consume(input.data());
+  pipeline.run(1.0f, 0.8f);
+  const image<RGB32F> output = pipeline.readOutput();
+  EXPECT_EQ(width(output), 33U);
+  EXPECT_EQ(height(output), 21U);
+  EXPECT_EQ(memory.allocations(), 2U);
+}
@@ -0,0 +1,189 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// images per second of the batched pipeline for growing batch sizes on
+// synthetic input, on the CPU backend or with --cuda on the device. small
+// images leave most of the machine idle one at a time, a batch fills it.
+
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <cuda_runtime_api.h>
+
+#include "calculators/cuda/hdr/framework/CUDA/error.h"
+#include "calculators/cuda/hdr/framework/cmd_args.h"
+#include "calculators/cuda/hdr/framework/host_executor.h"
+
+#include "calculators/cuda/hdr/HDRPipeline.h"
+
+namespace {
+// average milliseconds for consume(), run() and reading the outputs of the
+// whole batch
+double benchmark(HDRPipeline &pipeline, const std::vector<float> &input,
+                 std::vector<unsigned char> &output, int runs) {
+  const float exposure = 1.0f;
+  const float brightpass_threshold = 0.9f;
+
+  auto iteration = [&] {
+    pipeline.consumeAsync(input.data());
+    pipeline.run(exposure, brightpass_threshold);
+    pipeline.readOutputAsync(output.data());
+  };
+
+  // one untimed run warms up the caches, the thread pool and the device
+  iteration();
+  pipeline.synchronize();
+
+  const auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < runs; ++i)
+    iteration();
+  pipeline.synchronize();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - begin)
+             .count() /
+         runs;
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  try {
+    int image_width = 640;
+    int image_height = 480;
+    int runs = 20;
+    int max_batch = 32;
+    int bloom_levels = 0;
+    bool fused = false;
+    bool cuda = false;
+    int cuda_device = 0;
+
+    for (char **a = &argv[1]; *a; ++a) {
+      const bool option = checkArgument("--width", a, image_width) ||
+                          checkArgument("--height", a, image_height) ||
+                          checkArgument("--runs", a, runs) ||
+                          checkArgument("--max-batch", a, max_batch) ||
+                          checkArgument("--bloom-levels", a, bloom_levels) ||
+                          checkArgument("--fused", a, fused) ||
+                          checkArgument("--cuda", a, cuda) ||
+                          checkArgument("--device", a, cuda_device);
+      if (!option)
+        throw usage_error("unknown argument");
+    }
+
+    if (image_width < 1 || image_height < 1 || runs < 1 || max_batch < 1)
+      throw usage_error("width, height, runs and batch must be positive");
+    if (bloom_levels < 0 || bloom_levels > static_cast<int>(max_bloom_levels))
+      throw usage_error("bloom levels out of range");
+
+    const auto width = static_cast<unsigned int>(image_width);
+    const auto height = static_cast<unsigned int>(image_height);
+    const std::size_t pixels = std::size_t{width} * height;
+    const HDRMode mode = fused ? HDRMode::fused : HDRMode::debug;
+    BloomSettings bloom;
+    bloom.levels = static_cast<unsigned int>(bloom_levels);
+
+    // every image of the batch is a differently scaled gradient with a few
+    // bright spots, so each has its own exposure
+    const auto batch_limit = static_cast<unsigned int>(max_batch);
+    std::vector<float> input(3 * pixels * batch_limit);
+    for (unsigned int b = 0; b < batch_limit; ++b) {
+      const float scale = 1.0f + 0.25f * (b % 8);
+      float *image = input.data() + 3 * pixels * b;
+      for (std::size_t i = 0; i < pixels; ++i) {
+        const float x = static_cast<float>(i % width) / width;
+        const float y = static_cast<float>(i / width) / height;
+        const float spot = (i % 997 == 0) ? 50.0f : 0.0f;
+        image[3 * i + 0] = scale * 4.0f * x + spot;
+        image[3 * i + 1] = scale * 4.0f * y + spot;
+        image[3 * i + 2] = scale * 2.0f * (x + y) + spot;
+      }
+    }
+    std::vector<unsigned char> output(pixels * batch_limit *
+                                      output_pixel_size(HDRStorage::fp32));
+
+    std::cout << (cuda ? "cuda" : "cpu") << " backend, "
+              << (fused ? "fused" : "debug") << " mode, " << width << "x"
+              << height << ", " << runs << " runs\n"
+              << "batch        time      images/s     speedup\n"
+              << std::fixed << std::setprecision(2);
+
+    auto sweep = [&](HDRPipeline &pipeline) {
+      pipeline.configureBloom(bloom);
+      double single = 0.0;
+      for (unsigned int batch = 1; batch <= batch_limit; batch *= 2) {
+        pipeline.configureBatch(batch);
+        const double ms = benchmark(pipeline, input, output, runs);
+        const double rate = batch * 1000.0 / ms;
+        if (batch == 1)
+          single = rate;
+        std::cout << std::setw(5) << batch << std::setw(10) << ms << " ms"
+                  << std::setw(14) << rate << std::setw(11) << rate / single
+                  << "x\n";
+      }
+    };
+
+    if (cuda) {
+      throw_error(cudaSetDevice(cuda_device));
+      cudaStream_t stream;
+      throw_error(cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking));
+      {
+        HDRPipeline pipeline(width, height, stream, mode);
+        sweep(pipeline);
+      }
+      throw_error(cudaStreamDestroy(stream));
+    } else {
+      HostExecutor executor;
+      HDRPipeline pipeline(width, height, executor, mode);
+      sweep(pipeline);
+    }
+  } catch (const usage_error &e) {
+    std::cout << "error: " << e.what() << std::endl;
+    std::cout << "usage: batch_benchmark {options}\n"
+                 "\toptions:\n"
+                 "\t  --width <w>            image width, default: 640\n"
+                 "\t  --height <h>           image height, default: 480\n"
+                 "\t  --runs <N>             average over <N> runs, "
+                 "default: 20\n"
+                 "\t  --max-batch <n>        double the batch up to <n> "
+                 "images, default: 32\n"
+                 "\t  --bloom-levels <n>     blur the bloom on <n> downsampled "
+                 "levels, default: 0\n"
+                 "\t  --fused                time the fused pipeline\n"
+                 "\t  --cuda                 run on the device instead of the "
+                 "cpu\n"
+                 "\t  --device <i>           use cuda device <i>, default: 0\n";
+    return -127;
+  } catch (std::exception &e) {
+    std::cout << "error: " << e.what() << std::endl;
+    return -1;
+  } catch (...) {
+    std::cout << "unknown exception" << std::endl;
+    return -128;
+  }
+
+  return 0;
+}
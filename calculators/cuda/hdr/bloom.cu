@@ -0,0 +1,321 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <cuda_runtime_api.h>
+
+#include "calculators/cuda/hdr/bloom.cuh"
+#include "calculators/cuda/hdr/storage.cuh"
+
+namespace {
+constexpr unsigned int divup(unsigned int a, unsigned int b) {
+  return (a + b - 1) / b;
+}
+
+// horizontal pass: a block blurs rows_tile_width pixels of rows_tile_rows
+// rows. every row of the tile plus the halo is one contiguous run of floats,
+// so the interleaved RGB data is loaded into shared memory with coalesced
+// reads instead of stride-3 accesses.
+constexpr unsigned int rows_tile_width = 128U;
+constexpr unsigned int rows_tile_rows = 4U;
+
+// vertical pass: a block covers columns_tile_floats floats of a row, one
+// thread each, and columns_tile_rows output rows. every thread computes
+// columns_tile_rows / columns_block_rows of them from the cached column.
+constexpr unsigned int columns_tile_floats = 96U;
+constexpr unsigned int columns_tile_rows = 32U;
+constexpr unsigned int columns_block_rows = 4U;
+} // namespace
+
+// the kernels work on images with C floats per pixel: interleaved RGB in any
+// HDRStorage format for C = 3, or the planes of a planar float image for
+// C = 1. the grid has a depth of batch * 3 / C, blockIdx.z selects the image
+// of a batch or the plane of a planar image. either way the slice starts
+// blockIdx.z * C * width * height floats into every image involved.
+
+// in elements of the image, which are floats or whole RGB16F pixels
+template <unsigned int C>
+__device__ inline std::size_t slice_offset(const float *, unsigned int width,
+                                           unsigned int height) {
+  return std::size_t{blockIdx.z} * C * width * height;
+}
+
+template <unsigned int C>
+__device__ inline std::size_t slice_offset(const RGB16F *, unsigned int width,
+                                           unsigned int height) {
+  return std::size_t{blockIdx.z} * width * height;
+}
+
+template <unsigned int C, typename T>
+__global__ void blur_rows_kernel(float *dest, const T *src,
+                                 unsigned int width, unsigned int height,
+                                 BloomWeights weights) {
+  extern __shared__ float tile[];
+
+  dest += slice_offset<C>(dest, width, height);
+  src += slice_offset<C>(src, width, height);
+
+  const unsigned int r = weights.radius;
+  const unsigned int tile_floats = C * (rows_tile_width + 2 * r);
+  const unsigned int x0 = blockIdx.x * rows_tile_width;
+  const unsigned int y = blockIdx.y * rows_tile_rows + threadIdx.y;
+  float *row = tile + threadIdx.y * tile_floats;
+
+  // pixels outside the image count as black
+  const int first = C * (static_cast<int>(x0) - static_cast<int>(r));
+  for (unsigned int i = threadIdx.x; i < tile_floats; i += blockDim.x) {
+    int f = first + static_cast<int>(i);
+    row[i] = y < height && f >= 0 && f < static_cast<int>(C * width)
+                 ? load_channel(src, C * width * y + f)
+                 : 0.0f;
+  }
+  __syncthreads();
+
+  const unsigned int x = x0 + threadIdx.x;
+  if (x >= width || y >= height)
+    return;
+
+  float sum[C] = {};
+  for (unsigned int i = 0; i <= 2 * r; ++i)
+    for (unsigned int c = 0; c < C; ++c)
+      sum[c] += weights.w[i] * row[C * (threadIdx.x + i) + c];
+
+  for (unsigned int c = 0; c < C; ++c)
+    dest[C * (width * y + x) + c] = sum[c];
+}
+
+// coarser, if given, is the blurred level below, which is upsampled and added
+// on the way out
+template <unsigned int C, typename T>
+__global__ void blur_columns_kernel(T *dest, const float *src,
+                                    unsigned int width, unsigned int height,
+                                    BloomWeights weights, const float *coarser,
+                                    unsigned int coarser_width,
+                                    unsigned int coarser_height) {
+  extern __shared__ float tile[];
+
+  dest += slice_offset<C>(dest, width, height);
+  src += slice_offset<C>(src, width, height);
+  if (coarser)
+    coarser += slice_offset<C>(coarser, coarser_width, coarser_height);
+
+  const unsigned int r = weights.radius;
+  const unsigned int f = blockIdx.x * columns_tile_floats + threadIdx.x;
+  const int y0 = static_cast<int>(blockIdx.y * columns_tile_rows);
+
+  for (unsigned int i = threadIdx.y; i < columns_tile_rows + 2 * r;
+       i += blockDim.y) {
+    int y = y0 - static_cast<int>(r) + static_cast<int>(i);
+    tile[i * columns_tile_floats + threadIdx.x] =
+        y >= 0 && y < static_cast<int>(height) && f < C * width
+            ? __ldg(src + C * width * y + f)
+            : 0.0f;
+  }
+  __syncthreads();
+
+  if (f >= C * width)
+    return;
+
+  for (unsigned int k = threadIdx.y; k < columns_tile_rows; k += blockDim.y) {
+    const unsigned int y = y0 + k;
+    if (y >= height)
+      return;
+
+    float sum = 0.0f;
+    for (unsigned int i = 0; i <= 2 * r; ++i)
+      sum += weights.w[i] * tile[(k + i) * columns_tile_floats + threadIdx.x];
+
+    if (coarser)
+      sum += upsample_bilinear<C>(coarser, coarser_width, coarser_height,
+                                  f / C, y, f % C);
+    store_channel(dest, C * width * y + f, sum);
+  }
+}
+
+// 2x2 box filter, pixels of an odd last row or column are averaged with
+// fewer neighbours
+template <unsigned int C, typename T>
+__global__ void downsample_rgb_kernel(float *dest, const T *src,
+                                      unsigned int width,
+                                      unsigned int height) {
+  const unsigned int w = (width + 1) / 2;
+  const unsigned int h = (height + 1) / 2;
+  unsigned int x = blockIdx.x * blockDim.x + threadIdx.x;
+  unsigned int y = blockIdx.y * blockDim.y + threadIdx.y;
+
+  if (x >= w || y >= h)
+    return;
+
+  dest += slice_offset<C>(dest, w, h);
+  src += slice_offset<C>(src, width, height);
+
+  const unsigned int x1 = min(2 * x + 1, width - 1);
+  const unsigned int y1 = min(2 * y + 1, height - 1);
+  const float scale = 1.0f / ((x1 - 2 * x + 1) * (y1 - 2 * y + 1));
+  for (unsigned int c = 0; c < C; ++c) {
+    float sum = load_channel(src, C * (2 * y * width + 2 * x) + c);
+    if (x1 != 2 * x)
+      sum += load_channel(src, C * (2 * y * width + x1) + c);
+    if (y1 != 2 * y) {
+      sum += load_channel(src, C * (y1 * width + 2 * x) + c);
+      if (x1 != 2 * x)
+        sum += load_channel(src, C * (y1 * width + x1) + c);
+    }
+    dest[C * (y * w + x) + c] = sum * scale;
+  }
+}
+
+template <unsigned int C, typename T>
+__global__ void upsample_kernel(T *dest, const float *level1,
+                                unsigned int width, unsigned int height,
+                                unsigned int level1_width,
+                                unsigned int level1_height, float scale) {
+  unsigned int x = blockIdx.x * blockDim.x + threadIdx.x;
+  unsigned int y = blockIdx.y * blockDim.y + threadIdx.y;
+
+  dest += slice_offset<C>(dest, width, height);
+  level1 += slice_offset<C>(level1, level1_width, level1_height);
+
+  if (x < width && y < height)
+    for (unsigned int c = 0; c < C; ++c)
+      store_channel(dest, C * (y * width + x) + c,
+                    scale * upsample_bilinear<C>(level1, level1_width,
+                                                 level1_height, x, y, c));
+}
+
+namespace {
+template <unsigned int C, typename T>
+void blur(T *dest, float *temp, const T *src, unsigned int width,
+          unsigned int height, unsigned int batch, const BloomWeights &weights,
+          const float *coarser, unsigned int coarser_width,
+          unsigned int coarser_height, cudaStream_t stream) {
+  const unsigned int r = weights.radius;
+
+  const dim3 rows_block = {rows_tile_width, rows_tile_rows};
+  const dim3 rows_grid = {divup(width, rows_tile_width),
+                          divup(height, rows_tile_rows), batch * 3 / C};
+  const std::size_t rows_shared =
+      rows_tile_rows * C * (rows_tile_width + 2 * r) * sizeof(float);
+  blur_rows_kernel<C><<<rows_grid, rows_block, rows_shared, stream>>>(
+      temp, src, width, height, weights);
+
+  const dim3 columns_block = {columns_tile_floats, columns_block_rows};
+  const dim3 columns_grid = {divup(C * width, columns_tile_floats),
+                             divup(height, columns_tile_rows),
+                             batch * 3 / C};
+  const std::size_t columns_shared =
+      (columns_tile_rows + 2 * r) * columns_tile_floats * sizeof(float);
+  blur_columns_kernel<C>
+      <<<columns_grid, columns_block, columns_shared, stream>>>(
+          dest, temp, width, height, weights, coarser, coarser_width,
+          coarser_height);
+}
+
+template <unsigned int C, typename T>
+void downsample_rgb(float *dest, const T *src, unsigned int width,
+                    unsigned int height, unsigned int batch,
+                    cudaStream_t stream) {
+  const dim3 block_size = {32, 8};
+  const dim3 num_blocks = {divup(divup(width, 2), block_size.x),
+                           divup(divup(height, 2), block_size.y),
+                           batch * 3 / C};
+  downsample_rgb_kernel<C><<<num_blocks, block_size, 0, stream>>>(
+      dest, src, width, height);
+}
+
+// levels 2..n from level 1 and the blur of all levels. the planes of a
+// planar image and the images of a batch are processed together, slice s of
+// level l starts s * C * width * height floats into the workspace images of
+// the level.
+template <unsigned int C>
+void pyramid(float *workspace, const BloomLayout &layout,
+             const BloomWeights &weights, cudaStream_t stream) {
+  for (unsigned int l = 2; l <= layout.levels; ++l)
+    downsample_rgb<C>(workspace + layout.downsampled[l],
+                      workspace + layout.downsampled[l - 1],
+                      layout.width[l - 1], layout.height[l - 1], layout.batch,
+                      stream);
+
+  // coarsest level first, every finer level adds the one below it
+  for (unsigned int l = layout.levels; l >= 1; --l) {
+    const bool coarsest = l == layout.levels;
+    blur<C>(workspace + layout.blurred[l], workspace + layout.temp,
+            workspace + layout.downsampled[l], layout.width[l],
+            layout.height[l], layout.batch, weights,
+            coarsest ? nullptr : workspace + layout.blurred[l + 1],
+            coarsest ? 0 : layout.width[l + 1],
+            coarsest ? 0 : layout.height[l + 1], stream);
+  }
+}
+
+template <unsigned int C, typename T>
+void bloom_image(T *dest, float *workspace, const T *src, unsigned int width,
+                 unsigned int height, const BloomSettings &settings,
+                 unsigned int batch, cudaStream_t stream) {
+  const BloomWeights weights = bloom_weights(settings);
+  const BloomLayout layout(width, height, settings, batch);
+
+  if (layout.levels == 0) {
+    blur<C>(dest, workspace + layout.temp, src, width, height, batch,
+            weights, nullptr, 0, 0, stream);
+    return;
+  }
+
+  downsample_rgb<C>(workspace + layout.downsampled[1], src, width, height,
+                    batch, stream);
+  pyramid<C>(workspace, layout, weights, stream);
+
+  const dim3 block_size = {32, 8};
+  const dim3 num_blocks = {divup(width, block_size.x),
+                           divup(height, block_size.y), batch * 3 / C};
+  upsample_kernel<C><<<num_blocks, block_size, 0, stream>>>(
+      dest, workspace + layout.blurred[1], width, height, layout.width[1],
+      layout.height[1], 1.0f / layout.levels);
+}
+} // namespace
+
+void bloom_pyramid(float *workspace, const BloomLayout &layout,
+                   const BloomWeights &weights, cudaStream_t stream) {
+  pyramid<3>(workspace, layout, weights, stream);
+}
+
+void bloom(float *dest, float *workspace, const float *src, unsigned int width,
+           unsigned int height, const BloomSettings &settings,
+           cudaStream_t stream, unsigned int batch) {
+  bloom_image<3>(dest, workspace, src, width, height, settings, batch,
+                 stream);
+}
+
+void bloom(RGB16F *dest, float *workspace, const RGB16F *src,
+           unsigned int width, unsigned int height,
+           const BloomSettings &settings, cudaStream_t stream,
+           unsigned int batch) {
+  bloom_image<3>(dest, workspace, src, width, height, settings, batch,
+                 stream);
+}
+
+void bloom_planar(float *dest, float *workspace, const float *src,
+                  unsigned int width, unsigned int height,
+                  const BloomSettings &settings, cudaStream_t stream) {
+  bloom_image<1>(dest, workspace, src, width, height, settings, 1, stream);
+}
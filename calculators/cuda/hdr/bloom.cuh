@@ -0,0 +1,57 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef INCLUDED_BLOOM_CUH
+#define INCLUDED_BLOOM_CUH
+
+#pragma once
+
+#include "calculators/cuda/hdr/bloom.h"
+
+// channel c of the image one level coarser at the position of fine pixel
+// (x, y), bilinear with clamp to edge. coarse pixel i covers fine pixels 2i
+// and 2i + 1, so its center sits at 2i + 0.5. same as in bloom_cpu.cpp. C is
+// the number of floats per pixel, 1 for a plane of a planar image.
+template <unsigned int C = 3>
+__device__ inline float upsample_bilinear(const float *coarse,
+                                          unsigned int width,
+                                          unsigned int height, unsigned int x,
+                                          unsigned int y, unsigned int c) {
+  float u = fmaxf(x * 0.5f - 0.25f, 0.0f);
+  float v = fmaxf(y * 0.5f - 0.25f, 0.0f);
+  unsigned int x0 = min(static_cast<unsigned int>(u), width - 1);
+  unsigned int y0 = min(static_cast<unsigned int>(v), height - 1);
+  unsigned int x1 = min(x0 + 1, width - 1);
+  unsigned int y1 = min(y0 + 1, height - 1);
+  float fx = u - x0;
+  float fy = v - y0;
+
+  float top = (1.0f - fx) * __ldg(coarse + C * (y0 * width + x0) + c) +
+              fx * __ldg(coarse + C * (y0 * width + x1) + c);
+  float bottom = (1.0f - fx) * __ldg(coarse + C * (y1 * width + x0) + c) +
+                 fx * __ldg(coarse + C * (y1 * width + x1) + c);
+  return (1.0f - fy) * top + fy * bottom;
+}
+
+#endif // INCLUDED_BLOOM_CUH
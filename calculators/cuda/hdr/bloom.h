@@ -0,0 +1,150 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef INCLUDED_BLOOM
+#define INCLUDED_BLOOM
+
+#pragma once
+
+#include <cstddef>
+
+// same declaration as in driver_types.h, keeps the CUDA headers out of the
+// host-only library
+typedef struct CUstream_st *cudaStream_t;
+
+class RGB16F;
+
+// largest blur radius the tiled kernels keep in shared memory. wider glows
+// come from the pyramid, every level doubles the effective radius.
+constexpr unsigned int max_bloom_radius = 32U;
+constexpr unsigned int max_bloom_levels = 8U;
+
+struct BloomSettings {
+  // taps on either side of the separable gaussian
+  unsigned int radius = 16U;
+  // 0 blurs at full resolution. n > 0 blurs the brightpass at 1/2, 1/4, ...,
+  // 1/2^n resolution and adds the levels up on the way back.
+  unsigned int levels = 0U;
+};
+
+// normalized gaussian taps, passed to the kernels by value
+struct BloomWeights {
+  unsigned int radius;
+  float w[2 * max_bloom_radius + 1];
+};
+
+// sigma scales with the radius such that radius 16 reproduces the original
+// 33 tap filter. throws std::invalid_argument for unsupported settings.
+BloomWeights bloom_weights(const BloomSettings &settings);
+
+// pixels on either side of a full resolution pixel that its bloom depends
+// on, a multiple of 2^levels. tiles cut at multiples of 2^levels and
+// overlapping by this much bloom exactly like the whole image, which is how
+// HDRTiledPipeline stitches them.
+unsigned int bloom_halo(const BloomSettings &settings);
+
+// placement of the images the bloom works on inside one workspace, in floats.
+// level 0 is the full resolution image, levels 1..n are downsampled by 2 each
+// and have a downsampled and a blurred image. temp holds the horizontal blur
+// pass of the largest image blurred. for a batch, every image of a level holds
+// the images of all batch members one after the other.
+struct BloomLayout {
+  unsigned int levels;
+  unsigned int batch;
+  unsigned int width[max_bloom_levels + 1];
+  unsigned int height[max_bloom_levels + 1];
+  std::size_t downsampled[max_bloom_levels + 1];
+  std::size_t blurred[max_bloom_levels + 1];
+  std::size_t temp;
+  std::size_t size;
+
+  BloomLayout(unsigned int width, unsigned int height,
+              const BloomSettings &settings, unsigned int batch = 1U);
+};
+
+// CUDA: blurs the interleaved RGB image src into dest, on its own or through
+// the pyramid. workspace holds BloomLayout::size floats. a batch of images
+// stored one after the other is blurred by the same launches.
+void bloom(float *dest, float *workspace, const float *src, unsigned int width,
+           unsigned int height, const BloomSettings &settings,
+           cudaStream_t stream, unsigned int batch = 1U);
+
+// same for half images, the workspace stays float
+void bloom(RGB16F *dest, float *workspace, const RGB16F *src,
+           unsigned int width, unsigned int height,
+           const BloomSettings &settings, cudaStream_t stream,
+           unsigned int batch = 1U);
+
+// same for planar float images, three planes of width * height floats. every
+// plane is blurred as a single channel image, the workspace size is the same.
+void bloom_planar(float *dest, float *workspace, const float *src,
+                  unsigned int width, unsigned int height,
+                  const BloomSettings &settings, cudaStream_t stream);
+
+// CUDA: the pyramid part of bloom(), for callers that produce level 1
+// themselves. expects the downsampled level 1 in the workspace and leaves the
+// sum of all blurred levels in the blurred level 1, see bloom_sample(). works
+// on all layout.batch images.
+void bloom_pyramid(float *workspace, const BloomLayout &layout,
+                   const BloomWeights &weights, cudaStream_t stream);
+
+namespace cpu {
+void bloom(float *dest, float *workspace, const float *src, std::size_t width,
+           std::size_t height, const BloomSettings &settings);
+
+void bloom(RGB16F *dest, float *workspace, const RGB16F *src,
+           std::size_t width, std::size_t height,
+           const BloomSettings &settings);
+
+void bloom_planar(float *dest, float *workspace, const float *src,
+                  std::size_t width, std::size_t height,
+                  const BloomSettings &settings);
+
+void bloom_pyramid(float *workspace, const BloomLayout &layout,
+                   const BloomWeights &weights);
+
+// horizontal pass of gaussian_blur() for one row. padded holds the row with
+// 3 * radius zero floats on either side.
+void blur_row(float *dest, const float *padded, std::size_t width,
+              const BloomWeights &weights);
+
+// vertical pass of gaussian_blur() for the rows [begin, end), src is the
+// result of the horizontal pass. dest points at row begin.
+void blur_columns(float *dest, const float *src, std::size_t width,
+                  std::size_t height, std::size_t begin, std::size_t end,
+                  const BloomWeights &weights);
+
+// separable gaussian of an interleaved RGB image, pixels outside count as
+// black. temp holds one image of the same size.
+void gaussian_blur(float *dest, float *temp, const float *src,
+                   std::size_t width, std::size_t height,
+                   const BloomWeights &weights);
+
+// row y of the full resolution bloom: bilinear samples of the blurred level 1,
+// divided by the number of levels
+void bloom_sample(float *dest, const float *level1, const BloomLayout &layout,
+                  std::size_t y);
+} // namespace cpu
+
+#endif // INCLUDED_BLOOM
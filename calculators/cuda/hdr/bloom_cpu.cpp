@@ -0,0 +1,400 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "calculators/cuda/hdr/framework/thread_pool.h"
+
+#include "calculators/cuda/hdr/bloom.h"
+#include "calculators/cuda/hdr/hdr_storage.h"
+
+namespace {
+// rows handed to a worker at a time
+constexpr std::size_t band_rows = 16U;
+// floats of a row the vertical pass works on at a time, small enough for a
+// band plus its halo to stay in L2
+constexpr std::size_t column_block = 512U;
+
+// out[k] = sum_i w[i] * in[k + stride * i] for k < count
+void convolve(float *out, const float *in, std::size_t count,
+              std::size_t stride, const BloomWeights &weights) {
+  const unsigned int taps = 2 * weights.radius + 1;
+  std::size_t k = 0;
+
+#if defined(__AVX2__)
+  for (; k + 8 <= count; k += 8) {
+    __m256 sum = _mm256_setzero_ps();
+    for (unsigned int i = 0; i < taps; ++i)
+      sum = _mm256_fmadd_ps(_mm256_set1_ps(weights.w[i]),
+                            _mm256_loadu_ps(in + k + stride * i), sum);
+    _mm256_storeu_ps(out + k, sum);
+  }
+#endif
+
+  for (; k < count; ++k) {
+    float sum = 0.0f;
+    for (unsigned int i = 0; i < taps; ++i)
+      sum += weights.w[i] * in[k + stride * i];
+    out[k] = sum;
+  }
+}
+
+// rows of the images the blur works on, with C floats per pixel: interleaved
+// RGB in any HDRStorage format for C = 3, one plane of a planar float image
+// for C = 1
+template <std::size_t C, typename T>
+T *image_row(T *image, std::size_t width, std::size_t y) {
+  if constexpr (C == 3)
+    return cpu::pixel_row(image, width, y);
+  else
+    return image + width * y;
+}
+
+template <std::size_t C, typename T>
+void read_floats(float *dest, const T *src, std::size_t pixels) {
+  if constexpr (C == 3)
+    cpu::read_row(dest, src, pixels);
+  else
+    std::copy_n(src, pixels, dest);
+}
+
+template <std::size_t C, typename T>
+const float *load_floats(float *scratch, const T *src, std::size_t pixels) {
+  if constexpr (C == 3)
+    return cpu::load_row(scratch, src, pixels);
+  else
+    return src;
+}
+
+template <std::size_t C, typename T>
+void store_floats(T *dest, const float *src, std::size_t pixels) {
+  if constexpr (C == 3)
+    cpu::store_row(dest, src, pixels);
+  else if (dest != src)
+    std::copy_n(src, pixels, dest);
+}
+
+// vertical pass over rows of row_floats floats, see cpu::blur_columns()
+void blur_column_floats(float *dest, const float *src, std::size_t row_floats,
+                        std::size_t height, std::size_t begin,
+                        std::size_t end, const BloomWeights &weights) {
+  const std::size_t r = weights.radius;
+  std::vector<float> window((end - begin + 2 * r) * column_block);
+
+  // one block of columns at a time, so the 2r + 1 rows every output row reads
+  // stay cached
+  for (std::size_t f0 = 0; f0 < row_floats; f0 += column_block) {
+    const std::size_t n = std::min(column_block, row_floats - f0);
+    // gather the block of the band plus halo, rows outside are black
+    for (std::size_t i = 0; i < end - begin + 2 * r; ++i) {
+      const std::ptrdiff_t y = static_cast<std::ptrdiff_t>(begin + i) -
+                               static_cast<std::ptrdiff_t>(r);
+      float *w = &window[i * n];
+      if (y < 0 || y >= static_cast<std::ptrdiff_t>(height))
+        std::fill_n(w, n, 0.0f);
+      else
+        std::copy_n(src + row_floats * y + f0, n, w);
+    }
+    for (std::size_t y = begin; y < end; ++y)
+      convolve(dest + row_floats * (y - begin) + f0,
+               &window[(y - begin) * n], n, n, weights);
+  }
+}
+
+// same as upsample_bilinear() in bloom.cuh, for a whole row
+template <std::size_t C>
+void upsample_row(float *dest, const float *coarse, std::size_t coarse_width,
+                  std::size_t coarse_height, std::size_t width, std::size_t y,
+                  float scale, bool accumulate) {
+  const float v = std::max(y * 0.5f - 0.25f, 0.0f);
+  const std::size_t y0 = std::min(static_cast<std::size_t>(v),
+                                  coarse_height - 1);
+  const std::size_t y1 = std::min(y0 + 1, coarse_height - 1);
+  const float fy = v - y0;
+  const float *top = coarse + C * coarse_width * y0;
+  const float *bottom = coarse + C * coarse_width * y1;
+
+  for (std::size_t x = 0; x < width; ++x) {
+    const float u = std::max(x * 0.5f - 0.25f, 0.0f);
+    const std::size_t x0 = std::min(static_cast<std::size_t>(u),
+                                    coarse_width - 1);
+    const std::size_t x1 = std::min(x0 + 1, coarse_width - 1);
+    const float fx = u - x0;
+    for (std::size_t c = 0; c < C; ++c) {
+      float t = (1.0f - fx) * top[C * x0 + c] + fx * top[C * x1 + c];
+      float b = (1.0f - fx) * bottom[C * x0 + c] + fx * bottom[C * x1 + c];
+      float value = scale * ((1.0f - fy) * t + fy * b);
+      dest[C * x + c] = accumulate ? dest[C * x + c] + value : value;
+    }
+  }
+}
+
+template <std::size_t C, typename T>
+void blur(T *dest, float *temp, const T *src, std::size_t width,
+          std::size_t height, const BloomWeights &weights,
+          const float *coarser, std::size_t coarser_width,
+          std::size_t coarser_height) {
+  const std::size_t r = weights.radius;
+  const std::size_t row_floats = C * width;
+  ThreadPool &pool = ThreadPool::shared();
+  const std::size_t bands = (height + band_rows - 1) / band_rows;
+
+  // every row is copied into a zero padded buffer first so the inner loop
+  // needs no bounds checks
+  pool.parallel_for(bands, [&](std::size_t b) {
+    std::vector<float> padded(row_floats + 2 * C * r, 0.0f);
+    const std::size_t end = std::min((b + 1) * band_rows, height);
+    for (std::size_t y = b * band_rows; y < end; ++y) {
+      read_floats<C>(&padded[C * r], image_row<C>(src, width, y), width);
+      convolve(temp + row_floats * y, padded.data(), row_floats, C, weights);
+    }
+  });
+
+  pool.parallel_for(bands, [&](std::size_t b) {
+    const std::size_t begin = b * band_rows;
+    const std::size_t end = std::min(begin + band_rows, height);
+    std::vector<float> scratch(
+        cpu::scratch_floats<T>(width * (end - begin)));
+    T *band = image_row<C>(dest, width, begin);
+    float *out = cpu::row_target(scratch.data(), band);
+    blur_column_floats(out, temp, row_floats, height, begin, end, weights);
+    if (coarser)
+      for (std::size_t y = begin; y < end; ++y)
+        upsample_row<C>(out + row_floats * (y - begin), coarser,
+                        coarser_width, coarser_height, width, y, 1.0f, true);
+    store_floats<C>(band, out, width * (end - begin));
+  });
+}
+
+// 2x2 box filter, same as downsample_rgb_kernel in bloom.cu
+template <std::size_t C, typename T>
+void downsample_image(float *dest, const T *src, std::size_t width,
+                      std::size_t height) {
+  const std::size_t w = (width + 1) / 2;
+  const std::size_t h = (height + 1) / 2;
+  ThreadPool::shared().parallel_for(h, [&](std::size_t y) {
+    const std::size_t y1 = std::min(2 * y + 1, height - 1);
+    std::vector<float> scratch(2 * cpu::scratch_floats<T>(width));
+    const float *top = load_floats<C>(
+        scratch.data(), image_row<C>(src, width, 2 * y), width);
+    const float *bottom =
+        load_floats<C>(scratch.data() + cpu::scratch_floats<T>(width),
+                       image_row<C>(src, width, y1), width);
+    for (std::size_t x = 0; x < w; ++x) {
+      const std::size_t x1 = std::min(2 * x + 1, width - 1);
+      const float scale = 1.0f / ((x1 - 2 * x + 1) * (y1 - 2 * y + 1));
+      for (std::size_t c = 0; c < C; ++c) {
+        float sum = top[C * 2 * x + c];
+        if (x1 != 2 * x)
+          sum += top[C * x1 + c];
+        if (y1 != 2 * y) {
+          sum += bottom[C * 2 * x + c];
+          if (x1 != 2 * x)
+            sum += bottom[C * x1 + c];
+        }
+        dest[C * (y * w + x) + c] = sum * scale;
+      }
+    }
+  });
+}
+
+// the workspace images of a level hold three planes for planar images, plane
+// p of level l starts p * width * height floats into them
+std::size_t plane_offset(const BloomLayout &layout, unsigned int l,
+                         std::size_t p) {
+  return p * layout.width[l] * layout.height[l];
+}
+
+// levels 2..n from level 1 and the blur of all levels, for plane p of a
+// planar image (C = 1) or the interleaved image (C = 3, p = 0)
+template <std::size_t C>
+void pyramid(float *workspace, const BloomLayout &layout,
+             const BloomWeights &weights, std::size_t p) {
+  auto downsampled = [&](unsigned int l) {
+    return workspace + layout.downsampled[l] + plane_offset(layout, l, p);
+  };
+  auto blurred = [&](unsigned int l) {
+    return workspace + layout.blurred[l] + plane_offset(layout, l, p);
+  };
+
+  for (unsigned int l = 2; l <= layout.levels; ++l)
+    downsample_image<C>(downsampled(l), downsampled(l - 1),
+                        layout.width[l - 1], layout.height[l - 1]);
+
+  for (unsigned int l = layout.levels; l >= 1; --l) {
+    const bool coarsest = l == layout.levels;
+    blur<C>(blurred(l), workspace + layout.temp, downsampled(l),
+            layout.width[l], layout.height[l], weights,
+            coarsest ? nullptr : blurred(l + 1),
+            coarsest ? 0 : layout.width[l + 1],
+            coarsest ? 0 : layout.height[l + 1]);
+  }
+}
+
+// the planes are blurred one after the other, every one spread over the
+// whole pool
+template <std::size_t C, typename T>
+void bloom_image(T *dest, float *workspace, const T *src, std::size_t width,
+                 std::size_t height, const BloomSettings &settings) {
+  const BloomWeights weights = bloom_weights(settings);
+  const BloomLayout layout(static_cast<unsigned int>(width),
+                           static_cast<unsigned int>(height), settings);
+
+  for (std::size_t p = 0; p < 3 / C; ++p) {
+    T *dest_plane = dest + plane_offset(layout, 0, p);
+    const T *src_plane = src + plane_offset(layout, 0, p);
+
+    if (layout.levels == 0) {
+      blur<C>(dest_plane, workspace + layout.temp, src_plane, width, height,
+              weights, nullptr, 0, 0);
+      continue;
+    }
+
+    const float *level1 =
+        workspace + layout.blurred[1] + plane_offset(layout, 1, p);
+    downsample_image<C>(workspace + layout.downsampled[1] +
+                            plane_offset(layout, 1, p),
+                        src_plane, width, height);
+    pyramid<C>(workspace, layout, weights, p);
+    ThreadPool::shared().parallel_for(height, [&](std::size_t y) {
+      std::vector<float> scratch(cpu::scratch_floats<T>(width));
+      T *row = image_row<C>(dest_plane, width, y);
+      float *out = cpu::row_target(scratch.data(), row);
+      upsample_row<C>(out, level1, layout.width[1], layout.height[1], width,
+                      y, 1.0f / layout.levels, false);
+      store_floats<C>(row, out, width);
+    });
+  }
+}
+} // namespace
+
+BloomWeights bloom_weights(const BloomSettings &settings) {
+  if (settings.radius == 0 || settings.radius > max_bloom_radius)
+    throw std::invalid_argument("bloom radius must be in 1.." +
+                                std::to_string(max_bloom_radius));
+
+  BloomWeights weights = {settings.radius, {}};
+  const float sigma = settings.radius * (6.45f / 16.0f);
+  const int r = static_cast<int>(settings.radius);
+  double sum = 0.0;
+  for (int i = -r; i <= r; ++i)
+    sum += weights.w[i + r] = std::exp(-0.5f * i * i / (sigma * sigma));
+  for (int i = 0; i <= 2 * r; ++i)
+    weights.w[i] = static_cast<float>(weights.w[i] / sum);
+  return weights;
+}
+
+unsigned int bloom_halo(const BloomSettings &settings) {
+  if (settings.levels == 0)
+    return settings.radius;
+  // the coarsest level reaches radius pixels of its own resolution, plus one
+  // for the box filters on the way down. every bilinear tap on the way up
+  // adds one pixel of its level, which sums up to less than two of the
+  // coarsest level.
+  return (settings.radius + 3U) << settings.levels;
+}
+
+BloomLayout::BloomLayout(unsigned int width, unsigned int height,
+                         const BloomSettings &settings, unsigned int batch)
+    : levels(settings.levels), batch(batch) {
+  if (levels > max_bloom_levels)
+    throw std::invalid_argument("at most " + std::to_string(max_bloom_levels) +
+                                " bloom levels are supported");
+
+  this->width[0] = width;
+  this->height[0] = height;
+  downsampled[0] = blurred[0] = 0;
+
+  std::size_t offset = 0;
+  for (unsigned int l = 1; l <= levels; ++l) {
+    this->width[l] = (this->width[l - 1] + 1) / 2;
+    this->height[l] = (this->height[l - 1] + 1) / 2;
+    const std::size_t floats =
+        3 * std::size_t{batch} * this->width[l] * this->height[l];
+    downsampled[l] = offset;
+    blurred[l] = offset + floats;
+    offset += 2 * floats;
+  }
+
+  // the largest image blurred is level 1, or the full image without levels
+  const unsigned int t = levels ? 1 : 0;
+  temp = offset;
+  size = offset +
+         3 * std::size_t{batch} * this->width[t] * this->height[t];
+}
+
+namespace cpu {
+void blur_row(float *dest, const float *padded, std::size_t width,
+              const BloomWeights &weights) {
+  convolve(dest, padded, 3 * width, 3, weights);
+}
+
+void blur_columns(float *dest, const float *src, std::size_t width,
+                  std::size_t height, std::size_t begin, std::size_t end,
+                  const BloomWeights &weights) {
+  blur_column_floats(dest, src, 3 * width, height, begin, end, weights);
+}
+
+void gaussian_blur(float *dest, float *temp, const float *src,
+                   std::size_t width, std::size_t height,
+                   const BloomWeights &weights) {
+  blur<3>(dest, temp, src, width, height, weights, nullptr, 0, 0);
+}
+
+void bloom_pyramid(float *workspace, const BloomLayout &layout,
+                   const BloomWeights &weights) {
+  pyramid<3>(workspace, layout, weights, 0);
+}
+
+void bloom_sample(float *dest, const float *level1, const BloomLayout &layout,
+                  std::size_t y) {
+  upsample_row<3>(dest, level1, layout.width[1], layout.height[1],
+                  layout.width[0], y, 1.0f / layout.levels, false);
+}
+
+void bloom(float *dest, float *workspace, const float *src, std::size_t width,
+           std::size_t height, const BloomSettings &settings) {
+  bloom_image<3>(dest, workspace, src, width, height, settings);
+}
+
+void bloom(RGB16F *dest, float *workspace, const RGB16F *src,
+           std::size_t width, std::size_t height,
+           const BloomSettings &settings) {
+  bloom_image<3>(dest, workspace, src, width, height, settings);
+}
+
+void bloom_planar(float *dest, float *workspace, const float *src,
+                  std::size_t width, std::size_t height,
+                  const BloomSettings &settings) {
+  bloom_image<1>(dest, workspace, src, width, height, settings);
+}
+} // namespace cpu
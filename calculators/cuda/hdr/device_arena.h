@@ -0,0 +1,43 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef INCLUDED_DEVICE_ARENA
+#define INCLUDED_DEVICE_ARENA
+
+#pragma once
+
+#include "calculators/cuda/hdr/memory_arena.h"
+
+// device memory from cudaMalloc, which is aligned to at least 256 bytes.
+// growing the block synchronizes the device like every cudaMalloc()/cudaFree().
+class DeviceArena final : public MemoryArena {
+protected:
+  void *allocateBlock(std::size_t size) override;
+  void freeBlock(void *ptr) override;
+
+public:
+  ~DeviceArena() override;
+};
+
+#endif // INCLUDED_DEVICE_ARENA
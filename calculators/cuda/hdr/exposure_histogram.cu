@@ -0,0 +1,118 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include "calculators/cuda/hdr/exposure_histogram.h"
+
+namespace {
+constexpr unsigned int divup(unsigned int a, unsigned int b) {
+  return (a + b - 1) / b;
+}
+
+constexpr unsigned int histogram_block_size = 256U;
+// samples every thread counts, fewer blocks mean fewer global atomics when
+// the block bins are added up
+constexpr unsigned int histogram_items_per_thread = 32U;
+constexpr unsigned int max_histogram_blocks = 256U;
+
+struct LoadRGB {
+  const float *rgb;
+  std::size_t pixels;
+  __device__ float operator()(std::size_t image, std::size_t i) const {
+    const float *p = rgb + 3 * (image * pixels + i);
+    return histogram_luminance(__ldg(p), __ldg(p + 1), __ldg(p + 2));
+  }
+};
+
+struct LoadPlanar {
+  const float *input;
+  std::size_t pixels;
+  __device__ float operator()(std::size_t, std::size_t i) const {
+    const float *p = input + i;
+    return histogram_luminance(__ldg(p), __ldg(p + pixels),
+                               __ldg(p + 2 * pixels));
+  }
+};
+} // namespace
+
+// every thread counts a grid-strided subset of the samples into the bins of
+// its block in shared memory, which are added to the histogram of the image
+// once the block is done. blockIdx.y is the image of a batch.
+template <typename Load>
+__global__ void luminance_histogram_kernel(unsigned int *bins, Load load,
+                                           unsigned int width,
+                                           unsigned int subsample,
+                                           unsigned int columns,
+                                           unsigned int samples) {
+  __shared__ unsigned int block_bins[histogram_bins];
+  for (unsigned int b = threadIdx.x; b < histogram_bins; b += blockDim.x)
+    block_bins[b] = 0U;
+  __syncthreads();
+
+  for (unsigned int s = blockIdx.x * blockDim.x + threadIdx.x; s < samples;
+       s += gridDim.x * blockDim.x) {
+    const unsigned int x = s % columns * subsample;
+    const unsigned int y = s / columns * subsample;
+    atomicAdd(&block_bins[histogram_bin(
+                  load(blockIdx.y, std::size_t{y} * width + x))],
+              1U);
+  }
+  __syncthreads();
+
+  bins += blockIdx.y * histogram_bins;
+  for (unsigned int b = threadIdx.x; b < histogram_bins; b += blockDim.x)
+    if (block_bins[b] != 0U)
+      atomicAdd(&bins[b], block_bins[b]);
+}
+
+namespace {
+template <typename Load>
+void launch_histogram(unsigned int *bins, Load load, unsigned int width,
+                      unsigned int height, unsigned int subsample,
+                      unsigned int batch, cudaStream_t stream) {
+  const unsigned int columns = histogram_samples(width, subsample);
+  const unsigned int samples = columns * histogram_samples(height, subsample);
+  const dim3 num_blocks = {
+      min(max_histogram_blocks,
+          divup(samples, histogram_block_size * histogram_items_per_thread)),
+      batch};
+
+  luminance_histogram_kernel<<<num_blocks, histogram_block_size, 0, stream>>>(
+      bins, load, width, subsample, columns, samples);
+}
+} // namespace
+
+void luminance_histogram(unsigned int *bins, const float *rgb,
+                         unsigned int width, unsigned int height,
+                         unsigned int subsample, cudaStream_t stream,
+                         unsigned int batch) {
+  launch_histogram(bins, LoadRGB{rgb, std::size_t{width} * height}, width,
+                   height, subsample, batch, stream);
+}
+
+void luminance_histogram_planar(unsigned int *bins, const float *input,
+                                unsigned int width, unsigned int height,
+                                unsigned int subsample, cudaStream_t stream) {
+  launch_histogram(bins, LoadPlanar{input, std::size_t{width} * height},
+                   width, height, subsample, 1U, stream);
+}
@@ -0,0 +1,128 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef INCLUDED_EXPOSURE_HISTOGRAM
+#define INCLUDED_EXPOSURE_HISTOGRAM
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+// same declaration as in driver_types.h, keeps the CUDA headers out of the
+// host-only library
+typedef struct CUstream_st *cudaStream_t;
+
+// the bin mapping below is compiled into the CUDA kernel as well as into the
+// host loop
+#if defined(__CUDACC__)
+#define HISTOGRAM_HOST_DEVICE __host__ __device__
+#else
+#define HISTOGRAM_HOST_DEVICE
+#endif
+
+// log2 luminance histogram with 4 bins per octave, covering 2^-16 to 2^16.
+// darker pixels fall into the first bin, brighter ones into the last.
+constexpr unsigned int histogram_bins_per_octave = 4U;
+constexpr int histogram_min_octave = -16;
+constexpr unsigned int histogram_bins = 128U;
+
+// same weights as luminance_kernel in hdr_pipeline.cu. the explicit fused
+// multiply-adds round the same on host and device whatever the compilers
+// contract, so both sides put every pixel into the same bin.
+HISTOGRAM_HOST_DEVICE inline float histogram_luminance(float r, float g,
+                                                       float b) {
+  return fmaf(0.07f, b, fmaf(0.72f, g, 0.21f * r));
+}
+
+// the bin is read off the bits of the float: the exponent and the two
+// leading mantissa bits are floor(log2 L) and the quarter of the octave L is
+// in. no log2() is evaluated, which could differ by an ulp between host and
+// device.
+HISTOGRAM_HOST_DEVICE inline unsigned int histogram_bin(float luminance) {
+  // zero, negative and NaN luminance
+  if (!(luminance > 0.0f))
+    return 0U;
+#if defined(__CUDA_ARCH__)
+  const unsigned int bits = __float_as_uint(luminance);
+#else
+  unsigned int bits;
+  std::memcpy(&bits, &luminance, sizeof(bits));
+#endif
+  const int bin = static_cast<int>(bits >> 21) -
+                  (127 + histogram_min_octave) *
+                      static_cast<int>(histogram_bins_per_octave);
+  return bin < 0 ? 0U
+         : bin >= static_cast<int>(histogram_bins)
+             ? histogram_bins - 1U
+             : static_cast<unsigned int>(bin);
+}
+
+// width and height of the image of every subsample-th pixel of every
+// subsample-th row that the histograms are built from
+constexpr unsigned int histogram_samples(unsigned int size,
+                                         unsigned int subsample) {
+  return (size + subsample - 1U) / subsample;
+}
+
+// CUDA: counts the pixels of the subsampled interleaved RGB image per bin.
+// every block counts into bins of its own in shared memory and adds them to
+// the histogram once. bins holds histogram_bins counts per image of the batch
+// and has to be zeroed before, the counts are added to it.
+void luminance_histogram(unsigned int *bins, const float *rgb,
+                         unsigned int width, unsigned int height,
+                         unsigned int subsample, cudaStream_t stream = 0,
+                         unsigned int batch = 1U);
+
+// same for an image in R, G and B planes of width * height floats
+void luminance_histogram_planar(unsigned int *bins, const float *input,
+                                unsigned int width, unsigned int height,
+                                unsigned int subsample,
+                                cudaStream_t stream = 0);
+
+// log2 of the bin's luminance midpoint
+float histogram_bin_log2(unsigned int bin);
+
+// mean log2 luminance of the pixels between the low and the high fraction
+// of the histogram, 0 <= low < high <= 1. the darkest low and the brightest
+// 1 - high of the pixels are left out, so neither a few specular highlights
+// nor black borders move the result.
+float histogram_percentile_log2(const unsigned int *bins, float low,
+                                float high);
+
+namespace cpu {
+// host version of luminance_histogram(), bit-identical to it. the rows are
+// cut into strips counted into bins of their own on the shared thread pool
+// and summed up at the end.
+void luminance_histogram(unsigned int *bins, const float *rgb,
+                         std::size_t width, std::size_t height,
+                         unsigned int subsample);
+
+void luminance_histogram_planar(unsigned int *bins, const float *input,
+                                std::size_t width, std::size_t height,
+                                unsigned int subsample);
+} // namespace cpu
+
+#endif // INCLUDED_EXPOSURE_HISTOGRAM
@@ -0,0 +1,120 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+#include "calculators/cuda/hdr/framework/thread_pool.h"
+
+#include "calculators/cuda/hdr/exposure_histogram.h"
+
+namespace {
+using Bins = std::array<unsigned int, histogram_bins>;
+
+// counts of the subsampled rows are independent of the order they are added
+// in, the number of strips only needs to keep the threads busy
+constexpr std::size_t num_strips = 64U;
+
+// load(x, y) returns the luminance of pixel (x, y) of the full image
+template <typename Load>
+void count_strips(unsigned int *bins, std::size_t width, std::size_t height,
+                  unsigned int subsample, Load load) {
+  const std::size_t columns = histogram_samples(width, subsample);
+  const std::size_t rows = histogram_samples(height, subsample);
+  const std::size_t strips = std::min(num_strips, rows);
+  const std::size_t rows_per_strip = (rows + strips - 1) / strips;
+
+  std::vector<Bins> partials(strips);
+  ThreadPool::shared().parallel_for(strips, [&](std::size_t s) {
+    Bins local = {};
+    const std::size_t end = std::min((s + 1) * rows_per_strip, rows);
+    for (std::size_t j = s * rows_per_strip; j < end; ++j)
+      for (std::size_t i = 0; i < columns; ++i)
+        ++local[histogram_bin(load(i * subsample, j * subsample))];
+    partials[s] = local;
+  });
+
+  std::fill_n(bins, histogram_bins, 0U);
+  for (const Bins &p : partials)
+    for (unsigned int b = 0; b < histogram_bins; ++b)
+      bins[b] += p[b];
+}
+} // namespace
+
+float histogram_bin_log2(unsigned int bin) {
+  const unsigned int octave = bin / histogram_bins_per_octave;
+  const unsigned int step = bin % histogram_bins_per_octave;
+  return static_cast<float>(histogram_min_octave + static_cast<int>(octave)) +
+         std::log2(1.0f + (step + 0.5f) / histogram_bins_per_octave);
+}
+
+float histogram_percentile_log2(const unsigned int *bins, float low,
+                                float high) {
+  double total = 0.0;
+  for (unsigned int b = 0; b < histogram_bins; ++b)
+    total += bins[b];
+
+  // every bin contributes the part of its pixels between the two ranks
+  const double first = low * total;
+  const double last = high * total;
+  double below = 0.0;
+  double weight = 0.0;
+  double sum = 0.0;
+  for (unsigned int b = 0; b < histogram_bins; ++b) {
+    const double lo = std::max(below, first);
+    const double hi = std::min(below + bins[b], last);
+    if (hi > lo) {
+      weight += hi - lo;
+      sum += (hi - lo) * histogram_bin_log2(b);
+    }
+    below += bins[b];
+  }
+  // an empty histogram leaves the exposure as it is
+  return weight > 0.0 ? static_cast<float>(sum / weight) : 0.0f;
+}
+
+namespace cpu {
+void luminance_histogram(unsigned int *bins, const float *rgb,
+                         std::size_t width, std::size_t height,
+                         unsigned int subsample) {
+  count_strips(bins, width, height, subsample,
+               [&](std::size_t x, std::size_t y) {
+                 const float *p = rgb + 3 * (y * width + x);
+                 return histogram_luminance(p[0], p[1], p[2]);
+               });
+}
+
+void luminance_histogram_planar(unsigned int *bins, const float *input,
+                                std::size_t width, std::size_t height,
+                                unsigned int subsample) {
+  const std::size_t plane = width * height;
+  count_strips(bins, width, height, subsample,
+               [&](std::size_t x, std::size_t y) {
+                 const float *p = input + y * width + x;
+                 return histogram_luminance(p[0], p[plane], p[2 * plane]);
+               });
+}
+} // namespace cpu
@@ -46,3 +46,16 @@ char **parseArgument(char **argv, size_t token_offset, float &v) {
 
   return argv;
 }
+
+char **parseArgument(char **argv, size_t token_offset, const char *&v) {
+  const char *startptr = *argv + token_offset;
+
+  if (*startptr == '\0') {
+    if (!argv[1])
+      throw usage_error("expected string argument");
+    startptr = *++argv;
+  }
+
+  v = startptr;
+  return argv;
+}
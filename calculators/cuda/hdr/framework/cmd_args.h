@@ -14,6 +14,7 @@ struct usage_error : std::runtime_error {
 
 char **parseArgument(char **argv, size_t token_offset, int &v);
 char **parseArgument(char **argv, size_t token_offset, float &v);
+char **parseArgument(char **argv, size_t token_offset, const char *&v);
 
 template <int S, typename T>
 bool checkArgument(const char (&token)[S], char **&a, T &v) {
@@ -0,0 +1,202 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include "calculators/cuda/hdr/framework/file_io.h"
+
+namespace {
+[[noreturn]] void fail(const char *what, const char *filename) {
+  throw std::runtime_error(std::string(what) + " '" + filename + "'");
+}
+
+#if !defined(_WIN32)
+// spans handed to one writev() call
+constexpr std::size_t max_spans = IOV_MAX;
+#endif
+} // namespace
+
+#if defined(_WIN32)
+MappedFile::MappedFile(const char *filename) {
+  file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                     OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    file = nullptr;
+    fail("unable to open", filename);
+  }
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size)) {
+    CloseHandle(file);
+    fail("unable to read the size of", filename);
+  }
+  length = static_cast<std::size_t>(size.QuadPart);
+  if (length == 0)
+    return;
+
+  mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  const void *view =
+      mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+  if (!view) {
+    if (mapping)
+      CloseHandle(mapping);
+    CloseHandle(file);
+    fail("unable to map", filename);
+  }
+  base = static_cast<const unsigned char *>(view);
+}
+
+MappedFile::~MappedFile() {
+  if (base)
+    UnmapViewOfFile(base);
+  if (mapping)
+    CloseHandle(mapping);
+  if (file)
+    CloseHandle(file);
+}
+
+OutputFile::OutputFile(const char *filename) {
+  file = CreateFileA(filename, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                     FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    file = nullptr;
+    fail("unable to create", filename);
+  }
+}
+
+OutputFile::~OutputFile() { CloseHandle(file); }
+
+void OutputFile::write(const FileSpan *spans, std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) {
+    auto data = static_cast<const char *>(spans[i].data);
+    std::size_t left = spans[i].size;
+    while (left > 0) {
+      // WriteFile() takes 32 bit sizes
+      const DWORD chunk =
+          static_cast<DWORD>(std::min<std::size_t>(left, 1U << 30));
+      DWORD written = 0;
+      if (!WriteFile(file, data, chunk, &written, nullptr) || written == 0)
+        throw std::runtime_error("unable to write file");
+      data += written;
+      left -= written;
+    }
+  }
+}
+#else
+MappedFile::MappedFile(const char *filename) {
+  const int fd = open(filename, O_RDONLY);
+  if (fd < 0)
+    fail("unable to open", filename);
+
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    close(fd);
+    fail("unable to read the size of", filename);
+  }
+  length = static_cast<std::size_t>(info.st_size);
+  if (length == 0) {
+    close(fd);
+    return;
+  }
+
+  void *view = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  // the mapping keeps the file open
+  close(fd);
+  if (view == MAP_FAILED)
+    fail("unable to map", filename);
+  // the readers copy or convert all of it right away
+  madvise(view, length, MADV_WILLNEED);
+  base = static_cast<const unsigned char *>(view);
+}
+
+MappedFile::~MappedFile() {
+  if (base)
+    munmap(const_cast<unsigned char *>(base), length);
+}
+
+OutputFile::OutputFile(const char *filename) {
+  fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd < 0)
+    fail("unable to create", filename);
+}
+
+OutputFile::~OutputFile() { close(fd); }
+
+void OutputFile::write(const FileSpan *spans, std::size_t count) {
+  std::vector<iovec> batch;
+  batch.reserve(std::min(count, max_spans));
+  for (std::size_t first = 0; first < count; first += max_spans) {
+    batch.clear();
+    for (std::size_t i = first; i < std::min(first + max_spans, count); ++i)
+      if (spans[i].size > 0)
+        batch.push_back(
+            {const_cast<void *>(spans[i].data), spans[i].size});
+
+    // a call may write less than asked for, e.g. at most 2 GiB on Linux.
+    // the written spans are dropped and the next one is cut where it ended.
+    iovec *next = batch.data();
+    std::size_t left = batch.size();
+    while (left > 0) {
+      const ssize_t written =
+          writev(fd, next, static_cast<int>(std::min(left, max_spans)));
+      if (written < 0 && errno == EINTR)
+        continue;
+      if (written <= 0)
+        throw std::runtime_error(std::string("unable to write file: ") +
+                                 std::strerror(errno));
+      std::size_t done = static_cast<std::size_t>(written);
+      while (left > 0 && done >= next->iov_len) {
+        done -= next->iov_len;
+        ++next;
+        --left;
+      }
+      if (left > 0) {
+        next->iov_base = static_cast<char *>(next->iov_base) + done;
+        next->iov_len -= done;
+      }
+    }
+  }
+}
+#endif
+
+void OutputFile::write(const void *data, std::size_t size) {
+  const FileSpan span = {data, size};
+  write(&span, 1);
+}
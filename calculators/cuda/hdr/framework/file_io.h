@@ -0,0 +1,84 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef INCLUDED_FRAMEWORK_FILE_IO
+#define INCLUDED_FRAMEWORK_FILE_IO
+
+#pragma once
+
+#include <cstddef>
+
+// a whole file mapped read-only into memory. the pages are read in by the
+// first access, so a file is never copied in full just to look at part of it.
+class MappedFile {
+  const unsigned char *base = nullptr;
+  std::size_t length = 0;
+#if defined(_WIN32)
+  void *file = nullptr;
+  void *mapping = nullptr;
+#endif
+
+public:
+  // throws std::runtime_error if the file cannot be opened or mapped
+  explicit MappedFile(const char *filename);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  const unsigned char *data() const { return base; }
+  std::size_t size() const { return length; }
+};
+
+// a run of bytes of a gather write
+struct FileSpan {
+  const void *data;
+  std::size_t size;
+};
+
+// a file opened for writing from the start, truncated if it exists. write()
+// hands many buffers to the system at once, writev() batches on POSIX
+// systems, so a flipped image is written row by row without being copied.
+class OutputFile {
+#if defined(_WIN32)
+  void *file = nullptr;
+#else
+  int fd = -1;
+#endif
+
+public:
+  // throws std::runtime_error if the file cannot be created
+  explicit OutputFile(const char *filename);
+  ~OutputFile();
+
+  OutputFile(const OutputFile &) = delete;
+  OutputFile &operator=(const OutputFile &) = delete;
+
+  // appends the spans in order, throws std::runtime_error if the file
+  // cannot be written
+  void write(const FileSpan *spans, std::size_t count);
+  void write(const void *data, std::size_t size);
+};
+
+#endif // INCLUDED_FRAMEWORK_FILE_IO
@@ -0,0 +1,136 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef INCLUDED_HALF
+#define INCLUDED_HALF
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// F16C converts 8 values per instruction. MSVC has no macro for it, but every
+// AVX2 capable CPU supports it.
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define HALF_USE_F16C 1
+#include <immintrin.h>
+#endif
+
+// IEEE 754 binary16 values are stored as their bit pattern, which matches the
+// layout of __half in device code
+
+// round to nearest even, like _mm256_cvtps_ph() and __float2half_rn()
+inline std::uint16_t float_to_half(float value) {
+  std::uint32_t f;
+  std::memcpy(&f, &value, sizeof(f));
+  const std::uint16_t sign = static_cast<std::uint16_t>((f >> 16) & 0x8000U);
+  f &= 0x7FFFFFFFU;
+
+  // inf, nans keep the top of their payload and become quiet
+  if (f >= 0x7F800000U)
+    return sign | 0x7C00U |
+           (f > 0x7F800000U ? 0x0200U | ((f & 0x7FFFFFU) >> 13) : 0U);
+  // rounds to a value beyond the largest half
+  if (f >= 0x477FF000U)
+    return sign | 0x7C00U;
+
+  std::uint32_t h;
+  std::uint32_t rest;
+  std::uint32_t halfway;
+  if (f >= 0x38800000U) {
+    // normal: rebias the exponent from 127 to 15, drop 13 mantissa bits
+    h = (f - 0x38000000U) >> 13;
+    rest = f & 0x1FFFU;
+    halfway = 0x1000U;
+  } else if (f >= 0x33000000U) {
+    // subnormal: the mantissa with its implicit one in units of 2^-24
+    const std::uint32_t shift = 126U - (f >> 23);
+    const std::uint32_t m = (f & 0x7FFFFFU) | 0x800000U;
+    h = m >> shift;
+    rest = m & ((1U << shift) - 1U);
+    halfway = 1U << (shift - 1U);
+  } else {
+    return sign;
+  }
+
+  if (rest > halfway || (rest == halfway && (h & 1U)))
+    ++h;
+  return sign | static_cast<std::uint16_t>(h);
+}
+
+inline float half_to_float(std::uint16_t value) {
+  const std::uint32_t sign = (value & 0x8000U) << 16;
+  std::uint32_t exponent = (value >> 10) & 0x1FU;
+  std::uint32_t mantissa = value & 0x3FFU;
+
+  std::uint32_t f;
+  if (exponent == 0x1FU) {
+    f = sign | 0x7F800000U | (mantissa ? 0x400000U | (mantissa << 13) : 0U);
+  } else if (exponent != 0) {
+    f = sign | ((exponent + 112U) << 23) | (mantissa << 13);
+  } else if (mantissa == 0) {
+    f = sign;
+  } else {
+    // subnormal halves are normal floats
+    exponent = 113U;
+    while (!(mantissa & 0x400U)) {
+      mantissa <<= 1;
+      --exponent;
+    }
+    f = sign | (exponent << 23) | ((mantissa & 0x3FFU) << 13);
+  }
+
+  float result;
+  std::memcpy(&result, &f, sizeof(result));
+  return result;
+}
+
+inline void float_to_half(std::uint16_t *dest, const float *src,
+                          std::size_t count) {
+  std::size_t i = 0;
+#if defined(HALF_USE_F16C)
+  for (; i + 8 <= count; i += 8)
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i *>(dest + i),
+        _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+#endif
+  for (; i < count; ++i)
+    dest[i] = float_to_half(src[i]);
+}
+
+inline void half_to_float(float *dest, const std::uint16_t *src,
+                          std::size_t count) {
+  std::size_t i = 0;
+#if defined(HALF_USE_F16C)
+  for (; i + 8 <= count; i += 8)
+    _mm256_storeu_ps(dest + i,
+                     _mm256_cvtph_ps(_mm_loadu_si128(
+                         reinterpret_cast<const __m128i *>(src + i))));
+#endif
+  for (; i < count; ++i)
+    dest[i] = half_to_float(src[i]);
+}
+
+#endif // INCLUDED_HALF
@@ -0,0 +1,209 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef INCLUDED_FRAMEWORK_HOST_EXECUTOR
+#define INCLUDED_FRAMEWORK_HOST_EXECUTOR
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// the host counterpart of a cudaStream_t: tasks run one after the other on a
+// dedicated thread in the order they were enqueued, so enqueue() never blocks
+// the caller. a task that throws poisons the executor, the remaining tasks are
+// dropped and synchronize() rethrows the error, much like a sticky CUDA error.
+class HostExecutor {
+  struct Task {
+    std::function<void()> fn;
+    bool always; // runs even after an error, see signal()
+  };
+
+  std::deque<Task> queue;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable drained;
+  std::size_t pending = 0;
+  std::exception_ptr error;
+  bool stopping = false;
+  std::thread worker;
+
+  void run() {
+    for (;;) {
+      Task task;
+      bool poisoned;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (queue.empty())
+          return;
+        task = std::move(queue.front());
+        queue.pop_front();
+        poisoned = static_cast<bool>(error);
+      }
+
+      std::exception_ptr failure;
+      if (!poisoned || task.always) {
+        try {
+          task.fn();
+        } catch (...) {
+          failure = std::current_exception();
+        }
+      }
+
+      std::lock_guard<std::mutex> lock(mutex);
+      if (failure && !error)
+        error = failure;
+      if (--pending == 0)
+        drained.notify_all();
+    }
+  }
+
+  void push(std::function<void()> fn, bool always) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      queue.push_back({std::move(fn), always});
+      ++pending;
+    }
+    wake.notify_one();
+  }
+
+public:
+  HostExecutor() : worker([this] { run(); }) {}
+
+  HostExecutor(const HostExecutor &) = delete;
+  HostExecutor &operator=(const HostExecutor &) = delete;
+
+  ~HostExecutor() {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      drained.wait(lock, [this] { return pending == 0; });
+      stopping = true;
+    }
+    wake.notify_all();
+    worker.join();
+  }
+
+  void enqueue(std::function<void()> task) { push(std::move(task), false); }
+
+  // like enqueue(), but the task is not dropped after an error. meant for
+  // completion notifications other threads may be waiting for.
+  void signal(std::function<void()> task) { push(std::move(task), true); }
+
+  // true if every task enqueued so far has finished, cf. cudaStreamQuery()
+  bool idle() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending == 0;
+  }
+
+  // rethrows and clears the error of a failed task without waiting for the
+  // queue to drain, cf. cudaGetLastError()
+  void check() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (error) {
+      std::exception_ptr e = error;
+      error = nullptr;
+      std::rethrow_exception(e);
+    }
+  }
+
+  // blocks until all enqueued tasks are done, cf. cudaStreamSynchronize()
+  void synchronize() {
+    std::unique_lock<std::mutex> lock(mutex);
+    drained.wait(lock, [this] { return pending == 0; });
+    if (error) {
+      std::exception_ptr e = error;
+      error = nullptr;
+      std::rethrow_exception(e);
+    }
+  }
+};
+
+// the host counterpart of a cudaEvent_t: record() marks the current end of an
+// executor's queue, wait() makes another executor hold back the tasks enqueued
+// after it until that point is reached. like CUDA events, waiting refers to
+// the most recent record() at the time wait() is called.
+class HostEvent {
+  std::mutex mutex;
+  std::condition_variable reached;
+  std::uint64_t recorded = 0;
+  std::uint64_t completed = 0;
+
+  void complete(std::uint64_t ticket) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (ticket > completed)
+        completed = ticket;
+    }
+    reached.notify_all();
+  }
+
+  void await(std::uint64_t ticket) {
+    std::unique_lock<std::mutex> lock(mutex);
+    reached.wait(lock, [&] { return completed >= ticket; });
+  }
+
+  std::uint64_t last() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return recorded;
+  }
+
+public:
+  HostEvent() = default;
+
+  HostEvent(const HostEvent &) = delete;
+  HostEvent &operator=(const HostEvent &) = delete;
+
+  void record(HostExecutor &executor) {
+    std::uint64_t ticket;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      ticket = ++recorded;
+    }
+    // signalled even if the executor failed, so nobody waits forever
+    executor.signal([this, ticket] { complete(ticket); });
+  }
+
+  void wait(HostExecutor &executor) {
+    const std::uint64_t ticket = last();
+    executor.enqueue([this, ticket] { await(ticket); });
+  }
+
+  // true if the work before the last record() has finished, cf.
+  // cudaEventQuery()
+  bool query() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return completed >= recorded;
+  }
+
+  // blocks until the work before the last record() has finished
+  void synchronize() { await(last()); }
+};
+
+#endif // INCLUDED_FRAMEWORK_HOST_EXECUTOR
@@ -8,18 +8,104 @@
 #include <algorithm>
 #include <cstddef>
 #include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+#include <clim/aligned_malloc.h>
+
+// the pixels of every image start at a multiple of this many bytes, as do
+// the rows of a pitched_image, so whole cache lines and SIMD registers load
+// without splits
+constexpr std::size_t image_alignment = 64;
+
+struct aligned_free_deleter {
+  void operator()(void *ptr) const { aligned_free(ptr); }
+};
+
+// uninitialized storage for count pixels, only for pixel types that need no
+// construction
+template <typename T>
+std::unique_ptr<T[], aligned_free_deleter> allocate_pixels(std::size_t count) {
+  static_assert(std::is_trivially_default_constructible<T>::value &&
+                    std::is_trivially_destructible<T>::value,
+                "pixels are neither constructed nor destroyed");
+  // aligned_malloc() may return null for an empty block
+  T *ptr = aligned_malloc<T *>(std::max<std::size_t>(count, 1) * sizeof(T),
+                               image_alignment);
+  if (!ptr)
+    throw std::bad_alloc();
+  return std::unique_ptr<T[], aligned_free_deleter>(ptr);
+}
+
+// a window onto pixels owned elsewhere, e.g. a region of an image or a
+// camera buffer with padded rows. pitch is the distance of the rows in bytes.
+// T is const for read-only pixels, a view of T converts to one of const T.
+template <typename T> class image_view {
+  using byte = typename std::conditional<std::is_const<T>::value,
+                                         const unsigned char,
+                                         unsigned char>::type;
+
+  T *base;
+  std::size_t w;
+  std::size_t h;
+  std::size_t p;
+
+public:
+  image_view(T *base, std::size_t width, std::size_t height, std::size_t pitch)
+      : base(base), w(width), h(height), p(pitch) {}
+
+  // tightly packed rows
+  image_view(T *base, std::size_t width, std::size_t height)
+      : image_view(base, width, height, width * sizeof(T)) {}
+
+  template <typename U, typename = typename std::enable_if<
+                            std::is_same<const U, T>::value>::type>
+  image_view(const image_view<U> &view)
+      : image_view(data(view), width(view), height(view), pitch(view)) {}
+
+  T *row(std::size_t y) const {
+    return reinterpret_cast<T *>(reinterpret_cast<byte *>(base) + y * p);
+  }
+
+  T &operator()(std::size_t x, std::size_t y) const { return row(y)[x]; }
+
+  friend std::size_t width(const image_view &view) { return view.w; }
+
+  friend std::size_t height(const image_view &view) { return view.h; }
+
+  friend std::size_t pitch(const image_view &view) { return view.p; }
+
+  friend T *data(const image_view &view) { return view.base; }
+
+  // whether the rows follow each other without a gap
+  friend bool contiguous(const image_view &view) {
+    return view.p == view.w * sizeof(T) || view.h <= 1;
+  }
+};
+
+// the w x h pixels at x, y of view, without a copy. throws
+// std::out_of_range if they do not lie within view.
+template <typename T>
+image_view<T> subview(const image_view<T> &view, std::size_t x, std::size_t y,
+                      std::size_t w, std::size_t h) {
+  if (x > width(view) || w > width(view) - x || y > height(view) ||
+      h > height(view) - y)
+    throw std::out_of_range("subview outside of the image");
+  return image_view<T>(view.row(y) + x, w, h, pitch(view));
+}
 
 template <typename T> class image {
-  std::unique_ptr<T[]> m;
+  std::unique_ptr<T[], aligned_free_deleter> m;
 
   std::size_t w;
   std::size_t h;
 
 public:
   image(std::size_t width, std::size_t height)
-      : m(new T[width * height]), w(width), h(height) {}
+      : m(allocate_pixels<T>(width * height)), w(width), h(height) {}
 
-  image(const image &s) : m(new T[s.w * s.h]), w(s.w), h(s.h) {
+  image(const image &s) : m(allocate_pixels<T>(s.w * s.h)), w(s.w), h(s.h) {
     std::copy(&s.m[0], &s.m[0] + w * h, &m[0]);
   }
 
@@ -32,7 +118,7 @@ public:
   image &operator=(const image &s) {
     w = s.w;
     h = s.h;
-    std::unique_ptr<T[]> buffer(new T[w * h]);
+    auto buffer = allocate_pixels<T>(w * h);
     std::copy(&s.m[0], &s.m[0] + w * h, &buffer[0]);
     m = move(buffer);
     return *this;
@@ -61,4 +147,60 @@ public:
   friend T *data(image &img) { return &img.m[0]; }
 };
 
+// an image whose rows are padded to start at multiples of image_alignment
+// bytes. the pixels are left uninitialized.
+template <typename T> class pitched_image {
+  std::unique_ptr<T[], aligned_free_deleter> m;
+
+  std::size_t w;
+  std::size_t h;
+  std::size_t p;
+
+  static std::size_t padded(std::size_t width) {
+    const std::size_t bytes = width * sizeof(T);
+    return (bytes + image_alignment - 1) / image_alignment * image_alignment;
+  }
+
+public:
+  pitched_image(std::size_t width, std::size_t height)
+      : w(width), h(height), p(padded(width)) {
+    // pitches need not be multiples of sizeof(T), so allocate whole pixels
+    // that cover all rows
+    m = allocate_pixels<T>((p * height + sizeof(T) - 1) / sizeof(T));
+  }
+
+  pitched_image(pitched_image &&s) = default;
+  pitched_image &operator=(pitched_image &&s) = default;
+
+  friend std::size_t width(const pitched_image &img) { return img.w; }
+
+  friend std::size_t height(const pitched_image &img) { return img.h; }
+
+  friend std::size_t pitch(const pitched_image &img) { return img.p; }
+
+  friend image_view<T> view(pitched_image &img) {
+    return image_view<T>(img.m.get(), img.w, img.h, img.p);
+  }
+
+  friend image_view<const T> view(const pitched_image &img) {
+    return image_view<const T>(img.m.get(), img.w, img.h, img.p);
+  }
+};
+
+template <typename T> image_view<T> view(image<T> &img) {
+  return image_view<T>(data(img), width(img), height(img));
+}
+
+template <typename T> image_view<const T> view(const image<T> &img) {
+  return image_view<const T>(data(img), width(img), height(img));
+}
+
+// converts every pixel with the convert(T *, const S *, count) of the color
+// types, e.g. image<RGB32F> from image<RGB16F>
+template <typename T, typename S> image<T> convert(const image<S> &src) {
+  image<T> dest(width(src), height(src));
+  convert(data(dest), data(src), width(src) * height(src));
+  return dest;
+}
+
 #endif // INCLUDED_IMAGE
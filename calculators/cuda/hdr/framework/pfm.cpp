@@ -1,64 +1,295 @@
 
 
-#include <fstream>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 
-#include "calculators/cuda/hdr/framework/io.h"
+#include "calculators/cuda/hdr/framework/file_io.h"
+#include "calculators/cuda/hdr/framework/thread_pool.h"
 
 #include "calculators/cuda/hdr/framework/pfm.h"
 
 namespace {
-template <typename T> image<T> load(std::istream &file, const char *type) {
+// rows copied or converted by one task of the thread pool
+constexpr size_t rows_per_task = 32;
+
+// bytes converted to floats before the writer hands them to the file
+constexpr size_t convert_batch_bytes = size_t{32} << 20;
+
+struct Header {
+  size_t width;
+  size_t height;
+  size_t channels;
+  size_t offset; // of the pixels
+};
+
+// parses the header of a mapped Pf or PF file and checks that the file holds
+// all of its pixels
+Header parse(const MappedFile &file, const char *type) {
+  // the header is a few dozen characters, the pixels follow
+  const size_t head = std::min<size_t>(file.size(), 256);
+  std::istringstream in(
+      std::string(reinterpret_cast<const char *>(file.data()), head));
+
   std::string magic;
-  size_t w;
-  size_t h;
+  Header header;
   float a;
-  file >> magic >> w >> h >> a;
+  in >> magic >> header.width >> header.height >> a;
 
-  if (magic != type || a > 0.0f || file.get() != '\n')
+  if (type ? magic != type : magic != "Pf" && magic != "PF")
+    throw std::runtime_error("unsupported file format");
+  if (!in || a > 0.0f || in.get() != '\n')
     throw std::runtime_error("unsupported file format");
 
-  image<T> img(w, h);
+  header.channels = magic == "PF" ? 3 : 1;
+  header.offset = static_cast<size_t>(in.tellg());
+  const size_t row_bytes = header.width * header.channels * sizeof(float);
+  if (header.width == 0 || header.height == 0 ||
+      (file.size() - header.offset) / row_bytes < header.height)
+    throw std::runtime_error("truncated file");
+  return header;
+}
+
+// runs fn(first_row, rows) over all rows on the shared thread pool
+template <typename F> void for_row_blocks(size_t height, F &&fn) {
+  const size_t blocks = (height + rows_per_task - 1) / rows_per_task;
+  ThreadPool::shared().parallel_for(blocks, [&](size_t b) {
+    const size_t first = b * rows_per_task;
+    fn(first, std::min(rows_per_task, height - first));
+  });
+}
 
-  for (size_t j = 0; j < h; ++j)
-    read(file, data(img) + w * (h - 1 - j), w);
+// row j of the image is row src_row(j) of the file
+size_t src_row(size_t j, size_t height, PFM::RowOrder order) {
+  return order == PFM::RowOrder::bottom_up ? j : height - 1 - j;
+}
 
+// throws unless dest has the size of the image in the file
+template <typename T>
+void check_size(const image_view<T> &dest, const Header &header) {
+  if (width(dest) != header.width || height(dest) != header.height)
+    throw std::invalid_argument("the image in the file has another size");
+}
+
+// copies the pixels of the file to dest, flipped unless the rows stay bottom
+// up. memcpy() also reads the pixels of files that are not 4 byte aligned.
+template <typename T>
+void copy_pixels(const image_view<T> &dest, const unsigned char *pixels,
+                 PFM::RowOrder order) {
+  const size_t w = width(dest);
+  const size_t h = height(dest);
+  for_row_blocks(h, [&](size_t first, size_t rows) {
+    if (order == PFM::RowOrder::bottom_up && contiguous(dest)) {
+      std::memcpy(dest.row(first), pixels + sizeof(T) * w * first,
+                  sizeof(T) * w * rows);
+    } else {
+      for (size_t j = first; j < first + rows; ++j)
+        std::memcpy(dest.row(j), pixels + sizeof(T) * w * src_row(j, h, order),
+                    sizeof(T) * w);
+    }
+  });
+}
+
+// converts the pixels of a PF file to any color type that converts from
+// RGB32F
+template <typename T>
+void convert_pixels(const image_view<T> &dest, const unsigned char *pixels,
+                    PFM::RowOrder order) {
+  const size_t w = width(dest);
+  const size_t h = height(dest);
+  for_row_blocks(h, [&](size_t first, size_t rows) {
+    std::vector<RGB32F> row(w);
+    for (size_t j = first; j < first + rows; ++j) {
+      std::memcpy(row.data(),
+                  pixels + sizeof(RGB32F) * w * src_row(j, h, order),
+                  sizeof(RGB32F) * w);
+      convert(dest.row(j), row.data(), w);
+    }
+  });
+}
+
+template <typename T>
+image<T> load(const char *filename, const char *type, PFM::RowOrder order) {
+  const MappedFile file(filename);
+  const Header header = parse(file, type);
+  image<T> img(header.width, header.height);
+  copy_pixels(view(img), file.data() + header.offset, order);
   return img;
 }
 
 template <typename T>
-std::ostream &save(std::ostream &file, const image<T> &img, const char *type) {
-  auto w = width(img);
-  auto h = height(img);
+void load(const char *filename, const char *type, const image_view<T> &dest,
+          PFM::RowOrder order) {
+  const MappedFile file(filename);
+  const Header header = parse(file, type);
+  check_size(dest, header);
+  copy_pixels(dest, file.data() + header.offset, order);
+}
 
-  file << type << '\n' << w << ' ' << h << '\n' << -1.0f << '\n';
+// the header with a scale of -1 padded, so the pixels start at a multiple of
+// 16 bytes and the mapped pixels of the file are aligned for View
+std::string header(const char *type, size_t w, size_t h) {
+  std::ostringstream out;
+  out << type << '\n' << w << ' ' << h << '\n';
+  std::string s = out.str() + "-1";
+  const size_t pad = (16 - (s.size() + 1) % 16) % 16;
+  if (pad > 0)
+    s += '.' + std::string(pad - 1, '0');
+  return s + '\n';
+}
+
+template <typename T>
+void save(const char *filename, const image_view<const T> &img,
+          const char *type, PFM::RowOrder order) {
+  const size_t w = width(img);
+  const size_t h = height(img);
+  const std::string head = header(type, w, h);
 
-  for (size_t j = 0; j < h; ++j)
-    write(file, data(img) + w * (h - j - 1), w);
+  // the rows are handed to the file in the order of the file, so neither
+  // flipping them nor leaving out the padding of the rows costs a copy
+  std::vector<FileSpan> spans;
+  spans.reserve(h + 1);
+  spans.push_back({head.data(), head.size()});
+  if (order == PFM::RowOrder::bottom_up && contiguous(img)) {
+    spans.push_back({data(img), sizeof(T) * w * h});
+  } else {
+    for (size_t j = 0; j < h; ++j)
+      spans.push_back({img.row(src_row(j, h, order)), sizeof(T) * w});
+  }
 
-  return file;
+  OutputFile file(filename);
+  file.write(spans.data(), spans.size());
+}
+
+// PF files of any color type that converts to RGB32F
+template <typename T>
+void save_converted(const char *filename, const image_view<const T> &img,
+                    PFM::RowOrder order) {
+  const size_t w = width(img);
+  const size_t h = height(img);
+  const size_t batch_rows =
+      std::max<size_t>(1, convert_batch_bytes / (sizeof(RGB32F) * w));
+  std::vector<RGB32F> rows(w * std::min(batch_rows, h));
+
+  OutputFile file(filename);
+  const std::string head = header("PF", w, h);
+  file.write(head.data(), head.size());
+
+  // row j of the file is converted from row src_row(j) of the image
+  for (size_t first = 0; first < h; first += batch_rows) {
+    const size_t count = std::min(batch_rows, h - first);
+    for_row_blocks(count, [&](size_t begin, size_t n) {
+      for (size_t j = begin; j < begin + n; ++j)
+        convert(rows.data() + w * j, img.row(src_row(first + j, h, order)),
+                w);
+    });
+    file.write(rows.data(), sizeof(RGB32F) * w * count);
+  }
 }
 } // namespace
 
 namespace PFM {
-image<float> loadR32F(const char *filename) {
-  std::ifstream file(filename, std::ios::binary | std::ios::in);
-  return ::load<float>(file, "Pf");
+View::View(std::unique_ptr<MappedFile> mapped, size_t offset, size_t width,
+           size_t height, size_t channels)
+    : file(std::move(mapped)), w(width), h(height), c(channels) {
+  const unsigned char *payload = file->data() + offset;
+  if (reinterpret_cast<uintptr_t>(payload) % alignof(float) == 0) {
+    pixels = reinterpret_cast<const float *>(payload);
+    return;
+  }
+
+  // files written by other tools may misalign the floats
+  const size_t count = w * h * c;
+  copy.reset(new float[count]);
+  for_row_blocks(h, [&](size_t first, size_t rows) {
+    std::memcpy(copy.get() + w * c * first,
+                payload + sizeof(float) * w * c * first,
+                sizeof(float) * w * c * rows);
+  });
+  pixels = copy.get();
+  file.reset();
+}
+
+View map(const char *filename) {
+  std::unique_ptr<MappedFile> file(new MappedFile(filename));
+  const Header header = parse(*file, nullptr);
+  return View(std::move(file), header.offset, header.width, header.height,
+              header.channels);
+}
+
+std::tuple<int, int> readImageSize(const char *filename) {
+  const MappedFile file(filename);
+  const Header header = parse(file, nullptr);
+  return std::tuple<int, int>(static_cast<int>(header.width),
+                              static_cast<int>(header.height));
+}
+
+image<float> loadR32F(const char *filename, RowOrder order) {
+  return ::load<float>(filename, "Pf", order);
+}
+
+void loadR32F(const char *filename, const image_view<float> &dest,
+              RowOrder order) {
+  ::load(filename, "Pf", dest, order);
+}
+
+void saveR32F(const char *filename, const image<float> &img, RowOrder order) {
+  ::save(filename, view(img), "Pf", order);
+}
+
+void saveR32F(const char *filename, const image_view<const float> &img,
+              RowOrder order) {
+  ::save(filename, img, "Pf", order);
+}
+
+image<RGB32F> loadRGB32F(const char *filename, RowOrder order) {
+  return ::load<RGB32F>(filename, "PF", order);
+}
+
+void loadRGB32F(const char *filename, const image_view<RGB32F> &dest,
+                RowOrder order) {
+  ::load(filename, "PF", dest, order);
+}
+
+void saveRGB32F(const char *filename, const image<RGB32F> &img,
+                RowOrder order) {
+  ::save(filename, view(img), "PF", order);
+}
+
+void saveRGB32F(const char *filename, const image_view<const RGB32F> &img,
+                RowOrder order) {
+  ::save(filename, img, "PF", order);
+}
+
+image<RGB16F> loadRGB16F(const char *filename, RowOrder order) {
+  const MappedFile file(filename);
+  const Header header = parse(file, "PF");
+  image<RGB16F> img(header.width, header.height);
+  convert_pixels(view(img), file.data() + header.offset, order);
+  return img;
 }
 
-void saveR32F(const char *filename, const image<float> &img) {
-  std::ofstream file(filename, std::ios::binary | std::ios::out);
-  ::save(file, img, "Pf");
+void loadRGB16F(const char *filename, const image_view<RGB16F> &dest,
+                RowOrder order) {
+  const MappedFile file(filename);
+  const Header header = parse(file, "PF");
+  check_size(dest, header);
+  convert_pixels(dest, file.data() + header.offset, order);
 }
 
-image<RGB32F> loadRGB32F(const char *filename) {
-  std::ifstream file(filename, std::ios::binary | std::ios::in);
-  return ::load<RGB32F>(file, "PF");
+void saveRGB16F(const char *filename, const image<RGB16F> &img,
+                RowOrder order) {
+  ::save_converted(filename, view(img), order);
 }
 
-void saveRGB32F(const char *filename, const image<RGB32F> &img) {
-  std::ofstream file(filename, std::ios::binary | std::ios::out);
-  ::save(file, img, "PF");
+void saveRGB16F(const char *filename, const image_view<const RGB16F> &img,
+                RowOrder order) {
+  ::save_converted(filename, img, order);
 }
 } // namespace PFM
@@ -6,17 +6,93 @@
 
 #pragma once
 
+#include <cstddef>
+#include <memory>
+#include <tuple>
+
+#include "calculators/cuda/hdr/framework/file_io.h"
+#include "calculators/cuda/hdr/framework/rgb16f.h"
 #include "calculators/cuda/hdr/framework/rgb32f.h"
 #include "calculators/cuda/hdr/framework/image.h"
 
 
 namespace PFM
 {
-	image<float> loadR32F(const char* filename);
-	void saveR32F(const char* filename, const image<float>& image);
+	// the order of the rows in memory. PFM files store the bottom row first,
+	// bottom_up images are read and written without flipping them.
+	enum class RowOrder
+	{
+		top_down,
+		bottom_up
+	};
+
+	// the size of the image in a Pf or PF file
+	std::tuple<int, int> readImageSize(const char* filename);
+
+	// the loaders and savers of views read into and write from pixels owned
+	// elsewhere, e.g. a region of a larger image or rows with padding. the
+	// view to load into needs the size of the image in the file.
+	image<float> loadR32F(const char* filename,
+		RowOrder order = RowOrder::top_down);
+	void loadR32F(const char* filename, const image_view<float>& dest,
+		RowOrder order = RowOrder::top_down);
+	void saveR32F(const char* filename, const image<float>& image,
+		RowOrder order = RowOrder::top_down);
+	void saveR32F(const char* filename, const image_view<const float>& image,
+		RowOrder order = RowOrder::top_down);
+
+	image<RGB32F> loadRGB32F(const char* filename,
+		RowOrder order = RowOrder::top_down);
+	void loadRGB32F(const char* filename, const image_view<RGB32F>& dest,
+		RowOrder order = RowOrder::top_down);
+	void saveRGB32F(const char* filename, const image<RGB32F>& image,
+		RowOrder order = RowOrder::top_down);
+	void saveRGB32F(const char* filename, const image_view<const RGB32F>& image,
+		RowOrder order = RowOrder::top_down);
+
+	// the file holds floats, half images are converted row by row
+	image<RGB16F> loadRGB16F(const char* filename,
+		RowOrder order = RowOrder::top_down);
+	void loadRGB16F(const char* filename, const image_view<RGB16F>& dest,
+		RowOrder order = RowOrder::top_down);
+	void saveRGB16F(const char* filename, const image<RGB16F>& image,
+		RowOrder order = RowOrder::top_down);
+	void saveRGB16F(const char* filename, const image_view<const RGB16F>& image,
+		RowOrder order = RowOrder::top_down);
+
+	// the pixels of a Pf or PF file mapped into memory. files written by the
+	// save functions keep the pixels 4 byte aligned and are not copied, the
+	// pixels of other files are copied once.
+	class View
+	{
+		std::unique_ptr<MappedFile> file;
+		std::unique_ptr<float[]> copy;
+		const float* pixels;
+		std::size_t w;
+		std::size_t h;
+		std::size_t c;
+
+	public:
+		View(std::unique_ptr<MappedFile> file, std::size_t offset,
+		     std::size_t width, std::size_t height, std::size_t channels);
+
+		// all rows in the order of the file, the bottom row first
+		const float* data() const { return pixels; }
+
+		// row y counted from the top of the image
+		const float* row(std::size_t y) const
+		{
+			return pixels + (h - 1 - y) * w * c;
+		}
+
+		friend std::size_t width(const View& view) { return view.w; }
+		friend std::size_t height(const View& view) { return view.h; }
+
+		// 1 for Pf files, 3 for PF files
+		friend std::size_t channels(const View& view) { return view.c; }
+	};
 
-	image<RGB32F> loadRGB32F(const char* filename);
-	void saveRGB32F(const char* filename, const image<RGB32F>& image);
+	View map(const char* filename);
 }
 
 #endif  // INCLUDED_PFM_FILE_FORMAT
@@ -1,10 +1,18 @@
 
 
+#include <algorithm>
+#include <cstdlib>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 
+#include <zlib.h>
+
+#include "calculators/cuda/hdr/framework/file_io.h"
+#include "calculators/cuda/hdr/framework/thread_pool.h"
+
 #include "calculators/cuda/hdr/framework/png.h"
 
 namespace {
@@ -28,6 +36,275 @@ static void flush_fn(png_structp png_ptr) {
   auto &&file = *static_cast<std::ofstream *>(png_get_io_ptr(png_ptr));
   file.flush();
 }
+
+int deflate_level(PNG::Compression compression) {
+  switch (compression) {
+  case PNG::Compression::store:
+    return 0;
+  case PNG::Compression::fast:
+    return 1;
+  case PNG::Compression::best:
+    return 9;
+  default:
+    return 6;
+  }
+}
+
+void configure(png_struct *png_ptr, PNG::Compression compression) {
+  png_set_compression_level(png_ptr, deflate_level(compression));
+  png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE,
+                 compression == PNG::Compression::store  ? PNG_FILTER_NONE
+                 : compression == PNG::Compression::fast ? PNG_FILTER_SUB
+                                                         : PNG_ALL_FILTERS);
+}
+
+// PNG samples are big endian
+void rgb10a2_row(png_byte *row, const RGB10A2 *src, std::size_t w) {
+  for (std::size_t x = 0; x < w; ++x) {
+    const std::uint32_t c = src[x];
+    for (int i = 0; i < 3; ++i) {
+      const std::uint32_t v = (c >> (10 * i)) & 0x3FFU;
+      const std::uint32_t v16 = (v << 6) | (v >> 4);
+      row[8 * x + 2 * i] = static_cast<png_byte>(v16 >> 8);
+      row[8 * x + 2 * i + 1] = static_cast<png_byte>(v16);
+    }
+    const std::uint32_t a16 = (c >> 30) * 0x5555U;
+    row[8 * x + 6] = static_cast<png_byte>(a16 >> 8);
+    row[8 * x + 7] = static_cast<png_byte>(a16);
+  }
+}
+
+png_byte paeth(int a, int b, int c) {
+  const int p = a + b - c;
+  const int pa = std::abs(p - a);
+  const int pb = std::abs(p - b);
+  const int pc = std::abs(p - c);
+  return static_cast<png_byte>(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+}
+
+// filters the size bytes of raw against the row above, prev, with filter
+// type 0 to 4 and writes the type byte and the filtered bytes to out
+void filter_row(png_byte *out, const png_byte *raw, const png_byte *prev,
+                std::size_t size, std::size_t bpp, int type) {
+  out[0] = static_cast<png_byte>(type);
+  ++out;
+  const std::size_t left = std::min(bpp, size);
+  switch (type) {
+  case 0:
+    std::copy(raw, raw + size, out);
+    break;
+  case 1:
+    std::copy(raw, raw + left, out);
+    for (std::size_t i = left; i < size; ++i)
+      out[i] = static_cast<png_byte>(raw[i] - raw[i - bpp]);
+    break;
+  case 2:
+    for (std::size_t i = 0; i < size; ++i)
+      out[i] = static_cast<png_byte>(raw[i] - prev[i]);
+    break;
+  case 3:
+    for (std::size_t i = 0; i < left; ++i)
+      out[i] = static_cast<png_byte>(raw[i] - prev[i] / 2);
+    for (std::size_t i = left; i < size; ++i)
+      out[i] = static_cast<png_byte>(raw[i] - (raw[i - bpp] + prev[i]) / 2);
+    break;
+  default:
+    for (std::size_t i = 0; i < left; ++i)
+      out[i] = static_cast<png_byte>(raw[i] - prev[i]);
+    for (std::size_t i = left; i < size; ++i)
+      out[i] = static_cast<png_byte>(
+          raw[i] - paeth(raw[i - bpp], prev[i], prev[i - bpp]));
+  }
+}
+
+// the filter of the store and the fast presets, otherwise the one with the
+// smallest sum of the filtered bytes taken as signed, the heuristic of libpng
+void filter_row(png_byte *out, const png_byte *raw, const png_byte *prev,
+                std::size_t size, std::size_t bpp,
+                PNG::Compression compression, std::vector<png_byte> &scratch) {
+  if (compression == PNG::Compression::store)
+    return filter_row(out, raw, prev, size, bpp, 0);
+  if (compression == PNG::Compression::fast)
+    return filter_row(out, raw, prev, size, bpp, 1);
+
+  scratch.resize(size + 1);
+  unsigned long best_sum = ~0UL;
+  for (int type = 0; type < 5; ++type) {
+    filter_row(scratch.data(), raw, prev, size, bpp, type);
+    unsigned long sum = 0;
+    for (std::size_t i = 1; i <= size; ++i)
+      sum += scratch[i] < 128 ? scratch[i] : 256 - scratch[i];
+    if (sum < best_sum) {
+      best_sum = sum;
+      std::copy(scratch.begin(), scratch.end(), out);
+    }
+  }
+}
+
+void store_u32(png_byte *dest, std::uint32_t v) {
+  dest[0] = static_cast<png_byte>(v >> 24);
+  dest[1] = static_cast<png_byte>(v >> 16);
+  dest[2] = static_cast<png_byte>(v >> 8);
+  dest[3] = static_cast<png_byte>(v);
+}
+
+// a chunk of the file, the length and type in front of the data and the CRC
+// behind it
+struct Chunk {
+  png_byte head[8];
+  const void *data;
+  std::size_t size;
+  png_byte crc[4];
+
+  Chunk(const char *type, const void *data, std::size_t size)
+      : data(data), size(size) {
+    store_u32(head, static_cast<std::uint32_t>(size));
+    std::copy(type, type + 4, head + 4);
+    uLong crc_value = crc32(0L, head + 4, 4);
+    // crc32() restarts from a null pointer
+    if (size > 0)
+      crc_value = crc32(crc_value, static_cast<const Bytef *>(data),
+                        static_cast<uInt>(size));
+    store_u32(crc, static_cast<std::uint32_t>(crc_value));
+  }
+};
+
+struct Strip {
+  std::vector<png_byte> deflated;
+  uLong adler;
+  std::size_t filtered_size;
+};
+
+// filters and deflates rows [first, first + count) as a raw deflate stream
+// that ends at a byte boundary, by a sync flush or for the last strip by the
+// final block
+template <typename RowFn>
+void deflate_strip(Strip &strip, std::size_t first, std::size_t count,
+                   std::size_t height, std::size_t row_size, std::size_t bpp,
+                   PNG::Compression compression, const RowFn &row) {
+  std::vector<png_byte> filtered((row_size + 1) * count);
+  std::vector<png_byte> raw(row_size);
+  std::vector<png_byte> above(row_size);
+  std::vector<png_byte> scratch;
+
+  if (first > 0) {
+    const png_byte *prev = row(first - 1, raw.data());
+    std::copy(prev, prev + row_size, above.data());
+  }
+  for (std::size_t j = 0; j < count; ++j) {
+    const png_byte *current = row(first + j, raw.data());
+    filter_row(filtered.data() + (row_size + 1) * j, current, above.data(),
+               row_size, bpp, compression, scratch);
+    // the rows returned may live in raw, so keep a copy of the one above
+    std::copy(current, current + row_size, above.data());
+  }
+
+  strip.filtered_size = filtered.size();
+  strip.adler = adler32(adler32(0L, nullptr, 0), filtered.data(),
+                        static_cast<uInt>(filtered.size()));
+
+  z_stream z = {};
+  if (deflateInit2(&z, deflate_level(compression), Z_DEFLATED, -15, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK)
+    throw std::runtime_error("deflateInit2() failed");
+
+  const bool last = first + count == height;
+  strip.deflated.resize(deflateBound(&z, static_cast<uLong>(filtered.size())) +
+                        64);
+  z.next_in = filtered.data();
+  z.avail_in = static_cast<uInt>(filtered.size());
+  std::size_t written = 0;
+  for (;;) {
+    z.next_out = strip.deflated.data() + written;
+    z.avail_out = static_cast<uInt>(strip.deflated.size() - written);
+    const int result = deflate(&z, last ? Z_FINISH : Z_SYNC_FLUSH);
+    written = strip.deflated.size() - z.avail_out;
+    if (result == Z_STREAM_END || (!last && result == Z_OK && z.avail_out > 0))
+      break;
+    if (result != Z_OK && result != Z_BUF_ERROR) {
+      deflateEnd(&z);
+      throw std::runtime_error("deflate() failed");
+    }
+    strip.deflated.resize(2 * strip.deflated.size());
+  }
+  deflateEnd(&z);
+  strip.deflated.resize(written);
+}
+
+// writes a RGBA image of 8 or 16 bits per channel without libpng. row(y,
+// buffer) returns the bytes of row y as PNG stores them, either in place or
+// converted into buffer.
+template <typename RowFn>
+void save_strips(const char *filename, std::size_t w, std::size_t h,
+                 int bit_depth, const PNG::EncodeSettings &settings,
+                 const RowFn &row) {
+  if (w == 0 || h == 0 || w > 0x7FFFFFFFU || h > 0x7FFFFFFFU)
+    throw std::runtime_error("image size not supported by PNG");
+
+  const std::size_t bpp = 4 * bit_depth / 8;
+  const std::size_t row_size = bpp * w;
+  const std::size_t strip_rows = settings.strip_rows;
+  std::vector<Strip> strips((h + strip_rows - 1) / strip_rows);
+
+  ThreadPool::shared().parallel_for(strips.size(), [&](std::size_t i) {
+    const std::size_t first = i * strip_rows;
+    deflate_strip(strips[i], first, std::min(strip_rows, h - first), h,
+                  row_size, bpp, settings.compression, row);
+  });
+
+  // the strips joined into one zlib stream, the checksum combined from theirs
+  const int level = deflate_level(settings.compression);
+  const unsigned int flevel = level < 2   ? 0
+                             : level < 6  ? 1
+                             : level == 6 ? 2
+                                          : 3;
+  const unsigned int cmf = 0x78;
+  unsigned int flg = flevel << 6;
+  flg += (31 - (cmf * 256 + flg) % 31) % 31;
+  const png_byte zlib_header[2] = {static_cast<png_byte>(cmf),
+                                   static_cast<png_byte>(flg)};
+
+  uLong adler = adler32(0L, nullptr, 0);
+  for (const Strip &strip : strips)
+    adler = adler32_combine(adler, strip.adler,
+                            static_cast<z_off_t>(strip.filtered_size));
+  png_byte zlib_trailer[4];
+  store_u32(zlib_trailer, static_cast<std::uint32_t>(adler));
+
+  png_byte ihdr[13];
+  store_u32(ihdr, static_cast<std::uint32_t>(w));
+  store_u32(ihdr + 4, static_cast<std::uint32_t>(h));
+  ihdr[8] = static_cast<png_byte>(bit_depth);
+  ihdr[9] = PNG_COLOR_TYPE_RGB_ALPHA;
+  ihdr[10] = PNG_COMPRESSION_TYPE_BASE;
+  ihdr[11] = PNG_FILTER_TYPE_BASE;
+  ihdr[12] = PNG_INTERLACE_NONE;
+
+  static const png_byte signature[8] = {0x89, 'P', 'N', 'G',
+                                        '\r', '\n', 0x1A, '\n'};
+
+  // one IDAT chunk per strip between the ones of the zlib header and trailer
+  std::vector<Chunk> chunks;
+  chunks.reserve(strips.size() + 4);
+  chunks.emplace_back("IHDR", ihdr, sizeof(ihdr));
+  chunks.emplace_back("IDAT", zlib_header, sizeof(zlib_header));
+  for (const Strip &strip : strips)
+    chunks.emplace_back("IDAT", strip.deflated.data(), strip.deflated.size());
+  chunks.emplace_back("IDAT", zlib_trailer, sizeof(zlib_trailer));
+  chunks.emplace_back("IEND", nullptr, 0);
+
+  std::vector<FileSpan> spans;
+  spans.reserve(3 * chunks.size() + 1);
+  spans.push_back({signature, sizeof(signature)});
+  for (const Chunk &chunk : chunks) {
+    spans.push_back({chunk.head, sizeof(chunk.head)});
+    spans.push_back({chunk.data, chunk.size});
+    spans.push_back({chunk.crc, sizeof(chunk.crc)});
+  }
+
+  OutputFile file(filename);
+  file.write(spans.data(), spans.size());
+}
 } // namespace
 
 namespace PNG {
@@ -76,12 +353,14 @@ OStream::OStream(const char *filename)
 
 OStream::~OStream() { png_destroy_write_struct(&png_ptr, &info_ptr); }
 
-RGBA8OStream::RGBA8OStream(const char *filename, size_t width, size_t height)
+RGBA8OStream::RGBA8OStream(const char *filename, size_t width, size_t height,
+                           Compression compression)
     : OStream(filename) {
   png_set_IHDR(*this, *this, static_cast<png_uint_32>(width),
                static_cast<png_uint_32>(height), 8, PNG_COLOR_TYPE_RGB_ALPHA,
                PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
                PNG_FILTER_TYPE_DEFAULT);
+  configure(*this, compression);
 
   png_write_info(*this, *this);
 }
@@ -103,9 +382,10 @@ std::tuple<int, int> readImageSize(const char *filename) {
   return std::tuple<int, int>(w, h);
 }
 
-image<std::uint32_t> loadImage2D(const char *filename) {
-  IStream file(filename);
-
+namespace {
+// sets libpng up to read any image as 8 bit RGBA and returns its size
+std::tuple<png_uint_32, png_uint_32> read_rgba8_info(IStream &file,
+                                                     const char *filename) {
   png_uint_32 w, h;
   int bit_depth, color_type, interlace_method, compression_method,
       filter_method;
@@ -134,20 +414,58 @@ image<std::uint32_t> loadImage2D(const char *filename) {
 
   png_read_update_info(file, file);
 
-  image<std::uint32_t> img(w, h);
+  return std::tuple<png_uint_32, png_uint_32>(w, h);
+}
 
+void read_rows(IStream &file, const image_view<std::uint32_t> &dest) {
+  const std::size_t h = height(dest);
   std::unique_ptr<png_byte *[]> rows(new png_byte *[h]);
-  for (png_uint_32 y = 0; y < h; ++y)
-    rows[y] = reinterpret_cast<png_byte *>(data(img) + y * w);
+  for (std::size_t y = 0; y < h; ++y)
+    rows[y] = reinterpret_cast<png_byte *>(dest.row(y));
 
   png_read_image(file, &rows[0]);
 
   png_read_end(file, file);
+}
+} // namespace
 
+image<std::uint32_t> loadImage2D(const char *filename) {
+  IStream file(filename);
+
+  png_uint_32 w, h;
+  std::tie(w, h) = read_rgba8_info(file, filename);
+
+  image<std::uint32_t> img(w, h);
+  read_rows(file, view(img));
   return img;
 }
 
-void saveImage(const char *filename, const image<std::uint32_t> &img) {
+void loadImage2D(const char *filename, const image_view<std::uint32_t> &dest) {
+  IStream file(filename);
+
+  png_uint_32 w, h;
+  std::tie(w, h) = read_rgba8_info(file, filename);
+  if (w != width(dest) || h != height(dest))
+    throw std::invalid_argument("the image in the file has another size");
+
+  read_rows(file, dest);
+}
+
+void saveImage(const char *filename, const image<std::uint32_t> &img,
+               const EncodeSettings &settings) {
+  saveImage(filename, view(img), settings);
+}
+
+void saveImage(const char *filename, const image_view<const std::uint32_t> &img,
+               const EncodeSettings &settings) {
+  if (settings.strip_rows > 0) {
+    save_strips(filename, width(img), height(img), 8, settings,
+                [&](std::size_t y, png_byte *) {
+                  return reinterpret_cast<const png_byte *>(img.row(y));
+                });
+    return;
+  }
+
   OStream file(filename);
 
   int w = static_cast<int>(width(img));
@@ -156,11 +474,48 @@ void saveImage(const char *filename, const image<std::uint32_t> &img) {
   png_set_IHDR(file, file, w, h, 8, PNG_COLOR_TYPE_RGB_ALPHA,
                PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
                PNG_FILTER_TYPE_DEFAULT);
+  configure(file, settings.compression);
 
   png_write_info(file, file);
 
   for (int y = 0; y < h; ++y)
-    png_write_row(file, reinterpret_cast<const png_byte *>(data(img) + y * w));
+    png_write_row(file, reinterpret_cast<const png_byte *>(img.row(y)));
+
+  png_write_end(file, file);
+}
+
+void saveImage(const char *filename, const image<RGB10A2> &img,
+               const EncodeSettings &settings) {
+  saveImage(filename, view(img), settings);
+}
+
+void saveImage(const char *filename, const image_view<const RGB10A2> &img,
+               const EncodeSettings &settings) {
+  const std::size_t w = width(img);
+  if (settings.strip_rows > 0) {
+    save_strips(filename, w, height(img), 16, settings,
+                [&](std::size_t y, png_byte *row) {
+                  rgb10a2_row(row, img.row(y), w);
+                  return const_cast<const png_byte *>(row);
+                });
+    return;
+  }
+
+  OStream file(filename);
+
+  png_set_IHDR(file, file, static_cast<png_uint_32>(w),
+               static_cast<png_uint_32>(height(img)), 16,
+               PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE,
+               PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+  configure(file, settings.compression);
+
+  png_write_info(file, file);
+
+  std::vector<png_byte> row(8 * w);
+  for (std::size_t y = 0; y < height(img); ++y) {
+    rgb10a2_row(row.data(), img.row(y), w);
+    png_write_row(file, row.data());
+  }
 
   png_write_end(file, file);
 }
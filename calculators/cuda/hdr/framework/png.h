@@ -13,8 +13,25 @@
 #include <png.h>
 
 #include "calculators/cuda/hdr/framework/image.h"
+#include "calculators/cuda/hdr/framework/rgb10a2.h"
 
 namespace PNG {
+// speed against size of the written files
+enum class Compression {
+  store,    // neither filtered nor compressed, the fastest
+  fast,     // the sub filter and the fastest deflate level
+  balanced, // adaptive filters and the default deflate level of zlib
+  best      // adaptive filters and the highest deflate level
+};
+
+struct EncodeSettings {
+  Compression compression = Compression::balanced;
+  // strips of this many rows are filtered and deflated independently on the
+  // shared thread pool and joined at sync flush points into one stream. 0
+  // leaves the whole image to libpng on the calling thread.
+  unsigned int strip_rows = 64;
+};
+
 class IStream {
   std::ifstream file;
   png_struct *png_ptr;
@@ -55,7 +72,8 @@ public:
 
 class RGBA8OStream : public OStream {
 public:
-  RGBA8OStream(const char *filename, size_t width, size_t height);
+  RGBA8OStream(const char *filename, size_t width, size_t height,
+               Compression compression = Compression::balanced);
   ~RGBA8OStream();
 
   void writeRow(const std::uint32_t *row);
@@ -63,8 +81,22 @@ public:
 
 std::tuple<int, int> readImageSize(const char *filename);
 
+// the overloads of views read into and write from pixels owned elsewhere,
+// e.g. a region of a larger image. the view to load into needs the size of
+// the image in the file.
 image<std::uint32_t> loadImage2D(const char *filename);
-void saveImage(const char *filename, const image<std::uint32_t> &surface);
+void loadImage2D(const char *filename, const image_view<std::uint32_t> &dest);
+void saveImage(const char *filename, const image<std::uint32_t> &surface,
+               const EncodeSettings &settings = {});
+void saveImage(const char *filename,
+               const image_view<const std::uint32_t> &surface,
+               const EncodeSettings &settings = {});
+// written as 16 bit RGBA, the 10 bit channels are scaled up by replicating
+// their top bits
+void saveImage(const char *filename, const image<RGB10A2> &surface,
+               const EncodeSettings &settings = {});
+void saveImage(const char *filename, const image_view<const RGB10A2> &surface,
+               const EncodeSettings &settings = {});
 } // namespace PNG
 
 #endif // INCLUDED_FRAMEWORK_PNG_FILE_FORMAT
@@ -0,0 +1,80 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef INCLUDED_COLOR_RGB10A2
+#define INCLUDED_COLOR_RGB10A2
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "calculators/cuda/hdr/framework/rgb32f.h"
+
+// 10 bit unsigned normalized red, green and blue plus 2 bit alpha in one
+// 32 bit word, red in the lowest bits like RGBA8. channels are clamped to
+// [0, 1], so this is meant for display referred images.
+class RGB10A2 {
+  std::uint32_t color;
+
+  // nan becomes 0
+  static std::uint32_t quantize(float c, float max) {
+    return static_cast<std::uint32_t>(
+        (c > 0.0f ? (c < 1.0f ? c : 1.0f) : 0.0f) * max + 0.5f);
+  }
+
+public:
+  RGB10A2() = default;
+
+  explicit RGB10A2(std::uint32_t color) : color(color) {}
+
+  RGB10A2(float r, float g, float b, float a = 1.0f)
+      : color(quantize(r, 1023.0f) | (quantize(g, 1023.0f) << 10U) |
+              (quantize(b, 1023.0f) << 20U) | (quantize(a, 3.0f) << 30U)) {}
+
+  operator std::uint32_t() const { return color; }
+
+  template <int i> friend float channel(const RGB10A2 &color);
+};
+
+template <int i> inline float channel(const RGB10A2 &color) {
+  static_assert(i >= 0 && i < 4, "invalid color channel index");
+  if (i == 3)
+    return (color.color >> 30U) * (1.0f / 3.0f);
+  return ((color.color >> (10U * i)) & 0x3FFU) * (1.0f / 1023.0f);
+}
+
+inline void convert(RGB32F *dest, const RGB10A2 *src, std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i)
+    dest[i] = RGB32F(channel<0>(src[i]), channel<1>(src[i]),
+                     channel<2>(src[i]));
+}
+
+inline void convert(RGB10A2 *dest, const RGB32F *src, std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i)
+    dest[i] = RGB10A2(channel<0>(src[i]), channel<1>(src[i]),
+                      channel<2>(src[i]));
+}
+
+#endif // INCLUDED_COLOR_RGB10A2
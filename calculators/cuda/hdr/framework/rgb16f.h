@@ -0,0 +1,68 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef INCLUDED_COLOR_RGB16F
+#define INCLUDED_COLOR_RGB16F
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "calculators/cuda/hdr/framework/half.h"
+#include "calculators/cuda/hdr/framework/rgb32f.h"
+
+// RGB32F with half precision channels, half the size for images that do not
+// need the full range and precision of float
+class RGB16F {
+  std::uint16_t color[3];
+
+public:
+  RGB16F() = default;
+
+  RGB16F(float r, float g, float b)
+      : color{float_to_half(r), float_to_half(g), float_to_half(b)} {}
+
+  template <int i> friend float channel(const RGB16F &color);
+};
+
+template <int i> inline float channel(const RGB16F &color) {
+  static_assert(i >= 0 && i < 3, "invalid color channel index");
+  return half_to_float(color.color[i]);
+}
+
+static_assert(sizeof(RGB16F) == 3 * sizeof(std::uint16_t),
+              "RGB16F must be three packed halves");
+
+inline void convert(RGB32F *dest, const RGB16F *src, std::size_t count) {
+  half_to_float(reinterpret_cast<float *>(dest),
+                reinterpret_cast<const std::uint16_t *>(src), 3 * count);
+}
+
+inline void convert(RGB16F *dest, const RGB32F *src, std::size_t count) {
+  float_to_half(reinterpret_cast<std::uint16_t *>(dest),
+                reinterpret_cast<const float *>(src), 3 * count);
+}
+
+#endif // INCLUDED_COLOR_RGB16F
@@ -5,6 +5,9 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+
 class RGB32F {
   float color[3];
 
@@ -21,4 +24,9 @@ template <int i> inline float channel(const RGB32F &color) {
   return color.color[i];
 }
 
+// conversions between the color types have this form, see image.h
+inline void convert(RGB32F *dest, const RGB32F *src, std::size_t count) {
+  std::copy_n(src, count, dest);
+}
+
 #endif // INCLUDED_COLOR_RGB32F
@@ -0,0 +1,140 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef INCLUDED_FRAMEWORK_THREAD_POOL
+#define INCLUDED_FRAMEWORK_THREAD_POOL
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// fixed set of worker threads used by the host implementations of the
+// pipeline stages. parallel_for() lets the calling thread take part in the
+// work, so it may safely be called from inside a task running on the pool.
+class ThreadPool {
+  std::vector<std::thread> workers;
+  std::deque<std::function<void()>> tasks;
+  std::mutex mutex;
+  std::condition_variable wake;
+  bool stopping = false;
+
+  void run() {
+    for (;;) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [this] { return stopping || !tasks.empty(); });
+        if (tasks.empty())
+          return;
+        task = std::move(tasks.front());
+        tasks.pop_front();
+      }
+      task();
+    }
+  }
+
+public:
+  explicit ThreadPool(unsigned int num_threads =
+                          std::max(1U, std::thread::hardware_concurrency())) {
+    // the caller of parallel_for() works too, so spawn one thread less
+    for (unsigned int i = 1; i < num_threads; ++i)
+      workers.emplace_back([this] { run(); });
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    wake.notify_all();
+    for (auto &w : workers)
+      w.join();
+  }
+
+  unsigned int size() const {
+    return static_cast<unsigned int>(workers.size()) + 1U;
+  }
+
+  // invokes fn(i) for every i in [0, count) and returns once all are done
+  template <typename F> void parallel_for(std::size_t count, F &&fn) {
+    if (count == 0)
+      return;
+    if (count == 1 || workers.empty()) {
+      for (std::size_t i = 0; i < count; ++i)
+        fn(i);
+      return;
+    }
+
+    struct State {
+      std::atomic<std::size_t> next{0};
+      std::atomic<std::size_t> done{0};
+      std::mutex mutex;
+      std::condition_variable finished;
+    };
+    auto state = std::make_shared<State>();
+
+    auto work = [state, count, &fn] {
+      std::size_t completed = 0;
+      for (std::size_t i; (i = state->next.fetch_add(1)) < count; ++completed)
+        fn(i);
+      if (completed &&
+          state->done.fetch_add(completed) + completed == count) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->finished.notify_all();
+      }
+    };
+
+    std::size_t helpers = std::min(count - 1, workers.size());
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (std::size_t i = 0; i < helpers; ++i)
+        tasks.emplace_back(work);
+    }
+    wake.notify_all();
+
+    work();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&] { return state->done.load() == count; });
+  }
+
+  // process wide pool shared by all host stages
+  static ThreadPool &shared() {
+    static ThreadPool pool;
+    return pool;
+  }
+};
+
+#endif // INCLUDED_FRAMEWORK_THREAD_POOL
@@ -21,9 +21,14 @@
 // SOFTWARE.
 //
 
+#include <cuda_runtime_api.h>
 #include <math/vector.h>
 
+#include "calculators/cuda/hdr/bloom.cuh"
 #include "calculators/cuda/hdr/color.cuh"
+#include "calculators/cuda/hdr/framework/rgba8.h"
+#include "calculators/cuda/hdr/luminance_reduction.h"
+#include "calculators/cuda/hdr/storage.cuh"
 
 namespace {
 constexpr unsigned int divup(unsigned int a, unsigned int b) {
@@ -64,7 +69,7 @@ __global__ void luminance_kernel(float *dest, const float *input,
 // get the required number of blocks to cover the whole image, and run the
 // kernel on all blocks
 void luminance(float *dest, const float *input, unsigned int width,
-               unsigned int height) {
+               unsigned int height, cudaStream_t stream) {
   const dim3 block_size = {32, 32};
   // calculate number of blocks required to process the whole image -> round up
   // to the next multiple of 32 (full block)
@@ -72,15 +77,8 @@ void luminance(float *dest, const float *input, unsigned int width,
                            divup(height, block_size.y)};
 
   // launch the kernel that we wrote above for all the blocks
-  luminance_kernel<<<num_blocks, block_size>>>(dest, input, width, height);
-
-  // this 'downsampling' step takes about 1.3ms on a GT 730m
-  // now we want to run this in a hierarchical way: reduce the image in each
-  // step
-  // -> launch blocks on the images, reducing its size each step until we end up
-  // with a 1x1 color
-  // -> we need to allocate memory for a buffer in the HDRPipeline object
-  // declaration
+  luminance_kernel<<<num_blocks, block_size, 0, stream>>>(dest, input, width,
+                                                        height);
 }
 
 __global__ void downsample_kernel(float *dest, float *input, unsigned int width,
@@ -126,223 +124,608 @@ __global__ void downsample_kernel(float *dest, float *input, unsigned int width,
   dest[y * outputPitch + x] = sum / nb_counted;
 }
 
-// get the required number of blocks to cover the whole image, and run the
-// kernel on all blocks
-float downsample(float *dest, float *luminance, unsigned int width,
-                 unsigned int height) {
+// one 2x2 box filter pass, only used to inspect the first level of the
+// luminance pyramid. the average luminance itself comes from
+// reduce_luminance(), which does not need any intermediate images.
+void downsample(float *dest, float *luminance, unsigned int width,
+                unsigned int height, cudaStream_t stream) {
+  const dim3 block_size = {32, 32};
+  const dim3 num_blocks = {divup(divup(width, 2), block_size.x),
+                           divup(divup(height, 2), block_size.y)};
+
+  downsample_kernel<<<num_blocks, block_size, 0, stream>>>(
+      dest, luminance, width, height, divup(width, 2), width);
+}
+
+template <typename O, typename I>
+__global__ void compose_kernel(O *output, const I *tonemapped,
+                               const I *blurred, unsigned int width,
+                               unsigned int height) {
+  unsigned int x = blockIdx.x * blockDim.x + threadIdx.x;
+  unsigned int y = blockIdx.y * blockDim.y + threadIdx.y;
+
+  if (x < width && y < height)
+    store_pixel(output, y * width + x,
+                load_pixel(tonemapped, y * width + x) +
+                    load_pixel(blurred, y * width + x));
+}
+
+namespace {
+template <typename O, typename I>
+void launch_compose(O *output, const I *tonemapped, const I *blurred,
+                    unsigned int width, unsigned int height,
+                    cudaStream_t stream) {
   const dim3 block_size = {32, 32};
-  // calculate number of blocks required to process the whole image -> round up
-  // to the next multiple of 32 (full block)
   const dim3 num_blocks = {divup(width, block_size.x),
                            divup(height, block_size.y)};
 
-  // Store original width = width of buffer
-  const unsigned int pitchBuf = width / 2;
-  const unsigned int pitchLuminance = width;
-
-  // first iteration
-  downsample_kernel<<<num_blocks, block_size>>>(dest, luminance, width, height,
-                                                pitchBuf, pitchLuminance);
-  int ping = 0; // result in dest buffer
-
-  while (width != 1 || height != 1) {
-    // result will be in the dest buffer
-    width = width / 2;
-    height = height / 2;
-    if (width < 1) {
-      width = 1;
-      //			printf("width < 1 \n");
-    }
-    if (height < 1) {
-      height = 1;
-      //			printf("height < 1 \n");
-    }
+  compose_kernel<<<num_blocks, block_size, 0, stream>>>(
+      output, tonemapped, blurred, width, height);
+}
+} // namespace
 
-    //		printf(" width %d | height %d \n", width, height);
-    if (ping) {
-      downsample_kernel<<<num_blocks, block_size>>>(
-          dest, luminance, width, height, pitchBuf, pitchLuminance);
-    } else {
-      // now ping-pong; result will be in the luminance buffer
-      downsample_kernel<<<num_blocks, block_size>>>(
-          luminance, dest, width, height, pitchLuminance, pitchBuf);
-    }
-    ping = !ping;
-  }
+// adds the blurred brightpass (bloom) to the tonemapped image
+void compose(float *output, const float *tonemapped, const float *blurred,
+             unsigned int width, unsigned int height, cudaStream_t stream) {
+  launch_compose(output, tonemapped, blurred, width, height, stream);
+}
 
-  // make sure the result is stored in dest
-  if (ping) {
-    cudaMemcpy(luminance, dest, 1, cudaMemcpyDeviceToDevice);
-  }
+void compose(RGB16F *output, const RGB16F *tonemapped, const RGB16F *blurred,
+             unsigned int width, unsigned int height, cudaStream_t stream) {
+  launch_compose(output, tonemapped, blurred, width, height, stream);
+}
+
+void compose(RGB10A2 *output, const RGB16F *tonemapped,
+             const RGB16F *blurred, unsigned int width, unsigned int height,
+             cudaStream_t stream) {
+  launch_compose(output, tonemapped, blurred, width, height, stream);
+}
+
+__device__ math::float3 brightpass_color(const math::float3 &c_t,
+                                         float brightpass_threshold) {
+  return luminance(c_t) > brightpass_threshold ? c_t
+                                               : math::float3{0.0f, 0.0f, 0.0f};
+}
 
-  // return the grayscale value
-  float average;
-  cudaMemcpy(&average, dest, sizeof(float), cudaMemcpyDeviceToHost);
-  return average;
-}
-
-// first do it on the x direction
-// then do it on the y direction (-> texture memory to make this fast)
-__constant__ float weights[] = { // weights in one dimension -> 33x33 filter
-    //  -16           -15         -14          -13          -12          -11 -10
-    //  -9           -8           -7           -6           -5           -4 -3
-    //  -2           -1
-    0.00288204f, 0.00418319f, 0.00592754f, 0.00819980f, 0.01107369f,
-    0.01459965f, 0.01879116f, 0.02361161f, 0.02896398f, 0.03468581f,
-    0.04055144f, 0.04628301f, 0.05157007f, 0.05609637f, 0.05957069f,
-    0.06175773f,
-    //    0
-    0.06250444f,
-    //    1             2           3            4            5            6 7
-    //    8            9           10           11           12           13 14
-    //    15           16
-    0.06175773f, 0.05957069f, 0.05609637f, 0.05157007f, 0.04628301f,
-    0.04055144f, 0.03468581f, 0.02896398f, 0.02361161f, 0.01879116f,
-    0.01459965f, 0.01107369f, 0.00819980f, 0.00592754f, 0.00418319f,
-    0.00288204f};
-
-__global__ void blur_kernel_x(float *dest, const float *src, unsigned int width,
-                              unsigned int height, unsigned int inputPitch,
-                              unsigned int outputPitch) {
-  // 1 thread per output pixel
+// exposure is divided by the average luminance in device memory unless
+// average is null, so the pipeline never has to wait for the reduction.
+// blockIdx.z is the image of a batch, each divided by its own average.
+template <typename T, typename Op>
+__global__ void tonemap_kernel(T *tonemapped, T *brightpass,
+                               const float *src, unsigned int width,
+                               unsigned int height,
+                               const LuminanceStats *average, float exposure,
+                               float brightpass_threshold, Op op) {
   unsigned int x = blockIdx.x * blockDim.x + threadIdx.x;
   unsigned int y = blockIdx.y * blockDim.y + threadIdx.y;
 
-  //	__shared__ float blur_buffer[65*65];
-  //	if (threadIdx.x == 0){
-  //		// read 64x64 input image into shared buffer
-  //		// make sure you don't read out of bounds when the kernels
-  //operate near the image borders 		int startx = max(0,x - 64);
-  // int endx = min(width-1, x+64);
-  //
-  //		int starty = max(0,y - 64);
-  //		int endy = min(height-1, y+64);
-  //
-  //		blur_buffer = src[startx:endx][starty:endy];
-  //		for (int i = 0; i < 65; i++){
-  //			for (int j = 0; j< 65){
-  //				// if the kernel is near the borders, you need to fill
-  //the buffer with zeros at the right places
-  //				// so the access of the  buffer is easy relative to
-  //the thread coordinates.
-  //			}
-  //		}
-  //	}
-
-  float sumR = 0.0f;
-  float sumG = 0.0f;
-  float sumB = 0.0f;
-
-  for (int i = -16; i <= 16; i++) {
-    if ((3 * (x + i) > 0) && (3 * (x + i) < 3 * width)) {
-      sumR += src[3 * y * inputPitch + 3 * (x + i)] * weights[i + 16];
-      sumG += src[3 * y * inputPitch + 3 * (x + i) + 1] * weights[i + 16];
-      sumB += src[3 * y * inputPitch + 3 * (x + i) + 2] * weights[i + 16];
-    }
+  if (average)
+    exposure /= average[blockIdx.z].average;
+
+  if (x < width && y < height) {
+    const unsigned int i = (blockIdx.z * height + y) * width + x;
+
+    // figure out input color
+    math::float3 c = {src[3 * i + 0], src[3 * i + 1], src[3 * i + 2]};
+
+    // compute tonemapped color
+    math::float3 c_t = tonemap(c, exposure, op);
+
+    // write out tonemapped color
+    store_pixel(tonemapped, i, c_t);
+
+    // write out brightpass color
+    store_pixel(brightpass, i, brightpass_color(c_t, brightpass_threshold));
   }
-  //	if (!threadIdx.x){
-  //		printf("sumR: %f | sumG: %f | sumB: %f \n", sumR, sumG, sumB);
-  //	}
+}
+
+namespace {
+template <typename T>
+void launch_tonemap(T *tonemapped, T *brightpass, const float *src,
+                    unsigned int width, unsigned int height,
+                    const LuminanceStats *average, float exposure,
+                    float brightpass_threshold, const TonemapSettings &tonemap,
+                    const float *lut, cudaStream_t stream,
+                    unsigned int batch) {
+  const auto block_size = dim3{32U, 32U};
 
-  dest[3 * y * outputPitch + 3 * x] = sumR;
-  dest[3 * y * outputPitch + 3 * x + 1] = sumG;
-  dest[3 * y * outputPitch + 3 * x + 2] = sumB;
+  auto num_blocks =
+      dim3{divup(width, block_size.x), divup(height, block_size.y), batch};
+
+  with_tonemap(tonemap, lut, [&](auto op) {
+    tonemap_kernel<<<num_blocks, block_size, 0, stream>>>(
+        tonemapped, brightpass, src, width, height, average, exposure,
+        brightpass_threshold, op);
+  });
 }
+} // namespace
 
-__global__ void blur_kernel_y(float *dest, const float *src, unsigned int width,
-                              unsigned int height, unsigned int inputPitch,
-                              unsigned int outputPitch) {
+void tonemap(float *tonemapped, float *brightpass, const float *src,
+             unsigned int width, unsigned int height,
+             const LuminanceStats *average, float exposure,
+             float brightpass_threshold, const TonemapSettings &tonemap,
+             const float *lut, cudaStream_t stream, unsigned int batch) {
+  launch_tonemap(tonemapped, brightpass, src, width, height, average, exposure,
+                 brightpass_threshold, tonemap, lut, stream, batch);
+}
 
-  // 1 thread per output pixel
-  unsigned int x = blockIdx.x * blockDim.x + threadIdx.x;
-  unsigned int y = blockIdx.y * blockDim.y + threadIdx.y;
+void tonemap(RGB16F *tonemapped, RGB16F *brightpass, const float *src,
+             unsigned int width, unsigned int height,
+             const LuminanceStats *average, float exposure,
+             float brightpass_threshold, const TonemapSettings &tonemap,
+             const float *lut, cudaStream_t stream, unsigned int batch) {
+  launch_tonemap(tonemapped, brightpass, src, width, height, average, exposure,
+                 brightpass_threshold, tonemap, lut, stream, batch);
+}
+
+// planar layout: channel c of pixel i is at c * pixels + i, so consecutive
+// threads access consecutive floats of every plane. the kernels below run on
+// a 1D grid over the pixels.
+namespace {
+constexpr unsigned int planar_block = 256U;
+} // namespace
+
+__global__ void luminance_planar_kernel(float *dest, const float *input,
+                                        unsigned int pixels) {
+  unsigned int i = blockIdx.x * blockDim.x + threadIdx.x;
+
+  if (i < pixels)
+    dest[i] = 0.21f * __ldg(input + i) + 0.72f * __ldg(input + pixels + i) +
+              0.07f * __ldg(input + 2 * pixels + i);
+}
+
+void luminance_planar(float *dest, const float *input, unsigned int pixels,
+                      cudaStream_t stream) {
+  luminance_planar_kernel<<<divup(pixels, planar_block), planar_block, 0,
+                            stream>>>(dest, input, pixels);
+}
+
+template <typename Op>
+__global__ void tonemap_planar_kernel(float *tonemapped, float *brightpass,
+                                      const float *src, unsigned int pixels,
+                                      const LuminanceStats *average,
+                                      float exposure,
+                                      float brightpass_threshold, Op op) {
+  unsigned int i = blockIdx.x * blockDim.x + threadIdx.x;
+
+  if (average)
+    exposure /= average->average;
+
+  if (i < pixels) {
+    math::float3 c_t = tonemap(
+        math::float3{__ldg(src + i), __ldg(src + pixels + i),
+                     __ldg(src + 2 * pixels + i)},
+        exposure, op);
+    math::float3 c_b = brightpass_color(c_t, brightpass_threshold);
+
+    tonemapped[i] = c_t.x;
+    tonemapped[pixels + i] = c_t.y;
+    tonemapped[2 * pixels + i] = c_t.z;
+    brightpass[i] = c_b.x;
+    brightpass[pixels + i] = c_b.y;
+    brightpass[2 * pixels + i] = c_b.z;
+  }
+}
+
+void tonemap_planar(float *tonemapped, float *brightpass, const float *src,
+                    unsigned int pixels, const LuminanceStats *average,
+                    float exposure, float brightpass_threshold,
+                    const TonemapSettings &tonemap, const float *lut,
+                    cudaStream_t stream) {
+  with_tonemap(tonemap, lut, [&](auto op) {
+    tonemap_planar_kernel<<<divup(pixels, planar_block), planar_block, 0,
+                            stream>>>(tonemapped, brightpass, src, pixels,
+                                      average, exposure, brightpass_threshold,
+                                      op);
+  });
+}
+
+// layout conversion for consume() and the read*() accessors. a block moves
+// planar_block pixels through shared memory, so both the interleaved and the
+// planar side are accessed with coalesced loads and stores. the stride 3
+// accesses to shared memory are free of bank conflicts.
+__global__ void deinterleave_kernel(float *planes, const float *rgb,
+                                    unsigned int pixels) {
+  __shared__ float tile[3 * planar_block];
+
+  const unsigned int first = blockIdx.x * planar_block;
+  for (unsigned int k = threadIdx.x; k < 3 * planar_block; k += blockDim.x)
+    if (3 * first + k < 3 * pixels)
+      tile[k] = __ldg(rgb + 3 * first + k);
+  __syncthreads();
+
+  const unsigned int i = first + threadIdx.x;
+  if (i < pixels)
+    for (unsigned int c = 0; c < 3; ++c)
+      planes[c * pixels + i] = tile[3 * threadIdx.x + c];
+}
+
+__global__ void interleave_kernel(float *rgb, const float *planes,
+                                  unsigned int pixels) {
+  __shared__ float tile[3 * planar_block];
+
+  const unsigned int first = blockIdx.x * planar_block;
+  const unsigned int i = first + threadIdx.x;
+  if (i < pixels)
+    for (unsigned int c = 0; c < 3; ++c)
+      tile[3 * threadIdx.x + c] = __ldg(planes + c * pixels + i);
+  __syncthreads();
+
+  for (unsigned int k = threadIdx.x; k < 3 * planar_block; k += blockDim.x)
+    if (3 * first + k < 3 * pixels)
+      rgb[3 * first + k] = tile[k];
+}
+
+void deinterleave(float *planes, const float *rgb, unsigned int pixels,
+                  cudaStream_t stream) {
+  deinterleave_kernel<<<divup(pixels, planar_block), planar_block, 0,
+                        stream>>>(planes, rgb, pixels);
+}
+
+void interleave(float *rgb, const float *planes, unsigned int pixels,
+                cudaStream_t stream) {
+  interleave_kernel<<<divup(pixels, planar_block), planar_block, 0, stream>>>(
+      rgb, planes, pixels);
+}
+
+// 8 bit RGBA for the read*() accessors. a channel is the number of the
+// srgb8_table_size thresholds it reaches, found by a binary search in the
+// table in shared memory. the table is the same on the host, so both
+// backends round every channel the same.
+namespace {
+constexpr unsigned int srgb8_block_size = 256U;
+
+__device__ inline unsigned int srgb8(float c, const float *table) {
+  unsigned int v = 0;
+  // false for nan, which becomes 0
+  for (unsigned int step = srgb8_table_size / 2; step > 0; step /= 2)
+    if (c >= table[v + step])
+      v += step;
+  return v;
+}
+
+__device__ inline unsigned int pack_srgb8(const math::float3 &c,
+                                          const float *table) {
+  return srgb8(c.x, table) | srgb8(c.y, table) << 8 |
+         srgb8(c.z, table) << 16 | 0xFF000000U;
+}
+
+struct LoadGray {
+  const float *image;
+  __device__ math::float3 operator()(unsigned int i) const {
+    const float l = __ldg(image + i);
+    return {l, l, l};
+  }
+};
+
+template <typename T> struct LoadInterleaved {
+  const T *image;
+  __device__ math::float3 operator()(unsigned int i) const {
+    return load_pixel(image, i);
+  }
+};
+
+struct LoadPlanes {
+  const float *planes;
+  unsigned int pixels;
+  __device__ math::float3 operator()(unsigned int i) const {
+    return {__ldg(planes + i), __ldg(planes + pixels + i),
+            __ldg(planes + 2 * pixels + i)};
+  }
+};
+} // namespace
+
+template <typename Load>
+__global__ void srgb8_kernel(unsigned int *dest, Load load,
+                             unsigned int pixels, const float *thresholds) {
+  __shared__ float table[srgb8_table_size];
+  for (unsigned int k = threadIdx.x; k < srgb8_table_size; k += blockDim.x)
+    table[k] = __ldg(thresholds + k);
+  __syncthreads();
+
+  const unsigned int i = blockIdx.x * blockDim.x + threadIdx.x;
+  if (i < pixels)
+    dest[i] = pack_srgb8(load(i), table);
+}
+
+namespace {
+template <typename Load>
+void launch_srgb8(RGBA8 *dest, Load load, unsigned int pixels,
+                  const float *table, cudaStream_t stream) {
+  srgb8_kernel<<<divup(pixels, srgb8_block_size), srgb8_block_size, 0,
+                 stream>>>(reinterpret_cast<unsigned int *>(dest), load,
+                           pixels, table);
+}
+} // namespace
+
+void gray_to_srgb8(RGBA8 *dest, const float *src, unsigned int pixels,
+                   const float *table, cudaStream_t stream) {
+  launch_srgb8(dest, LoadGray{src}, pixels, table, stream);
+}
+
+void to_srgb8(RGBA8 *dest, const float *src, unsigned int pixels,
+              const float *table, cudaStream_t stream) {
+  launch_srgb8(dest, LoadInterleaved<float>{src}, pixels, table, stream);
+}
+
+void to_srgb8(RGBA8 *dest, const RGB16F *src, unsigned int pixels,
+              const float *table, cudaStream_t stream) {
+  launch_srgb8(dest, LoadInterleaved<RGB16F>{src}, pixels, table, stream);
+}
 
-  float sumR = 0.0f;
-  float sumG = 0.0f;
-  float sumB = 0.0f;
-
-  for (int i = -16; i <= 16; i++) {
-    if ((3 * (y + i) > 0) && (3 * (y + i) < 3 * height)) {
-      // all threads in the block read the same pixels. -> lots of overlap.
-      // each block accesses 32x32 pixels plus 16 on each side for the gaussian
-      // operation -> 64x64 pixels are to be read Before processing, have the
-      // threads each read 4 pixels (32x32 threads, 64x64 pixels) in a shared
-      // buffer. Then Sync, and have the threads process data from this shared
-      // buffer instead of from memory.
-
-      sumR += src[3 * (y + i) * inputPitch + 3 * x] * weights[i + 16];
-      sumG += src[3 * (y + i) * inputPitch + 3 * x + 1] * weights[i + 16];
-      sumB += src[3 * (y + i) * inputPitch + 3 * x + 2] * weights[i + 16];
+void to_srgb8(RGBA8 *dest, const RGB10A2 *src, unsigned int pixels,
+              const float *table, cudaStream_t stream) {
+  launch_srgb8(dest, LoadInterleaved<RGB10A2>{src}, pixels, table, stream);
+}
+
+void planar_to_srgb8(RGBA8 *dest, const float *src, unsigned int pixels,
+                     const float *table, cudaStream_t stream) {
+  launch_srgb8(dest, LoadPlanes{src, pixels}, pixels, table, stream);
+}
+
+// fused mode: only what the blur has to see in full is materialized, the
+// tonemapped image is recomputed from the input where it is needed. without
+// pyramid levels that is the horizontally blurred brightpass: a block covers
+// fused_tile_width pixels of fused_tile_rows rows and tonemaps them plus the
+// blur halo into shared memory. with levels, the brightpass goes straight
+// into the first downsampled level and the bloom is sampled from level 1.
+namespace {
+constexpr unsigned int fused_tile_width = 128U;
+constexpr unsigned int fused_tile_rows = 4U;
+} // namespace
+
+template <typename Op>
+__global__ void fused_brightpass_blur_x_kernel(
+    float *dest, const float *src, unsigned int width, unsigned int height,
+    const LuminanceStats *average, float exposure, float brightpass_threshold,
+    BloomWeights weights, Op op) {
+  extern __shared__ float tile[];
+
+  const unsigned int r = weights.radius;
+  const unsigned int x0 = blockIdx.x * fused_tile_width;
+  const unsigned int y = blockIdx.y * fused_tile_rows + threadIdx.y;
+  float *row = tile + threadIdx.y * 3 * (fused_tile_width + 2 * r);
+
+  // blockIdx.z is the image of a batch, here and in the kernels below
+  dest += 3 * std::size_t{blockIdx.z} * width * height;
+  src += 3 * std::size_t{blockIdx.z} * width * height;
+  exposure /= average[blockIdx.z].average;
+
+  for (unsigned int i = threadIdx.x; i < fused_tile_width + 2 * r;
+       i += blockDim.x) {
+    // pixels outside the image count as black, like in blur_rows_kernel
+    int x = static_cast<int>(x0 + i) - static_cast<int>(r);
+    math::float3 c_b = {0.0f, 0.0f, 0.0f};
+    if (y < height && x >= 0 && x < static_cast<int>(width)) {
+      const float *p = src + 3 * (y * width + x);
+      c_b = brightpass_color(
+          tonemap(math::float3{p[0], p[1], p[2]}, exposure, op),
+          brightpass_threshold);
     }
+    row[3 * i + 0] = c_b.x;
+    row[3 * i + 1] = c_b.y;
+    row[3 * i + 2] = c_b.z;
   }
+  __syncthreads();
+
+  const unsigned int x = x0 + threadIdx.x;
+  if (x >= width || y >= height)
+    return;
+
+  float sum[3] = {0.0f, 0.0f, 0.0f};
+  for (unsigned int i = 0; i <= 2 * r; ++i)
+    for (unsigned int c = 0; c < 3; ++c)
+      sum[c] += weights.w[i] * row[3 * (threadIdx.x + i) + c];
 
-  dest[3 * y * outputPitch + 3 * x] = sumR;
-  dest[3 * y * outputPitch + 3 * x + 1] = sumG;
-  dest[3 * y * outputPitch + 3 * x + 2] = sumB;
+  for (unsigned int c = 0; c < 3; ++c)
+    dest[3 * (y * width + x) + c] = sum[c];
 }
 
-void gaussian_blur(float *dest, const float *src, unsigned int width,
-                   unsigned int height) {
-  const dim3 block_size = {32, 32};
-  // calculate number of blocks required to process the whole image -> round up
-  // to the next multiple of 32 (full block)
-  const dim3 num_blocks = {divup(width, block_size.x),
-                           divup(height, block_size.y)};
+// vertical blur of the brightpass, recomputes the tonemapped pixel from the
+// input and writes their sum
+template <typename O, typename Op>
+__global__ void fused_blur_y_compose_kernel(O *output, const float *src,
+                                            const float *blurred_x,
+                                            unsigned int width,
+                                            unsigned int height,
+                                            const LuminanceStats *average,
+                                            float exposure,
+                                            BloomWeights weights, Op op) {
+  unsigned int x = blockIdx.x * blockDim.x + threadIdx.x;
+  unsigned int y = blockIdx.y * blockDim.y + threadIdx.y;
+
+  if (x >= width || y >= height)
+    return;
 
-  int inputPitch = width;
-  int outputPitch = width;
+  src += 3 * std::size_t{blockIdx.z} * width * height;
+  blurred_x += 3 * std::size_t{blockIdx.z} * width * height;
+  exposure /= average[blockIdx.z].average;
+
+  const int r = static_cast<int>(weights.radius);
+  float sum[3] = {0.0f, 0.0f, 0.0f};
+  for (int i = -r; i <= r; ++i) {
+    int yi = static_cast<int>(y) + i;
+    if (yi >= 0 && yi < static_cast<int>(height))
+      for (unsigned int c = 0; c < 3; ++c)
+        sum[c] +=
+            weights.w[i + r] * __ldg(blurred_x + 3 * (yi * width + x) + c);
+  }
+
+  const float *p = src + 3 * (y * width + x);
+  math::float3 c_t = tonemap(math::float3{p[0], p[1], p[2]}, exposure, op);
 
-  blur_kernel_x<<<num_blocks, block_size>>>(dest, src, width, height,
-                                            inputPitch, outputPitch);
-  blur_kernel_y<<<num_blocks, block_size>>>(dest, dest, width, height,
-                                            inputPitch, outputPitch);
+  store_pixel(output, (blockIdx.z * height + y) * width + x,
+              c_t + math::float3{sum[0], sum[1], sum[2]});
 }
 
-void compose(float *output, const float *tonemapped, const float *blurred,
-             unsigned int width, unsigned int height) {
-  // TODO: add blurred brightpass to tonemapped image
+// brightpass of 2x2 input pixels averaged into pyramid level 1, same edge
+// handling as downsample_rgb_kernel in bloom.cu
+template <typename Op>
+__global__ void fused_brightpass_downsample_kernel(
+    float *dest, const float *src, unsigned int width, unsigned int height,
+    const LuminanceStats *average, float exposure, float brightpass_threshold,
+    Op op) {
+  const unsigned int w = (width + 1) / 2;
+  const unsigned int h = (height + 1) / 2;
+  unsigned int x = blockIdx.x * blockDim.x + threadIdx.x;
+  unsigned int y = blockIdx.y * blockDim.y + threadIdx.y;
+
+  if (x >= w || y >= h)
+    return;
+
+  dest += 3 * std::size_t{blockIdx.z} * w * h;
+  src += 3 * std::size_t{blockIdx.z} * width * height;
+  exposure /= average[blockIdx.z].average;
+
+  auto bright = [&](unsigned int i, unsigned int j) {
+    const float *p = src + 3 * (j * width + i);
+    return brightpass_color(
+        tonemap(math::float3{p[0], p[1], p[2]}, exposure, op),
+        brightpass_threshold);
+  };
+
+  const unsigned int x1 = min(2 * x + 1, width - 1);
+  const unsigned int y1 = min(2 * y + 1, height - 1);
+  const float scale = 1.0f / ((x1 - 2 * x + 1) * (y1 - 2 * y + 1));
+  math::float3 sum = bright(2 * x, 2 * y);
+  if (x1 != 2 * x)
+    sum = sum + bright(x1, 2 * y);
+  if (y1 != 2 * y) {
+    sum = sum + bright(2 * x, y1);
+    if (x1 != 2 * x)
+      sum = sum + bright(x1, y1);
+  }
+  dest[3 * (y * w + x) + 0] = sum.x * scale;
+  dest[3 * (y * w + x) + 1] = sum.y * scale;
+  dest[3 * (y * w + x) + 2] = sum.z * scale;
 }
 
-__global__ void tonemap_kernel(float *tonemapped, float *brightpass,
-                               const float *src, unsigned int width,
-                               unsigned int height, float exposure,
-                               float brightpass_threshold) {
+// tonemapped input plus the bloom sampled from the blurred level 1
+template <typename O, typename Op>
+__global__ void fused_upsample_compose_kernel(
+    O *output, const float *src, const float *level1, unsigned int width,
+    unsigned int height, unsigned int level1_width,
+    unsigned int level1_height, float scale, const LuminanceStats *average,
+    float exposure, Op op) {
   unsigned int x = blockIdx.x * blockDim.x + threadIdx.x;
   unsigned int y = blockIdx.y * blockDim.y + threadIdx.y;
 
-  if (x < width && y < height) {
-    // figure out input color
-    math::float3 c = {src[3 * (y * width + x) + 0],
-                      src[3 * (y * width + x) + 1],
-                      src[3 * (y * width + x) + 2]};
+  if (x >= width || y >= height)
+    return;
 
-    // compute tonemapped color
-    math::float3 c_t = tonemap(c, exposure);
+  src += 3 * std::size_t{blockIdx.z} * width * height;
+  level1 += 3 * std::size_t{blockIdx.z} * level1_width * level1_height;
+  exposure /= average[blockIdx.z].average;
 
-    // write out tonemapped color
-    tonemapped[3 * (y * width + x) + 0] = c_t.x;
-    tonemapped[3 * (y * width + x) + 1] = c_t.y;
-    tonemapped[3 * (y * width + x) + 2] = c_t.z;
+  const float *p = src + 3 * (y * width + x);
+  math::float3 c_t = tonemap(math::float3{p[0], p[1], p[2]}, exposure, op);
 
-    // write out brightpass color
-    math::float3 c_b = luminance(c_t) > brightpass_threshold
-                           ? c_t
-                           : math::float3{0.0f, 0.0f, 0.0f};
-    brightpass[3 * (y * width + x) + 0] = c_b.x;
-    brightpass[3 * (y * width + x) + 1] = c_b.y;
-    brightpass[3 * (y * width + x) + 2] = c_b.z;
+  math::float3 bloom = {
+      scale * upsample_bilinear(level1, level1_width, level1_height, x, y, 0),
+      scale * upsample_bilinear(level1, level1_width, level1_height, x, y, 1),
+      scale * upsample_bilinear(level1, level1_width, level1_height, x, y, 2)};
+  store_pixel(output, (blockIdx.z * height + y) * width + x, c_t + bloom);
+}
+
+namespace {
+template <typename O, typename Op>
+void launch_fused(O *output, float *workspace, const float *src,
+                  unsigned int width, unsigned int height,
+                  const LuminanceStats *average, float exposure,
+                  float brightpass_threshold, const BloomSettings &settings,
+                  Op op, cudaStream_t stream, unsigned int batch) {
+  const BloomWeights weights = bloom_weights(settings);
+  const BloomLayout layout(width, height, settings, batch);
+  const dim3 block_size = {32, 8};
+
+  if (layout.levels == 0) {
+    float *blurred_x = workspace + layout.temp;
+
+    const dim3 tile_block = {fused_tile_width, fused_tile_rows};
+    const dim3 tile_blocks = {divup(width, fused_tile_width),
+                              divup(height, fused_tile_rows), batch};
+    const std::size_t tile_shared = fused_tile_rows * 3 *
+                                    (fused_tile_width + 2 * weights.radius) *
+                                    sizeof(float);
+    fused_brightpass_blur_x_kernel<<<tile_blocks, tile_block, tile_shared,
+                                     stream>>>(
+        blurred_x, src, width, height, average, exposure, brightpass_threshold,
+        weights, op);
+
+    const dim3 num_blocks = {divup(width, block_size.x),
+                             divup(height, block_size.y), batch};
+    fused_blur_y_compose_kernel<<<num_blocks, block_size, 0, stream>>>(
+        output, src, blurred_x, width, height, average, exposure, weights, op);
+    return;
   }
+
+  const dim3 level1_blocks = {divup(layout.width[1], block_size.x),
+                              divup(layout.height[1], block_size.y), batch};
+  fused_brightpass_downsample_kernel<<<level1_blocks, block_size, 0,
+                                       stream>>>(
+      workspace + layout.downsampled[1], src, width, height, average, exposure,
+      brightpass_threshold, op);
+
+  bloom_pyramid(workspace, layout, weights, stream);
+
+  const dim3 num_blocks = {divup(width, block_size.x),
+                           divup(height, block_size.y), batch};
+  fused_upsample_compose_kernel<<<num_blocks, block_size, 0, stream>>>(
+      output, src, workspace + layout.blurred[1], width, height,
+      layout.width[1], layout.height[1], 1.0f / layout.levels, average,
+      exposure, op);
 }
 
-void tonemap(float *tonemapped, float *brightpass, const float *src,
-             unsigned int width, unsigned int height, float exposure,
-             float brightpass_threshold) {
-  const auto block_size = dim3{32U, 32U};
+// one set of fused kernels per operator
+template <typename O>
+void launch_fused(O *output, float *workspace, const float *src,
+                  unsigned int width, unsigned int height,
+                  const LuminanceStats *average, float exposure,
+                  float brightpass_threshold, const BloomSettings &settings,
+                  const TonemapSettings &tonemap, const float *lut,
+                  cudaStream_t stream, unsigned int batch) {
+  with_tonemap(tonemap, lut, [&](auto op) {
+    launch_fused(output, workspace, src, width, height, average, exposure,
+                 brightpass_threshold, settings, op, stream, batch);
+  });
+}
+} // namespace
 
-  auto num_blocks =
-      dim3{divup(width, block_size.x), divup(height, block_size.y)};
+// tonemap, brightpass, bloom and compose. the luminance statistics have to be
+// in average already, see reduce_luminance_rgb(). workspace holds
+// BloomLayout::size floats. a batch of images stored one after the other is
+// processed by the same launches, each with its own entry of average. lut
+// holds the table of tonemap if it is evaluated through one, see
+// tonemap_lut().
+void fused_tonemap_bloom(float *output, float *workspace, const float *src,
+                         unsigned int width, unsigned int height,
+                         const LuminanceStats *average, float exposure,
+                         float brightpass_threshold,
+                         const BloomSettings &settings,
+                         const TonemapSettings &tonemap, const float *lut,
+                         cudaStream_t stream, unsigned int batch) {
+  launch_fused(output, workspace, src, width, height, average, exposure,
+               brightpass_threshold, settings, tonemap, lut, stream, batch);
+}
+
+void fused_tonemap_bloom(RGB16F *output, float *workspace, const float *src,
+                         unsigned int width, unsigned int height,
+                         const LuminanceStats *average, float exposure,
+                         float brightpass_threshold,
+                         const BloomSettings &settings,
+                         const TonemapSettings &tonemap, const float *lut,
+                         cudaStream_t stream, unsigned int batch) {
+  launch_fused(output, workspace, src, width, height, average, exposure,
+               brightpass_threshold, settings, tonemap, lut, stream, batch);
+}
 
-  tonemap_kernel<<<num_blocks, block_size>>>(tonemapped, brightpass, src, width,
-                                             height, exposure,
-                                             brightpass_threshold);
+void fused_tonemap_bloom(RGB10A2 *output, float *workspace, const float *src,
+                         unsigned int width, unsigned int height,
+                         const LuminanceStats *average, float exposure,
+                         float brightpass_threshold,
+                         const BloomSettings &settings,
+                         const TonemapSettings &tonemap, const float *lut,
+                         cudaStream_t stream, unsigned int batch) {
+  launch_fused(output, workspace, src, width, height, average, exposure,
+               brightpass_threshold, settings, tonemap, lut, stream, batch);
 }
@@ -0,0 +1,758 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "calculators/cuda/hdr/framework/rgba8.h"
+#include "calculators/cuda/hdr/framework/thread_pool.h"
+
+#include "calculators/cuda/hdr/bloom.h"
+#include "calculators/cuda/hdr/hdr_pipeline_cpu.h"
+#include "calculators/cuda/hdr/hdr_storage.h"
+
+namespace {
+// rows handed to a worker at a time
+constexpr std::size_t rows_per_task = 16U;
+
+// fn(begin, end) is called for consecutive ranges of rows
+template <typename F>
+void parallel_row_ranges(std::size_t height, F &&fn) {
+  const std::size_t tasks = (height + rows_per_task - 1) / rows_per_task;
+  ThreadPool::shared().parallel_for(tasks, [&](std::size_t t) {
+    const std::size_t begin = t * rows_per_task;
+    fn(begin, std::min(begin + rows_per_task, height));
+  });
+}
+
+template <typename F>
+void parallel_rows(std::size_t height, F &&fn) {
+  parallel_row_ranges(height, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t y = begin; y < end; ++y)
+      fn(y);
+  });
+}
+
+bool is_bright(float r, float g, float b, float brightpass_threshold) {
+  return 0.2126f * r + 0.7152f * g + 0.0722f * b > brightpass_threshold;
+}
+
+#if defined(__AVX2__)
+// the vector paths below compute the same operations as the scalar functions
+// above, on eight pixels or floats at a time
+
+// the operators of tonemap.h on 8 exposed floats x
+inline __m256 hable_ps(__m256 x, float A, float B, float C, float D, float E,
+                       float F) {
+  const __m256 a = _mm256_set1_ps(A);
+  const __m256 n = _mm256_fmadd_ps(
+      x, _mm256_fmadd_ps(a, x, _mm256_set1_ps(C * B)), _mm256_set1_ps(D * E));
+  const __m256 d = _mm256_fmadd_ps(
+      x, _mm256_fmadd_ps(a, x, _mm256_set1_ps(B)), _mm256_set1_ps(D * F));
+  return _mm256_sub_ps(_mm256_div_ps(n, d), _mm256_set1_ps(E / F));
+}
+
+inline __m256 tonemap_ps(const Uncharted2Tonemap &, __m256 x) {
+  const float white = hable_curve(11.2f, 0.15f, 0.50f, 0.10f, 0.20f, 0.02f,
+                                  0.30f);
+  return _mm256_div_ps(hable_ps(_mm256_add_ps(x, x), 0.15f, 0.50f, 0.10f,
+                                0.20f, 0.02f, 0.30f),
+                       _mm256_set1_ps(white));
+}
+
+inline __m256 tonemap_ps(const AcesTonemap &, __m256 x) {
+  x = _mm256_mul_ps(x, _mm256_set1_ps(0.6f));
+  const __m256 n = _mm256_mul_ps(
+      x, _mm256_fmadd_ps(_mm256_set1_ps(2.51f), x, _mm256_set1_ps(0.03f)));
+  const __m256 d = _mm256_fmadd_ps(
+      x, _mm256_fmadd_ps(_mm256_set1_ps(2.43f), x, _mm256_set1_ps(0.59f)),
+      _mm256_set1_ps(0.14f));
+  return _mm256_min_ps(_mm256_max_ps(_mm256_div_ps(n, d), _mm256_setzero_ps()),
+                       _mm256_set1_ps(1.0f));
+}
+
+inline __m256 tonemap_ps(const ReinhardTonemap &op, __m256 x) {
+  const __m256 one = _mm256_set1_ps(1.0f);
+  return _mm256_div_ps(
+      _mm256_mul_ps(x, _mm256_fmadd_ps(x, _mm256_set1_ps(op.inv_white2), one)),
+      _mm256_add_ps(one, x));
+}
+
+inline __m256 tonemap_ps(const HableTonemap &op, __m256 x) {
+  const HableParams &p = op.p;
+  return _mm256_mul_ps(
+      hable_ps(_mm256_mul_ps(x, _mm256_set1_ps(p.exposure_bias)), p.A, p.B,
+               p.C, p.D, p.E, p.F),
+      _mm256_set1_ps(op.inv_white));
+}
+
+// two gathers per 8 floats instead of the rational polynomials
+inline __m256 tonemap_ps(const LutTonemap &op, __m256 x) {
+  const float last = tonemap_lut_size - 1;
+  const __m256 u = _mm256_min_ps(
+      _mm256_mul_ps(_mm256_sqrt_ps(_mm256_max_ps(x, _mm256_setzero_ps())),
+                    _mm256_set1_ps(LutTonemap::scale)),
+      _mm256_set1_ps(last));
+  const __m256i i = _mm256_min_epi32(_mm256_cvttps_epi32(u),
+                                     _mm256_set1_epi32(tonemap_lut_size - 2));
+  const __m256 f = _mm256_sub_ps(u, _mm256_cvtepi32_ps(i));
+  const __m256 a = _mm256_i32gather_ps(op.table, i, 4);
+  const __m256 b = _mm256_i32gather_ps(op.table + 1, i, 4);
+  return _mm256_fmadd_ps(f, _mm256_sub_ps(b, a), a);
+}
+
+// is_bright() of 8 pixels as a mask
+inline __m256 bright_ps(__m256 r, __m256 g, __m256 b, __m256 threshold) {
+  const __m256 y = _mm256_fmadd_ps(
+      _mm256_set1_ps(0.2126f), r,
+      _mm256_fmadd_ps(_mm256_set1_ps(0.7152f), g,
+                      _mm256_mul_ps(_mm256_set1_ps(0.0722f), b)));
+  return _mm256_cmp_ps(y, threshold, _CMP_GT_OQ);
+}
+
+// splits 8 interleaved RGB pixels, the 24 floats in v0, v1 and v2, into
+// their channels. every channel takes disjoint lanes from the three vectors,
+// so two blends and one permute put it together.
+inline void deinterleave_ps(__m256 v0, __m256 v1, __m256 v2, __m256 &r,
+                            __m256 &g, __m256 &b) {
+  r = _mm256_permutevar8x32_ps(
+      _mm256_blend_ps(_mm256_blend_ps(v0, v1, 0x92), v2, 0x24),
+      _mm256_setr_epi32(0, 3, 6, 1, 4, 7, 2, 5));
+  g = _mm256_permutevar8x32_ps(
+      _mm256_blend_ps(_mm256_blend_ps(v0, v1, 0x24), v2, 0x49),
+      _mm256_setr_epi32(1, 4, 7, 2, 5, 0, 3, 6));
+  b = _mm256_permutevar8x32_ps(
+      _mm256_blend_ps(_mm256_blend_ps(v0, v1, 0x49), v2, 0x92),
+      _mm256_setr_epi32(2, 5, 0, 3, 6, 1, 4, 7));
+}
+
+// a per pixel mask of 8 pixels spread over their 24 interleaved floats
+inline void expand_mask_ps(__m256 m, __m256 &m0, __m256 &m1, __m256 &m2) {
+  m0 = _mm256_permutevar8x32_ps(m, _mm256_setr_epi32(0, 0, 0, 1, 1, 1, 2, 2));
+  m1 = _mm256_permutevar8x32_ps(m, _mm256_setr_epi32(2, 3, 3, 3, 4, 4, 4, 5));
+  m2 = _mm256_permutevar8x32_ps(m, _mm256_setr_epi32(5, 5, 6, 6, 6, 7, 7, 7));
+}
+#endif
+
+// tonemapped image and brightpass of one interleaved input row. tonemapped
+// may be null if only the brightpass is needed.
+template <typename Op>
+void tonemap_row(float *tonemapped, float *brightpass, const float *src,
+                 std::size_t width, float exposure, float brightpass_threshold,
+                 const Op &op) {
+  std::size_t x = 0;
+
+#if defined(__AVX2__)
+  const __m256 e = _mm256_set1_ps(exposure);
+  const __m256 threshold = _mm256_set1_ps(brightpass_threshold);
+  for (; x + 8 <= width; x += 8) {
+    const float *in = src + 3 * x;
+    const __m256 t0 = tonemap_ps(op, _mm256_mul_ps(_mm256_loadu_ps(in), e));
+    const __m256 t1 =
+        tonemap_ps(op, _mm256_mul_ps(_mm256_loadu_ps(in + 8), e));
+    const __m256 t2 =
+        tonemap_ps(op, _mm256_mul_ps(_mm256_loadu_ps(in + 16), e));
+    if (tonemapped) {
+      _mm256_storeu_ps(tonemapped + 3 * x, t0);
+      _mm256_storeu_ps(tonemapped + 3 * x + 8, t1);
+      _mm256_storeu_ps(tonemapped + 3 * x + 16, t2);
+    }
+
+    __m256 r, g, b, m0, m1, m2;
+    deinterleave_ps(t0, t1, t2, r, g, b);
+    expand_mask_ps(bright_ps(r, g, b, threshold), m0, m1, m2);
+    _mm256_storeu_ps(brightpass + 3 * x, _mm256_and_ps(m0, t0));
+    _mm256_storeu_ps(brightpass + 3 * x + 8, _mm256_and_ps(m1, t1));
+    _mm256_storeu_ps(brightpass + 3 * x + 16, _mm256_and_ps(m2, t2));
+  }
+#endif
+
+  for (; x < width; ++x) {
+    float r = op(src[3 * x] * exposure);
+    float g = op(src[3 * x + 1] * exposure);
+    float b = op(src[3 * x + 2] * exposure);
+    if (tonemapped) {
+      tonemapped[3 * x] = r;
+      tonemapped[3 * x + 1] = g;
+      tonemapped[3 * x + 2] = b;
+    }
+
+    bool bright = is_bright(r, g, b, brightpass_threshold);
+    brightpass[3 * x] = bright ? r : 0.0f;
+    brightpass[3 * x + 1] = bright ? g : 0.0f;
+    brightpass[3 * x + 2] = bright ? b : 0.0f;
+  }
+}
+
+// tonemapped brightpass of one input row
+template <typename Op>
+void brightpass_row(float *dest, const float *src, std::size_t width,
+                    float exposure, float brightpass_threshold, const Op &op) {
+  tonemap_row(nullptr, dest, src, width, exposure, brightpass_threshold, op);
+}
+
+// dest[i] += op(src[i] * exposure) for count floats
+template <typename Op>
+void add_tonemapped(float *dest, const float *src, std::size_t count,
+                    float exposure, const Op &op) {
+  std::size_t i = 0;
+
+#if defined(__AVX2__)
+  const __m256 e = _mm256_set1_ps(exposure);
+  for (; i + 8 <= count; i += 8) {
+    const __m256 t =
+        tonemap_ps(op, _mm256_mul_ps(_mm256_loadu_ps(src + i), e));
+    _mm256_storeu_ps(dest + i, _mm256_add_ps(_mm256_loadu_ps(dest + i), t));
+  }
+#endif
+
+  for (; i < count; ++i)
+    dest[i] += op(src[i] * exposure);
+}
+
+// dest[i] = a[i] + b[i] for count floats
+void add_rows(float *dest, const float *a, const float *b, std::size_t count) {
+  std::size_t i = 0;
+
+#if defined(__AVX2__)
+  for (; i + 8 <= count; i += 8)
+    _mm256_storeu_ps(dest + i, _mm256_add_ps(_mm256_loadu_ps(a + i),
+                                             _mm256_loadu_ps(b + i)));
+#endif
+
+  for (; i < count; ++i)
+    dest[i] = a[i] + b[i];
+}
+
+// 0.21 R + 0.72 G + 0.07 B of one interleaved row
+void luminance_row(float *dest, const float *src, std::size_t width) {
+  std::size_t x = 0;
+
+#if defined(__AVX2__)
+  for (; x + 8 <= width; x += 8) {
+    __m256 r, g, b;
+    deinterleave_ps(_mm256_loadu_ps(src + 3 * x),
+                    _mm256_loadu_ps(src + 3 * x + 8),
+                    _mm256_loadu_ps(src + 3 * x + 16), r, g, b);
+    _mm256_storeu_ps(
+        dest + x,
+        _mm256_fmadd_ps(
+            _mm256_set1_ps(0.21f), r,
+            _mm256_fmadd_ps(_mm256_set1_ps(0.72f), g,
+                            _mm256_mul_ps(_mm256_set1_ps(0.07f), b))));
+  }
+#endif
+
+  for (; x < width; ++x)
+    dest[x] = 0.21f * src[3 * x] + 0.72f * src[3 * x + 1] +
+              0.07f * src[3 * x + 2];
+}
+
+// 2x2 box filter of the rows top and bottom into dest, which has
+// (width + 1) / 2 floats. bottom is top for an odd last row.
+void downsample_row(float *dest, const float *top, const float *bottom,
+                    std::size_t width) {
+  const std::size_t w = (width + 1) / 2;
+  std::size_t x = 0;
+
+#if defined(__AVX2__)
+  // full 2x2 blocks only: the pairs summed by hadd are interleaved across
+  // the two 128 bit lanes, the permute puts them back in order
+  if (top != bottom)
+    for (; 2 * x + 16 <= width; x += 8) {
+      const __m256 s0 = _mm256_add_ps(_mm256_loadu_ps(top + 2 * x),
+                                      _mm256_loadu_ps(bottom + 2 * x));
+      const __m256 s1 = _mm256_add_ps(_mm256_loadu_ps(top + 2 * x + 8),
+                                      _mm256_loadu_ps(bottom + 2 * x + 8));
+      const __m256 h = _mm256_castpd_ps(_mm256_permute4x64_pd(
+          _mm256_castps_pd(_mm256_hadd_ps(s0, s1)), 0xD8));
+      _mm256_storeu_ps(dest + x, _mm256_mul_ps(h, _mm256_set1_ps(0.25f)));
+    }
+#endif
+
+  for (; x < w; ++x) {
+    const std::size_t x1 = std::min(2 * x + 1, width - 1);
+    float sum = top[2 * x];
+    int count = 1;
+    if (x1 != 2 * x) {
+      sum += top[x1];
+      ++count;
+    }
+    if (bottom != top) {
+      sum += bottom[2 * x];
+      ++count;
+      if (x1 != 2 * x) {
+        sum += bottom[x1];
+        ++count;
+      }
+    }
+    dest[x] = sum / count;
+  }
+}
+
+// pixels [begin, end) of a planar image, channel c of pixel i is at
+// c * pixels + i. the planes are read and written in contiguous runs, eight
+// pixels at a time where AVX2 is available.
+template <typename Op>
+void tonemap_planar_span(float *tonemapped, float *brightpass,
+                         const float *src, std::size_t pixels,
+                         std::size_t begin, std::size_t end, float exposure,
+                         float brightpass_threshold, const Op &op) {
+  std::size_t i = begin;
+
+#if defined(__AVX2__)
+  const __m256 e = _mm256_set1_ps(exposure);
+  const __m256 threshold = _mm256_set1_ps(brightpass_threshold);
+  auto load = [&](const float *p) {
+    return _mm256_mul_ps(_mm256_loadu_ps(p), e);
+  };
+  for (; i + 8 <= end; i += 8) {
+    const __m256 r = tonemap_ps(op, load(src + i));
+    const __m256 g = tonemap_ps(op, load(src + pixels + i));
+    const __m256 b = tonemap_ps(op, load(src + 2 * pixels + i));
+    _mm256_storeu_ps(tonemapped + i, r);
+    _mm256_storeu_ps(tonemapped + pixels + i, g);
+    _mm256_storeu_ps(tonemapped + 2 * pixels + i, b);
+
+    const __m256 bright = bright_ps(r, g, b, threshold);
+    _mm256_storeu_ps(brightpass + i, _mm256_and_ps(bright, r));
+    _mm256_storeu_ps(brightpass + pixels + i, _mm256_and_ps(bright, g));
+    _mm256_storeu_ps(brightpass + 2 * pixels + i, _mm256_and_ps(bright, b));
+  }
+#endif
+
+  for (; i < end; ++i) {
+    float r = op(src[i] * exposure);
+    float g = op(src[pixels + i] * exposure);
+    float b = op(src[2 * pixels + i] * exposure);
+    tonemapped[i] = r;
+    tonemapped[pixels + i] = g;
+    tonemapped[2 * pixels + i] = b;
+
+    bool bright = is_bright(r, g, b, brightpass_threshold);
+    brightpass[i] = bright ? r : 0.0f;
+    brightpass[pixels + i] = bright ? g : 0.0f;
+    brightpass[2 * pixels + i] = bright ? b : 0.0f;
+  }
+}
+
+template <typename T, typename Op>
+void tonemap_image(T *tonemapped, T *brightpass, const float *src,
+                   std::size_t width, std::size_t height, float exposure,
+                   float brightpass_threshold, const Op &op) {
+  parallel_row_ranges(height, [&](std::size_t begin, std::size_t end) {
+    std::vector<float> scratch(2 * cpu::scratch_floats<T>(width));
+    for (std::size_t y = begin; y < end; ++y) {
+      T *tonemapped_row = cpu::pixel_row(tonemapped, width, y);
+      T *brightpass_row = cpu::pixel_row(brightpass, width, y);
+      float *tone = cpu::row_target(scratch.data(), tonemapped_row);
+      float *pass = cpu::row_target(
+          scratch.data() + cpu::scratch_floats<T>(width), brightpass_row);
+      tonemap_row(tone, pass, src + 3 * width * y, width, exposure,
+                  brightpass_threshold, op);
+      cpu::store_row(tonemapped_row, tone, width);
+      cpu::store_row(brightpass_row, pass, width);
+    }
+  });
+}
+
+template <typename O, typename I>
+void compose_image(O *output, const I *tonemapped, const I *blurred,
+                   std::size_t width, std::size_t height) {
+  parallel_row_ranges(height, [&](std::size_t begin, std::size_t end) {
+    const std::size_t n = cpu::scratch_floats<I>(width);
+    std::vector<float> scratch(2 * n + cpu::scratch_floats<O>(width));
+    for (std::size_t y = begin; y < end; ++y) {
+      const float *t = cpu::load_row(
+          scratch.data(), cpu::pixel_row(tonemapped, width, y), width);
+      const float *b = cpu::load_row(
+          scratch.data() + n, cpu::pixel_row(blurred, width, y), width);
+      O *row = cpu::pixel_row(output, width, y);
+      float *out = cpu::row_target(scratch.data() + 2 * n, row);
+      add_rows(out, t, b, 3 * width);
+      cpu::store_row(row, out, width);
+    }
+  });
+}
+
+template <typename O, typename Op>
+void fused_image(O *output, float *workspace, const float *src,
+                 std::size_t width, std::size_t height, float exposure,
+                 float brightpass_threshold, const BloomSettings &settings,
+                 const Op &op) {
+  const BloomWeights weights = bloom_weights(settings);
+  const BloomLayout layout(static_cast<unsigned int>(width),
+                           static_cast<unsigned int>(height), settings);
+  const std::size_t r = weights.radius;
+
+  if (layout.levels == 0) {
+    // brightpass of a row plus the blur halo, blurred horizontally into temp
+    float *blurred_x = workspace + layout.temp;
+    parallel_row_ranges(height, [&](std::size_t begin, std::size_t end) {
+      std::vector<float> padded(3 * (width + 2 * r), 0.0f);
+      for (std::size_t y = begin; y < end; ++y) {
+        brightpass_row(&padded[3 * r], src + 3 * width * y, width, exposure,
+                       brightpass_threshold, op);
+        cpu::blur_row(blurred_x + 3 * width * y, padded.data(), width, weights);
+      }
+    });
+
+    // vertical blur plus the tonemapped input, band by band while the
+    // blurred rows are still in cache
+    parallel_row_ranges(height, [&](std::size_t begin, std::size_t end) {
+      std::vector<float> scratch(cpu::scratch_floats<O>(width * (end - begin)));
+      O *band = cpu::pixel_row(output, width, begin);
+      float *out = cpu::row_target(scratch.data(), band);
+      cpu::blur_columns(out, blurred_x, width, height, begin, end, weights);
+      add_tonemapped(out, src + 3 * width * begin, 3 * width * (end - begin),
+                     exposure, op);
+      cpu::store_row(band, out, width * (end - begin));
+    });
+    return;
+  }
+
+  // brightpass of 2x2 input pixels averaged into level 1, same as
+  // downsample_rgb() in bloom_cpu.cpp
+  float *level1 = workspace + layout.downsampled[1];
+  const std::size_t w1 = layout.width[1];
+  parallel_rows(layout.height[1], [&](std::size_t y) {
+    std::vector<float> rows(6 * width);
+    const std::size_t y1 = std::min(2 * y + 1, height - 1);
+    brightpass_row(&rows[0], src + 3 * width * (2 * y), width, exposure,
+                   brightpass_threshold, op);
+    brightpass_row(&rows[3 * width], src + 3 * width * y1, width, exposure,
+                   brightpass_threshold, op);
+    const float *top = &rows[0];
+    const float *bottom = &rows[3 * width];
+    for (std::size_t x = 0; x < w1; ++x) {
+      const std::size_t x1 = std::min(2 * x + 1, width - 1);
+      const float scale = 1.0f / ((x1 - 2 * x + 1) * (y1 - 2 * y + 1));
+      for (int c = 0; c < 3; ++c) {
+        float sum = top[3 * 2 * x + c];
+        if (x1 != 2 * x)
+          sum += top[3 * x1 + c];
+        if (y1 != 2 * y) {
+          sum += bottom[3 * 2 * x + c];
+          if (x1 != 2 * x)
+            sum += bottom[3 * x1 + c];
+        }
+        level1[3 * (y * w1 + x) + c] = sum * scale;
+      }
+    }
+  });
+
+  cpu::bloom_pyramid(workspace, layout, weights);
+
+  parallel_row_ranges(height, [&](std::size_t begin, std::size_t end) {
+    std::vector<float> scratch(cpu::scratch_floats<O>(width));
+    for (std::size_t y = begin; y < end; ++y) {
+      O *row = cpu::pixel_row(output, width, y);
+      float *out = cpu::row_target(scratch.data(), row);
+      cpu::bloom_sample(out, workspace + layout.blurred[1], layout, y);
+      add_tonemapped(out, src + 3 * width * y, 3 * width, exposure, op);
+      cpu::store_row(row, out, width);
+    }
+  });
+}
+
+// 8 bit channels of count floats, see srgb8_table()
+void srgb8_span(std::uint8_t *dest, const float *src, std::size_t count,
+                const float *table) {
+  std::size_t i = 0;
+#if defined(__AVX2__)
+  // the binary search of 8 channels at once, one gather per step
+  for (; i + 8 <= count; i += 8) {
+    const __m256 c = _mm256_loadu_ps(src + i);
+    __m256i v = _mm256_setzero_si256();
+    for (int step = srgb8_table_size / 2; step > 0; step /= 2) {
+      const __m256i s = _mm256_set1_epi32(step);
+      const __m256 t =
+          _mm256_i32gather_ps(table, _mm256_add_epi32(v, s), sizeof(float));
+      // false for nan, which becomes 0
+      const __m256 reached = _mm256_cmp_ps(c, t, _CMP_GE_OQ);
+      v = _mm256_add_epi32(v,
+                           _mm256_and_si256(_mm256_castps_si256(reached), s));
+    }
+    alignas(32) std::int32_t lanes[8];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), v);
+    for (std::size_t k = 0; k < 8; ++k)
+      dest[i + k] = static_cast<std::uint8_t>(lanes[k]);
+  }
+#endif
+  for (; i < count; ++i) {
+    unsigned int v = 0;
+    for (unsigned int step = srgb8_table_size / 2; step > 0; step /= 2)
+      if (src[i] >= table[v + step])
+        v += step;
+    dest[i] = static_cast<std::uint8_t>(v);
+  }
+}
+
+template <typename T>
+void srgb8_image(RGBA8 *dest, const T *src, std::size_t width,
+                 std::size_t height) {
+  const float *table = srgb8_table();
+  parallel_row_ranges(height, [&](std::size_t begin, std::size_t end) {
+    std::vector<float> scratch(cpu::scratch_floats<T>(width));
+    std::vector<std::uint8_t> channels(3 * width);
+    for (std::size_t y = begin; y < end; ++y) {
+      const float *row =
+          cpu::load_row(scratch.data(), cpu::pixel_row(src, width, y), width);
+      srgb8_span(channels.data(), row, 3 * width, table);
+      RGBA8 *out = dest + width * y;
+      for (std::size_t x = 0; x < width; ++x)
+        out[x] = RGBA8(channels[3 * x], channels[3 * x + 1],
+                       channels[3 * x + 2]);
+    }
+  });
+}
+} // namespace
+
+const float *srgb8_table() {
+  static const auto table = [] {
+    std::vector<float> t(srgb8_table_size);
+    for (unsigned int v = 0; v < srgb8_table_size; ++v)
+      t[v] = static_cast<float>(std::pow(v / 255.0, 2.2));
+    return t;
+  }();
+  return table.data();
+}
+
+void check_tonemap(const TonemapSettings &settings) {
+  if (settings.op == TonemapOperator::reinhard && !(settings.white > 0.0f))
+    throw std::invalid_argument("the white point has to be positive");
+  if (settings.op == TonemapOperator::hable) {
+    const HableParams &p = settings.hable;
+    if (!(p.W > 0.0f) || !(p.exposure_bias > 0.0f))
+      throw std::invalid_argument(
+          "white point and exposure bias have to be positive");
+    if (!(hable_curve(p.W, p.A, p.B, p.C, p.D, p.E, p.F) > 0.0f))
+      throw std::invalid_argument(
+          "the hable curve has to be positive at the white point");
+  }
+}
+
+void tonemap_lut(float *table, const TonemapSettings &settings) {
+  check_tonemap(settings);
+
+  TonemapSettings exact = settings;
+  exact.lut = false;
+  with_tonemap(exact, nullptr, [&](auto op) {
+    for (std::size_t i = 0; i < tonemap_lut_size; ++i) {
+      const float s = i / LutTonemap::scale;
+      table[i] = op(s * s);
+    }
+  });
+}
+
+namespace cpu {
+void luminance(float *dest, const float *input, std::size_t width,
+               std::size_t height) {
+  parallel_rows(height, [&](std::size_t y) {
+    luminance_row(dest + width * y, input + 3 * width * y, width);
+  });
+}
+
+void downsample(float *dest, const float *luminance, std::size_t width,
+                std::size_t height) {
+  const std::size_t w = (width + 1) / 2;
+  const std::size_t h = (height + 1) / 2;
+  parallel_rows(h, [&](std::size_t y) {
+    const std::size_t y1 = std::min(2 * y + 1, height - 1);
+    downsample_row(dest + w * y, luminance + width * (2 * y),
+                   luminance + width * y1, width);
+  });
+}
+
+void luminance_planar(float *dest, const float *input, std::size_t width,
+                      std::size_t height) {
+  const std::size_t pixels = width * height;
+  const float *r = input;
+  const float *g = input + pixels;
+  const float *b = input + 2 * pixels;
+  parallel_row_ranges(height, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = width * begin; i < width * end; ++i)
+      dest[i] = 0.21f * r[i] + 0.72f * g[i] + 0.07f * b[i];
+  });
+}
+
+void tonemap(float *tonemapped, float *brightpass, const float *src,
+             std::size_t width, std::size_t height, float exposure,
+             float brightpass_threshold, const TonemapSettings &tonemap,
+             const float *lut) {
+  with_tonemap(tonemap, lut, [&](auto op) {
+    tonemap_image(tonemapped, brightpass, src, width, height, exposure,
+                  brightpass_threshold, op);
+  });
+}
+
+void tonemap(RGB16F *tonemapped, RGB16F *brightpass, const float *src,
+             std::size_t width, std::size_t height, float exposure,
+             float brightpass_threshold, const TonemapSettings &tonemap,
+             const float *lut) {
+  with_tonemap(tonemap, lut, [&](auto op) {
+    tonemap_image(tonemapped, brightpass, src, width, height, exposure,
+                  brightpass_threshold, op);
+  });
+}
+
+void tonemap_planar(float *tonemapped, float *brightpass, const float *src,
+                    std::size_t width, std::size_t height, float exposure,
+                    float brightpass_threshold, const TonemapSettings &tonemap,
+                    const float *lut) {
+  with_tonemap(tonemap, lut, [&](auto op) {
+    parallel_row_ranges(height, [&](std::size_t begin, std::size_t end) {
+      tonemap_planar_span(tonemapped, brightpass, src, width * height,
+                          width * begin, width * end, exposure,
+                          brightpass_threshold, op);
+    });
+  });
+}
+
+void compose(float *output, const float *tonemapped, const float *blurred,
+             std::size_t width, std::size_t height) {
+  compose_image(output, tonemapped, blurred, width, height);
+}
+
+void compose(RGB16F *output, const RGB16F *tonemapped, const RGB16F *blurred,
+             std::size_t width, std::size_t height) {
+  compose_image(output, tonemapped, blurred, width, height);
+}
+
+void compose(RGB10A2 *output, const RGB16F *tonemapped,
+             const RGB16F *blurred, std::size_t width, std::size_t height) {
+  compose_image(output, tonemapped, blurred, width, height);
+}
+
+void fused_tonemap_bloom(float *output, float *workspace, const float *src,
+                         std::size_t width, std::size_t height, float exposure,
+                         float brightpass_threshold,
+                         const BloomSettings &settings,
+                         const TonemapSettings &tonemap, const float *lut) {
+  with_tonemap(tonemap, lut, [&](auto op) {
+    fused_image(output, workspace, src, width, height, exposure,
+                brightpass_threshold, settings, op);
+  });
+}
+
+void fused_tonemap_bloom(RGB16F *output, float *workspace, const float *src,
+                         std::size_t width, std::size_t height, float exposure,
+                         float brightpass_threshold,
+                         const BloomSettings &settings,
+                         const TonemapSettings &tonemap, const float *lut) {
+  with_tonemap(tonemap, lut, [&](auto op) {
+    fused_image(output, workspace, src, width, height, exposure,
+                brightpass_threshold, settings, op);
+  });
+}
+
+void fused_tonemap_bloom(RGB10A2 *output, float *workspace, const float *src,
+                         std::size_t width, std::size_t height, float exposure,
+                         float brightpass_threshold,
+                         const BloomSettings &settings,
+                         const TonemapSettings &tonemap, const float *lut) {
+  with_tonemap(tonemap, lut, [&](auto op) {
+    fused_image(output, workspace, src, width, height, exposure,
+                brightpass_threshold, settings, op);
+  });
+}
+
+void deinterleave(float *planes, const float *rgb, std::size_t width,
+                  std::size_t height, std::size_t rgb_pitch) {
+  const std::size_t pixels = width * height;
+  parallel_row_ranges(height, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t y = begin; y < end; ++y) {
+      const auto row = reinterpret_cast<const float *>(
+          reinterpret_cast<const unsigned char *>(rgb) + y * rgb_pitch);
+      for (std::size_t x = 0; x < width; ++x)
+        for (std::size_t c = 0; c < 3; ++c)
+          planes[c * pixels + y * width + x] = row[3 * x + c];
+    }
+  });
+}
+
+void interleave(float *rgb, const float *planes, std::size_t width,
+                std::size_t height) {
+  const std::size_t pixels = width * height;
+  parallel_row_ranges(height, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = width * begin; i < width * end; ++i)
+      for (std::size_t c = 0; c < 3; ++c)
+        rgb[3 * i + c] = planes[c * pixels + i];
+  });
+}
+
+void gray_to_srgb8(RGBA8 *dest, const float *src, std::size_t width,
+                   std::size_t height) {
+  const float *table = srgb8_table();
+  parallel_row_ranges(height, [&](std::size_t begin, std::size_t end) {
+    std::vector<std::uint8_t> channels(width);
+    for (std::size_t y = begin; y < end; ++y) {
+      srgb8_span(channels.data(), src + width * y, width, table);
+      RGBA8 *out = dest + width * y;
+      for (std::size_t x = 0; x < width; ++x)
+        out[x] = RGBA8(channels[x], channels[x], channels[x]);
+    }
+  });
+}
+
+void to_srgb8(RGBA8 *dest, const float *src, std::size_t width,
+              std::size_t height) {
+  srgb8_image(dest, src, width, height);
+}
+
+void to_srgb8(RGBA8 *dest, const RGB16F *src, std::size_t width,
+              std::size_t height) {
+  srgb8_image(dest, src, width, height);
+}
+
+void to_srgb8(RGBA8 *dest, const RGB10A2 *src, std::size_t width,
+              std::size_t height) {
+  srgb8_image(dest, src, width, height);
+}
+
+void planar_to_srgb8(RGBA8 *dest, const float *src, std::size_t width,
+                     std::size_t height) {
+  const float *table = srgb8_table();
+  const std::size_t pixels = width * height;
+  parallel_row_ranges(height, [&](std::size_t begin, std::size_t end) {
+    std::vector<std::uint8_t> channels(3 * width);
+    for (std::size_t y = begin; y < end; ++y) {
+      for (std::size_t c = 0; c < 3; ++c)
+        srgb8_span(channels.data() + c * width,
+                   src + c * pixels + width * y, width, table);
+      RGBA8 *out = dest + width * y;
+      for (std::size_t x = 0; x < width; ++x)
+        out[x] = RGBA8(channels[x], channels[width + x],
+                       channels[2 * width + x]);
+    }
+  });
+}
+} // namespace cpu
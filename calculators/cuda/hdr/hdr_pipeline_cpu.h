@@ -0,0 +1,116 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef INCLUDED_HDR_PIPELINE_CPU
+#define INCLUDED_HDR_PIPELINE_CPU
+
+#pragma once
+
+#include <cstddef>
+
+#include "calculators/cuda/hdr/bloom.h"
+#include "calculators/cuda/hdr/tonemap.h"
+
+class RGB10A2;
+class RGB16F;
+class RGBA8;
+
+// host implementations of the stages in hdr_pipeline.cu. they take the same
+// interleaved RGB buffers and are spread over ThreadPool::shared(). the
+// overloads for the HDRStorage formats compute in float and convert rows on
+// load and store. the tonemapping stages evaluate the operator of tonemap,
+// through the host table lut if tonemap.lut is set.
+namespace cpu {
+void luminance(float *dest, const float *input, std::size_t width,
+               std::size_t height);
+
+void downsample(float *dest, const float *luminance, std::size_t width,
+                std::size_t height);
+
+void tonemap(float *tonemapped, float *brightpass, const float *src,
+             std::size_t width, std::size_t height, float exposure,
+             float brightpass_threshold, const TonemapSettings &tonemap,
+             const float *lut);
+void tonemap(RGB16F *tonemapped, RGB16F *brightpass, const float *src,
+             std::size_t width, std::size_t height, float exposure,
+             float brightpass_threshold, const TonemapSettings &tonemap,
+             const float *lut);
+
+void compose(float *output, const float *tonemapped, const float *blurred,
+             std::size_t width, std::size_t height);
+void compose(RGB16F *output, const RGB16F *tonemapped, const RGB16F *blurred,
+             std::size_t width, std::size_t height);
+void compose(RGB10A2 *output, const RGB16F *tonemapped,
+             const RGB16F *blurred, std::size_t width, std::size_t height);
+
+// tonemap, brightpass, bloom and compose, see fused_tonemap_bloom() in
+// hdr_pipeline.cu. exposure has already been divided by the average
+// luminance, workspace holds BloomLayout::size floats.
+void fused_tonemap_bloom(float *output, float *workspace, const float *src,
+                         std::size_t width, std::size_t height, float exposure,
+                         float brightpass_threshold,
+                         const BloomSettings &settings,
+                         const TonemapSettings &tonemap, const float *lut);
+void fused_tonemap_bloom(RGB16F *output, float *workspace, const float *src,
+                         std::size_t width, std::size_t height, float exposure,
+                         float brightpass_threshold,
+                         const BloomSettings &settings,
+                         const TonemapSettings &tonemap, const float *lut);
+void fused_tonemap_bloom(RGB10A2 *output, float *workspace, const float *src,
+                         std::size_t width, std::size_t height, float exposure,
+                         float brightpass_threshold,
+                         const BloomSettings &settings,
+                         const TonemapSettings &tonemap, const float *lut);
+
+// the planar layout keeps the channels of a float image in three planes of
+// width * height floats. compose() and bloom_planar() work on it as well.
+void luminance_planar(float *dest, const float *input, std::size_t width,
+                      std::size_t height);
+
+void tonemap_planar(float *tonemapped, float *brightpass, const float *src,
+                    std::size_t width, std::size_t height, float exposure,
+                    float brightpass_threshold, const TonemapSettings &tonemap,
+                    const float *lut);
+
+// conversion between the interleaved and the planar layout. the rows of rgb
+// are rgb_pitch bytes apart when it is split into planes.
+void deinterleave(float *planes, const float *rgb, std::size_t width,
+                  std::size_t height, std::size_t rgb_pitch);
+void interleave(float *rgb, const float *planes, std::size_t width,
+                std::size_t height);
+
+// conversion to 8 bit RGBA with the gamma of srgb8_table(), alpha is opaque.
+// a gray image of luminance gives gray pixels.
+void gray_to_srgb8(RGBA8 *dest, const float *src, std::size_t width,
+                   std::size_t height);
+void to_srgb8(RGBA8 *dest, const float *src, std::size_t width,
+              std::size_t height);
+void to_srgb8(RGBA8 *dest, const RGB16F *src, std::size_t width,
+              std::size_t height);
+void to_srgb8(RGBA8 *dest, const RGB10A2 *src, std::size_t width,
+              std::size_t height);
+void planar_to_srgb8(RGBA8 *dest, const float *src, std::size_t width,
+                     std::size_t height);
+} // namespace cpu
+
+#endif // INCLUDED_HDR_PIPELINE_CPU
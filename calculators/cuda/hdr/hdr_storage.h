@@ -0,0 +1,139 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef INCLUDED_HDR_STORAGE
+#define INCLUDED_HDR_STORAGE
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+
+#include "calculators/cuda/hdr/framework/rgb10a2.h"
+#include "calculators/cuda/hdr/framework/rgb16f.h"
+#include "calculators/cuda/hdr/framework/rgb32f.h"
+
+// how HDRPipeline stores the tonemapped, brightpass, blurred and output
+// images. every stage computes in float and converts on load and store, fp16
+// halves the memory traffic between the stages. fp16_rgb10a2 packs the output
+// into 32 bits per pixel, clamped to [0, 1]. the input, the luminance images
+// and the bloom workspace stay float.
+enum class HDRStorage { fp32, fp16, fp16_rgb10a2 };
+
+// pixel types of a storage policy. float images hold three floats per pixel,
+// the other types one pixel per element.
+template <HDRStorage S> struct HDRStorageFormat;
+
+template <> struct HDRStorageFormat<HDRStorage::fp32> {
+  using intermediate = float;
+  using output = float;
+};
+
+template <> struct HDRStorageFormat<HDRStorage::fp16> {
+  using intermediate = RGB16F;
+  using output = RGB16F;
+};
+
+template <> struct HDRStorageFormat<HDRStorage::fp16_rgb10a2> {
+  using intermediate = RGB16F;
+  using output = RGB10A2;
+};
+
+constexpr std::size_t intermediate_pixel_size(HDRStorage storage) {
+  return storage == HDRStorage::fp32 ? sizeof(RGB32F) : sizeof(RGB16F);
+}
+
+constexpr std::size_t output_pixel_size(HDRStorage storage) {
+  return storage == HDRStorage::fp32   ? sizeof(RGB32F)
+         : storage == HDRStorage::fp16 ? sizeof(RGB16F)
+                                       : sizeof(RGB10A2);
+}
+
+// 8 bit channels of the read*() accessors with a gamma of 2.2, the usual
+// approximation of sRGB. entry v > 0 of the table is the smallest linear
+// value that maps to v, (v / 255)^2.2, and a channel is the number of entries
+// it reaches. both backends look up the same table and round alike.
+constexpr unsigned int srgb8_table_size = 256U;
+const float *srgb8_table();
+
+// row access for the host stages, which work on float rows and convert the
+// other formats on the way in and out
+namespace cpu {
+// floats of scratch the helpers below need for pixels of T, none for float
+template <typename T> constexpr std::size_t scratch_floats(std::size_t pixels) {
+  return std::is_same<typename std::remove_const<T>::type, float>::value
+             ? 0
+             : 3 * pixels;
+}
+
+template <typename T>
+T *pixel_row(T *image, std::size_t width, std::size_t y) {
+  constexpr std::size_t elements =
+      std::is_same<typename std::remove_const<T>::type, float>::value ? 3 : 1;
+  return image + elements * width * y;
+}
+
+// copies pixels of src to the float row dest
+inline void read_row(float *dest, const float *src, std::size_t pixels) {
+  std::copy_n(src, 3 * pixels, dest);
+}
+
+template <typename T>
+void read_row(float *dest, const T *src, std::size_t pixels) {
+  convert(reinterpret_cast<RGB32F *>(dest), src, pixels);
+}
+
+// src as float row, converted into scratch unless it is one already
+inline const float *load_row(float * /*scratch*/, const float *src,
+                             std::size_t /*pixels*/) {
+  return src;
+}
+
+template <typename T>
+const float *load_row(float *scratch, const T *src, std::size_t pixels) {
+  read_row(scratch, src, pixels);
+  return scratch;
+}
+
+// the float row to compute a row of dest in before store_row(): float rows
+// are written in place, the other formats go through scratch
+inline float *row_target(float * /*scratch*/, float *dest) { return dest; }
+
+template <typename T> float *row_target(float *scratch, T * /*dest*/) {
+  return scratch;
+}
+
+inline void store_row(float *dest, const float *src, std::size_t pixels) {
+  if (dest != src)
+    std::copy_n(src, 3 * pixels, dest);
+}
+
+template <typename T>
+void store_row(T *dest, const float *src, std::size_t pixels) {
+  convert(dest, reinterpret_cast<const RGB32F *>(src), pixels);
+}
+} // namespace cpu
+
+#endif // INCLUDED_HDR_STORAGE
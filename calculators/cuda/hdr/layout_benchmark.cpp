@@ -0,0 +1,208 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// per stage timings of the interleaved and the planar layout on synthetic
+// input, on the CPU backend or with --cuda on the device
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <cuda_runtime_api.h>
+
+#include "calculators/cuda/hdr/framework/CUDA/error.h"
+#include "calculators/cuda/hdr/framework/cmd_args.h"
+#include "calculators/cuda/hdr/framework/host_executor.h"
+
+#include "calculators/cuda/hdr/HDRPipeline.h"
+
+namespace {
+constexpr std::size_t stage_count = 7;
+const char *const stage_names[stage_count] = {
+    "consume", "luminance", "downsample", "tonemap",
+    "blur",    "compose",   "readOutput"};
+
+using Timings = std::array<double, stage_count>;
+
+// average milliseconds per stage. every stage is timed from an idle pipeline
+// to the end of its work, so the layout conversions in consume() and
+// readOutput() count towards those stages.
+Timings benchmark(HDRPipeline &pipeline, const std::vector<float> &input,
+                  int runs) {
+  const float exposure = 1.0f;
+  const float brightpass_threshold = 0.9f;
+
+  // one untimed run warms up the caches, the thread pool and the device
+  pipeline.consume(input.data());
+  pipeline.run(exposure, brightpass_threshold);
+  pipeline.readOutput();
+
+  Timings ms = {};
+  auto time = [&](std::size_t stage, auto &&fn) {
+    pipeline.synchronize();
+    const auto begin = std::chrono::steady_clock::now();
+    fn();
+    pipeline.synchronize();
+    ms[stage] += std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - begin)
+                     .count();
+  };
+
+  for (int i = 0; i < runs; ++i) {
+    time(0, [&] { pipeline.consume(input.data()); });
+    time(1, [&] { pipeline.computeLuminance(); });
+    time(2, [&] { pipeline.downsampleAsync(); });
+    time(3, [&] { pipeline.tonemapResident(exposure, brightpass_threshold); });
+    time(4, [&] { pipeline.blur(); });
+    time(5, [&] { pipeline.compose(); });
+    time(6, [&] { pipeline.readOutput(); });
+  }
+
+  for (double &t : ms)
+    t /= runs;
+  return ms;
+}
+
+void report(const Timings &interleaved, const Timings &planar,
+            std::size_t pixels) {
+  std::cout << "stage         interleaved          planar     speedup\n";
+  double total[2] = {0.0, 0.0};
+  for (std::size_t s = 0; s < stage_count; ++s) {
+    total[0] += interleaved[s];
+    total[1] += planar[s];
+    std::cout << std::left << std::setw(12) << stage_names[s] << std::right
+              << std::setw(10) << interleaved[s] << " ms" << std::setw(12)
+              << planar[s] << " ms" << std::setw(11)
+              << interleaved[s] / planar[s] << "x\n";
+  }
+  std::cout << std::left << std::setw(12) << "overall" << std::right
+            << std::setw(10) << total[0] << " ms" << std::setw(12) << total[1]
+            << " ms" << std::setw(11) << total[0] / total[1] << "x\n"
+            << "throughput  " << std::setw(10) << pixels / total[0] / 1000.0
+            << " MP/s" << std::setw(10) << pixels / total[1] / 1000.0
+            << " MP/s\n";
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  try {
+    int image_width = 3840;
+    int image_height = 2160;
+    int runs = 10;
+    int bloom_levels = 0;
+    bool cuda = false;
+    int cuda_device = 0;
+
+    for (char **a = &argv[1]; *a; ++a) {
+      if (!checkArgument("--width", a, image_width))
+        if (!checkArgument("--height", a, image_height))
+          if (!checkArgument("--runs", a, runs))
+            if (!checkArgument("--bloom-levels", a, bloom_levels))
+              if (!checkArgument("--cuda", a, cuda))
+                if (!checkArgument("--device", a, cuda_device))
+                  throw usage_error("unknown argument");
+    }
+
+    if (image_width < 1 || image_height < 1 || runs < 1)
+      throw usage_error("width, height and runs must be positive");
+    if (bloom_levels < 0 || bloom_levels > static_cast<int>(max_bloom_levels))
+      throw usage_error("bloom levels out of range");
+
+    const auto width = static_cast<unsigned int>(image_width);
+    const auto height = static_cast<unsigned int>(image_height);
+    const std::size_t pixels = std::size_t{width} * height;
+    BloomSettings bloom;
+    bloom.levels = static_cast<unsigned int>(bloom_levels);
+
+    // smooth gradients with a few bright spots, so the brightpass keeps part
+    // of the image
+    std::vector<float> input(3 * pixels);
+    for (std::size_t i = 0; i < pixels; ++i) {
+      const float x = static_cast<float>(i % width) / width;
+      const float y = static_cast<float>(i / width) / height;
+      const float spot = (i % 997 == 0) ? 50.0f : 0.0f;
+      input[3 * i + 0] = 4.0f * x + spot;
+      input[3 * i + 1] = 4.0f * y + spot;
+      input[3 * i + 2] = 2.0f * (x + y) + spot;
+    }
+
+    Timings interleaved;
+    Timings planar;
+    if (cuda) {
+      throw_error(cudaSetDevice(cuda_device));
+      cudaStream_t stream;
+      throw_error(cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking));
+      {
+        HDRPipeline a(width, height, stream);
+        HDRPipeline b(width, height, stream, HDRMode::debug, HDRStorage::fp32,
+                      HDRLayout::planar);
+        a.configureBloom(bloom);
+        b.configureBloom(bloom);
+        interleaved = benchmark(a, input, runs);
+        planar = benchmark(b, input, runs);
+      }
+      throw_error(cudaStreamDestroy(stream));
+    } else {
+      HostExecutor executor;
+      HDRPipeline a(width, height, executor);
+      HDRPipeline b(width, height, executor, HDRMode::debug, HDRStorage::fp32,
+                    HDRLayout::planar);
+      a.configureBloom(bloom);
+      b.configureBloom(bloom);
+      interleaved = benchmark(a, input, runs);
+      planar = benchmark(b, input, runs);
+    }
+
+    std::cout << (cuda ? "cuda" : "cpu") << " backend, " << width << "x"
+              << height << ", " << runs << " runs\n"
+              << std::fixed << std::setprecision(2);
+    report(interleaved, planar, pixels);
+  } catch (const usage_error &e) {
+    std::cout << "error: " << e.what() << std::endl;
+    std::cout << "usage: layout_benchmark {options}\n"
+                 "\toptions:\n"
+                 "\t  --width <w>            image width, default: 3840\n"
+                 "\t  --height <h>           image height, default: 2160\n"
+                 "\t  --runs <N>             average over <N> runs, "
+                 "default: 10\n"
+                 "\t  --bloom-levels <n>     blur the bloom on <n> downsampled "
+                 "levels, default: 0\n"
+                 "\t  --cuda                 run on the device instead of the "
+                 "cpu\n"
+                 "\t  --device <i>           use cuda device <i>, default: 0\n";
+    return -127;
+  } catch (std::exception &e) {
+    std::cout << "error: " << e.what() << std::endl;
+    return -1;
+  } catch (...) {
+    std::cout << "unknown exception" << std::endl;
+    return -128;
+  }
+
+  return 0;
+}
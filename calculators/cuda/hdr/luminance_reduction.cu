@@ -0,0 +1,169 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "calculators/cuda/hdr/luminance_reduction.h"
+
+namespace {
+constexpr unsigned int divup(unsigned int a, unsigned int b) {
+  return (a + b - 1) / b;
+}
+
+constexpr unsigned int reduction_block_size = 256U;
+// pixels every thread accumulates before the block reduction kicks in
+constexpr unsigned int reduction_items_per_thread = 16U;
+
+template <typename T> struct Sums {
+  T sum;
+  T log_sum;
+};
+
+template <typename T> __device__ Sums<T> warp_reduce(Sums<T> v) {
+  for (int offset = warpSize / 2; offset > 0; offset /= 2) {
+    v.sum += __shfl_down_sync(0xFFFFFFFFU, v.sum, offset);
+    v.log_sum += __shfl_down_sync(0xFFFFFFFFU, v.log_sum, offset);
+  }
+  return v;
+}
+
+// sums over all threads of the block, the result is valid in thread 0 only
+template <typename T> __device__ Sums<T> block_reduce(Sums<T> v) {
+  __shared__ Sums<T> warp_sums[reduction_block_size / 32];
+
+  const unsigned int lane = threadIdx.x % warpSize;
+  const unsigned int warp = threadIdx.x / warpSize;
+
+  v = warp_reduce(v);
+  if (lane == 0)
+    warp_sums[warp] = v;
+  __syncthreads();
+
+  if (warp == 0) {
+    v = lane < blockDim.x / warpSize ? warp_sums[lane] : Sums<T>{0, 0};
+    v = warp_reduce(v);
+  }
+  return v;
+}
+
+struct LoadLuminance {
+  const float *luminance;
+  __device__ float operator()(std::size_t i) const {
+    return __ldg(luminance + i);
+  }
+};
+
+// same weights as luminance_kernel in hdr_pipeline.cu
+struct LoadRGBLuminance {
+  const float *rgb;
+  __device__ float operator()(std::size_t i) const {
+    return 0.21f * __ldg(rgb + 3 * i) + 0.72f * __ldg(rgb + 3 * i + 1) +
+           0.07f * __ldg(rgb + 3 * i + 2);
+  }
+};
+} // namespace
+
+// every thread accumulates a grid-strided subset of the pixels, the block
+// combines them with warp shuffles and leaves one partial in the workspace.
+// the last block to finish folds all partials in double precision, so the
+// whole reduction is one launch reading every pixel exactly once. blockIdx.y
+// is the image of a batch, each one with partials and counter of its own.
+template <typename Load>
+__global__ void reduce_luminance_kernel(LuminanceStats *stats,
+                                        Sums<float> *partials,
+                                        unsigned int *blocks_done, Load load,
+                                        unsigned int num_pixels) {
+  const std::size_t first = std::size_t{blockIdx.y} * num_pixels;
+  stats += blockIdx.y;
+  partials += blockIdx.y * max_reduction_blocks;
+  blocks_done += blockIdx.y;
+
+  Sums<float> acc = {0.0f, 0.0f};
+  for (unsigned int i = blockIdx.x * blockDim.x + threadIdx.x; i < num_pixels;
+       i += gridDim.x * blockDim.x) {
+    float l = fmaxf(load(first + i), 0.0f);
+    acc.sum += l;
+    acc.log_sum += logf(l + log_luminance_delta);
+  }
+  acc = block_reduce(acc);
+
+  __shared__ bool is_last_block;
+  if (threadIdx.x == 0) {
+    partials[blockIdx.x] = acc;
+    __threadfence();
+    // atomicInc wraps back to 0 for the last block, which leaves the counter
+    // ready for the next launch
+    is_last_block = atomicInc(blocks_done, gridDim.x - 1) == gridDim.x - 1;
+  }
+  __syncthreads();
+
+  if (!is_last_block)
+    return;
+
+  const volatile Sums<float> *p = partials;
+  Sums<double> total = {0.0, 0.0};
+  for (unsigned int i = threadIdx.x; i < gridDim.x; i += blockDim.x) {
+    total.sum += p[i].sum;
+    total.log_sum += p[i].log_sum;
+  }
+  total = block_reduce(total);
+
+  if (threadIdx.x == 0) {
+    stats->average = static_cast<float>(total.sum / num_pixels);
+    stats->log_average = static_cast<float>(exp(total.log_sum / num_pixels));
+  }
+}
+
+namespace {
+template <typename Load>
+void launch_reduction(LuminanceStats *stats, void *workspace, Load load,
+                      unsigned int width, unsigned int height,
+                      unsigned int batch, cudaStream_t stream) {
+  const unsigned int num_pixels = width * height;
+  const dim3 num_blocks = {
+      min(max_reduction_blocks,
+          divup(num_pixels, reduction_block_size * reduction_items_per_thread)),
+      batch};
+
+  auto partials = static_cast<Sums<float> *>(workspace);
+  auto blocks_done = reinterpret_cast<unsigned int *>(
+      partials + batch * max_reduction_blocks);
+
+  reduce_luminance_kernel<<<num_blocks, reduction_block_size, 0, stream>>>(
+      stats, partials, blocks_done, load, num_pixels);
+}
+} // namespace
+
+void reduce_luminance(LuminanceStats *stats, void *workspace,
+                      const float *luminance, unsigned int width,
+                      unsigned int height, cudaStream_t stream,
+                      unsigned int batch) {
+  launch_reduction(stats, workspace, LoadLuminance{luminance}, width, height,
+                   batch, stream);
+}
+
+void reduce_luminance_rgb(LuminanceStats *stats, void *workspace,
+                          const float *rgb, unsigned int width,
+                          unsigned int height, cudaStream_t stream,
+                          unsigned int batch) {
+  launch_reduction(stats, workspace, LoadRGBLuminance{rgb}, width, height,
+                   batch, stream);
+}
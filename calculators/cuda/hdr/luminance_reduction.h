@@ -0,0 +1,85 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef INCLUDED_LUMINANCE_REDUCTION
+#define INCLUDED_LUMINANCE_REDUCTION
+
+#pragma once
+
+#include <cstddef>
+
+// same declaration as in driver_types.h, keeps the CUDA headers out of the
+// host-only library
+typedef struct CUstream_st *cudaStream_t;
+
+// result of reducing a luminance image to a single value
+struct LuminanceStats {
+  float average;     // arithmetic mean
+  float log_average; // geometric mean: exp(mean(log(delta + L)))
+};
+
+// keeps log() finite on black pixels
+constexpr float log_luminance_delta = 1.0e-4f;
+
+// upper bound of blocks launched by the single-pass CUDA reduction. every
+// block leaves one partial sum in the workspace, the last block to finish
+// folds them into the final result.
+constexpr unsigned int max_reduction_blocks = 1024U;
+
+// size in bytes of the device workspace needed by reduce_luminance() for a
+// batch of images, every image has partials and a counter of its own
+constexpr std::size_t luminance_reduction_workspace_size(unsigned int batch =
+                                                             1U) {
+  return batch *
+         (max_reduction_blocks * 2U * sizeof(float) + sizeof(unsigned int));
+}
+
+// CUDA: reduces width * height luminance values in one kernel launch on
+// stream and writes the result to device memory. workspace must be
+// zero-initialized before the first call, the kernel leaves it zeroed for the
+// next one. a batch of images stored one after the other is reduced by the
+// same launch, stats receives one result per image.
+void reduce_luminance(LuminanceStats *stats, void *workspace,
+                      const float *luminance, unsigned int width,
+                      unsigned int height, cudaStream_t stream = 0,
+                      unsigned int batch = 1U);
+
+// same as reduce_luminance(), but computes the luminance of every pixel of an
+// interleaved RGB image on the fly, so no luminance image is needed
+void reduce_luminance_rgb(LuminanceStats *stats, void *workspace,
+                          const float *rgb, unsigned int width,
+                          unsigned int height, cudaStream_t stream = 0,
+                          unsigned int batch = 1U);
+
+namespace cpu {
+// host reference of reduce_luminance(). the image is cut into a fixed number
+// of row strips which are reduced by the shared thread pool and combined in
+// order, so the result does not depend on the number of threads.
+LuminanceStats reduce_luminance(const float *luminance, std::size_t width,
+                                std::size_t height);
+
+LuminanceStats reduce_luminance_rgb(const float *rgb, std::size_t width,
+                                    std::size_t height);
+} // namespace cpu
+
+#endif // INCLUDED_LUMINANCE_REDUCTION
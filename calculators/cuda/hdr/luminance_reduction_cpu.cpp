@@ -0,0 +1,178 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "calculators/cuda/hdr/framework/thread_pool.h"
+
+#include "calculators/cuda/hdr/luminance_reduction.h"
+
+namespace {
+// number of strips the image is cut into, independent of the thread count so
+// that the summation order and therefore the result is reproducible
+constexpr std::size_t num_strips = 256U;
+
+struct Partial {
+  double sum;
+  double log_sum;
+};
+
+#if defined(__AVX2__)
+// natural logarithm of 8 floats, cephes logf() polynomial (~1 ulp for x > 0)
+inline __m256 log_ps(__m256 x) {
+  const __m256 one = _mm256_set1_ps(1.0f);
+
+  __m256i bits = _mm256_castps_si256(x);
+  __m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(
+      _mm256_srli_epi32(bits, 23), _mm256_set1_epi32(126)));
+
+  // mantissa in [0.5, 1)
+  __m256 m = _mm256_castsi256_ps(
+      _mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x807FFFFF)),
+                      _mm256_set1_epi32(0x3F000000)));
+
+  __m256 small = _mm256_cmp_ps(m, _mm256_set1_ps(0.707106781186547524f),
+                               _CMP_LT_OS);
+  e = _mm256_sub_ps(e, _mm256_and_ps(one, small));
+  m = _mm256_add_ps(_mm256_sub_ps(m, one), _mm256_and_ps(m, small));
+
+  __m256 z = _mm256_mul_ps(m, m);
+  __m256 y = _mm256_set1_ps(7.0376836292e-2f);
+  y = _mm256_fmadd_ps(y, m, _mm256_set1_ps(-1.1514610310e-1f));
+  y = _mm256_fmadd_ps(y, m, _mm256_set1_ps(1.1676998740e-1f));
+  y = _mm256_fmadd_ps(y, m, _mm256_set1_ps(-1.2420140846e-1f));
+  y = _mm256_fmadd_ps(y, m, _mm256_set1_ps(1.4249322787e-1f));
+  y = _mm256_fmadd_ps(y, m, _mm256_set1_ps(-1.6668057665e-1f));
+  y = _mm256_fmadd_ps(y, m, _mm256_set1_ps(2.0000714765e-1f));
+  y = _mm256_fmadd_ps(y, m, _mm256_set1_ps(-2.4999993993e-1f));
+  y = _mm256_fmadd_ps(y, m, _mm256_set1_ps(3.3333331174e-1f));
+  y = _mm256_mul_ps(_mm256_mul_ps(y, m), z);
+
+  y = _mm256_fmadd_ps(e, _mm256_set1_ps(-2.12194440e-4f), y);
+  y = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), y);
+  return _mm256_fmadd_ps(e, _mm256_set1_ps(0.693359375f), _mm256_add_ps(m, y));
+}
+
+inline double hsum(__m256 v) {
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+  s = _mm_add_ss(s, _mm_movehdup_ps(s));
+  return _mm_cvtss_f32(s);
+}
+#endif
+
+// reduces one contiguous run of pixels. float accumulators per SIMD lane are
+// flushed into doubles every row so long rows do not lose precision.
+Partial reduce_run(const float *src, std::size_t count) {
+  Partial p = {0.0, 0.0};
+  std::size_t i = 0;
+
+#if defined(__AVX2__)
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 delta = _mm256_set1_ps(log_luminance_delta);
+  __m256 sum = zero;
+  __m256 log_sum = zero;
+  for (; i + 8 <= count; i += 8) {
+    __m256 l = _mm256_max_ps(_mm256_loadu_ps(src + i), zero);
+    sum = _mm256_add_ps(sum, l);
+    log_sum = _mm256_add_ps(log_sum, log_ps(_mm256_add_ps(l, delta)));
+  }
+  p.sum = hsum(sum);
+  p.log_sum = hsum(log_sum);
+#endif
+
+  for (; i < count; ++i) {
+    float l = std::max(src[i], 0.0f);
+    p.sum += l;
+    p.log_sum += std::log(l + log_luminance_delta);
+  }
+  return p;
+}
+
+// cuts the image into strips, reduces them on the shared thread pool and
+// combines the partials in order. row(y, buffer) returns the luminance of row y,
+// either in place or computed into buffer. empty images have no pixels to
+// average, their statistics are 0.
+template <typename Row>
+LuminanceStats reduce_strips(std::size_t width, std::size_t height, Row row) {
+  if (width == 0 || height == 0)
+    return {0.0f, 0.0f};
+  const std::size_t strips = std::min(num_strips, height);
+  const std::size_t rows_per_strip = (height + strips - 1) / strips;
+
+  std::vector<Partial> partials(strips, Partial{0.0, 0.0});
+
+  ThreadPool::shared().parallel_for(strips, [&](std::size_t s) {
+    std::size_t begin = s * rows_per_strip;
+    std::size_t end = std::min(begin + rows_per_strip, height);
+    std::vector<float> buffer;
+    Partial acc = {0.0, 0.0};
+    for (std::size_t y = begin; y < end; ++y) {
+      Partial p = reduce_run(row(y, buffer), width);
+      acc.sum += p.sum;
+      acc.log_sum += p.log_sum;
+    }
+    partials[s] = acc;
+  });
+
+  double sum = 0.0;
+  double log_sum = 0.0;
+  for (const auto &p : partials) {
+    sum += p.sum;
+    log_sum += p.log_sum;
+  }
+
+  const double n = static_cast<double>(width) * static_cast<double>(height);
+  return {static_cast<float>(sum / n),
+          static_cast<float>(std::exp(log_sum / n))};
+}
+} // namespace
+
+namespace cpu {
+LuminanceStats reduce_luminance(const float *luminance, std::size_t width,
+                                std::size_t height) {
+  return reduce_strips(width, height,
+                       [&](std::size_t y, std::vector<float> &) {
+                         return luminance + y * width;
+                       });
+}
+
+LuminanceStats reduce_luminance_rgb(const float *rgb, std::size_t width,
+                                    std::size_t height) {
+  return reduce_strips(
+      width, height, [&](std::size_t y, std::vector<float> &buffer) {
+        buffer.resize(width);
+        const float *src = rgb + 3 * width * y;
+        for (std::size_t x = 0; x < width; ++x)
+          buffer[x] = 0.21f * src[3 * x] + 0.72f * src[3 * x + 1] +
+                      0.07f * src[3 * x + 2];
+        return static_cast<const float *>(buffer.data());
+      });
+}
+} // namespace cpu
@@ -22,116 +22,301 @@
 //
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <exception>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include <cuda_runtime_api.h>
 
 #include "calculators/cuda/hdr/framework/CUDA/error.h"
 #include "calculators/cuda/hdr/framework/cmd_args.h"
+#include "calculators/cuda/hdr/framework/host_executor.h"
 #include "calculators/cuda/hdr/framework/image.h"
 #include "calculators/cuda/hdr/framework/pfm.h"
 #include "calculators/cuda/hdr/framework/png.h"
+#include "calculators/cuda/hdr/framework/rgb10a2.h"
+#include "calculators/cuda/hdr/framework/rgb16f.h"
 #include "calculators/cuda/hdr/framework/rgb32f.h"
+#include "calculators/cuda/hdr/framework/thread_pool.h"
 
+#include "calculators/cuda/hdr/HDRAutoExposure.h"
 #include "calculators/cuda/hdr/HDRPipeline.h"
+#include "calculators/cuda/hdr/HDRTiledPipeline.h"
+#include "calculators/cuda/hdr/HDRVideoPipeline.h"
 
 namespace {
-std::uint8_t toLinear8(float c) {
-  return static_cast<std::uint8_t>(std::min(std::max(c, 0.0f), 1.0f) * 255.0f);
+// image of the pipeline in 8 bit RGBA for the PNG files. the conversion
+// runs where the pipeline does, straight into the pixels of png.
+image<std::uint32_t> &readSRGB(image<std::uint32_t> &png,
+                               HDRPipeline &pipeline, HDRImage which) {
+  pipeline.readSRGBAsync(which, reinterpret_cast<RGBA8 *>(data(png)));
+  pipeline.synchronize();
+  return png;
 }
 
-std::uint8_t toSRGB8(float c) { return toLinear8(std::pow(c, 1.0f / 2.2f)); }
+float maxDifference(const image<RGB32F> &a, const image<RGB32F> &b) {
+  float difference = 0.0f;
+  for (std::size_t y = 0U; y < height(a); ++y)
+    for (std::size_t x = 0U; x < width(a); ++x) {
+      difference = std::max(difference, std::abs(channel<0>(a(x, y)) -
+                                                  channel<0>(b(x, y))));
+      difference = std::max(difference, std::abs(channel<1>(a(x, y)) -
+                                                  channel<1>(b(x, y))));
+      difference = std::max(difference, std::abs(channel<2>(a(x, y)) -
+                                                  channel<2>(b(x, y))));
+    }
+  return difference;
+}
+
+// points in the work queued on the pipeline that the stages are timed
+// between
+enum Mark : std::size_t {
+  pipeline_consume,
+  luminance_begin,
+  luminance_end,
+  downsample_begin,
+  downsample_end,
+  tonemap_begin,
+  tonemap_end,
+  blur_begin,
+  blur_end,
+  compose_begin,
+  compose_end,
+  mark_count
+};
+
+// CUDA events on the CUDA backend. the CPU backend reads the host clock
+// after waiting for the executor, so the stages run one by one there.
+class StageTimer {
+  HDRPipeline &pipeline;
+  cudaStream_t stream;
+  std::vector<cudaEvent_t> events;
+  std::vector<std::chrono::steady_clock::time_point> times;
+
+public:
+  StageTimer(HDRPipeline &pipeline, cudaStream_t stream)
+      : pipeline(pipeline), stream(stream) {
+    if (pipeline.getBackend() == HDRBackend::cuda) {
+      events.resize(mark_count);
+      for (cudaEvent_t &event : events)
+        throw_error(cudaEventCreate(&event));
+    } else {
+      times.resize(mark_count);
+    }
+  }
+
+  StageTimer(const StageTimer &) = delete;
+  StageTimer &operator=(const StageTimer &) = delete;
 
-image<std::uint32_t> tonemap(const image<float> &img) {
-  image<std::uint32_t> output(width(img), height(img));
+  ~StageTimer() {
+    for (cudaEvent_t event : events)
+      cudaEventDestroy(event);
+  }
 
-  for (std::size_t y = 0U; y < height(img); ++y) {
-    for (std::size_t x = 0U; x < width(img); ++x) {
-      std::uint8_t v = toSRGB8(img(x, y));
-      output(x, y) = 0xFF000000U | (v << 16) | (v << 8) | v;
+  void record(Mark mark) {
+    if (events.empty()) {
+      pipeline.synchronize();
+      times[mark] = std::chrono::steady_clock::now();
+    } else {
+      throw_error(cudaEventRecord(events[mark], stream));
     }
   }
-  return output;
-}
 
-image<std::uint32_t> tonemap(const image<RGB32F> &img) {
-  image<std::uint32_t> output(width(img), height(img));
+  // waits for the work up to mark
+  void synchronize(Mark mark) {
+    if (!events.empty())
+      throw_error(cudaEventSynchronize(events[mark]));
+  }
 
-  for (std::size_t y = 0U; y < height(img); ++y)
-    for (std::size_t x = 0U; x < width(img); ++x)
-      output(x, y) = 0xFF000000U | (toSRGB8(channel<2>(img(x, y))) << 16) |
-                     (toSRGB8(channel<1>(img(x, y))) << 8) |
-                     toSRGB8(channel<0>(img(x, y)));
-  return output;
-}
+  // milliseconds between two marks
+  float elapsed(Mark from, Mark to) const {
+    if (events.empty())
+      return std::chrono::duration<float, std::milli>(times[to] - times[from])
+          .count();
+    float t;
+    throw_error(cudaEventElapsedTime(&t, events[from], events[to]));
+    return t;
+  }
+};
 } // namespace
 
 int main(int argc, char *argv[]) {
   try {
     const char *input_file = nullptr;
+    const char *backend_name = nullptr;
     int cuda_device = 0;
     float exposure_value = 0.0f;
     float brightpass_threshold = 0.9f;
     int test_runs = 1;
+    bool verify = false;
+    bool async = false;
+    bool fused = false;
+    int bloom_radius = 16;
+    int bloom_levels = 0;
+    int video_frames = 0;
+    bool fp16 = false;
+    bool rgb10a2 = false;
+    bool planar = false;
+    int tile_size = 0;
+    const char *tonemap_name = nullptr;
+    float white_point = 4.0f;
+    bool tonemap_lut = false;
+    bool auto_exposure = false;
+    const char *png_compression = nullptr;
 
     for (char **a = &argv[1]; *a; ++a) {
-      if (!checkArgument("--device", a, cuda_device))
-        if (!checkArgument("--exposure", a, exposure_value))
-          if (!checkArgument("--brightpass", a, brightpass_threshold))
-            if (!checkArgument("--test-runs", a, test_runs))
-              input_file = *a;
+      const bool option =
+          checkArgument("--backend", a, backend_name) ||
+          checkArgument("--device", a, cuda_device) ||
+          checkArgument("--exposure", a, exposure_value) ||
+          checkArgument("--brightpass", a, brightpass_threshold) ||
+          checkArgument("--test-runs", a, test_runs) ||
+          checkArgument("--verify", a, verify) ||
+          checkArgument("--async", a, async) ||
+          checkArgument("--video-frames", a, video_frames) ||
+          checkArgument("--fused", a, fused) ||
+          checkArgument("--bloom-radius", a, bloom_radius) ||
+          checkArgument("--bloom-levels", a, bloom_levels) ||
+          checkArgument("--fp16", a, fp16) ||
+          checkArgument("--rgb10a2", a, rgb10a2) ||
+          checkArgument("--planar", a, planar) ||
+          checkArgument("--tile-size", a, tile_size) ||
+          checkArgument("--tonemap", a, tonemap_name) ||
+          checkArgument("--white", a, white_point) ||
+          checkArgument("--lut", a, tonemap_lut) ||
+          checkArgument("--auto-exposure", a, auto_exposure) ||
+          checkArgument("--png-compression", a, png_compression);
+      if (!option)
+        input_file = *a;
     }
 
     if (!input_file)
       throw usage_error("need to specify input file");
 
+    if (bloom_radius < 1 || bloom_radius > static_cast<int>(max_bloom_radius))
+      throw usage_error("bloom radius out of range");
+    if (bloom_levels < 0 || bloom_levels > static_cast<int>(max_bloom_levels))
+      throw usage_error("bloom levels out of range");
+    BloomSettings bloom;
+    bloom.radius = static_cast<unsigned int>(bloom_radius);
+    bloom.levels = static_cast<unsigned int>(bloom_levels);
+
+    TonemapSettings tonemap_settings;
+    if (!tonemap_name || std::strcmp(tonemap_name, "uncharted2") == 0)
+      tonemap_settings.op = TonemapOperator::uncharted2;
+    else if (std::strcmp(tonemap_name, "aces") == 0)
+      tonemap_settings.op = TonemapOperator::aces;
+    else if (std::strcmp(tonemap_name, "reinhard") == 0)
+      tonemap_settings.op = TonemapOperator::reinhard;
+    else if (std::strcmp(tonemap_name, "hable") == 0)
+      tonemap_settings.op = TonemapOperator::hable;
+    else
+      throw usage_error("tonemap must be uncharted2, aces, reinhard or hable");
+    if (!(white_point > 0.0f))
+      throw usage_error("white point out of range");
+    tonemap_settings.white = white_point;
+    tonemap_settings.lut = tonemap_lut;
+
+    PNG::EncodeSettings png_settings;
+    if (!png_compression || std::strcmp(png_compression, "balanced") == 0)
+      png_settings.compression = PNG::Compression::balanced;
+    else if (std::strcmp(png_compression, "store") == 0)
+      png_settings.compression = PNG::Compression::store;
+    else if (std::strcmp(png_compression, "fast") == 0)
+      png_settings.compression = PNG::Compression::fast;
+    else if (std::strcmp(png_compression, "best") == 0)
+      png_settings.compression = PNG::Compression::best;
+    else
+      throw usage_error("png compression must be store, fast, balanced or "
+                        "best");
+
+    const HDRStorage storage = rgb10a2 ? HDRStorage::fp16_rgb10a2
+                               : fp16  ? HDRStorage::fp16
+                                       : HDRStorage::fp32;
+    if (planar && (fused || storage != HDRStorage::fp32))
+      throw usage_error("--planar needs fp32 storage and no --fused");
+    if (tile_size < 0)
+      throw usage_error("tile size out of range");
+
     auto input = PFM::loadRGB32F(input_file);
     float exposure = std::exp2(exposure_value);
 
-    cudaDeviceProp props;
-    throw_error(cudaGetDeviceProperties(&props, cuda_device));
-    std::cout << "using cuda device " << cuda_device
-              << ":\n"
-                 "\t"
-              << props.name
-              << "\n"
-                 "\tcompute capability "
-              << props.major << "." << props.minor << " @ "
-              << std::setprecision(1) << std::fixed << props.clockRate / 1000.0f
-              << " MHz\n"
-                 "\t"
-              << props.multiProcessorCount
-              << " multiprocessors\n"
-                 "\t"
-              << props.totalGlobalMem / (1024U * 1024U)
-              << " MiB global memory  "
-              << props.sharedMemPerMultiprocessor / 1024
-              << " kiB shared memory\n"
-              << std::endl;
-
-    throw_error(cudaSetDevice(cuda_device));
-
-    cudaEvent_t pipeline_consume, luminance_begin, luminance_end,
-        downsample_begin, downsample_end, tonemap_begin, tonemap_end,
-        blur_begin, blur_end, compose_begin, compose_end;
-    throw_error(cudaEventCreate(&pipeline_consume));
-    throw_error(cudaEventCreate(&luminance_begin));
-    throw_error(cudaEventCreate(&luminance_end));
-    throw_error(cudaEventCreate(&downsample_begin));
-    throw_error(cudaEventCreate(&downsample_end));
-    throw_error(cudaEventCreate(&tonemap_begin));
-    throw_error(cudaEventCreate(&tonemap_end));
-    throw_error(cudaEventCreate(&blur_begin));
-    throw_error(cudaEventCreate(&blur_end));
-    throw_error(cudaEventCreate(&compose_begin));
-    throw_error(cudaEventCreate(&compose_end));
-
-    HDRPipeline pipeline(static_cast<unsigned int>(width(input)),
-                         static_cast<unsigned int>(height(input)));
+    // without --backend the CUDA device is used if there is one
+    HDRBackend backend = HDRBackend::cpu;
+    if (!backend_name) {
+      int devices = 0;
+      if (cudaGetDeviceCount(&devices) == cudaSuccess && devices > 0)
+        backend = HDRBackend::cuda;
+      else
+        std::cout << "no cuda device found, falling back to the cpu\n";
+    } else if (std::strcmp(backend_name, "cuda") == 0) {
+      backend = HDRBackend::cuda;
+    } else if (std::strcmp(backend_name, "cpu") != 0) {
+      throw usage_error("backend must be cpu or cuda");
+    }
+    const bool cuda = backend == HDRBackend::cuda;
+
+    cudaStream_t stream = 0;
+    std::unique_ptr<HostExecutor> executor;
+    if (cuda) {
+      cudaDeviceProp props;
+      throw_error(cudaGetDeviceProperties(&props, cuda_device));
+      std::cout << "using cuda device " << cuda_device
+                << ":\n"
+                   "\t"
+                << props.name
+                << "\n"
+                   "\tcompute capability "
+                << props.major << "." << props.minor << " @ "
+                << std::setprecision(1) << std::fixed
+                << props.clockRate / 1000.0f
+                << " MHz\n"
+                   "\t"
+                << props.multiProcessorCount
+                << " multiprocessors\n"
+                   "\t"
+                << props.totalGlobalMem / (1024U * 1024U)
+                << " MiB global memory  "
+                << props.sharedMemPerMultiprocessor / 1024
+                << " kiB shared memory\n"
+                << std::endl;
+
+      throw_error(cudaSetDevice(cuda_device));
+      throw_error(cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking));
+    } else {
+      std::cout << "using the cpu backend with "
+                << ThreadPool::shared().size() << " threads\n"
+                << std::endl;
+      executor.reset(new HostExecutor);
+    }
+
+    const auto image_width = static_cast<unsigned int>(width(input));
+    const auto image_height = static_cast<unsigned int>(height(input));
+    const HDRMode mode = fused ? HDRMode::fused : HDRMode::debug;
+    const HDRLayout layout =
+        planar ? HDRLayout::planar : HDRLayout::interleaved;
+    std::unique_ptr<HDRPipeline> pipeline_owner(
+        cuda ? new HDRPipeline(image_width, image_height, stream, mode,
+                               storage, layout)
+             : new HDRPipeline(image_width, image_height, *executor, mode,
+                               storage, layout));
+    HDRPipeline &pipeline = *pipeline_owner;
+    pipeline.configureBloom(bloom);
+    pipeline.configureTonemap(tonemap_settings);
+    StageTimer timer(pipeline, stream);
+
+    // the test runs are taken as frames 1/30 s apart, the adaptation starts
+    // at the first one
+    const float frame_seconds = 1.0f / 30.0f;
+    HDRAutoExposure exposure_control;
+    LuminanceStats adapted = {};
 
     float luminance_time = 0.0f;
     float downsample_time = 0.0f;
@@ -141,44 +326,72 @@ int main(int argc, char *argv[]) {
     float overall_time = 0.0f;
 
     for (int i = 0; i < test_runs; ++i) {
-      throw_error(cudaEventRecord(pipeline_consume));
+      timer.record(pipeline_consume);
       pipeline.consume(reinterpret_cast<const float *>(data(input)));
 
-      throw_error(cudaEventRecord(luminance_begin));
-      pipeline.computeLuminance();
-      throw_error(cudaEventRecord(luminance_end));
-
-      throw_error(cudaEventRecord(downsample_begin));
-      float lum = pipeline.downsample();
-      throw_error(cudaEventRecord(downsample_end));
-
-      throw_error(cudaEventRecord(tonemap_begin));
-      pipeline.tonemap(exposure / lum, brightpass_threshold);
-      throw_error(cudaEventRecord(tonemap_end));
-
-      throw_error(cudaEventRecord(blur_begin));
-      pipeline.blur();
-      throw_error(cudaEventRecord(blur_end));
-
-      throw_error(cudaEventRecord(compose_begin));
-      pipeline.compose();
-      throw_error(cudaEventRecord(compose_end));
-
-      throw_error(cudaEventSynchronize(compose_end));
-
-      float t;
-      throw_error(cudaEventElapsedTime(&t, luminance_begin, luminance_end));
-      luminance_time += t;
-      throw_error(cudaEventElapsedTime(&t, downsample_begin, downsample_end));
-      downsample_time += t;
-      throw_error(cudaEventElapsedTime(&t, tonemap_begin, tonemap_end));
-      tonemap_time += t;
-      throw_error(cudaEventElapsedTime(&t, blur_begin, blur_end));
-      blur_time += t;
-      throw_error(cudaEventElapsedTime(&t, compose_begin, compose_end));
-      compose_time += t;
-      throw_error(cudaEventElapsedTime(&t, pipeline_consume, compose_end));
-      overall_time += t;
+      if (fused) {
+        // everything from luminance to compose, timed as compositing
+        timer.record(compose_begin);
+        if (auto_exposure) {
+          adapted = exposure_control.update(pipeline, frame_seconds);
+          pipeline.run(exposure, brightpass_threshold, adapted);
+        } else {
+          pipeline.run(exposure, brightpass_threshold);
+        }
+        timer.record(compose_end);
+      } else {
+        timer.record(luminance_begin);
+        pipeline.computeLuminance();
+        timer.record(luminance_end);
+
+        if (auto_exposure) {
+          // the histogram, if one is due this frame, and the adaptation
+          timer.record(downsample_begin);
+          adapted = exposure_control.update(pipeline, frame_seconds);
+          timer.record(downsample_end);
+
+          timer.record(tonemap_begin);
+          pipeline.tonemap(exposure / adapted.average, brightpass_threshold);
+          timer.record(tonemap_end);
+        } else if (async) {
+          // the average luminance never leaves the device, nothing below
+          // blocks until the final event synchronization
+          timer.record(downsample_begin);
+          pipeline.downsampleAsync();
+          timer.record(downsample_end);
+
+          timer.record(tonemap_begin);
+          pipeline.tonemapResident(exposure, brightpass_threshold);
+          timer.record(tonemap_end);
+        } else {
+          timer.record(downsample_begin);
+          float lum = pipeline.downsample();
+          timer.record(downsample_end);
+
+          timer.record(tonemap_begin);
+          pipeline.tonemap(exposure / lum, brightpass_threshold);
+          timer.record(tonemap_end);
+        }
+
+        timer.record(blur_begin);
+        pipeline.blur();
+        timer.record(blur_end);
+
+        timer.record(compose_begin);
+        pipeline.compose();
+        timer.record(compose_end);
+      }
+
+      timer.synchronize(compose_end);
+
+      if (!fused) {
+        luminance_time += timer.elapsed(luminance_begin, luminance_end);
+        downsample_time += timer.elapsed(downsample_begin, downsample_end);
+        tonemap_time += timer.elapsed(tonemap_begin, tonemap_end);
+        blur_time += timer.elapsed(blur_begin, blur_end);
+      }
+      compose_time += timer.elapsed(compose_begin, compose_end);
+      overall_time += timer.elapsed(pipeline_consume, compose_end);
     }
 
     {
@@ -193,58 +406,282 @@ int main(int argc, char *argv[]) {
 
     std::cout << "-------------------------------------------------------------"
                  "-----------\n"
-              << std::setprecision(2) << std::fixed
-              << "luminance:      " << luminance_time
-              << " ms\n"
-                 "downsampling:   "
-              << downsample_time
-              << " ms\n"
-                 "tonemapping:    "
-              << tonemap_time
-              << " ms\n"
-                 "blur:           "
-              << blur_time
-              << " ms\n"
-                 "compositing:    "
-              << compose_time
-              << " ms\n"
-                 "overall:        "
-              << overall_time << " ms\n";
-
-    auto luminance = pipeline.readLuminance();
-    PFM::saveR32F("luminance.pfm", luminance);
-    PNG::saveImage("luminance.png", tonemap(luminance));
-
-    auto downsample = pipeline.readDownsample();
-    PFM::saveR32F("downsample.pfm", downsample);
-    PNG::saveImage("downsample.png", tonemap(downsample));
-
-    auto tonemapped = pipeline.readTonemapped();
-    PFM::saveRGB32F("tonemapped.pfm", tonemapped);
-    PNG::saveImage("tonemapped.png", tonemap(tonemapped));
-
-    auto brightpass = pipeline.readBrightpass();
-    PFM::saveRGB32F("brightpass.pfm", brightpass);
-    PNG::saveImage("brightpass.png", tonemap(brightpass));
-
-    auto blurred = pipeline.readBlurred();
-    PFM::saveRGB32F("blurred.pfm", blurred);
-    PNG::saveImage("blurred.png", tonemap(blurred));
-
-    auto output = pipeline.readOutput();
-    PFM::saveRGB32F("output.pfm", output);
-    PNG::saveImage("output.png", tonemap(output));
+              << std::setprecision(2) << std::fixed;
+    if (fused)
+      std::cout << "fused passes:   " << compose_time << " ms\n";
+    else
+      std::cout << "luminance:      " << luminance_time
+                << " ms\n"
+                   "downsampling:   "
+                << downsample_time
+                << " ms\n"
+                   "tonemapping:    "
+                << tonemap_time
+                << " ms\n"
+                   "blur:           "
+                << blur_time
+                << " ms\n"
+                   "compositing:    "
+                << compose_time << " ms\n";
+    std::cout << "overall:        " << overall_time << " ms\n"
+              << "buffers:        "
+              << pipeline.memory().capacity() / (1024.0 * 1024.0)
+              << " MiB in " << pipeline.memory().allocations()
+              << " allocation(s)\n";
+
+    const LuminanceStats stats = pipeline.luminanceStatistics();
+    if (auto_exposure)
+      std::cout << std::setprecision(6) << "adapted luminance:     "
+                << exposure_control.adaptedLuminance()
+                << "\nscene luminance:       "
+                << exposure_control.sceneLuminance() << "  ("
+                << exposure_control.histogramCount() << " histograms in "
+                << exposure_control.frameCount() << " frames)\n";
+    else
+      std::cout << std::setprecision(6) << "average luminance:     "
+                << stats.average << "\nlog-average luminance: "
+                << stats.log_average << '\n';
+
+    if (video_frames > 0) {
+      // feed the image as a stream of frames, keeping the ring full
+      HDRVideoPipeline video(static_cast<unsigned int>(width(input)),
+                             static_cast<unsigned int>(height(input)),
+                             backend, exposure, brightpass_threshold,
+                             3, fused ? HDRMode::fused : HDRMode::debug,
+                             bloom, tonemap_settings);
+      image<RGB32F> frame(width(input), height(input));
+      float *frame_data = reinterpret_cast<float *>(data(frame));
+      int submitted = 0;
+      int retrieved = 0;
+      while (retrieved < video_frames) {
+        if (submitted < video_frames &&
+            video.submit(reinterpret_cast<const float *>(data(input))))
+          ++submitted;
+        else if (video.poll(frame_data) || video.retrieve(frame_data))
+          ++retrieved;
+      }
+
+      const VideoPipelineStats stats = video.statistics();
+      std::cout << std::setprecision(2) << std::fixed << "video ("
+                << video.capacity() << " frames in flight):\n"
+                << "  latency:      " << stats.average_latency_ms
+                << " ms average, " << stats.max_latency_ms << " ms max\n"
+                << "  throughput:   " << stats.throughput_fps
+                << " frames/s\n";
+    }
+
+    if (verify) {
+      if (auto_exposure) {
+        // the histogram of the last frame counted once more on the host
+        std::vector<unsigned int> reference(histogram_bins);
+        const unsigned int subsample = exposure_control.getSettings().subsample;
+        cpu::luminance_histogram(reference.data(),
+                                 reinterpret_cast<const float *>(data(input)),
+                                 width(input), height(input), subsample);
+        pipeline.computeHistogram(subsample);
+        const std::vector<unsigned int> bins = pipeline.readHistogram();
+        unsigned int differing = 0;
+        for (unsigned int b = 0; b < histogram_bins; ++b)
+          differing += bins[b] != reference[b];
+        std::cout << std::setprecision(2)
+                  << "cpu reference:         histogram "
+                  << (differing == 0 ? "identical"
+                                     : std::to_string(differing) +
+                                           " bins differ")
+                  << '\n';
+      } else {
+        // the host reduction runs on the downloaded luminance image, so any
+        // difference is down to the reduction itself. in fused mode there is
+        // no luminance image, the reference is computed from the input.
+        const LuminanceStats reference =
+            fused ? cpu::reduce_luminance_rgb(
+                        reinterpret_cast<const float *>(data(input)),
+                        width(input), height(input))
+                  : cpu::reduce_luminance(data(pipeline.readLuminance()),
+                                          width(input), height(input));
+        std::cout << "cpu reference:         " << reference.average << " / "
+                  << reference.log_average << "  (rel. error "
+                  << std::scientific << std::setprecision(2)
+                  << std::abs(stats.average - reference.average) /
+                         reference.average
+                  << " / "
+                  << std::abs(stats.log_average - reference.log_average) /
+                         reference.log_average
+                  << ")\n"
+                  << std::fixed;
+      }
+
+      // both modes on the host, the fused passes must match the stages
+      HostExecutor reference_executor;
+      HDRPipeline staged_cpu(image_width, image_height, reference_executor,
+                             HDRMode::debug, storage);
+      HDRPipeline fused_cpu(image_width, image_height, reference_executor,
+                            HDRMode::fused, storage);
+      for (HDRPipeline *p : {&staged_cpu, &fused_cpu}) {
+        p->configureBloom(bloom);
+        p->configureTonemap(tonemap_settings);
+        p->consume(reinterpret_cast<const float *>(data(input)));
+        if (auto_exposure)
+          p->run(exposure, brightpass_threshold, adapted);
+        else
+          p->run(exposure, brightpass_threshold);
+      }
+      auto staged_output = staged_cpu.readOutput();
+      std::cout << "max. output difference: " << std::scientific
+                << "cpu fused "
+                << maxDifference(fused_cpu.readOutput(), staged_output) << ", "
+                << (cuda ? "cuda " : "cpu ")
+                << maxDifference(pipeline.readOutput(), staged_output)
+                << " (to cpu staged)\n"
+                << std::fixed;
+    }
+
+    if (tile_size > 0) {
+      // the same image once more in tiles through a bounded working set
+      std::unique_ptr<HDRTiledPipeline> tiled(
+          cuda ? new HDRTiledPipeline(static_cast<unsigned int>(tile_size),
+                                      stream, storage, bloom)
+               : new HDRTiledPipeline(static_cast<unsigned int>(tile_size),
+                                      *executor, storage, bloom));
+      tiled->configureTonemap(tonemap_settings);
+      std::vector<unsigned char> tiled_output(width(input) * height(input) *
+                                              output_pixel_size(storage));
+      auto begin = std::chrono::steady_clock::now();
+      if (auto_exposure)
+        tiled->process(tiled_output.data(),
+                       reinterpret_cast<const float *>(data(input)),
+                       width(input), height(input), adapted, exposure,
+                       brightpass_threshold);
+      else
+        tiled->process(tiled_output.data(),
+                       reinterpret_cast<const float *>(data(input)),
+                       width(input), height(input), exposure,
+                       brightpass_threshold);
+      std::chrono::duration<float, std::milli> t =
+          std::chrono::steady_clock::now() - begin;
+
+      std::cout << std::setprecision(2) << std::fixed << "tiled ("
+                << tiled->getTileSize() << " px tiles, " << tiled->getHalo()
+                << " px halo):\n"
+                << "  overall:      " << t.count() << " ms\n"
+                << "  buffers:      "
+                << tiled->memory().capacity() / (1024.0 * 1024.0)
+                << " MiB\n";
+      if (verify) {
+        image<RGB32F> output = pipeline.readOutput();
+        image<RGB32F> tiled_rgb(width(input), height(input));
+        if (storage == HDRStorage::fp32) {
+          std::memcpy(data(tiled_rgb), tiled_output.data(),
+                      tiled_output.size());
+        } else if (storage == HDRStorage::fp16) {
+          image<RGB16F> stored(width(input), height(input));
+          std::memcpy(data(stored), tiled_output.data(), tiled_output.size());
+          tiled_rgb = convert<RGB32F>(stored);
+        } else {
+          image<RGB10A2> stored(width(input), height(input));
+          std::memcpy(data(stored), tiled_output.data(), tiled_output.size());
+          tiled_rgb = convert<RGB32F>(stored);
+        }
+        std::cout << "  max. difference to the whole image: "
+                  << std::scientific << maxDifference(tiled_rgb, output)
+                  << '\n'
+                  << std::fixed;
+      }
+    }
+
+    // all full size PNGs go through the same buffer
+    image<std::uint32_t> png(width(input), height(input));
+    if (!fused) {
+      auto luminance = pipeline.readLuminance();
+      PFM::saveR32F("luminance.pfm", luminance);
+      PNG::saveImage("luminance.png",
+                     readSRGB(png, pipeline, HDRImage::luminance),
+                     png_settings);
+
+      auto downsample = pipeline.readDownsample();
+      PFM::saveR32F("downsample.pfm", downsample);
+      image<std::uint32_t> downsample_png(width(downsample),
+                                          height(downsample));
+      PNG::saveImage("downsample.png",
+                     readSRGB(downsample_png, pipeline, HDRImage::downsample),
+                     png_settings);
+
+      PFM::saveRGB32F("tonemapped.pfm", pipeline.readTonemapped());
+      PNG::saveImage("tonemapped.png",
+                     readSRGB(png, pipeline, HDRImage::tonemapped),
+                     png_settings);
+
+      PFM::saveRGB32F("brightpass.pfm", pipeline.readBrightpass());
+      PNG::saveImage("brightpass.png",
+                     readSRGB(png, pipeline, HDRImage::brightpass),
+                     png_settings);
+
+      PFM::saveRGB32F("blurred.pfm", pipeline.readBlurred());
+      PNG::saveImage("blurred.png",
+                     readSRGB(png, pipeline, HDRImage::blurred), png_settings);
+    }
+
+    PNG::saveImage("output.png", readSRGB(png, pipeline, HDRImage::output),
+                   png_settings);
+    if (storage == HDRStorage::fp32) {
+      PFM::saveRGB32F("output.pfm", pipeline.readOutput());
+    } else if (storage == HDRStorage::fp16) {
+      image<RGB16F> output(width(input), height(input));
+      pipeline.readOutputAsync(data(output));
+      pipeline.synchronize();
+      PFM::saveRGB16F("output.pfm", output);
+    } else {
+      image<RGB10A2> output(width(input), height(input));
+      pipeline.readOutputAsync(data(output));
+      pipeline.synchronize();
+      // the packed linear values as they are, 16 bits per channel
+      PNG::saveImage("output16.png", output, png_settings);
+    }
   } catch (const usage_error &e) {
     std::cout << "error: " << e.what() << std::endl;
     std::cout << "usage: hdr_pipeline {options} <input-file>\n"
                  "\toptions:\n"
+                 "\t  --backend <cpu|cuda>   run the pipeline on the host or "
+                 "the GPU, default: cuda\n"
+                 "\t                         if a device is found, cpu "
+                 "otherwise\n"
                  "\t  --device <i>           use CUDA device <i>, default: 0\n"
                  "\t  --exposure <v>         set exposure value to <v>, "
                  "default: 0.0\n"
                  "\t  --brightpass <v>       set brightpass threshold to <v>, "
                  "default: 0.9\n"
                  "\t  --test-runs <N>        average timings over <N> test "
-                 "runs, default: 1\n";
+                 "runs, default: 1\n"
+                 "\t  --verify               check the luminance reduction "
+                 "against the cpu reference\n"
+                 "\t  --async                keep the average luminance on "
+                 "the device, no host round-trip\n"
+                 "\t  --video-frames <N>     stream the image <N> times "
+                 "through the video pipeline\n"
+                 "\t  --fused                fused passes, no intermediate "
+                 "images\n"
+                 "\t  --bloom-radius <r>     bloom blur radius, default: 16\n"
+                 "\t  --bloom-levels <n>     blur the bloom on <n> downsampled "
+                 "levels, default: 0\n"
+                 "\t  --fp16                 store the intermediate and output "
+                 "images as half floats\n"
+                 "\t  --rgb10a2              like --fp16, but pack the output "
+                 "into RGB10A2\n"
+                 "\t  --planar               keep the float images in "
+                 "R, G and B planes\n"
+                 "\t  --tile-size <n>        also process the image in tiles "
+                 "of <n> x <n> pixels\n"
+                 "\t  --tonemap <op>         uncharted2, aces, reinhard or "
+                 "hable, default: uncharted2\n"
+                 "\t  --white <w>            white point of reinhard, "
+                 "default: 4.0\n"
+                 "\t  --lut                  look the tonemap operator up in a "
+                 "table\n"
+                 "\t  --auto-exposure        adapt the exposure to a histogram "
+                 "over the test runs,\n"
+                 "\t                         taken as frames 1/30 s apart\n"
+                 "\t  --png-compression <c>  store, fast, balanced or best, "
+                 "default: balanced\n";
     return -127;
   } catch (std::exception &e) {
     std::cout << "error: " << e.what() << std::endl;
@@ -0,0 +1,75 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <algorithm>
+#include <new>
+
+#include <clim/aligned_malloc.h>
+
+#include "calculators/cuda/hdr/memory_arena.h"
+
+std::size_t ArenaLayout::add(std::size_t size) {
+  const std::size_t offset = bytes;
+  bytes += (size + MemoryArena::alignment - 1) / MemoryArena::alignment *
+           MemoryArena::alignment;
+  return offset;
+}
+
+void MemoryArena::release() {
+  if (block)
+    freeBlock(block);
+  block = nullptr;
+  capacity_bytes = 0;
+}
+
+void *MemoryArena::reserve(std::size_t size) {
+  if (size > capacity_bytes || !block) {
+    // the old contents are not kept, so free first to keep the peak low
+    release();
+    block = allocateBlock(std::max<std::size_t>(size, 1U));
+    capacity_bytes = size;
+    peak_bytes = std::max(peak_bytes, capacity_bytes);
+    ++allocation_count;
+  }
+  used_bytes = size;
+  return block;
+}
+
+void MemoryArena::shrinkToFit() {
+  if (capacity_bytes == used_bytes)
+    return;
+  release();
+  reserve(used_bytes);
+}
+
+void *HostArena::allocateBlock(std::size_t size) {
+  void *ptr = aligned_malloc<void *>(size, alignment);
+  if (!ptr)
+    throw std::bad_alloc();
+  return ptr;
+}
+
+void HostArena::freeBlock(void *ptr) { aligned_free(ptr); }
+
+HostArena::~HostArena() { release(); }
@@ -0,0 +1,100 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef INCLUDED_MEMORY_ARENA
+#define INCLUDED_MEMORY_ARENA
+
+#pragma once
+
+#include <cstddef>
+
+// offsets of the sub-buffers carved out of one arena block. every offset is
+// aligned to MemoryArena::alignment, so float4 and SIMD loads stay aligned.
+class ArenaLayout {
+  std::size_t bytes = 0;
+
+public:
+  // appends a sub-buffer of size bytes and returns its offset
+  std::size_t add(std::size_t size);
+
+  std::size_t size() const { return bytes; }
+};
+
+// one block of memory shared by all buffers of a pipeline. the block only
+// grows: reserve() keeps it whenever the requested size fits, so switching
+// between resolutions reuses the largest allocation so far and never
+// fragments. derived classes provide the memory, see HostArena and
+// DeviceArena.
+class MemoryArena {
+  void *block = nullptr;
+  std::size_t capacity_bytes = 0;
+  std::size_t used_bytes = 0;
+  std::size_t peak_bytes = 0;
+  std::size_t allocation_count = 0;
+
+protected:
+  // allocation failures throw
+  virtual void *allocateBlock(std::size_t size) = 0;
+  virtual void freeBlock(void *ptr) = 0;
+
+  // frees the block, derived destructors have to call this since the base
+  // destructor can no longer reach freeBlock()
+  void release();
+
+public:
+  static constexpr std::size_t alignment = 256U;
+
+  MemoryArena() = default;
+  MemoryArena(const MemoryArena &) = delete;
+  MemoryArena &operator=(const MemoryArena &) = delete;
+  virtual ~MemoryArena() = default;
+
+  // start of a block of at least size bytes. the contents and every pointer
+  // handed out before are invalid if the block had to grow.
+  void *reserve(std::size_t size);
+  // reallocates the block to exactly the size used by the last reserve(),
+  // invalidates the contents like a growing reserve()
+  void shrinkToFit();
+
+  // bytes requested by the last reserve()
+  std::size_t used() const { return used_bytes; }
+  // bytes currently allocated
+  std::size_t capacity() const { return capacity_bytes; }
+  // largest capacity held at any time
+  std::size_t peak() const { return peak_bytes; }
+  // number of times a block was allocated
+  std::size_t allocations() const { return allocation_count; }
+};
+
+// host memory, aligned to MemoryArena::alignment
+class HostArena final : public MemoryArena {
+protected:
+  void *allocateBlock(std::size_t size) override;
+  void freeBlock(void *ptr) override;
+
+public:
+  ~HostArena() override;
+};
+
+#endif // INCLUDED_MEMORY_ARENA
@@ -0,0 +1,189 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+
+// throughput of the memory mapped PFM reader and the gather writer against
+// the std::ifstream/std::ofstream implementation they replaced, on a
+// synthetic RGB image. the default size makes a file of 2.4 GB. the file
+// stays in the page cache between runs, so the numbers show the cost of the
+// copies and the flip rather than of the disk.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "calculators/cuda/hdr/framework/cmd_args.h"
+#include "calculators/cuda/hdr/framework/io.h"
+#include "calculators/cuda/hdr/framework/pfm.h"
+
+namespace {
+// the stream implementation as it was before the files were mapped
+namespace stream {
+image<RGB32F> load(const char *filename) {
+  std::ifstream file(filename, std::ios::binary | std::ios::in);
+  std::string magic;
+  std::size_t w;
+  std::size_t h;
+  float a;
+  file >> magic >> w >> h >> a;
+
+  if (magic != "PF" || a > 0.0f || file.get() != '\n')
+    throw std::runtime_error("unsupported file format");
+
+  image<RGB32F> img(w, h);
+  for (std::size_t j = 0; j < h; ++j)
+    read(file, data(img) + w * (h - 1 - j), w);
+  return img;
+}
+
+void save(const char *filename, const image<RGB32F> &img) {
+  std::ofstream file(filename, std::ios::binary | std::ios::out);
+  const std::size_t w = width(img);
+  const std::size_t h = height(img);
+
+  file << "PF" << '\n' << w << ' ' << h << '\n' << -1.0f << '\n';
+  for (std::size_t j = 0; j < h; ++j)
+    write(file, data(img) + w * (h - j - 1), w);
+}
+} // namespace stream
+
+constexpr std::size_t case_count = 7;
+const char *const case_names[case_count] = {
+    "stream save", "stream load", "writev save", "writev save bottom up",
+    "mapped load", "mapped load bottom up", "mapped view"};
+
+bool same(const image<RGB32F> &a, const image<RGB32F> &b) {
+  return width(a) == width(b) && height(a) == height(b) &&
+         std::memcmp(data(a), data(b),
+                     sizeof(RGB32F) * width(a) * height(a)) == 0;
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  try {
+    int image_width = 16384;
+    int image_height = 12288;
+    int runs = 3;
+    const char *filename = "pfm_benchmark.pfm";
+
+    for (char **a = &argv[1]; *a; ++a) {
+      if (!checkArgument("--width", a, image_width))
+        if (!checkArgument("--height", a, image_height))
+          if (!checkArgument("--runs", a, runs))
+            if (!checkArgument("--file", a, filename))
+              throw usage_error("unknown argument");
+    }
+
+    if (image_width < 1 || image_height < 1 || runs < 1)
+      throw usage_error("width, height and runs must be positive");
+
+    const auto width = static_cast<std::size_t>(image_width);
+    const auto height = static_cast<std::size_t>(image_height);
+    const double megabytes = sizeof(RGB32F) * width * height / 1e6;
+
+    image<RGB32F> input(width, height);
+    for (std::size_t y = 0; y < height; ++y)
+      for (std::size_t x = 0; x < width; ++x)
+        input(x, y) = {static_cast<float>(x), static_cast<float>(y),
+                       static_cast<float>(x ^ y)};
+
+    double ms[case_count] = {};
+    auto time = [&](std::size_t c, auto &&fn) {
+      const auto begin = std::chrono::steady_clock::now();
+      fn();
+      ms[c] += std::chrono::duration<double, std::milli>(
+                   std::chrono::steady_clock::now() - begin)
+                   .count();
+    };
+
+    for (int i = 0; i < runs; ++i) {
+      time(0, [&] { stream::save(filename, input); });
+      time(1, [&] {
+        if (!same(stream::load(filename), input))
+          throw std::runtime_error("stream load differs");
+      });
+      time(3, [&] {
+        PFM::saveRGB32F(filename, input, PFM::RowOrder::bottom_up);
+      });
+      time(2, [&] { PFM::saveRGB32F(filename, input); });
+      time(4, [&] {
+        if (!same(PFM::loadRGB32F(filename), input))
+          throw std::runtime_error("mapped load differs");
+      });
+      time(5, [&] { PFM::loadRGB32F(filename, PFM::RowOrder::bottom_up); });
+      // reads a float of every kilobyte, so every page is mapped in
+      time(6, [&] {
+        const PFM::View view = PFM::map(filename);
+        const float *p = view.row(0);
+        if (p[0] != 0.0f || p[1] != 0.0f ||
+            view.data()[1] != static_cast<float>(height - 1))
+          throw std::runtime_error("mapped view differs");
+        float sum = 0.0f;
+        const std::size_t count = 3 * width * height;
+        for (std::size_t k = 0; k < count; k += 1024 / sizeof(float))
+          sum += view.data()[k];
+        if (sum < 0.0f)
+          throw std::runtime_error("mapped view differs");
+      });
+    }
+    std::remove(filename);
+
+    std::cout << width << "x" << height << " RGB32F, " << std::fixed
+              << std::setprecision(0) << megabytes << " MB, " << runs
+              << " runs\n";
+    for (std::size_t c = 0; c < case_count; ++c)
+      std::cout << std::left << std::setw(24) << case_names[c] << std::right
+                << std::setprecision(1) << std::setw(10) << ms[c] / runs
+                << " ms" << std::setprecision(0) << std::setw(10)
+                << megabytes * runs / ms[c] * 1000.0 << " MB/s\n";
+  } catch (const usage_error &e) {
+    std::cout << "error: " << e.what() << std::endl;
+    std::cout << "usage: pfm_benchmark {options}\n"
+                 "\toptions:\n"
+                 "\t  --width <w>            image width, default: 16384\n"
+                 "\t  --height <h>           image height, default: 12288\n"
+                 "\t  --runs <N>             average over <N> runs, "
+                 "default: 3\n"
+                 "\t  --file <path>          scratch file, removed at the "
+                 "end, default:\n"
+                 "\t                         pfm_benchmark.pfm\n";
+    return -127;
+  } catch (std::exception &e) {
+    std::cout << "error: " << e.what() << std::endl;
+    return -1;
+  } catch (...) {
+    std::cout << "unknown exception" << std::endl;
+    return -128;
+  }
+
+  return 0;
+}
@@ -0,0 +1,163 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+
+// MB/s of the PNG encoder presets, written by libpng on one thread and in
+// strips on the shared thread pool, on a synthetic 8 bit RGBA image. the
+// size column is the file size relative to the pixels.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+#include "calculators/cuda/hdr/framework/cmd_args.h"
+#include "calculators/cuda/hdr/framework/png.h"
+
+namespace {
+constexpr std::size_t preset_count = 4;
+const char *const preset_names[preset_count] = {"store", "fast", "balanced",
+                                                "best"};
+
+struct Result {
+  double ms;
+  double size;
+};
+
+// average milliseconds of a save and the size of the file relative to the
+// pixels. the file is read back once to check it.
+Result benchmark(const char *filename, const image<std::uint32_t> &img,
+                 const PNG::EncodeSettings &settings, int runs) {
+  Result result = {0.0, 0.0};
+  for (int i = 0; i < runs; ++i) {
+    const auto begin = std::chrono::steady_clock::now();
+    PNG::saveImage(filename, img, settings);
+    result.ms += std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - begin)
+                     .count();
+  }
+  result.ms /= runs;
+
+  const auto back = PNG::loadImage2D(filename);
+  const std::size_t bytes = sizeof(std::uint32_t) * width(img) * height(img);
+  if (width(back) != width(img) || height(back) != height(img) ||
+      std::memcmp(data(back), data(img), bytes) != 0)
+    throw std::runtime_error("the written image differs");
+
+  std::ifstream file(filename, std::ios::binary | std::ios::ate);
+  result.size = static_cast<double>(file.tellg()) / bytes;
+  return result;
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  try {
+    int image_width = 3840;
+    int image_height = 2160;
+    int runs = 5;
+    int strip_rows = 64;
+    const char *filename = "png_benchmark.png";
+
+    for (char **a = &argv[1]; *a; ++a) {
+      if (!checkArgument("--width", a, image_width))
+        if (!checkArgument("--height", a, image_height))
+          if (!checkArgument("--runs", a, runs))
+            if (!checkArgument("--strip-rows", a, strip_rows))
+              if (!checkArgument("--file", a, filename))
+                throw usage_error("unknown argument");
+    }
+
+    if (image_width < 1 || image_height < 1 || runs < 1 || strip_rows < 1)
+      throw usage_error("width, height, runs and strip rows must be positive");
+
+    const auto width = static_cast<std::size_t>(image_width);
+    const auto height = static_cast<std::size_t>(image_height);
+    const double megabytes = sizeof(std::uint32_t) * width * height / 1e6;
+
+    // smooth gradients with a little noise and hard edges, like a tonemapped
+    // photo
+    image<std::uint32_t> img(width, height);
+    std::uint32_t noise = 1;
+    for (std::size_t y = 0; y < height; ++y)
+      for (std::size_t x = 0; x < width; ++x) {
+        noise = noise * 1664525U + 1013904223U;
+        const std::uint32_t n = noise >> 29;
+        const std::uint32_t r = (255 * x / width + n) & 0xFFU;
+        const std::uint32_t g = (255 * y / height + n) & 0xFFU;
+        const std::uint32_t b = ((x / 64 + y / 64) % 2 ? 200U : 40U) + n;
+        img(x, y) = r | g << 8 | b << 16 | 0xFF000000U;
+      }
+
+    std::cout << width << "x" << height << " RGBA8, " << std::fixed
+              << std::setprecision(1) << megabytes << " MB, " << runs
+              << " runs, strips of " << strip_rows << " rows\n"
+              << "preset          libpng      size        strips      size"
+                 "   speedup\n";
+    for (std::size_t p = 0; p < preset_count; ++p) {
+      const auto compression = static_cast<PNG::Compression>(p);
+      const Result single = benchmark(filename, img, {compression, 0}, runs);
+      const Result strips = benchmark(
+          filename, img,
+          {compression, static_cast<unsigned int>(strip_rows)}, runs);
+      std::cout << std::left << std::setw(10) << preset_names[p] << std::right
+                << std::setprecision(0) << std::setw(8)
+                << megabytes / single.ms * 1000.0 << " MB/s"
+                << std::setprecision(1) << std::setw(8) << 100.0 * single.size
+                << " %" << std::setprecision(0) << std::setw(8)
+                << megabytes / strips.ms * 1000.0 << " MB/s"
+                << std::setprecision(1) << std::setw(8) << 100.0 * strips.size
+                << " %" << std::setprecision(2) << std::setw(9)
+                << single.ms / strips.ms << "x\n";
+    }
+    std::remove(filename);
+  } catch (const usage_error &e) {
+    std::cout << "error: " << e.what() << std::endl;
+    std::cout << "usage: png_benchmark {options}\n"
+                 "\toptions:\n"
+                 "\t  --width <w>            image width, default: 3840\n"
+                 "\t  --height <h>           image height, default: 2160\n"
+                 "\t  --runs <N>             average over <N> runs, "
+                 "default: 5\n"
+                 "\t  --strip-rows <n>       rows deflated per strip, "
+                 "default: 64\n"
+                 "\t  --file <path>          scratch file, removed at the "
+                 "end, default:\n"
+                 "\t                         png_benchmark.png\n";
+    return -127;
+  } catch (std::exception &e) {
+    std::cout << "error: " << e.what() << std::endl;
+    return -1;
+  } catch (...) {
+    std::cout << "unknown exception" << std::endl;
+    return -128;
+  }
+
+  return 0;
+}
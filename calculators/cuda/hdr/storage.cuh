@@ -0,0 +1,105 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef INCLUDED_STORAGE_CUH
+#define INCLUDED_STORAGE_CUH
+
+#pragma once
+
+#include <cuda_fp16.h>
+#include <math/vector.h>
+
+#include "calculators/cuda/hdr/hdr_storage.h"
+
+// device side of the HDRStorage formats, the kernels are templated on the
+// image type and always compute in float. RGB16F is three __half, RGB10A2 one
+// 32 bit word.
+
+// channel f of an interleaved RGB image, f = 3 * pixel + channel
+__device__ inline float load_channel(const float *image, unsigned int f) {
+  return __ldg(image + f);
+}
+
+__device__ inline float load_channel(const RGB16F *image, unsigned int f) {
+  return __half2float(__ldg(reinterpret_cast<const __half *>(image) + f));
+}
+
+__device__ inline void store_channel(float *image, unsigned int f,
+                                     float value) {
+  image[f] = value;
+}
+
+__device__ inline void store_channel(RGB16F *image, unsigned int f,
+                                     float value) {
+  reinterpret_cast<__half *>(image)[f] = __float2half_rn(value);
+}
+
+__device__ inline math::float3 load_pixel(const float *image, unsigned int i) {
+  return {__ldg(image + 3 * i), __ldg(image + 3 * i + 1),
+          __ldg(image + 3 * i + 2)};
+}
+
+__device__ inline math::float3 load_pixel(const RGB16F *image,
+                                          unsigned int i) {
+  return {load_channel(image, 3 * i), load_channel(image, 3 * i + 1),
+          load_channel(image, 3 * i + 2)};
+}
+
+__device__ inline void store_pixel(float *image, unsigned int i,
+                                   const math::float3 &c) {
+  image[3 * i + 0] = c.x;
+  image[3 * i + 1] = c.y;
+  image[3 * i + 2] = c.z;
+}
+
+__device__ inline void store_pixel(RGB16F *image, unsigned int i,
+                                   const math::float3 &c) {
+  store_channel(image, 3 * i + 0, c.x);
+  store_channel(image, 3 * i + 1, c.y);
+  store_channel(image, 3 * i + 2, c.z);
+}
+
+// same rounding as the RGB10A2 constructor, alpha is opaque
+__device__ inline unsigned int unorm10(float c) {
+  return static_cast<unsigned int>(__saturatef(c) * 1023.0f + 0.5f);
+}
+
+__device__ inline void store_pixel(RGB10A2 *image, unsigned int i,
+                                   const math::float3 &c) {
+  reinterpret_cast<unsigned int *>(image)[i] = unorm10(c.x) |
+                                               (unorm10(c.y) << 10) |
+                                               (unorm10(c.z) << 20) | 3U << 30;
+}
+
+// same scale as channel<i>() of RGB10A2
+__device__ inline math::float3 load_pixel(const RGB10A2 *image,
+                                          unsigned int i) {
+  const unsigned int c =
+      __ldg(reinterpret_cast<const unsigned int *>(image) + i);
+  return {(c & 0x3FFU) * (1.0f / 1023.0f),
+          ((c >> 10) & 0x3FFU) * (1.0f / 1023.0f),
+          ((c >> 20) & 0x3FFU) * (1.0f / 1023.0f)};
+}
+
+#endif // INCLUDED_STORAGE_CUH
@@ -0,0 +1,166 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "calculators/cuda/hdr/HDRPipeline.h"
+#include "calculators/cuda/hdr/HDRTiledPipeline.h"
+#include "calculators/cuda/hdr/framework/host_executor.h"
+
+namespace {
+// not a multiple of any tile size below
+constexpr unsigned int width = 301;
+constexpr unsigned int height = 197;
+
+std::vector<float> random_image(std::size_t width, std::size_t height) {
+  std::mt19937 rng(7);
+  std::lognormal_distribution<float> radiance(0.0f, 1.5f);
+  std::vector<float> image(width * height * 3);
+  for (float &value : image)
+    value = radiance(rng);
+  return image;
+}
+
+BloomSettings bloom_levels(unsigned int levels) {
+  BloomSettings bloom;
+  bloom.levels = levels;
+  return bloom;
+}
+
+std::size_t tile_memory(unsigned int tile_size, unsigned int halo,
+                        HDRStorage storage, const BloomSettings &bloom) {
+  const unsigned int extent = tile_size + 2 * halo;
+  return HDRPipeline::memoryRequired(extent, extent, HDRBackend::cpu,
+                                     HDRMode::fused, storage,
+                                     HDRLayout::interleaved, bloom);
+}
+} // namespace
+
+TEST(HDRTiledPipeline, CpuMatchesWholeImage) {
+  HostExecutor executor;
+  const std::vector<float> input = random_image(width, height);
+  for (unsigned int levels : {0U, 2U})
+    for (HDRStorage storage : {HDRStorage::fp32, HDRStorage::fp16})
+      for (unsigned int tile_size : {8U, 37U}) {
+        SCOPED_TRACE(testing::Message()
+                     << "levels " << levels << " storage "
+                     << static_cast<int>(storage) << " tile " << tile_size);
+        const BloomSettings bloom = bloom_levels(levels);
+        HDRTiledPipeline tiled(tile_size, executor, storage, bloom);
+        EXPECT_EQ(tiled.getTileSize() % (1U << levels), 0U);
+        EXPECT_GE(tiled.getTileSize(), tile_size);
+
+        HDRPipeline whole(width, height, executor, HDRMode::fused, storage);
+        whole.configureBloom(bloom);
+        whole.consume(input.data());
+        whole.computeStatistics();
+        const LuminanceStats expected = whole.luminanceStatistics();
+
+        // the sums of the tiles only differ in rounding from those of the
+        // whole image
+        const LuminanceStats stats =
+            tiled.statistics(input.data(), width, height);
+        EXPECT_NEAR(stats.average, expected.average, 1e-5f * expected.average);
+        EXPECT_NEAR(stats.log_average, expected.log_average,
+                    1e-5f * expected.log_average);
+
+        // with the same statistics every tile sees the pixels the bloom
+        // reaches through its halo, so the stitched output is identical
+        const std::size_t size =
+            std::size_t{width} * height * output_pixel_size(storage);
+        std::vector<unsigned char> expected_output(size);
+        std::vector<unsigned char> output(size);
+        whole.run(1.0f, 0.8f, stats);
+        whole.readOutputAsync(expected_output.data());
+        whole.synchronize();
+        tiled.process(output.data(), input.data(), width, height, stats, 1.0f,
+                      0.8f);
+        EXPECT_EQ(output, expected_output);
+      }
+}
+
+TEST(HDRTiledPipeline, CpuStatisticsWeightTilesByPixels) {
+  HostExecutor executor;
+  HDRTiledPipeline tiled(8, executor);
+  // a full tile of luminance 1 and a column of 100 as the second tile
+  const unsigned int extent = tiled.getTileSize() + 2 * tiled.getHalo();
+  const unsigned int width = extent + 1;
+  const unsigned int height = extent;
+  std::vector<float> input(std::size_t{width} * height * 3, 1.0f);
+  for (unsigned int y = 0; y < height; ++y)
+    for (unsigned int c = 0; c < 3; ++c)
+      input[(std::size_t{y} * width + extent) * 3 + c] = 100.0f;
+
+  const LuminanceStats stats = tiled.statistics(input.data(), width, height);
+  const float average = (extent + 100.0f) / width;
+  EXPECT_NEAR(stats.average, average, 1e-4f * average);
+
+  HDRPipeline whole(width, height, executor, HDRMode::fused);
+  whole.consume(input.data());
+  whole.computeStatistics();
+  const LuminanceStats expected = whole.luminanceStatistics();
+  EXPECT_NEAR(stats.average, expected.average, 1e-5f * expected.average);
+  EXPECT_NEAR(stats.log_average, expected.log_average,
+              1e-5f * expected.log_average);
+}
+
+TEST(HDRTiledPipeline, CpuTileSizeForTinyBudgets) {
+  HostExecutor executor;
+  const std::vector<float> input = random_image(width, height);
+  for (unsigned int levels : {0U, 2U}) {
+    SCOPED_TRACE(testing::Message() << "levels " << levels);
+    const BloomSettings bloom = bloom_levels(levels);
+    const unsigned int alignment = 1U << levels;
+    const unsigned int halo = bloom_halo(bloom);
+
+    // the smallest tile fits exactly, one byte less fits none
+    const std::size_t smallest =
+        tile_memory(alignment, halo, HDRStorage::fp32, bloom);
+    EXPECT_EQ(HDRTiledPipeline::tileSizeFor(smallest, HDRBackend::cpu,
+                                            HDRStorage::fp32, bloom),
+              alignment);
+    EXPECT_THROW(HDRTiledPipeline::tileSizeFor(
+                     smallest - 1, HDRBackend::cpu, HDRStorage::fp32, bloom),
+                 std::invalid_argument);
+
+    // the largest tile that fits, and a pipeline with it stays in budget
+    const std::size_t budget = smallest + (256U << 10);
+    const unsigned int tile_size = HDRTiledPipeline::tileSizeFor(
+        budget, HDRBackend::cpu, HDRStorage::fp32, bloom);
+    EXPECT_EQ(tile_size % alignment, 0U);
+    EXPECT_LE(tile_memory(tile_size, halo, HDRStorage::fp32, bloom), budget);
+    EXPECT_GT(tile_memory(tile_size + alignment, halo, HDRStorage::fp32, bloom),
+              budget);
+
+    HDRTiledPipeline tiled(tile_size, executor, HDRStorage::fp32, bloom);
+    std::vector<float> output(input.size());
+    tiled.process(output.data(), input.data(), width, height, 1.0f, 0.8f);
+    EXPECT_LE(tiled.memory().peak(), budget);
+  }
+}
@@ -0,0 +1,190 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef INCLUDED_TONEMAP
+#define INCLUDED_TONEMAP
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+// the operators below are compiled into the CUDA kernels as well as into the
+// host stages
+#if defined(__CUDACC__)
+#define TONEMAP_HOST_DEVICE __host__ __device__
+#else
+#define TONEMAP_HOST_DEVICE
+#endif
+
+// the curve every channel of the exposed color is mapped through. the
+// operator is a template parameter of the kernels and host loops, so every
+// operator gets code of its own with its constants folded in.
+enum class TonemapOperator { uncharted2, aces, reinhard, hable };
+
+// filmic curve of John Hable, ((x (Ax + CB) + DE) / (x (Ax + B) + DF)) - E/F
+// divided by its value at the white point W. the defaults are those of
+// Uncharted 2, from http://filmicworlds.com/blog/filmic-tonemapping-operators/
+struct HableParams {
+  float A = 0.15f; // shoulder strength
+  float B = 0.50f; // linear strength
+  float C = 0.10f; // linear angle
+  float D = 0.20f; // toe strength
+  float E = 0.02f; // toe numerator
+  float F = 0.30f; // toe denominator
+  float W = 11.2f; // linear white point
+  // scale of the exposed color before the curve
+  float exposure_bias = 2.0f;
+};
+
+struct TonemapSettings {
+  TonemapOperator op = TonemapOperator::uncharted2;
+  // reinhard: the exposed value that maps to 1
+  float white = 4.0f;
+  // hable: the curve, uncharted2 is hable with the defaults built in
+  HableParams hable;
+  // look the operator up in a table of tonemap_lut_size entries instead of
+  // evaluating it, see LutTonemap
+  bool lut = false;
+};
+
+constexpr std::size_t tonemap_lut_size = 1024U;
+// exposed values beyond this map to the last entry of the table
+constexpr float tonemap_lut_range = 64.0f;
+
+TONEMAP_HOST_DEVICE inline float hable_curve(float x, float A, float B,
+                                             float C, float D, float E,
+                                             float F) {
+  return ((x * (A * x + C * B) + D * E) / (x * (A * x + B) + D * F)) - E / F;
+}
+
+// every operator maps the exposed channel x = c * exposure of the input
+
+struct Uncharted2Tonemap {
+  TONEMAP_HOST_DEVICE float operator()(float x) const {
+    constexpr float A = 0.15f;
+    constexpr float B = 0.50f;
+    constexpr float C = 0.10f;
+    constexpr float D = 0.20f;
+    constexpr float E = 0.02f;
+    constexpr float F = 0.30f;
+    constexpr float W = 11.2f;
+    return hable_curve(x * 2.0f, A, B, C, D, E, F) /
+           hable_curve(W, A, B, C, D, E, F);
+  }
+};
+
+// the curve Krzysztof Narkowicz fitted to the ACES reference rendering and
+// output transforms, per channel and with his exposure bias of 0.6
+struct AcesTonemap {
+  TONEMAP_HOST_DEVICE float operator()(float x) const {
+    x *= 0.6f;
+    const float y =
+        (x * (2.51f * x + 0.03f)) / (x * (2.43f * x + 0.59f) + 0.14f);
+    return fminf(fmaxf(y, 0.0f), 1.0f);
+  }
+};
+
+// Reinhard's operator extended by a white point, x (1 + x / white^2) / (1 + x)
+struct ReinhardTonemap {
+  float inv_white2;
+
+  explicit ReinhardTonemap(float white) : inv_white2(1.0f / (white * white)) {}
+
+  TONEMAP_HOST_DEVICE float operator()(float x) const {
+    return x * (1.0f + x * inv_white2) / (1.0f + x);
+  }
+};
+
+struct HableTonemap {
+  HableParams p;
+  float inv_white;
+
+  explicit HableTonemap(const HableParams &params)
+      : p(params), inv_white(1.0f / hable_curve(params.W, params.A, params.B,
+                                                params.C, params.D, params.E,
+                                                params.F)) {}
+
+  TONEMAP_HOST_DEVICE float operator()(float x) const {
+    return hable_curve(x * p.exposure_bias, p.A, p.B, p.C, p.D, p.E, p.F) *
+           inv_white;
+  }
+};
+
+// linear interpolation in a table of the operator sampled at x = s^2 for
+// evenly spaced s, which puts most entries into the dark end where the
+// curves bend the most. table holds tonemap_lut_size floats in the memory of
+// the backend evaluating it, see tonemap_lut().
+struct LutTonemap {
+  const float *table;
+
+  // entries per unit of s, the last one is at s = sqrt(tonemap_lut_range)
+  static constexpr float scale = (tonemap_lut_size - 1) / 8.0f;
+  static_assert(tonemap_lut_range == 8.0f * 8.0f, "scale assumes s <= 8");
+
+  TONEMAP_HOST_DEVICE float operator()(float x) const {
+    constexpr unsigned int last = tonemap_lut_size - 1;
+    const float u = fminf(sqrtf(fmaxf(x, 0.0f)) * scale, last);
+    const unsigned int i =
+        u < last - 1 ? static_cast<unsigned int>(u) : last - 1;
+    const float f = u - i;
+    return table[i] + f * (table[i + 1] - table[i]);
+  }
+};
+
+// calls fn with the operator of settings, LutTonemap over lut if settings.lut
+// is set
+template <typename F>
+void with_tonemap(const TonemapSettings &settings, const float *lut, F &&fn) {
+  if (settings.lut) {
+    fn(LutTonemap{lut});
+    return;
+  }
+
+  switch (settings.op) {
+  case TonemapOperator::uncharted2:
+    fn(Uncharted2Tonemap{});
+    break;
+  case TonemapOperator::aces:
+    fn(AcesTonemap{});
+    break;
+  case TonemapOperator::reinhard:
+    fn(ReinhardTonemap(settings.white));
+    break;
+  case TonemapOperator::hable:
+    fn(HableTonemap(settings.hable));
+    break;
+  }
+}
+
+// throws std::invalid_argument for settings that do not give a curve: a
+// white point or exposure bias of zero or below, or a hable curve that is not
+// positive at W
+void check_tonemap(const TonemapSettings &settings);
+
+// samples the operator of settings into the tonemap_lut_size floats of table,
+// on the host
+void tonemap_lut(float *table, const TonemapSettings &settings);
+
+#endif // INCLUDED_TONEMAP
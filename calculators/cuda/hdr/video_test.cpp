@@ -0,0 +1,149 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <cstddef>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "calculators/cuda/hdr/HDRPipeline.h"
+#include "calculators/cuda/hdr/HDRVideoPipeline.h"
+#include "calculators/cuda/hdr/framework/host_executor.h"
+
+namespace {
+constexpr float exposure = 1.0f;
+constexpr float brightpass_threshold = 0.8f;
+
+// interleaved RGB frames, each brighter than the one before so that frames
+// out of order give other outputs
+std::vector<std::vector<float>> random_frames(std::size_t count,
+                                              unsigned int width,
+                                              unsigned int height) {
+  std::mt19937 rng(11);
+  std::lognormal_distribution<float> radiance(0.0f, 1.5f);
+  std::vector<std::vector<float>> frames(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    frames[i].resize(std::size_t{width} * height * 3);
+    for (float &value : frames[i])
+      value = radiance(rng) * (i + 1);
+  }
+  return frames;
+}
+
+// the output of HDRPipeline::run() for every frame on its own
+std::vector<std::vector<float>>
+reference_outputs(const std::vector<std::vector<float>> &frames,
+                  unsigned int width, unsigned int height) {
+  HostExecutor executor;
+  HDRPipeline pipeline(width, height, executor, HDRMode::fused);
+  std::vector<std::vector<float>> outputs;
+  for (const std::vector<float> &frame : frames) {
+    outputs.emplace_back(frame.size());
+    pipeline.consume(frame.data());
+    pipeline.run(exposure, brightpass_threshold);
+    pipeline.readOutputAsync(outputs.back().data());
+    pipeline.synchronize();
+  }
+  return outputs;
+}
+} // namespace
+
+TEST(HDRVideoPipeline, CpuMatchesPipelineFrameByFrame) {
+  constexpr unsigned int width = 97;
+  constexpr unsigned int height = 61;
+  const std::vector<std::vector<float>> frames =
+      random_frames(8, width, height);
+  const std::vector<std::vector<float>> expected =
+      reference_outputs(frames, width, height);
+
+  HDRVideoPipeline video(width, height, HDRBackend::cpu, exposure,
+                         brightpass_threshold, 3);
+  EXPECT_EQ(video.capacity(), 3U);
+  std::vector<float> output(frames[0].size());
+  EXPECT_FALSE(video.poll(output.data()));
+  EXPECT_FALSE(video.retrieve(output.data()));
+  EXPECT_EQ(video.statistics().frames, 0U);
+
+  // fill the ring, the frame after the last slot is refused
+  std::size_t submitted = 0;
+  while (video.submit(frames[submitted].data()))
+    ++submitted;
+  EXPECT_EQ(submitted, 3U);
+  EXPECT_EQ(video.framesInFlight(), 3U);
+
+  // retrieve in turns with poll() and retrieve(), refilling the ring
+  std::size_t retrieved = 0;
+  while (retrieved < frames.size()) {
+    SCOPED_TRACE(testing::Message() << "frame " << retrieved);
+    if (retrieved % 2 == 0) {
+      while (!video.poll(output.data()))
+        std::this_thread::yield();
+    } else {
+      ASSERT_TRUE(video.retrieve(output.data()));
+    }
+    EXPECT_EQ(output, expected[retrieved]);
+    ++retrieved;
+
+    if (submitted < frames.size()) {
+      EXPECT_TRUE(video.submit(frames[submitted].data()));
+      ++submitted;
+      EXPECT_FALSE(video.submit(frames[0].data()));
+    }
+    EXPECT_EQ(video.framesInFlight(), submitted - retrieved);
+  }
+  EXPECT_FALSE(video.poll(output.data()));
+  EXPECT_FALSE(video.retrieve(output.data()));
+
+  const VideoPipelineStats stats = video.statistics();
+  EXPECT_EQ(stats.frames, frames.size());
+  EXPECT_GT(stats.average_latency_ms, 0.0);
+  EXPECT_GE(stats.max_latency_ms, stats.average_latency_ms);
+  EXPECT_GT(stats.throughput_fps, 0.0);
+}
+
+TEST(HDRVideoPipeline, CpuPollDoesNotWait) {
+  // a full HD frame takes far longer to process than submit() takes to
+  // return, so the first poll() finds it in flight
+  constexpr unsigned int width = 1920;
+  constexpr unsigned int height = 1080;
+  const std::vector<std::vector<float>> frames =
+      random_frames(1, width, height);
+  const std::vector<std::vector<float>> expected =
+      reference_outputs(frames, width, height);
+
+  HDRVideoPipeline video(width, height, HDRBackend::cpu, exposure,
+                         brightpass_threshold, 1);
+  std::vector<float> output(frames[0].size());
+  ASSERT_TRUE(video.submit(frames[0].data()));
+  EXPECT_FALSE(video.submit(frames[0].data()));
+  EXPECT_FALSE(video.poll(output.data()));
+  EXPECT_EQ(video.framesInFlight(), 1U);
+  EXPECT_EQ(video.statistics().frames, 0U);
+
+  ASSERT_TRUE(video.retrieve(output.data()));
+  EXPECT_EQ(output, expected[0]);
+  EXPECT_EQ(video.framesInFlight(), 0U);
+  EXPECT_EQ(video.statistics().frames, 1U);
+}
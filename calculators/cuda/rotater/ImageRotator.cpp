@@ -0,0 +1,267 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#include "calculators/cuda/hdr/framework/CUDA/error.h"
+
+#include "ImageRotator.h"
+#include "calculators/cuda/rotater/frame_layout.h"
+#include "calculators/cuda/rotater/rotate_pipeline_cpu.h"
+
+ImageRotator::ImageRotator(unsigned int width, unsigned int height,
+                           RotateFormat format, RotateBackend backend,
+                           cudaStream_t stream)
+    : width(width), height(height), format(format), backend(backend),
+      stream(stream) {
+  checkSize();
+  if (backend == RotateBackend::cuda) {
+    for (cudaEvent_t &event : events)
+      throw_error(cudaEventCreate(&event));
+  }
+}
+
+ImageRotator::ImageRotator(unsigned int width, unsigned int height,
+                           RotateFormat format, cudaStream_t stream)
+    : ImageRotator(width, height, format, RotateBackend::cuda, stream) {}
+
+ImageRotator::ImageRotator(unsigned int width, unsigned int height,
+                           RotateFormat format, RotateBackend backend)
+    : ImageRotator(width, height, format, backend, 0) {}
+
+ImageRotator::~ImageRotator() {
+  if (backend == RotateBackend::cuda) {
+    cudaStreamSynchronize(stream);
+    for (cudaEvent_t event : events)
+      if (event)
+        cudaEventDestroy(event);
+  }
+}
+
+void ImageRotator::checkSize() const {
+  if (width == 0 || height == 0)
+    throw std::invalid_argument("the frame must not be empty");
+  if (format == RotateFormat::nv12 && (width % 2 || height % 2))
+    throw std::invalid_argument("nv12 frames need an even width and height");
+}
+
+void ImageRotator::reserveBuffers(bool output) {
+  // the output is as large as the input turned or not
+  const std::size_t src_size = frame_size(format, width, height);
+  const std::size_t dst_size =
+      output ? std::max(src_size, frame_size(format, height, width)) : 0;
+  if (src_size + dst_size > d_capacity) {
+    void *ptr = nullptr;
+    d_memory.reset();
+    d_capacity = 0;
+    throw_error(cudaMalloc(&ptr, src_size + dst_size));
+    d_memory.reset(ptr);
+    d_capacity = src_size + dst_size;
+  }
+  d_src = static_cast<unsigned char *>(d_memory.get());
+  d_dst = output ? d_src + src_size : nullptr;
+}
+
+void ImageRotator::reconfigure(unsigned int width, unsigned int height) {
+  if (backend == RotateBackend::cuda)
+    throw_error(cudaStreamSynchronize(stream));
+  const unsigned int old_width = this->width;
+  const unsigned int old_height = this->height;
+  this->width = width;
+  this->height = height;
+  try {
+    checkSize();
+  } catch (const std::invalid_argument &) {
+    this->width = old_width;
+    this->height = old_height;
+    throw;
+  }
+}
+
+void ImageRotator::process(const std::uint8_t *src, std::size_t pitch,
+                           std::uint8_t *dst, std::size_t dst_pitch,
+                           Orientation orientation) {
+  if (pitch < row_size(format, width) ||
+      dst_pitch < row_size(format, outputWidth(orientation)))
+    throw std::invalid_argument("the row pitch is smaller than a row");
+  last_timings = RotateTimings();
+  if (width == 0 || height == 0)
+    return;
+
+  if (backend == RotateBackend::cuda)
+    processCUDA(src, pitch, dst, dst_pitch, orientation);
+  else
+    processCPU(src, pitch, dst, dst_pitch, orientation);
+}
+
+void ImageRotator::processCUDA(const std::uint8_t *src, std::size_t pitch,
+                               std::uint8_t *dst, std::size_t dst_pitch,
+                               Orientation orientation) {
+  void orient_plane(unsigned char *dst, std::size_t dst_pitch,
+                    const unsigned char *src, std::size_t src_pitch,
+                    unsigned int width, unsigned int height,
+                    unsigned int pixel_size, Orientation orientation,
+                    cudaStream_t stream);
+
+  const unsigned int out_width = outputWidth(orientation);
+  const unsigned int out_height = outputHeight(orientation);
+
+  // device memory is read and written in place, host memory goes through
+  // the frame buffers
+  const bool upload = !device_accessible(src);
+  const bool download = !device_accessible(dst);
+  if (upload || download)
+    reserveBuffers(true);
+  const unsigned char *d_input = upload ? d_src : src;
+  const std::size_t input_pitch = upload ? frame_pitch(format, width) : pitch;
+  unsigned char *d_output = download ? d_dst : dst;
+  const std::size_t output_pitch =
+      download ? frame_pitch(format, out_width) : dst_pitch;
+
+  throw_error(cudaEventRecord(events[0], stream));
+  if (upload)
+    throw_error(cudaMemcpy2DAsync(d_src, input_pitch, src, pitch,
+                                  row_size(format, width),
+                                  frame_rows(format, height),
+                                  cudaMemcpyDefault, stream));
+  throw_error(cudaEventRecord(events[1], stream));
+
+  FramePlane in[2];
+  FramePlane out[2];
+  const int planes = frame_planes(format, width, height, in);
+  frame_planes(format, out_width, out_height, out);
+  for (int p = 0; p < planes; ++p)
+    orient_plane(d_output + out[p].row * output_pitch, output_pitch,
+                 d_input + in[p].row * input_pitch, input_pitch, in[p].width,
+                 in[p].height, in[p].pixel_size, orientation, stream);
+  throw_error(cudaEventRecord(events[2], stream));
+
+  if (download)
+    throw_error(cudaMemcpy2DAsync(dst, dst_pitch, d_dst, output_pitch,
+                                  row_size(format, out_width),
+                                  frame_rows(format, out_height),
+                                  cudaMemcpyDefault, stream));
+  throw_error(cudaEventRecord(events[3], stream));
+  throw_error(cudaEventSynchronize(events[3]));
+
+  throw_error(
+      cudaEventElapsedTime(&last_timings.upload, events[0], events[1]));
+  throw_error(
+      cudaEventElapsedTime(&last_timings.orient, events[1], events[2]));
+  throw_error(
+      cudaEventElapsedTime(&last_timings.download, events[2], events[3]));
+}
+
+void ImageRotator::processCPU(const std::uint8_t *src, std::size_t pitch,
+                              std::uint8_t *dst, std::size_t dst_pitch,
+                              Orientation orientation) {
+  const auto start = std::chrono::steady_clock::now();
+  FramePlane in[2];
+  FramePlane out[2];
+  const int planes = frame_planes(format, width, height, in);
+  frame_planes(format, outputWidth(orientation), outputHeight(orientation),
+               out);
+  for (int p = 0; p < planes; ++p)
+    cpu::orient_plane(dst + out[p].row * dst_pitch, dst_pitch,
+                      src + in[p].row * pitch, pitch, in[p].width,
+                      in[p].height, in[p].pixel_size, orientation);
+  last_timings.orient = std::chrono::duration<float, std::milli>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+}
+
+void ImageRotator::processInPlace(std::uint8_t *frame, std::size_t pitch,
+                                  Orientation orientation) {
+  if (swaps_axes(orientation))
+    throw std::invalid_argument(
+        "only orientations that keep the axes flip in place");
+  if (pitch < row_size(format, width))
+    throw std::invalid_argument("the row pitch is smaller than a row");
+  last_timings = RotateTimings();
+  if (orientation == Orientation::identity)
+    return;
+
+  if (backend == RotateBackend::cuda) {
+    processInPlaceCUDA(frame, pitch, orientation);
+    return;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  FramePlane planes[2];
+  const int count = frame_planes(format, width, height, planes);
+  for (int p = 0; p < count; ++p)
+    cpu::flip_plane_in_place(frame + planes[p].row * pitch, pitch,
+                             planes[p].width, planes[p].height,
+                             planes[p].pixel_size, orientation);
+  last_timings.orient = std::chrono::duration<float, std::milli>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+}
+
+void ImageRotator::processInPlaceCUDA(std::uint8_t *frame, std::size_t pitch,
+                                      Orientation orientation) {
+  void flip_plane_in_place(unsigned char *frame, std::size_t pitch,
+                           unsigned int width, unsigned int height,
+                           unsigned int pixel_size, Orientation orientation,
+                           cudaStream_t stream);
+
+  // host memory makes a round trip through the input buffer
+  const bool copy = !device_accessible(frame);
+  if (copy)
+    reserveBuffers(false);
+  unsigned char *d_frame = copy ? d_src : frame;
+  const std::size_t d_pitch = copy ? frame_pitch(format, width) : pitch;
+
+  throw_error(cudaEventRecord(events[0], stream));
+  if (copy)
+    throw_error(cudaMemcpy2DAsync(d_frame, d_pitch, frame, pitch,
+                                  row_size(format, width),
+                                  frame_rows(format, height),
+                                  cudaMemcpyDefault, stream));
+  throw_error(cudaEventRecord(events[1], stream));
+
+  FramePlane planes[2];
+  const int count = frame_planes(format, width, height, planes);
+  for (int p = 0; p < count; ++p)
+    flip_plane_in_place(d_frame + planes[p].row * d_pitch, d_pitch,
+                        planes[p].width, planes[p].height,
+                        planes[p].pixel_size, orientation, stream);
+  throw_error(cudaEventRecord(events[2], stream));
+
+  if (copy)
+    throw_error(cudaMemcpy2DAsync(frame, pitch, d_frame, d_pitch,
+                                  row_size(format, width),
+                                  frame_rows(format, height),
+                                  cudaMemcpyDefault, stream));
+  throw_error(cudaEventRecord(events[3], stream));
+  throw_error(cudaEventSynchronize(events[3]));
+
+  throw_error(
+      cudaEventElapsedTime(&last_timings.upload, events[0], events[1]));
+  throw_error(
+      cudaEventElapsedTime(&last_timings.orient, events[1], events[2]));
+  throw_error(
+      cudaEventElapsedTime(&last_timings.download, events[2], events[3]));
+}
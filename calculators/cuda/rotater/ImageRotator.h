@@ -0,0 +1,146 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef INCLUDED_IMAGEROTATOR
+#define INCLUDED_IMAGEROTATOR
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <cuda_runtime_api.h>
+
+#include "calculators/cuda/rotater/orientation.h"
+
+enum class RotateBackend { cuda, cpu };
+
+// milliseconds spent in the stages of the last process() call. the copies
+// are 0 on the CPU backend and for device memory.
+struct RotateTimings {
+  float upload = 0.0f;
+  float orient = 0.0f;
+  float download = 0.0f;
+
+  float total() const { return upload + orient + download; }
+};
+
+// flips, rotations and transposes of frames of a fixed size and format,
+// every orientation in a single pass over the frame. the device buffers for
+// frames in host memory are allocated by the first frame that needs them
+// and kept. a rotator keeps no state outside of itself, separate instances
+// may be used from different threads.
+class ImageRotator {
+  struct cudaFreeDeleter {
+    void operator()(void *ptr) const { cudaFree(ptr); }
+  };
+
+  unsigned int width;
+  unsigned int height;
+
+  const RotateFormat format;
+  const RotateBackend backend;
+  cudaStream_t stream = 0;
+  RotateTimings last_timings;
+
+  // CUDA backend: one block of device memory with the input frame and, for
+  // frames that are not flipped in place, the output frame, grown only if
+  // a frame needs more. stage boundaries are recorded on the events, which
+  // live as long as the rotator.
+  std::unique_ptr<void, cudaFreeDeleter> d_memory;
+  std::size_t d_capacity = 0;
+  unsigned char *d_src = nullptr;
+  unsigned char *d_dst = nullptr;
+  cudaEvent_t events[4] = {};
+
+  ImageRotator(unsigned int width, unsigned int height, RotateFormat format,
+               RotateBackend backend, cudaStream_t stream);
+
+  // throws std::invalid_argument if the frames can not have the size
+  void checkSize() const;
+  // places the input buffer and the output buffer if output, allocating
+  // only if they no longer fit
+  void reserveBuffers(bool output);
+  void processCUDA(const std::uint8_t *src, std::size_t pitch,
+                   std::uint8_t *dst, std::size_t dst_pitch,
+                   Orientation orientation);
+  void processCPU(const std::uint8_t *src, std::size_t pitch,
+                  std::uint8_t *dst, std::size_t dst_pitch,
+                  Orientation orientation);
+  void processInPlaceCUDA(std::uint8_t *frame, std::size_t pitch,
+                          Orientation orientation);
+
+public:
+  // CUDA backend, all work is enqueued on the given stream. throws
+  // std::invalid_argument for empty frames and nv12 frames of odd width or
+  // height.
+  ImageRotator(unsigned int width, unsigned int height, RotateFormat format,
+               cudaStream_t stream = 0);
+  // CPU backend, the work is spread over ThreadPool::shared()
+  ImageRotator(unsigned int width, unsigned int height, RotateFormat format,
+               RotateBackend backend);
+  ~ImageRotator();
+
+  ImageRotator(const ImageRotator &) = delete;
+  ImageRotator &operator=(const ImageRotator &) = delete;
+
+  unsigned int getWidth() const { return width; }
+  unsigned int getHeight() const { return height; }
+  RotateFormat getFormat() const { return format; }
+  RotateBackend getBackend() const { return backend; }
+
+  // size of the frames written by process() with orientation
+  unsigned int outputWidth(Orientation orientation) const {
+    return swaps_axes(orientation) ? height : width;
+  }
+  unsigned int outputHeight(Orientation orientation) const {
+    return swaps_axes(orientation) ? width : height;
+  }
+
+  // changes the frame size. the buffers are only reallocated once they no
+  // longer fit a frame.
+  void reconfigure(unsigned int width, unsigned int height);
+
+  // writes the frame src with rows of pitch bytes in orientation to dst,
+  // rows of dst_pitch bytes, see outputWidth() and outputHeight(). the
+  // planes of nv12 frames follow each other with the same pitch. the
+  // padding of the rows is left alone. on the CUDA backend src and dst may
+  // be host or device memory, device memory is read and written in place.
+  // src and dst must not overlap. returns once dst is written.
+  void process(const std::uint8_t *src, std::size_t pitch, std::uint8_t *dst,
+               std::size_t dst_pitch, Orientation orientation);
+
+  // flips frame, rows of pitch bytes, in orientation in place without a
+  // second frame, every worker swapping a pair of mirrored rows or pixels.
+  // on the CUDA backend device memory is flipped where it is, host memory
+  // through a single device buffer. throws std::invalid_argument for the
+  // orientations that swap the axes, see swaps_axes().
+  void processInPlace(std::uint8_t *frame, std::size_t pitch,
+                      Orientation orientation);
+
+  // stage timings of the last process() or processInPlace()
+  const RotateTimings &timings() const { return last_timings; }
+};
+
+#endif // INCLUDED_IMAGEROTATOR
@@ -0,0 +1,201 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <chrono>
+#include <stdexcept>
+#include <utility>
+
+#include "calculators/cuda/hdr/framework/CUDA/error.h"
+
+#include "ImageWarper.h"
+#include "calculators/cuda/rotater/frame_layout.h"
+#include "calculators/cuda/rotater/warp_pipeline_cpu.h"
+
+namespace {
+// the source of plane p of a frame, chroma filled neutral
+WarpSource plane_source(const FramePlane &plane, const std::uint8_t *frame,
+                        std::size_t pitch) {
+  return {frame + plane.row * pitch,
+          pitch,
+          static_cast<int>(plane.width),
+          static_cast<int>(plane.height),
+          static_cast<int>(plane.subsampling),
+          static_cast<unsigned char>(plane.subsampling > 1 ? 128 : 0)};
+}
+} // namespace
+
+ImageWarper::ImageWarper(unsigned int width, unsigned int height,
+                         RotateFormat format, WarpBackend backend,
+                         cudaStream_t stream)
+    : width(width), height(height), format(format), backend(backend),
+      stream(stream) {
+  if (width == 0 || height == 0)
+    throw std::invalid_argument("the frame must not be empty");
+  if (format == RotateFormat::nv12 && (width % 2 || height % 2))
+    throw std::invalid_argument("nv12 frames need an even width and height");
+  if (backend == WarpBackend::cuda) {
+    for (cudaEvent_t &event : events)
+      throw_error(cudaEventCreate(&event));
+  }
+  setMesh(std::make_shared<const WarpMesh>(width, height));
+}
+
+ImageWarper::ImageWarper(unsigned int width, unsigned int height,
+                         RotateFormat format, cudaStream_t stream)
+    : ImageWarper(width, height, format, WarpBackend::cuda, stream) {}
+
+ImageWarper::ImageWarper(unsigned int width, unsigned int height,
+                         RotateFormat format, WarpBackend backend)
+    : ImageWarper(width, height, format, backend, 0) {}
+
+ImageWarper::~ImageWarper() {
+  if (backend == WarpBackend::cuda) {
+    cudaStreamSynchronize(stream);
+    for (cudaEvent_t event : events)
+      if (event)
+        cudaEventDestroy(event);
+  }
+}
+
+void ImageWarper::reserveBuffers() {
+  if (d_memory)
+    return;
+  const std::size_t size = frame_size(format, width, height);
+  void *ptr = nullptr;
+  throw_error(cudaMalloc(&ptr, 2 * size));
+  d_memory.reset(ptr);
+  d_src = static_cast<unsigned char *>(ptr);
+  d_dst = d_src + size;
+}
+
+void ImageWarper::setMesh(std::shared_ptr<const WarpMesh> mesh) {
+  if (!mesh || !mesh->covers(width, height))
+    throw std::invalid_argument("the mesh does not cover the frame");
+
+  if (backend == WarpBackend::cuda) {
+    // the last frame may still read the nodes
+    throw_error(cudaStreamSynchronize(stream));
+    const std::size_t size = mesh->points.size() * sizeof(MeshPoint);
+    if (size > d_mesh_capacity) {
+      void *ptr = nullptr;
+      d_mesh.reset();
+      d_mesh_capacity = 0;
+      throw_error(cudaMalloc(&ptr, size));
+      d_mesh.reset(ptr);
+      d_mesh_capacity = size;
+    }
+    throw_error(cudaMemcpyAsync(d_mesh.get(), mesh->points.data(), size,
+                                cudaMemcpyHostToDevice, stream));
+    throw_error(cudaStreamSynchronize(stream));
+  }
+  this->mesh = std::move(mesh);
+}
+
+void ImageWarper::setLensModel(const LensModel &model, unsigned int cell) {
+  setMesh(WarpMeshCache::shared().lensMesh(model, width, height, cell));
+}
+
+void ImageWarper::process(const std::uint8_t *src, std::size_t pitch,
+                          std::uint8_t *dst, std::size_t dst_pitch) {
+  if (pitch < row_size(format, width) || dst_pitch < row_size(format, width))
+    throw std::invalid_argument("the row pitch is smaller than a row");
+  last_timings = WarpTimings();
+
+  if (backend == WarpBackend::cuda)
+    processCUDA(src, pitch, dst, dst_pitch);
+  else
+    processCPU(src, pitch, dst, dst_pitch);
+}
+
+void ImageWarper::processCUDA(const std::uint8_t *src, std::size_t pitch,
+                              std::uint8_t *dst, std::size_t dst_pitch) {
+  void warp_plane(unsigned char *dst, std::size_t dst_pitch,
+                  const WarpSource &source, unsigned int pixel_size,
+                  const MeshView &mesh, WarpInterpolation interpolation,
+                  cudaStream_t stream);
+
+  // device memory is read and written in place, host memory goes through
+  // the frame buffers
+  const bool upload = !device_accessible(src);
+  const bool download = !device_accessible(dst);
+  if (upload || download)
+    reserveBuffers();
+  const unsigned char *d_input = upload ? d_src : src;
+  const std::size_t input_pitch = upload ? frame_pitch(format, width) : pitch;
+  unsigned char *d_output = download ? d_dst : dst;
+  const std::size_t output_pitch =
+      download ? frame_pitch(format, width) : dst_pitch;
+  const MeshView view{static_cast<const MeshPoint *>(d_mesh.get()),
+                      static_cast<int>(mesh->columns),
+                      static_cast<int>(mesh->rows),
+                      static_cast<int>(mesh->cell)};
+
+  throw_error(cudaEventRecord(events[0], stream));
+  if (upload)
+    throw_error(cudaMemcpy2DAsync(d_src, input_pitch, src, pitch,
+                                  row_size(format, width),
+                                  frame_rows(format, height),
+                                  cudaMemcpyDefault, stream));
+  throw_error(cudaEventRecord(events[1], stream));
+
+  FramePlane planes[2];
+  const int count = frame_planes(format, width, height, planes);
+  for (int p = 0; p < count; ++p)
+    warp_plane(d_output + planes[p].row * output_pitch, output_pitch,
+               plane_source(planes[p], d_input, input_pitch),
+               planes[p].pixel_size, view, interpolation, stream);
+  throw_error(cudaEventRecord(events[2], stream));
+
+  if (download)
+    throw_error(cudaMemcpy2DAsync(dst, dst_pitch, d_dst, output_pitch,
+                                  row_size(format, width),
+                                  frame_rows(format, height),
+                                  cudaMemcpyDefault, stream));
+  throw_error(cudaEventRecord(events[3], stream));
+  throw_error(cudaEventSynchronize(events[3]));
+
+  throw_error(
+      cudaEventElapsedTime(&last_timings.upload, events[0], events[1]));
+  throw_error(
+      cudaEventElapsedTime(&last_timings.warp, events[1], events[2]));
+  throw_error(
+      cudaEventElapsedTime(&last_timings.download, events[2], events[3]));
+}
+
+void ImageWarper::processCPU(const std::uint8_t *src, std::size_t pitch,
+                             std::uint8_t *dst, std::size_t dst_pitch) {
+  const auto start = std::chrono::steady_clock::now();
+  const MeshView view{mesh->points.data(), static_cast<int>(mesh->columns),
+                      static_cast<int>(mesh->rows),
+                      static_cast<int>(mesh->cell)};
+  FramePlane planes[2];
+  const int count = frame_planes(format, width, height, planes);
+  for (int p = 0; p < count; ++p)
+    cpu::warp_plane(dst + planes[p].row * dst_pitch, dst_pitch,
+                    plane_source(planes[p], src, pitch),
+                    planes[p].pixel_size, view, interpolation);
+  last_timings.warp = std::chrono::duration<float, std::milli>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+}
@@ -0,0 +1,140 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef INCLUDED_IMAGEWARPER
+#define INCLUDED_IMAGEWARPER
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <cuda_runtime_api.h>
+
+#include "calculators/cuda/rotater/orientation.h"
+#include "calculators/cuda/rotater/warp_mesh.h"
+#include "calculators/cuda/rotater/warp_sample.h"
+
+enum class WarpBackend { cuda, cpu };
+
+// milliseconds spent in the stages of the last process() call. the copies
+// are 0 on the CPU backend and for device memory.
+struct WarpTimings {
+  float upload = 0.0f;
+  float warp = 0.0f;
+  float download = 0.0f;
+
+  float total() const { return upload + warp + download; }
+};
+
+// remaps frames of a fixed size and format by a sparse mesh of source
+// positions, for geometric distortion correction from a lens model or any
+// other mapping. the positions of the pixels between the nodes are
+// interpolated while warping, no dense map is kept. the device buffers for
+// frames in host memory are allocated by the first frame that needs them
+// and kept. separate instances may be used from different threads.
+class ImageWarper {
+  struct cudaFreeDeleter {
+    void operator()(void *ptr) const { cudaFree(ptr); }
+  };
+
+  const unsigned int width;
+  const unsigned int height;
+
+  const RotateFormat format;
+  const WarpBackend backend;
+  cudaStream_t stream = 0;
+  WarpInterpolation interpolation = WarpInterpolation::bilinear;
+  std::shared_ptr<const WarpMesh> mesh;
+  WarpTimings last_timings;
+
+  // CUDA backend: one block of device memory with the input and the output
+  // frame, a copy of the nodes of the mesh. stage boundaries are recorded
+  // on the events, which live as long as the warper.
+  std::unique_ptr<void, cudaFreeDeleter> d_memory;
+  unsigned char *d_src = nullptr;
+  unsigned char *d_dst = nullptr;
+  std::unique_ptr<void, cudaFreeDeleter> d_mesh;
+  std::size_t d_mesh_capacity = 0;
+  cudaEvent_t events[4] = {};
+
+  ImageWarper(unsigned int width, unsigned int height, RotateFormat format,
+              WarpBackend backend, cudaStream_t stream);
+
+  // allocates the frame buffers once
+  void reserveBuffers();
+  void processCUDA(const std::uint8_t *src, std::size_t pitch,
+                   std::uint8_t *dst, std::size_t dst_pitch);
+  void processCPU(const std::uint8_t *src, std::size_t pitch,
+                  std::uint8_t *dst, std::size_t dst_pitch);
+
+public:
+  // CUDA backend, all work is enqueued on the given stream. the mesh is the
+  // identity. throws std::invalid_argument for empty frames and nv12
+  // frames of odd width or height.
+  ImageWarper(unsigned int width, unsigned int height, RotateFormat format,
+              cudaStream_t stream = 0);
+  // CPU backend, the work is spread over ThreadPool::shared()
+  ImageWarper(unsigned int width, unsigned int height, RotateFormat format,
+              WarpBackend backend);
+  ~ImageWarper();
+
+  ImageWarper(const ImageWarper &) = delete;
+  ImageWarper &operator=(const ImageWarper &) = delete;
+
+  unsigned int getWidth() const { return width; }
+  unsigned int getHeight() const { return height; }
+  RotateFormat getFormat() const { return format; }
+  WarpBackend getBackend() const { return backend; }
+
+  // the mapping from output to source positions, in pixels of the luma
+  // plane for nv12 frames. throws std::invalid_argument if its nodes do
+  // not cover the frame.
+  void setMesh(std::shared_ptr<const WarpMesh> mesh);
+  const WarpMesh &getMesh() const { return *mesh; }
+
+  // corrects the distortion of model, the mesh comes from
+  // WarpMeshCache::shared()
+  void setLensModel(const LensModel &model, unsigned int cell = 32);
+
+  void setInterpolation(WarpInterpolation interpolation) {
+    this->interpolation = interpolation;
+  }
+  WarpInterpolation getInterpolation() const { return interpolation; }
+
+  // writes the frame src with rows of pitch bytes warped to dst, rows of
+  // dst_pitch bytes. the planes of nv12 frames follow each other with the
+  // same pitch, the chroma of pixels without a source is neutral and their
+  // other bytes 0. on the CUDA backend src and dst may be host or device
+  // memory, device memory is read and written in place. src and dst must
+  // not overlap. returns once dst is written.
+  void process(const std::uint8_t *src, std::size_t pitch, std::uint8_t *dst,
+               std::size_t dst_pitch);
+
+  // stage timings of the last process()
+  const WarpTimings &timings() const { return last_timings; }
+};
+
+#endif // INCLUDED_IMAGEWARPER
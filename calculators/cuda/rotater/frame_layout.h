@@ -0,0 +1,99 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef INCLUDED_FRAME_LAYOUT
+#define INCLUDED_FRAME_LAYOUT
+
+#pragma once
+
+#include <cstddef>
+
+#include <cuda_runtime_api.h>
+
+#include "calculators/cuda/rotater/orientation.h"
+
+// the layout of the frames of ImageRotator and ImageWarper in host and in
+// device memory
+
+// a plane of a frame: its first row in rows of the frame pitch, its size in
+// pixels, the bytes per pixel and the factor it is subsampled by in both
+// directions
+struct FramePlane {
+  std::size_t row;
+  unsigned int width;
+  unsigned int height;
+  unsigned int pixel_size;
+  unsigned int subsampling;
+};
+
+// the planes of a width x height frame, returns their number
+inline int frame_planes(RotateFormat format, unsigned int width,
+                        unsigned int height, FramePlane planes[2]) {
+  switch (format) {
+  case RotateFormat::bgr24:
+    planes[0] = {0, width, height, 3, 1};
+    return 1;
+  case RotateFormat::gray8:
+    planes[0] = {0, width, height, 1, 1};
+    return 1;
+  case RotateFormat::nv12:
+    planes[0] = {0, width, height, 1, 1};
+    planes[1] = {height, width / 2, height / 2, 2, 2};
+    return 2;
+  }
+  return 0;
+}
+
+// bytes of a row and rows of a width x height frame
+inline std::size_t row_size(RotateFormat format, unsigned int width) {
+  return std::size_t{width} * (format == RotateFormat::bgr24 ? 3 : 1);
+}
+
+inline std::size_t frame_rows(RotateFormat format, unsigned int height) {
+  return format == RotateFormat::nv12 ? std::size_t{height} * 3 / 2 : height;
+}
+
+// device row pitch and bytes of the frames
+inline std::size_t frame_pitch(RotateFormat format, unsigned int width) {
+  return (row_size(format, width) + 127) / 128 * 128;
+}
+
+inline std::size_t frame_size(RotateFormat format, unsigned int width,
+                              unsigned int height) {
+  return (frame_pitch(format, width) * frame_rows(format, height) + 255) /
+         256 * 256;
+}
+
+// whether the kernels can access ptr in place, host memory unknown to CUDA
+// is an error before CUDA 11
+inline bool device_accessible(const void *ptr) {
+  cudaPointerAttributes attributes;
+  if (cudaPointerGetAttributes(&attributes, ptr) != cudaSuccess) {
+    cudaGetLastError();
+    return false;
+  }
+  return attributes.type == cudaMemoryTypeDevice ||
+         attributes.type == cudaMemoryTypeManaged;
+}
+#endif // INCLUDED_FRAME_LAYOUT
@@ -25,11 +25,15 @@
 #include <cuda.h>
 #include <cuda_runtime.h>
 #include <device_launch_parameters.h>
+#include <exception>
 #include <iostream>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <vector>
+
+#include "calculators/cuda/rotater/ImageRotator.h"
 
 #define DATAMB(bytes) (bytes / 1024 / 1024)
 #define DATABW(bytes, timems)                                                  \
@@ -114,7 +118,7 @@ __global__ void PixCopy(uch *ImgDst, uch *ImgSrc, ui FS) {
   ui MYtid = threadIdx.x;
   ui MYgtid = ThrPerBlk * MYbid + MYtid;
 
-  if (MYgtid > FS)
+  if (MYgtid >= FS)
     return; // outside the allocated memory
   ImgDst[MYgtid] = ImgSrc[MYgtid];
 }
@@ -185,6 +189,83 @@ void WriteBMPlin(uch *Img, char *fn) {
   fclose(f);
 }
 
+//* The orientation of the BMP buffer that shows the image turned as Flip
+//* says. BMP rows run bottom up, so rotations of the buffer turn the other
+//* way and the transpose of the image is the transverse of the buffer.
+Orientation BufferOrientation(char Flip) {
+  switch (Flip) {
+  case 'H':
+    return Orientation::flip_horizontal;
+  case 'V':
+    return Orientation::flip_vertical;
+  case 'C':
+    return Orientation::identity;
+  case 'T':
+    return Orientation::transverse;
+  case 'R':
+    return Orientation::rotate270;
+  case 'L':
+    return Orientation::rotate90;
+  default:
+    return Orientation::rotate180;
+  }
+}
+
+//* Flips, transposes or rotates TheImg through ImageRotator in a single
+//* pass and writes the result with width and height swapped where needed.
+//* Flips and copies work on TheImg in place, without a second image.
+void OrientImage(char Flip, char *OutputFileName) {
+  const Orientation orientation = BufferOrientation(Flip);
+  RotateTimings t;
+  std::vector<uch> Result;
+  uch *OutputImg = TheImg;
+  ImgProp op = ip;
+  try {
+    ImageRotator rotator(IPH, IPV, RotateFormat::bgr24);
+    if (swaps_axes(orientation)) {
+      op.Hpixels = rotator.outputWidth(orientation);
+      op.Vpixels = rotator.outputHeight(orientation);
+      op.Hbytes = (op.Hpixels * 3 + 3) & (~3);
+      Result.resize(op.Hbytes * op.Vpixels);
+      OutputImg = Result.data();
+      rotator.process(TheImg, IPHB, OutputImg, op.Hbytes, orientation);
+    } else {
+      rotator.processInPlace(TheImg, IPHB, orientation);
+    }
+    t = rotator.timings();
+  } catch (const std::exception &e) {
+    fprintf(stderr, "\n\nrotation failed: %s\n", e.what());
+    exit(EXIT_FAILURE);
+  }
+
+  //* patch the sizes in the header and write the result with it
+  const ui ImageBytes = op.Hbytes * op.Vpixels;
+  const ui FileBytes = 54 + ImageBytes;
+  memcpy(&op.HeaderInfo[2], &FileBytes, 4);
+  memcpy(&op.HeaderInfo[18], &op.Hpixels, 4);
+  memcpy(&op.HeaderInfo[22], &op.Vpixels, 4);
+  memcpy(&op.HeaderInfo[34], &ImageBytes, 4);
+  const ImgProp saved = ip;
+  ip = op;
+  WriteBMPlin(OutputImg, OutputFileName);
+  ip = saved;
+
+  printf("\n\n-----------------------------------------------------------------"
+         "---------\n");
+  printf("CPU->GPU Transfer   =%7.2f ms  ...  %4lu MB  ...  %6.2f GB/s\n",
+         t.upload, (ul)DATAMB(IMAGESIZE), DATABW(IMAGESIZE, t.upload));
+  const ul KernelBytes = IMAGESIZE + ImageBytes;
+  printf("Kernel Execution    =%7.2f ms  ...  %4lu MB  ...  %6.2f GB/s\n",
+         t.orient, (ul)DATAMB(KernelBytes), DATABW(KernelBytes, t.orient));
+  printf("GPU->CPU Transfer   =%7.2f ms  ...  %4lu MB  ...  %6.2f GB/s\n",
+         t.download, (ul)DATAMB(ImageBytes), DATABW(ImageBytes, t.download));
+  printf("---------------------------------------------------------------------"
+         "-----\n");
+  printf("Total time elapsed  =%7.2f ms\n", t.total());
+  printf("---------------------------------------------------------------------"
+         "-----\n\n");
+}
+
 void rotater(int argc, char **argv) {
   char Flip = 'H';
   float totalTime, tfrCPUtoGPU, tfrGPUtoCPU,
@@ -208,17 +289,22 @@ void rotater(int argc, char **argv) {
     strcpy(OutputFileName, argv[2]);
     break;
   default:
-    printf("\n\nUsage:   %s InputFilename OutputFilename [V/H/C/T] [ThrPerBlk]",
+    printf("\n\nUsage:   %s InputFilename OutputFilename [V/H/C/T/R/L/U] "
+           "[ThrPerBlk]",
            ProgName);
     printf("\n\nExample: %s Astronaut.bmp Output.bmp", ProgName);
     printf("\n\nExample: %s Astronaut.bmp Output.bmp H", ProgName);
     printf("\n\nExample: %s Astronaut.bmp Output.bmp V  128", ProgName);
     printf("\n\nH=horizontal flip, V=vertical flip, T=Transpose, C=copy "
-           "image\n\n");
+           "image,\nR=rotate 90 clockwise, L=rotate 90 counterclockwise, "
+           "U=rotate 180\n\nWith ThrPerBlk H, V and C run on the per-byte "
+           "kernels\n\n");
     exit(EXIT_FAILURE);
   }
-  if ((Flip != 'V') && (Flip != 'H') && (Flip != 'C') && (Flip != 'T')) {
-    printf("Invalid flip option '%c'. Must be 'V','H', 'T', or 'C'... \n",
+  if ((Flip != 'V') && (Flip != 'H') && (Flip != 'C') && (Flip != 'T') &&
+      (Flip != 'R') && (Flip != 'L') && (Flip != 'U')) {
+    printf("Invalid flip option '%c'. Must be 'V','H', 'T', 'R', 'L', 'U' "
+           "or 'C'... \n",
            Flip);
     exit(EXIT_FAILURE);
   }
@@ -235,13 +321,6 @@ void rotater(int argc, char **argv) {
     printf("Cannot allocate memory for the input image...\n");
     exit(EXIT_FAILURE);
   }
-  CopyImg = (uch *)malloc(IMAGESIZE);
-  if (CopyImg == NULL) {
-    free(TheImg);
-    printf("Cannot allocate memory for the input image...\n");
-    exit(EXIT_FAILURE);
-  }
-
   //* Choose which GPU to run on, change this on a multi-GPU system.
   int NumGPUs = 0;
   cudaGetDeviceCount(&NumGPUs);
@@ -264,6 +343,24 @@ void rotater(int argc, char **argv) {
           (SupportedMBlocks >= 5) ? 'M' : 'K');
   MaxThrPerBlk = (ui)GPUprop.maxThreadsPerBlock;
 
+  //* the per-byte kernels only run if asked for with a block size
+  if ((argc < 5) || (Flip == 'T') || (Flip == 'R') || (Flip == 'L') ||
+      (Flip == 'U')) {
+    printf("\n\n%s    ComputeCapab=%d.%d  [max %s blocks; %d thr/blk]",
+           GPUprop.name, GPUprop.major, GPUprop.minor, SupportedBlocks,
+           MaxThrPerBlk);
+    OrientImage(Flip, OutputFileName);
+    free(TheImg);
+    return;
+  }
+
+  CopyImg = (uch *)malloc(IMAGESIZE);
+  if (CopyImg == NULL) {
+    free(TheImg);
+    printf("Cannot allocate memory for the output image...\n");
+    exit(EXIT_FAILURE);
+  }
+
   cudaEventCreate(&time1);
   cudaEventCreate(&time2);
   cudaEventCreate(&time3);
@@ -303,12 +400,6 @@ void rotater(int argc, char **argv) {
     GPUResult = GPUCopyImg;
     GPUDataTransfer = 2 * IMAGESIZE;
     break;
-  case 'T':
-    Hflip<<<NumBlocks, ThrPerBlk>>>(GPUCopyImg, GPUImg, IPH);
-    Vflip<<<NumBlocks, ThrPerBlk>>>(GPUImg, GPUCopyImg, IPH, IPV);
-    GPUResult = GPUImg;
-    GPUDataTransfer = 4 * IMAGESIZE;
-    break;
   case 'C':
     NumBlocks = (IMAGESIZE + ThrPerBlk - 1) / ThrPerBlk;
     PixCopy<<<NumBlocks, ThrPerBlk>>>(GPUCopyImg, GPUImg, IMAGESIZE);
@@ -0,0 +1,109 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef INCLUDED_ORIENTATION
+#define INCLUDED_ORIENTATION
+
+#pragma once
+
+#include <cstddef>
+
+// the mapping below is compiled into the CUDA kernel as well as into the
+// host loops
+#if defined(__CUDACC__)
+#define ROTATE_HOST_DEVICE __host__ __device__
+#else
+#define ROTATE_HOST_DEVICE
+#endif
+
+// the eight ways to lay an image onto a rectangle. the rotations are
+// clockwise, transpose mirrors at the main diagonal and transverse at the
+// other one. the four after rotate180 swap width and height.
+enum class Orientation {
+  identity,
+  flip_horizontal,
+  flip_vertical,
+  rotate180,
+  rotate90,
+  rotate270,
+  transpose,
+  transverse,
+};
+
+// the frames ImageRotator and ImageWarper work on. bgr24 and gray8 are
+// single planes of 3 and 1 bytes per pixel. nv12 is a plane of luma bytes
+// followed by one of interleaved U and V at half the resolution in both
+// directions, a pixel of it being the 2 bytes of a U V pair, both planes
+// with the same pitch.
+enum class RotateFormat { bgr24, gray8, nv12 };
+
+ROTATE_HOST_DEVICE inline bool swaps_axes(Orientation orientation) {
+  return orientation == Orientation::rotate90 ||
+         orientation == Orientation::rotate270 ||
+         orientation == Orientation::transpose ||
+         orientation == Orientation::transverse;
+}
+
+// the pixel (sx, sy) of a width x height image that lands on (x, y) of the
+// oriented one. the mapping is affine, so the source of a rectangle is the
+// rectangle spanned by the sources of two opposite corners.
+ROTATE_HOST_DEVICE inline void orient_source(Orientation orientation,
+                                             int width, int height, int x,
+                                             int y, int &sx, int &sy) {
+  sx = x;
+  sy = y;
+  switch (orientation) {
+  case Orientation::identity:
+    break;
+  case Orientation::flip_horizontal:
+    sx = width - 1 - x;
+    sy = y;
+    break;
+  case Orientation::flip_vertical:
+    sx = x;
+    sy = height - 1 - y;
+    break;
+  case Orientation::rotate180:
+    sx = width - 1 - x;
+    sy = height - 1 - y;
+    break;
+  case Orientation::rotate90:
+    sx = y;
+    sy = height - 1 - x;
+    break;
+  case Orientation::rotate270:
+    sx = width - 1 - y;
+    sy = x;
+    break;
+  case Orientation::transpose:
+    sx = y;
+    sy = x;
+    break;
+  case Orientation::transverse:
+    sx = width - 1 - y;
+    sy = height - 1 - x;
+    break;
+  }
+}
+
+#endif // INCLUDED_ORIENTATION
@@ -0,0 +1,271 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// throughput of every orientation of a synthetic frame next to that of a
+// plain copy of the same bytes, on the CPU backend or with --cuda on the
+// device. the flips and the copy should run at copy speed.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cuda_runtime_api.h>
+
+#include "calculators/cuda/hdr/framework/CUDA/error.h"
+#include "calculators/cuda/hdr/framework/cmd_args.h"
+#include "calculators/cuda/hdr/framework/thread_pool.h"
+
+#include "calculators/cuda/rotater/ImageRotator.h"
+
+namespace {
+struct cudaFreeDeleter {
+  void operator()(void *ptr) const { cudaFree(ptr); }
+};
+
+const struct {
+  const char *name;
+  Orientation orientation;
+} orientations[] = {
+    {"identity", Orientation::identity},
+    {"flip_horizontal", Orientation::flip_horizontal},
+    {"flip_vertical", Orientation::flip_vertical},
+    {"rotate180", Orientation::rotate180},
+    {"rotate90", Orientation::rotate90},
+    {"rotate270", Orientation::rotate270},
+    {"transpose", Orientation::transpose},
+    {"transverse", Orientation::transverse},
+};
+
+std::size_t pixel_size(RotateFormat format) {
+  return format == RotateFormat::bgr24 ? 3 : 1;
+}
+
+// rows of a frame, the chroma plane of nv12 frames included
+std::size_t frame_rows(RotateFormat format, std::size_t height) {
+  return format == RotateFormat::nv12 ? height * 3 / 2 : height;
+}
+
+// rows padded to 128 bytes like those of the rotator's own buffers
+std::size_t frame_pitch(RotateFormat format, std::size_t width) {
+  return (width * pixel_size(format) + 127) / 128 * 128;
+}
+
+// average time of the orient stage of runs frames, after an untimed one
+// warming up the caches, the thread pool and the device
+float benchmark(ImageRotator &rotator, const std::uint8_t *src,
+                std::size_t pitch, std::uint8_t *dst, std::size_t dst_pitch,
+                Orientation orientation, int runs) {
+  rotator.process(src, pitch, dst, dst_pitch, orientation);
+
+  float sum = 0.0f;
+  for (int i = 0; i < runs; ++i) {
+    rotator.process(src, pitch, dst, dst_pitch, orientation);
+    sum += rotator.timings().orient;
+  }
+  return sum / runs;
+}
+
+// average time of a copy of size bytes, split over the shared thread pool
+// like the rotator's own work
+float benchmark_memcpy(std::uint8_t *dst, const std::uint8_t *src,
+                       std::size_t size, int runs) {
+  ThreadPool &pool = ThreadPool::shared();
+  const std::size_t chunk = (size + pool.size() - 1) / pool.size();
+  auto copy = [&]() {
+    pool.parallel_for(pool.size(), [&](std::size_t i) {
+      const std::size_t begin = std::min(size, i * chunk);
+      std::memcpy(dst + begin, src + begin,
+                  std::min(size, begin + chunk) - begin);
+    });
+  };
+  copy();
+
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < runs; ++i)
+    copy();
+  const std::chrono::duration<float, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / runs;
+}
+
+// average time of a device to device copy of size bytes
+float benchmark_memcpy(std::uint8_t *dst, const std::uint8_t *src,
+                       std::size_t size, int runs, cudaStream_t stream) {
+  cudaEvent_t start, stop;
+  throw_error(cudaEventCreate(&start));
+  throw_error(cudaEventCreate(&stop));
+  throw_error(cudaMemcpyAsync(dst, src, size, cudaMemcpyDeviceToDevice,
+                              stream));
+  throw_error(cudaEventRecord(start, stream));
+  for (int i = 0; i < runs; ++i)
+    throw_error(cudaMemcpyAsync(dst, src, size, cudaMemcpyDeviceToDevice,
+                                stream));
+  throw_error(cudaEventRecord(stop, stream));
+  throw_error(cudaEventSynchronize(stop));
+  float ms = 0.0f;
+  throw_error(cudaEventElapsedTime(&ms, start, stop));
+  throw_error(cudaEventDestroy(start));
+  throw_error(cudaEventDestroy(stop));
+  return ms / runs;
+}
+
+void report(const float (&ms)[8], float memcpy_ms, std::size_t bytes) {
+  auto bandwidth = [bytes](float ms) { return 2 * bytes / (ms * 1.0e6); };
+  auto row = [&](const char *name, float ms) {
+    std::cout << std::left << std::setw(16) << name << std::right
+              << std::setw(10) << ms << " ms" << std::setw(10)
+              << bandwidth(ms) << " GB/s" << std::setw(10)
+              << 100.0f * memcpy_ms / ms << " %\n";
+  };
+
+  std::cout << "orientation           time      bandwidth   of memcpy\n";
+  row("memcpy", memcpy_ms);
+  for (std::size_t i = 0; i < std::size(orientations); ++i)
+    row(orientations[i].name, ms[i]);
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  try {
+    int image_width = 3840;
+    int image_height = 2160;
+    int runs = 10;
+    const char *format_name = "bgr24";
+    bool cuda = false;
+    int cuda_device = 0;
+
+    for (char **a = &argv[1]; *a; ++a) {
+      if (!checkArgument("--width", a, image_width))
+        if (!checkArgument("--height", a, image_height))
+          if (!checkArgument("--runs", a, runs))
+            if (!checkArgument("--format", a, format_name))
+              if (!checkArgument("--cuda", a, cuda))
+                if (!checkArgument("--device", a, cuda_device))
+                  throw usage_error("unknown argument");
+    }
+
+    if (image_width < 1 || image_height < 1 || runs < 1)
+      throw usage_error("width, height and runs must be positive");
+    RotateFormat format;
+    const std::string name = format_name;
+    if (name == "bgr24")
+      format = RotateFormat::bgr24;
+    else if (name == "gray8")
+      format = RotateFormat::gray8;
+    else if (name == "nv12")
+      format = RotateFormat::nv12;
+    else
+      throw usage_error("the format must be bgr24, gray8 or nv12");
+
+    const auto width = static_cast<unsigned int>(image_width);
+    const auto height = static_cast<unsigned int>(image_height);
+    const std::size_t pitch = frame_pitch(format, width);
+    const std::size_t rows = frame_rows(format, height);
+    // the output of a turning orientation has the rows of a turned frame
+    const std::size_t size = std::max(pitch * rows,
+                                      frame_pitch(format, height) *
+                                          frame_rows(format, width));
+    const std::size_t bytes = width * pixel_size(format) * rows;
+
+    std::vector<std::uint8_t> frame(size);
+    std::uint32_t noise = 1;
+    for (std::uint8_t &v : frame) {
+      noise = noise * 1664525U + 1013904223U;
+      v = static_cast<std::uint8_t>(noise >> 24);
+    }
+    std::vector<std::uint8_t> result(size);
+
+    float ms[std::size(orientations)];
+    float memcpy_ms;
+    if (cuda) {
+      throw_error(cudaSetDevice(cuda_device));
+      cudaStream_t stream;
+      throw_error(cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking));
+      {
+        // frames in device memory, so that only the kernels are timed
+        void *ptr = nullptr;
+        throw_error(cudaMalloc(&ptr, 2 * size));
+        std::unique_ptr<void, cudaFreeDeleter> memory(ptr);
+        auto *d_src = static_cast<std::uint8_t *>(ptr);
+        std::uint8_t *d_dst = d_src + size;
+        throw_error(cudaMemcpy(d_src, frame.data(), size,
+                               cudaMemcpyHostToDevice));
+
+        ImageRotator rotator(width, height, format, stream);
+        for (std::size_t i = 0; i < std::size(orientations); ++i) {
+          const Orientation o = orientations[i].orientation;
+          ms[i] = benchmark(rotator, d_src, pitch, d_dst,
+                            frame_pitch(format, rotator.outputWidth(o)), o,
+                            runs);
+        }
+        memcpy_ms = benchmark_memcpy(d_dst, d_src, bytes, runs, stream);
+      }
+      throw_error(cudaStreamDestroy(stream));
+    } else {
+      ImageRotator rotator(width, height, format, RotateBackend::cpu);
+      for (std::size_t i = 0; i < std::size(orientations); ++i) {
+        const Orientation o = orientations[i].orientation;
+        ms[i] = benchmark(rotator, frame.data(), pitch, result.data(),
+                          frame_pitch(format, rotator.outputWidth(o)), o,
+                          runs);
+      }
+      memcpy_ms = benchmark_memcpy(result.data(), frame.data(), bytes, runs);
+    }
+
+    std::cout << (cuda ? "cuda" : "cpu") << " backend, " << name << " "
+              << width << "x" << height << ", " << runs << " runs\n"
+              << std::fixed << std::setprecision(2);
+    report(ms, memcpy_ms, bytes);
+  } catch (const usage_error &e) {
+    std::cout << "error: " << e.what() << std::endl;
+    std::cout << "usage: rotate_benchmark {options}\n"
+                 "\toptions:\n"
+                 "\t  --width <w>            image width, default: 3840\n"
+                 "\t  --height <h>           image height, default: 2160\n"
+                 "\t  --runs <N>             average over <N> runs, "
+                 "default: 10\n"
+                 "\t  --format <f>           bgr24, gray8 or nv12, "
+                 "default: bgr24\n"
+                 "\t  --cuda                 run on the device instead of the "
+                 "cpu\n"
+                 "\t  --device <i>           use cuda device <i>, default: 0\n";
+    return -127;
+  } catch (std::exception &e) {
+    std::cout << "error: " << e.what() << std::endl;
+    return -1;
+  } catch (...) {
+    std::cout << "unknown exception" << std::endl;
+    return -128;
+  }
+
+  return 0;
+}
@@ -0,0 +1,370 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <cstddef>
+#include <cstdint>
+
+#include <cuda_runtime_api.h>
+
+#include "calculators/cuda/hdr/framework/CUDA/error.h"
+
+#include "calculators/cuda/rotater/orientation.h"
+
+namespace {
+// pixels of the square tile of a block, every thread covers tile_size /
+// tile_rows rows
+constexpr int tile_size = 32;
+constexpr int tile_rows = 8;
+
+unsigned int divup(unsigned int a, unsigned int b) {
+  return (a + b - 1) / b;
+}
+
+// threads of the blocks that move rows which stay rows
+constexpr int row_threads = 64;
+constexpr int row_lines = 4;
+
+// a pixel of N bytes, without alignment requirements on the row pitch
+template <int N> struct PixelBytes {
+  unsigned char bytes[N];
+};
+} // namespace
+
+// copies the rows of a plane one Word per thread, bottom up for the
+// orientations that turn the plane upside down. the thread after the last
+// whole word of a row copies the rest of it byte by byte, the padding is
+// left alone.
+template <typename Word>
+__global__ void copy_rows_kernel(unsigned char *dst, std::size_t dst_pitch,
+                                 const unsigned char *src,
+                                 std::size_t src_pitch,
+                                 unsigned int row_bytes, int height,
+                                 bool upside_down) {
+  const unsigned int i = blockIdx.x * blockDim.x + threadIdx.x;
+  const int y = blockIdx.y * blockDim.y + threadIdx.y;
+  const unsigned int words = row_bytes / sizeof(Word);
+  if (i > words || y >= height)
+    return;
+
+  unsigned char *row = dst + y * dst_pitch;
+  const unsigned char *source =
+      src + (upside_down ? height - 1 - y : y) * src_pitch;
+  if (i < words) {
+    reinterpret_cast<Word *>(row)[i] =
+        reinterpret_cast<const Word *>(source)[i];
+    return;
+  }
+  for (unsigned int b = words * sizeof(Word); b < row_bytes; ++b)
+    row[b] = source[b];
+}
+
+// mirrors the rows of a plane 4 pixels per thread in words of 4 bytes. the
+// 4N source bytes of a thread lie in N or N + 1 aligned words and are
+// lined up with funnel shifts, byte permutes then reverse the order of the
+// pixels but not that of their bytes. the thread after the last group of 4
+// writes the rest of the row pixel by pixel. needs rows aligned to 4 bytes.
+template <int N>
+__global__ void mirror_rows_kernel(unsigned char *dst, std::size_t dst_pitch,
+                                   const unsigned char *src,
+                                   std::size_t src_pitch, int width,
+                                   int height, bool upside_down) {
+  const int g = blockIdx.x * blockDim.x + threadIdx.x;
+  const int y = blockIdx.y * blockDim.y + threadIdx.y;
+  const int groups = width / 4;
+  if (g > groups || y >= height)
+    return;
+
+  unsigned char *row = dst + y * dst_pitch;
+  const unsigned char *source =
+      src + (upside_down ? height - 1 - y : y) * src_pitch;
+  const int x0 = 4 * g;
+  if (g == groups) {
+    for (int x = x0; x < width; ++x)
+      reinterpret_cast<PixelBytes<N> *>(row)[x] =
+          reinterpret_cast<const PixelBytes<N> *>(source)[width - 1 - x];
+    return;
+  }
+
+  // source pixels width - 4 - x0 to width - 1 - x0, in source order
+  const unsigned int first = N * (width - 4 - x0);
+  const unsigned int shift = 8 * (first % 4);
+  const unsigned int *words =
+      reinterpret_cast<const unsigned int *>(source) + first / 4;
+  unsigned int in[N + 1];
+#pragma unroll
+  for (int i = 0; i < N; ++i)
+    in[i] = words[i];
+  in[N] = shift ? words[N] : 0;
+  unsigned int v[N];
+#pragma unroll
+  for (int i = 0; i < N; ++i)
+    v[i] = __funnelshift_r(in[i], in[i + 1], shift);
+
+  unsigned int *out = reinterpret_cast<unsigned int *>(row + N * x0);
+  if constexpr (N == 1) {
+    out[0] = __byte_perm(v[0], 0, 0x0123);
+  } else if constexpr (N == 2) {
+    out[0] = __byte_perm(v[1], 0, 0x1032);
+    out[1] = __byte_perm(v[0], 0, 0x1032);
+  } else {
+    // v holds the bytes of pixels 3, 2, 1, 0 of the output
+    out[0] = __byte_perm(v[2], v[1], 0x6321);
+    out[1] = __byte_perm(__byte_perm(v[1], v[2], 0x0043), v[0], 0x3710);
+    out[2] = __byte_perm(v[0], v[1], 0x2105);
+  }
+}
+
+// orients a width x height plane of N byte pixels in one pass. a block
+// loads the source of its tile of the output along the source rows into
+// shared memory and writes the tile along the output rows, so that both
+// sides are coalesced whichever way the image turns.
+template <int N>
+__global__ void orient_kernel(unsigned char *dst, std::size_t dst_pitch,
+                              const unsigned char *src, std::size_t src_pitch,
+                              int width, int height,
+                              Orientation orientation) {
+  __shared__ PixelBytes<N> tile[tile_size][tile_size + 1];
+
+  const bool swap = swaps_axes(orientation);
+  const int out_width = swap ? height : width;
+  const int out_height = swap ? width : height;
+  const int x0 = blockIdx.x * tile_size;
+  const int y0 = blockIdx.y * tile_size;
+
+  int ax, ay, bx, by;
+  orient_source(orientation, width, height, x0, y0, ax, ay);
+  orient_source(orientation, width, height, x0 + tile_size - 1,
+                y0 + tile_size - 1, bx, by);
+  const int sx0 = min(ax, bx);
+  const int sy0 = min(ay, by);
+
+  for (int r = threadIdx.y; r < tile_size; r += tile_rows) {
+    const int sx = sx0 + threadIdx.x;
+    const int sy = sy0 + r;
+    if (sx >= 0 && sy >= 0 && sx < width && sy < height)
+      tile[r][threadIdx.x] = *reinterpret_cast<const PixelBytes<N> *>(
+          src + sy * src_pitch + N * sx);
+  }
+  __syncthreads();
+
+  for (int r = threadIdx.y; r < tile_size; r += tile_rows) {
+    const int x = x0 + threadIdx.x;
+    const int y = y0 + r;
+    if (x >= out_width || y >= out_height)
+      continue;
+    int sx, sy;
+    orient_source(orientation, width, height, x, y, sx, sy);
+    *reinterpret_cast<PixelBytes<N> *>(dst + y * dst_pitch + N * x) =
+        tile[sy - sy0][sx - sx0];
+  }
+}
+
+// swaps row y of the upper half of a plane with row height - 1 - y one Word
+// per thread, the thread after the last whole word swaps the rest of the
+// rows byte by byte
+template <typename Word>
+__global__ void swap_rows_kernel(unsigned char *frame, std::size_t pitch,
+                                 unsigned int row_bytes, int height) {
+  const unsigned int i = blockIdx.x * blockDim.x + threadIdx.x;
+  const int y = blockIdx.y * blockDim.y + threadIdx.y;
+  const unsigned int words = row_bytes / sizeof(Word);
+  if (i > words || y >= height / 2)
+    return;
+
+  unsigned char *a = frame + y * pitch;
+  unsigned char *b = frame + (height - 1 - y) * pitch;
+  if (i < words) {
+    const Word t = reinterpret_cast<Word *>(a)[i];
+    reinterpret_cast<Word *>(a)[i] = reinterpret_cast<Word *>(b)[i];
+    reinterpret_cast<Word *>(b)[i] = t;
+    return;
+  }
+  for (unsigned int k = words * sizeof(Word); k < row_bytes; ++k) {
+    const unsigned char t = a[k];
+    a[k] = b[k];
+    b[k] = t;
+  }
+}
+
+// swaps pixel (x, y) with its mirror image (width - 1 - x, y), or with
+// (width - 1 - x, height - 1 - y) for the orientations that turn the plane
+// upside down. the threads cover the pairs_width x pairs_height pixels of
+// the first half of the plane, of a pair only the thread of the pixel
+// first in memory swaps, the middle pixel of an odd plane stays.
+template <int N>
+__global__ void swap_pixels_kernel(unsigned char *frame, std::size_t pitch,
+                                   int width, int height, int pairs_width,
+                                   int pairs_height, bool upside_down) {
+  const int x = blockIdx.x * blockDim.x + threadIdx.x;
+  const int y = blockIdx.y * blockDim.y + threadIdx.y;
+  if (x >= pairs_width || y >= pairs_height)
+    return;
+
+  const int mx = width - 1 - x;
+  const int my = upside_down ? height - 1 - y : y;
+  if (my * width + mx <= y * width + x)
+    return;
+  auto *a = reinterpret_cast<PixelBytes<N> *>(frame + y * pitch) + x;
+  auto *b = reinterpret_cast<PixelBytes<N> *>(frame + my * pitch) + mx;
+  const PixelBytes<N> t = *a;
+  *a = *b;
+  *b = t;
+}
+
+void orient_plane(unsigned char *dst, std::size_t dst_pitch,
+                  const unsigned char *src, std::size_t src_pitch,
+                  unsigned int width, unsigned int height,
+                  unsigned int pixel_size, Orientation orientation,
+                  cudaStream_t stream) {
+  const bool swap = swaps_axes(orientation);
+  const bool mirrored = orientation == Orientation::flip_horizontal ||
+                        orientation == Orientation::rotate180;
+  const bool upside_down = orientation == Orientation::flip_vertical ||
+                           orientation == Orientation::rotate180;
+  const std::uintptr_t alignment = reinterpret_cast<std::uintptr_t>(dst) |
+                                   reinterpret_cast<std::uintptr_t>(src) |
+                                   dst_pitch | src_pitch;
+
+  // rows that stay rows move in the widest words their alignment allows,
+  // only mirrored rows that are not aligned to 4 bytes go through the tile
+  if (!swap && !mirrored) {
+    const unsigned int row_bytes = width * pixel_size;
+    const dim3 block(row_threads, row_lines);
+    if (alignment % 16 == 0)
+      copy_rows_kernel<uint4>
+          <<<dim3(row_bytes / 16 / row_threads + 1,
+                  divup(height, row_lines)),
+             block, 0, stream>>>(dst, dst_pitch, src, src_pitch, row_bytes,
+                                 height, upside_down);
+    else if (alignment % 4 == 0)
+      copy_rows_kernel<unsigned int>
+          <<<dim3(row_bytes / 4 / row_threads + 1,
+                  divup(height, row_lines)),
+             block, 0, stream>>>(dst, dst_pitch, src, src_pitch, row_bytes,
+                                 height, upside_down);
+    else
+      copy_rows_kernel<unsigned char>
+          <<<dim3(row_bytes / row_threads + 1, divup(height, row_lines)),
+             block, 0, stream>>>(dst, dst_pitch, src, src_pitch, row_bytes,
+                                 height, upside_down);
+    throw_error(cudaGetLastError());
+    return;
+  }
+  if (!swap && alignment % 4 == 0) {
+    const dim3 block(row_threads, row_lines);
+    const dim3 grid(width / 4 / row_threads + 1, divup(height, row_lines));
+    switch (pixel_size) {
+    case 1:
+      mirror_rows_kernel<1><<<grid, block, 0, stream>>>(
+          dst, dst_pitch, src, src_pitch, width, height, upside_down);
+      break;
+    case 2:
+      mirror_rows_kernel<2><<<grid, block, 0, stream>>>(
+          dst, dst_pitch, src, src_pitch, width, height, upside_down);
+      break;
+    case 3:
+      mirror_rows_kernel<3><<<grid, block, 0, stream>>>(
+          dst, dst_pitch, src, src_pitch, width, height, upside_down);
+      break;
+    }
+    throw_error(cudaGetLastError());
+    return;
+  }
+
+  const dim3 block(tile_size, tile_rows);
+  const dim3 grid(divup(swap ? height : width, tile_size),
+                  divup(swap ? width : height, tile_size));
+  switch (pixel_size) {
+  case 1:
+    orient_kernel<1><<<grid, block, 0, stream>>>(
+        dst, dst_pitch, src, src_pitch, width, height, orientation);
+    break;
+  case 2:
+    orient_kernel<2><<<grid, block, 0, stream>>>(
+        dst, dst_pitch, src, src_pitch, width, height, orientation);
+    break;
+  case 3:
+    orient_kernel<3><<<grid, block, 0, stream>>>(
+        dst, dst_pitch, src, src_pitch, width, height, orientation);
+    break;
+  }
+  throw_error(cudaGetLastError());
+}
+
+void flip_plane_in_place(unsigned char *frame, std::size_t pitch,
+                         unsigned int width, unsigned int height,
+                         unsigned int pixel_size, Orientation orientation,
+                         cudaStream_t stream) {
+  const bool mirrored = orientation == Orientation::flip_horizontal ||
+                        orientation == Orientation::rotate180;
+  const bool upside_down = orientation == Orientation::flip_vertical ||
+                           orientation == Orientation::rotate180;
+  const dim3 block(row_threads, row_lines);
+
+  if (!mirrored) {
+    if (!upside_down || height < 2)
+      return;
+    const std::uintptr_t alignment =
+        reinterpret_cast<std::uintptr_t>(frame) | pitch;
+    const unsigned int row_bytes = width * pixel_size;
+    const unsigned int lines = divup(height / 2, row_lines);
+    if (alignment % 16 == 0)
+      swap_rows_kernel<uint4>
+          <<<dim3(row_bytes / 16 / row_threads + 1, lines), block, 0,
+             stream>>>(frame, pitch, row_bytes, height);
+    else if (alignment % 4 == 0)
+      swap_rows_kernel<unsigned int>
+          <<<dim3(row_bytes / 4 / row_threads + 1, lines), block, 0,
+             stream>>>(frame, pitch, row_bytes, height);
+    else
+      swap_rows_kernel<unsigned char>
+          <<<dim3(row_bytes / row_threads + 1, lines), block, 0, stream>>>(
+              frame, pitch, row_bytes, height);
+    throw_error(cudaGetLastError());
+    return;
+  }
+
+  // the left half of every row, or the upper half of the plane and the
+  // middle row of an odd one
+  const unsigned int pairs_width = upside_down ? width : width / 2;
+  const unsigned int pairs_height = upside_down ? (height + 1) / 2 : height;
+  if (pairs_width == 0)
+    return;
+  const dim3 grid(divup(pairs_width, row_threads),
+                  divup(pairs_height, row_lines));
+  switch (pixel_size) {
+  case 1:
+    swap_pixels_kernel<1><<<grid, block, 0, stream>>>(
+        frame, pitch, width, height, pairs_width, pairs_height, upside_down);
+    break;
+  case 2:
+    swap_pixels_kernel<2><<<grid, block, 0, stream>>>(
+        frame, pitch, width, height, pairs_width, pairs_height, upside_down);
+    break;
+  case 3:
+    swap_pixels_kernel<3><<<grid, block, 0, stream>>>(
+        frame, pitch, width, height, pairs_width, pairs_height, upside_down);
+    break;
+  }
+  throw_error(cudaGetLastError());
+}
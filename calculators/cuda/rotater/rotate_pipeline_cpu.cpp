@@ -0,0 +1,382 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "calculators/cuda/hdr/framework/thread_pool.h"
+
+#include "calculators/cuda/rotater/orientation.h"
+#include "calculators/cuda/rotater/rotate_pipeline_cpu.h"
+
+namespace {
+constexpr std::size_t rows_per_task = 16;
+
+// output pixels per side of a block of the turning orientations. the
+// source columns of a block, 64 rows of up to 192 bytes, stay in the L1
+// cache while it is written.
+constexpr std::size_t block_pixels = 64;
+
+// calls fn(y) for every row, rows_per_task rows per task
+template <typename F> void for_rows(std::size_t height, F &&fn) {
+  const std::size_t tasks = (height + rows_per_task - 1) / rows_per_task;
+  ThreadPool::shared().parallel_for(tasks, [&](std::size_t t) {
+    const std::size_t end = std::min(height, (t + 1) * rows_per_task);
+    for (std::size_t y = t * rows_per_task; y < end; ++y)
+      fn(y);
+  });
+}
+
+// the pixels [x0, x1) x [y0, y1) of the output one by one
+template <int N>
+void orient_pixels(unsigned char *dst, std::size_t dst_pitch,
+                   const unsigned char *src, std::size_t src_pitch,
+                   std::size_t width, std::size_t height,
+                   Orientation orientation, std::size_t x0, std::size_t x1,
+                   std::size_t y0, std::size_t y1) {
+  for (std::size_t y = y0; y < y1; ++y) {
+    unsigned char *row = dst + y * dst_pitch;
+    for (std::size_t x = x0; x < x1; ++x) {
+      int sx, sy;
+      orient_source(orientation, static_cast<int>(width),
+                    static_cast<int>(height), static_cast<int>(x),
+                    static_cast<int>(y), sx, sy);
+      std::memcpy(row + N * x, src + sy * src_pitch + N * sx, N);
+    }
+  }
+}
+
+// writes the pixels of source from right to left into row. the shuffles
+// reverse the pixels of a register and keep the bytes of each in order,
+// whatever they leave at the end of the row goes pixel by pixel.
+template <int N>
+void mirror_row(unsigned char *row, const unsigned char *source,
+                std::size_t width) {
+  std::size_t x = 0;
+#if defined(__SSSE3__)
+  if constexpr (N <= 2) {
+    constexpr std::size_t count = 16 / N;
+    // byte i of a lane takes the pixel of byte 16 - N - i
+    const __m128i reverse =
+        N == 1 ? _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3,
+                               2, 1, 0)
+               : _mm_setr_epi8(14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2,
+                               3, 0, 1);
+#if defined(__AVX2__)
+    const __m256i reverse2 = _mm256_broadcastsi128_si256(reverse);
+    for (; x + 2 * count <= width; x += 2 * count) {
+      const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(
+          source + N * (width - 2 * count - x)));
+      _mm256_storeu_si256(
+          reinterpret_cast<__m256i *>(row + N * x),
+          _mm256_permute4x64_epi64(_mm256_shuffle_epi8(v, reverse2), 0x4e));
+    }
+#endif
+    for (; x + count <= width; x += count) {
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(
+          source + N * (width - count - x)));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(row + N * x),
+                       _mm_shuffle_epi8(v, reverse));
+    }
+  } else {
+    // 5 pixels of 3 bytes per register. the load starts a byte early and
+    // the store writes a byte of the next pixel, which is written again
+    // after it, so both stay inside the row.
+    const __m128i reverse = _mm_setr_epi8(13, 14, 15, 10, 11, 12, 7, 8, 9, 4,
+                                          5, 6, 1, 2, 3, 0);
+    for (; x + 6 <= width; x += 5) {
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(
+          source + 3 * (width - 5 - x) - 1));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(row + 3 * x),
+                       _mm_shuffle_epi8(v, reverse));
+    }
+  }
+#endif
+  for (; x < width; ++x)
+    std::memcpy(row + N * x, source + N * (width - 1 - x), N);
+}
+
+// swaps pixel x of row a with pixel width - 1 - x of row b for x < count,
+// the same shuffles as mirror_row() reverse both sides. a and b may be the
+// same row for count <= width / 2. the 3 byte registers carry a byte of a
+// pixel outside of the 5 they swap, it is blended back from the load.
+template <int N>
+void swap_mirrored(unsigned char *a, unsigned char *b, std::size_t width,
+                   std::size_t count) {
+  std::size_t x = 0;
+#if defined(__SSSE3__)
+  if constexpr (N <= 2) {
+    constexpr std::size_t lanes = 16 / N;
+    const __m128i reverse =
+        N == 1 ? _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3,
+                               2, 1, 0)
+               : _mm_setr_epi8(14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2,
+                               3, 0, 1);
+#if defined(__AVX2__)
+    const __m256i reverse2 = _mm256_broadcastsi128_si256(reverse);
+    for (; x + 2 * lanes <= count; x += 2 * lanes) {
+      auto *left = reinterpret_cast<__m256i *>(a + N * x);
+      auto *right =
+          reinterpret_cast<__m256i *>(b + N * (width - 2 * lanes - x));
+      const __m256i l = _mm256_loadu_si256(left);
+      const __m256i r = _mm256_loadu_si256(right);
+      _mm256_storeu_si256(left, _mm256_permute4x64_epi64(
+                                    _mm256_shuffle_epi8(r, reverse2), 0x4e));
+      _mm256_storeu_si256(right, _mm256_permute4x64_epi64(
+                                     _mm256_shuffle_epi8(l, reverse2), 0x4e));
+    }
+#endif
+    for (; x + lanes <= count; x += lanes) {
+      auto *left = reinterpret_cast<__m128i *>(a + N * x);
+      auto *right = reinterpret_cast<__m128i *>(b + N * (width - lanes - x));
+      const __m128i l = _mm_loadu_si128(left);
+      const __m128i r = _mm_loadu_si128(right);
+      _mm_storeu_si128(left, _mm_shuffle_epi8(r, reverse));
+      _mm_storeu_si128(right, _mm_shuffle_epi8(l, reverse));
+    }
+  } else {
+    // the left register holds pixels x to x + 4 and the first byte of
+    // x + 5, the right one the last byte of width - 6 - x and the pixels
+    // width - 5 - x to width - 1 - x
+    const __m128i to_left = _mm_setr_epi8(13, 14, 15, 10, 11, 12, 7, 8, 9, 4,
+                                          5, 6, 1, 2, 3, -1);
+    const __m128i to_right = _mm_setr_epi8(-1, 12, 13, 14, 9, 10, 11, 6, 7,
+                                           8, 3, 4, 5, 0, 1, 2);
+    const __m128i left_kept = _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                            0, 0, 0, 0, -1);
+    const __m128i right_kept = _mm_setr_epi8(-1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                             0, 0, 0, 0, 0);
+    for (; x + 5 <= count && x + 6 <= width &&
+           (a != b || 6 * x + 32 <= 3 * width);
+         x += 5) {
+      auto *left = reinterpret_cast<__m128i *>(a + 3 * x);
+      auto *right =
+          reinterpret_cast<__m128i *>(b + 3 * (width - 5 - x) - 1);
+      const __m128i l = _mm_loadu_si128(left);
+      const __m128i r = _mm_loadu_si128(right);
+      _mm_storeu_si128(left, _mm_or_si128(_mm_shuffle_epi8(r, to_left),
+                                          _mm_and_si128(l, left_kept)));
+      _mm_storeu_si128(right, _mm_or_si128(_mm_shuffle_epi8(l, to_right),
+                                           _mm_and_si128(r, right_kept)));
+    }
+  }
+#endif
+  for (; x < count; ++x) {
+    unsigned char *p = a + N * x;
+    unsigned char *q = b + N * (width - 1 - x);
+    for (int k = 0; k < N; ++k)
+      std::swap(p[k], q[k]);
+  }
+}
+
+#if defined(__SSE2__)
+// transposes 16 rows of 16 / N pixels of N bytes. every round interleaves
+// row i with row i + 8 into rows 2i and 2i + 1, after log2(16 / N) rounds
+// row i holds column i.
+template <int N> void transpose_registers(__m128i *rows) {
+  constexpr int count = 16 / N;
+  for (int step = 1; step < count; step *= 2) {
+    __m128i t[count];
+    for (int i = 0; i < count / 2; ++i) {
+      const __m128i a = rows[i];
+      const __m128i b = rows[i + count / 2];
+      t[2 * i] = N == 1 ? _mm_unpacklo_epi8(a, b) : _mm_unpacklo_epi16(a, b);
+      t[2 * i + 1] =
+          N == 1 ? _mm_unpackhi_epi8(a, b) : _mm_unpackhi_epi16(a, b);
+    }
+    std::copy(t, t + count, rows);
+  }
+}
+
+// the 16 / N x 16 / N pixels of the output at (x0, y0) of a turning
+// orientation: output column x0 + i comes from source row sy_i and output
+// row y0 + j from source column sx_j, so the source rows are loaded in the
+// order of the output columns and the transposed registers stored in that
+// of the output rows.
+template <int N>
+void orient_registers(unsigned char *dst, std::size_t dst_pitch,
+                      const unsigned char *src, std::size_t src_pitch,
+                      int width, int height, Orientation orientation, int x0,
+                      int y0) {
+  constexpr int count = 16 / N;
+  __m128i rows[count];
+  int sx_first, sx_last, sy;
+  orient_source(orientation, width, height, x0, y0, sx_first, sy);
+  orient_source(orientation, width, height, x0, y0 + count - 1, sx_last, sy);
+  const int sx0 = std::min(sx_first, sx_last);
+  for (int i = 0; i < count; ++i) {
+    int sx;
+    orient_source(orientation, width, height, x0 + i, y0, sx, sy);
+    rows[i] = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(src + sy * src_pitch + N * sx0));
+  }
+  transpose_registers<N>(rows);
+  for (int j = 0; j < count; ++j) {
+    int sx;
+    orient_source(orientation, width, height, x0, y0 + j, sx, sy);
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i *>(dst + (y0 + j) * dst_pitch + N * x0),
+        rows[sx - sx0]);
+  }
+}
+#endif
+
+// the block [x0, x1) x [y0, y1) of the output of a turning orientation
+template <int N>
+void orient_block(unsigned char *dst, std::size_t dst_pitch,
+                  const unsigned char *src, std::size_t src_pitch,
+                  std::size_t width, std::size_t height,
+                  Orientation orientation, std::size_t x0, std::size_t x1,
+                  std::size_t y0, std::size_t y1) {
+#if defined(__SSE2__)
+  if constexpr (N <= 2) {
+    constexpr std::size_t count = 16 / N;
+    const std::size_t x_end = x0 + (x1 - x0) / count * count;
+    const std::size_t y_end = y0 + (y1 - y0) / count * count;
+    for (std::size_t y = y0; y < y_end; y += count)
+      for (std::size_t x = x0; x < x_end; x += count)
+        orient_registers<N>(dst, dst_pitch, src, src_pitch,
+                            static_cast<int>(width), static_cast<int>(height),
+                            orientation, static_cast<int>(x),
+                            static_cast<int>(y));
+    orient_pixels<N>(dst, dst_pitch, src, src_pitch, width, height,
+                     orientation, x_end, x1, y0, y_end);
+    y0 = y_end;
+  }
+#endif
+  orient_pixels<N>(dst, dst_pitch, src, src_pitch, width, height,
+                   orientation, x0, x1, y0, y1);
+}
+
+template <int N>
+void orient(unsigned char *dst, std::size_t dst_pitch,
+            const unsigned char *src, std::size_t src_pitch,
+            std::size_t width, std::size_t height, Orientation orientation) {
+  if (!swaps_axes(orientation)) {
+    // rows stay rows
+    const bool mirrored = orientation == Orientation::flip_horizontal ||
+                          orientation == Orientation::rotate180;
+    const bool upside_down = orientation == Orientation::flip_vertical ||
+                             orientation == Orientation::rotate180;
+    for_rows(height, [&](std::size_t y) {
+      unsigned char *row = dst + y * dst_pitch;
+      const unsigned char *source =
+          src + (upside_down ? height - 1 - y : y) * src_pitch;
+      if (mirrored)
+        mirror_row<N>(row, source, width);
+      else
+        std::memcpy(row, source, N * width);
+    });
+    return;
+  }
+
+  const std::size_t out_width = height;
+  const std::size_t out_height = width;
+  const std::size_t blocks_x = (out_width + block_pixels - 1) / block_pixels;
+  const std::size_t blocks_y = (out_height + block_pixels - 1) / block_pixels;
+  ThreadPool::shared().parallel_for(blocks_x * blocks_y, [&](std::size_t b) {
+    const std::size_t x0 = b % blocks_x * block_pixels;
+    const std::size_t y0 = b / blocks_x * block_pixels;
+    orient_block<N>(dst, dst_pitch, src, src_pitch, width, height,
+                    orientation, x0, std::min(out_width, x0 + block_pixels),
+                    y0, std::min(out_height, y0 + block_pixels));
+  });
+}
+
+template <int N>
+void flip_in_place(unsigned char *frame, std::size_t pitch,
+                   std::size_t width, std::size_t height,
+                   Orientation orientation) {
+  const bool mirrored = orientation == Orientation::flip_horizontal ||
+                        orientation == Orientation::rotate180;
+  const bool upside_down = orientation == Orientation::flip_vertical ||
+                           orientation == Orientation::rotate180;
+  if (!upside_down) {
+    if (mirrored)
+      for_rows(height, [&](std::size_t y) {
+        unsigned char *row = frame + y * pitch;
+        swap_mirrored<N>(row, row, width, width / 2);
+      });
+    return;
+  }
+
+  // row y trades places with row height - 1 - y, the middle row of an odd
+  // plane only turns around
+  for_rows((height + 1) / 2, [&](std::size_t y) {
+    unsigned char *a = frame + y * pitch;
+    unsigned char *b = frame + (height - 1 - y) * pitch;
+    if (a == b)
+      swap_mirrored<N>(a, a, width, mirrored ? width / 2 : 0);
+    else if (mirrored)
+      swap_mirrored<N>(a, b, width, width);
+    else
+      std::swap_ranges(a, a + N * width, b);
+  });
+}
+} // namespace
+
+namespace cpu {
+void orient_plane(unsigned char *dst, std::size_t dst_pitch,
+                  const unsigned char *src, std::size_t src_pitch,
+                  std::size_t width, std::size_t height,
+                  std::size_t pixel_size, Orientation orientation) {
+  switch (pixel_size) {
+  case 1:
+    orient<1>(dst, dst_pitch, src, src_pitch, width, height, orientation);
+    break;
+  case 2:
+    orient<2>(dst, dst_pitch, src, src_pitch, width, height, orientation);
+    break;
+  case 3:
+    orient<3>(dst, dst_pitch, src, src_pitch, width, height, orientation);
+    break;
+  }
+}
+
+void flip_plane_in_place(unsigned char *frame, std::size_t pitch,
+                         std::size_t width, std::size_t height,
+                         std::size_t pixel_size, Orientation orientation) {
+  switch (pixel_size) {
+  case 1:
+    flip_in_place<1>(frame, pitch, width, height, orientation);
+    break;
+  case 2:
+    flip_in_place<2>(frame, pitch, width, height, orientation);
+    break;
+  case 3:
+    flip_in_place<3>(frame, pitch, width, height, orientation);
+    break;
+  }
+}
+} // namespace cpu
@@ -0,0 +1,54 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef INCLUDED_ROTATE_PIPELINE_CPU
+#define INCLUDED_ROTATE_PIPELINE_CPU
+
+#pragma once
+
+#include <cstddef>
+
+#include "calculators/cuda/rotater/orientation.h"
+
+// host implementations of the kernels in rotate_pipeline.cu, spread over
+// ThreadPool::shared()
+namespace cpu {
+// orients a width x height plane of pixel_size byte pixels, 1 to 3, into
+// dst in one pass. rows that stay rows are copied or mirrored with byte
+// shuffles where the target supports SSSE3. the output of the turning
+// orientations is cut into blocks that stay in the cache, 1 and 2 byte
+// pixels transpose 16 x 16 bytes in registers where it supports SSE2.
+void orient_plane(unsigned char *dst, std::size_t dst_pitch,
+                  const unsigned char *src, std::size_t src_pitch,
+                  std::size_t width, std::size_t height,
+                  std::size_t pixel_size, Orientation orientation);
+
+// flips a plane in place, every worker swapping pairs of mirrored rows or
+// pixels. orientation must keep the rows rows, identity leaves the plane
+// alone.
+void flip_plane_in_place(unsigned char *frame, std::size_t pitch,
+                         std::size_t width, std::size_t height,
+                         std::size_t pixel_size, Orientation orientation);
+} // namespace cpu
+
+#endif // INCLUDED_ROTATE_PIPELINE_CPU
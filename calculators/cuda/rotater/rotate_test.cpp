@@ -0,0 +1,191 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <cuda_runtime_api.h>
+#include <gtest/gtest.h>
+
+#include "calculators/cuda/rotater/ImageRotator.h"
+#include "calculators/cuda/rotater/orientation.h"
+
+namespace {
+struct TestPlane {
+  std::size_t row;
+  unsigned int width;
+  unsigned int height;
+  unsigned int pixel_size;
+};
+
+std::vector<TestPlane> test_planes(RotateFormat format, unsigned int width,
+                                   unsigned int height) {
+  switch (format) {
+  case RotateFormat::bgr24:
+    return {{0, width, height, 3}};
+  case RotateFormat::gray8:
+    return {{0, width, height, 1}};
+  case RotateFormat::nv12:
+    return {{0, width, height, 1}, {height, width / 2, height / 2, 2}};
+  }
+  return {};
+}
+
+std::size_t test_row_size(RotateFormat format, unsigned int width) {
+  return format == RotateFormat::bgr24 ? 3 * std::size_t{width} : width;
+}
+
+std::size_t test_rows(RotateFormat format, unsigned int height) {
+  return format == RotateFormat::nv12 ? height + height / 2 : height;
+}
+
+// frame oriented pixel by pixel through orient_source(), the padding of the
+// rows that of frame
+std::vector<std::uint8_t> reference(const std::vector<std::uint8_t> &frame,
+                                    std::size_t pitch, RotateFormat format,
+                                    unsigned int width, unsigned int height,
+                                    Orientation orientation) {
+  std::vector<std::uint8_t> out = frame;
+  for (const TestPlane &plane : test_planes(format, width, height)) {
+    for (unsigned int y = 0; y < plane.height; ++y) {
+      for (unsigned int x = 0; x < plane.width; ++x) {
+        int sx, sy;
+        orient_source(orientation, plane.width, plane.height, x, y, sx, sy);
+        for (unsigned int b = 0; b < plane.pixel_size; ++b)
+          out[(plane.row + y) * pitch + x * plane.pixel_size + b] =
+              frame[(plane.row + sy) * pitch + sx * plane.pixel_size + b];
+      }
+    }
+  }
+  return out;
+}
+
+bool has_cuda_device() {
+  int count = 0;
+  return cudaGetDeviceCount(&count) == cudaSuccess && count > 0;
+}
+
+const Orientation flips[] = {Orientation::identity,
+                             Orientation::flip_horizontal,
+                             Orientation::flip_vertical,
+                             Orientation::rotate180};
+
+// odd and even sizes from 1 upward, and some past the vector widths of
+// both backends
+const unsigned int sizes[] = {1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11,
+                              13, 15, 16, 17, 31, 33, 63, 65, 97, 130, 257};
+
+const std::size_t pads[] = {0, 1, 3, 64};
+
+// flips frames of every size in place and compares them with process()
+// and the reference. device flips the frames in device memory.
+void check_in_place(RotateFormat format, RotateBackend backend,
+                    bool device = false) {
+  std::mt19937 random(7);
+  for (unsigned int width : sizes) {
+    for (unsigned int height : sizes) {
+      if (format == RotateFormat::nv12 && (width % 2 || height % 2))
+        continue;
+      ImageRotator rotator =
+          backend == RotateBackend::cuda
+              ? ImageRotator(width, height, format)
+              : ImageRotator(width, height, format, RotateBackend::cpu);
+      for (std::size_t pad : pads) {
+        const std::size_t pitch = test_row_size(format, width) + pad;
+        std::vector<std::uint8_t> frame(pitch * test_rows(format, height));
+        for (std::uint8_t &byte : frame)
+          byte = static_cast<std::uint8_t>(random());
+
+        for (Orientation orientation : flips) {
+          SCOPED_TRACE(::testing::Message()
+                       << width << "x" << height << " pitch " << pitch
+                       << " orientation " << static_cast<int>(orientation));
+          const std::vector<std::uint8_t> expected =
+              reference(frame, pitch, format, width, height, orientation);
+
+          std::vector<std::uint8_t> copied = frame;
+          rotator.process(frame.data(), pitch, copied.data(), pitch,
+                          orientation);
+          EXPECT_EQ(copied, expected);
+
+          std::vector<std::uint8_t> flipped = frame;
+          if (device) {
+            void *d_frame = nullptr;
+            ASSERT_EQ(cudaMalloc(&d_frame, flipped.size()), cudaSuccess);
+            cudaMemcpy(d_frame, flipped.data(), flipped.size(),
+                       cudaMemcpyHostToDevice);
+            rotator.processInPlace(static_cast<std::uint8_t *>(d_frame),
+                                   pitch, orientation);
+            cudaMemcpy(flipped.data(), d_frame, flipped.size(),
+                       cudaMemcpyDeviceToHost);
+            cudaFree(d_frame);
+          } else {
+            rotator.processInPlace(flipped.data(), pitch, orientation);
+          }
+          EXPECT_EQ(flipped, expected);
+        }
+      }
+    }
+  }
+}
+} // namespace
+
+TEST(ImageRotatorInPlace, CpuBgr24) {
+  check_in_place(RotateFormat::bgr24, RotateBackend::cpu);
+}
+
+TEST(ImageRotatorInPlace, CpuGray8) {
+  check_in_place(RotateFormat::gray8, RotateBackend::cpu);
+}
+
+TEST(ImageRotatorInPlace, CpuNv12) {
+  check_in_place(RotateFormat::nv12, RotateBackend::cpu);
+}
+
+TEST(ImageRotatorInPlace, CpuRejectsTurns) {
+  ImageRotator rotator(4, 2, RotateFormat::gray8, RotateBackend::cpu);
+  std::vector<std::uint8_t> frame(8);
+  for (Orientation orientation :
+       {Orientation::rotate90, Orientation::rotate270,
+        Orientation::transpose, Orientation::transverse})
+    EXPECT_THROW(rotator.processInPlace(frame.data(), 4, orientation),
+                 std::invalid_argument);
+}
+
+TEST(ImageRotatorInPlace, CudaHostMemory) {
+  if (!has_cuda_device())
+    GTEST_SKIP() << "no CUDA device";
+  check_in_place(RotateFormat::bgr24, RotateBackend::cuda);
+  check_in_place(RotateFormat::gray8, RotateBackend::cuda);
+  check_in_place(RotateFormat::nv12, RotateBackend::cuda);
+}
+
+TEST(ImageRotatorInPlace, CudaDeviceMemory) {
+  if (!has_cuda_device())
+    GTEST_SKIP() << "no CUDA device";
+  check_in_place(RotateFormat::bgr24, RotateBackend::cuda, true);
+  check_in_place(RotateFormat::gray8, RotateBackend::cuda, true);
+  check_in_place(RotateFormat::nv12, RotateBackend::cuda, true);
+}
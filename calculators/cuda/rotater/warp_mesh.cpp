@@ -0,0 +1,101 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "calculators/cuda/rotater/warp_mesh.h"
+
+namespace {
+// nodes along a side of length pixels, the last one on or beyond the last
+// pixel
+unsigned int mesh_nodes(unsigned int pixels, unsigned int cell) {
+  return (pixels > 0 ? (pixels - 1) / cell : 0) + 2;
+}
+} // namespace
+
+WarpMesh::WarpMesh(unsigned int width, unsigned int height, unsigned int cell)
+    : cell(cell) {
+  if (cell == 0)
+    throw std::invalid_argument("mesh cells must not be empty");
+  columns = mesh_nodes(width, cell);
+  rows = mesh_nodes(height, cell);
+  points.resize(std::size_t{columns} * rows);
+  for (unsigned int j = 0; j < rows; ++j)
+    for (unsigned int i = 0; i < columns; ++i)
+      at(i, j) = {static_cast<float>(i * cell), static_cast<float>(j * cell)};
+}
+
+bool WarpMesh::covers(unsigned int width, unsigned int height) const {
+  return cell > 0 && columns >= 2 && rows >= 2 &&
+         points.size() == std::size_t{columns} * rows &&
+         std::size_t{columns - 1} * cell + 1 >= width &&
+         std::size_t{rows - 1} * cell + 1 >= height;
+}
+
+WarpMesh lens_mesh(const LensModel &model, unsigned int width,
+                   unsigned int height, unsigned int cell) {
+  if (model.fx == 0.0f || model.fy == 0.0f)
+    throw std::invalid_argument("the focal lengths must not be 0");
+
+  WarpMesh mesh(width, height, cell);
+  for (unsigned int j = 0; j < mesh.rows; ++j) {
+    for (unsigned int i = 0; i < mesh.columns; ++i) {
+      // the ray of the node in normalized camera coordinates, distorted
+      const double x = (static_cast<double>(i) * cell - model.cx) / model.fx;
+      const double y = (static_cast<double>(j) * cell - model.cy) / model.fy;
+      const double r2 = x * x + y * y;
+      const double radial =
+          1.0 + r2 * (model.k1 + r2 * (model.k2 + r2 * model.k3));
+      const double xd = x * radial + 2.0 * model.p1 * x * y +
+                        model.p2 * (r2 + 2.0 * x * x);
+      const double yd = y * radial + model.p1 * (r2 + 2.0 * y * y) +
+                        2.0 * model.p2 * x * y;
+      mesh.at(i, j) = {static_cast<float>(xd * model.fx + model.cx),
+                       static_cast<float>(yd * model.fy + model.cy)};
+    }
+  }
+  return mesh;
+}
+
+std::shared_ptr<const WarpMesh>
+WarpMeshCache::lensMesh(const LensModel &model, unsigned int width,
+                        unsigned int height, unsigned int cell) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto hit = std::find_if(entries.begin(), entries.end(), [&](const Entry &e) {
+    return e.model == model && e.width == width && e.height == height &&
+           e.cell == cell;
+  });
+  if (hit != entries.end()) {
+    std::rotate(hit, hit + 1, entries.end());
+    return entries.back().mesh;
+  }
+
+  if (entries.size() >= capacity && !entries.empty())
+    entries.erase(entries.begin());
+  entries.push_back({model, width, height, cell,
+                     std::make_shared<const WarpMesh>(
+                         lens_mesh(model, width, height, cell))});
+  return entries.back().mesh;
+}
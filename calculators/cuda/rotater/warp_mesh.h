@@ -0,0 +1,131 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef INCLUDED_WARP_MESH
+#define INCLUDED_WARP_MESH
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// the source position of a node of a mesh in pixels of the source frame,
+// pixel centers at whole numbers
+struct MeshPoint {
+  float x;
+  float y;
+};
+
+// a geometric mapping of frames given at the nodes of a grid of square
+// cells. node (i, j) sits on output pixel (i * cell, j * cell) and holds
+// its source position, the positions of the pixels in between are
+// interpolated bilinearly from the 4 nodes of their cell. the last row and
+// column of nodes lie on or beyond the last pixels of the frame.
+struct WarpMesh {
+  unsigned int cell = 32;
+  unsigned int columns = 0;
+  unsigned int rows = 0;
+  std::vector<MeshPoint> points;
+
+  // the identity mapping for width x height frames, to be changed node by
+  // node
+  WarpMesh(unsigned int width, unsigned int height, unsigned int cell = 32);
+
+  MeshPoint &at(unsigned int i, unsigned int j) {
+    return points[std::size_t{j} * columns + i];
+  }
+  const MeshPoint &at(unsigned int i, unsigned int j) const {
+    return points[std::size_t{j} * columns + i];
+  }
+
+  // whether the nodes reach the last pixels of width x height frames
+  bool covers(unsigned int width, unsigned int height) const;
+};
+
+// a pinhole camera with polynomial radial (k1, k2, k3) and tangential
+// (p1, p2) distortion. the focal lengths and the principal point are in
+// pixels.
+struct LensModel {
+  float fx = 1.0f;
+  float fy = 1.0f;
+  float cx = 0.0f;
+  float cy = 0.0f;
+  float k1 = 0.0f;
+  float k2 = 0.0f;
+  float k3 = 0.0f;
+  float p1 = 0.0f;
+  float p2 = 0.0f;
+
+  bool operator==(const LensModel &other) const {
+    return fx == other.fx && fy == other.fy && cx == other.cx &&
+           cy == other.cy && k1 == other.k1 && k2 == other.k2 &&
+           k3 == other.k3 && p1 == other.p1 && p2 == other.p2;
+  }
+};
+
+// the mesh that corrects the distortion of model in width x height frames:
+// every node of the undistorted output holds the position its ray hits the
+// distorted source frame at
+WarpMesh lens_mesh(const LensModel &model, unsigned int width,
+                   unsigned int height, unsigned int cell = 32);
+
+// the lens meshes made last, so that warpers of the same camera and frame
+// size share one mesh that is computed once
+class WarpMeshCache {
+  struct Entry {
+    LensModel model;
+    unsigned int width;
+    unsigned int height;
+    unsigned int cell;
+    std::shared_ptr<const WarpMesh> mesh;
+  };
+
+  std::mutex mutex;
+  // the least recently used first
+  std::vector<Entry> entries;
+  const std::size_t capacity;
+
+public:
+  explicit WarpMeshCache(std::size_t capacity = 8) : capacity(capacity) {}
+
+  WarpMeshCache(const WarpMeshCache &) = delete;
+  WarpMeshCache &operator=(const WarpMeshCache &) = delete;
+
+  // the mesh of lens_mesh(model, width, height, cell), made if it is not
+  // among the last capacity ones
+  std::shared_ptr<const WarpMesh> lensMesh(const LensModel &model,
+                                           unsigned int width,
+                                           unsigned int height,
+                                           unsigned int cell = 32);
+
+  // the cache of the process
+  static WarpMeshCache &shared() {
+    static WarpMeshCache cache;
+    return cache;
+  }
+};
+
+#endif // INCLUDED_WARP_MESH
@@ -0,0 +1,94 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <cstddef>
+
+#include <cuda_runtime_api.h>
+
+#include "calculators/cuda/hdr/framework/CUDA/error.h"
+
+#include "calculators/cuda/rotater/warp_sample.h"
+
+namespace {
+constexpr int block_width = 32;
+constexpr int block_height = 8;
+
+unsigned int divup(unsigned int a, unsigned int b) {
+  return (a + b - 1) / b;
+}
+} // namespace
+
+// warps a plane of N byte pixels into one of the same size, a pixel per
+// thread. the position of the pixel is interpolated from the mesh right
+// here, the nodes a block needs stay in the L1 cache, so no map of the
+// positions of all pixels is read.
+template <int N, WarpInterpolation interpolation>
+__global__ void warp_kernel(unsigned char *dst, std::size_t dst_pitch,
+                            WarpSource source, MeshView mesh) {
+  const int x = blockIdx.x * blockDim.x + threadIdx.x;
+  const int y = blockIdx.y * blockDim.y + threadIdx.y;
+  if (x >= source.width || y >= source.height)
+    return;
+
+  unsigned char pixel[N];
+  warp_pixel<N, interpolation>(source, mesh, x, y, pixel);
+  unsigned char *out = dst + y * dst_pitch + N * x;
+  for (int c = 0; c < N; ++c)
+    out[c] = pixel[c];
+}
+
+namespace {
+template <int N>
+void launch_warp(unsigned char *dst, std::size_t dst_pitch,
+                 const WarpSource &source, const MeshView &mesh,
+                 WarpInterpolation interpolation, cudaStream_t stream) {
+  const dim3 block(block_width, block_height);
+  const dim3 grid(divup(source.width, block_width),
+                  divup(source.height, block_height));
+  if (interpolation == WarpInterpolation::bilinear)
+    warp_kernel<N, WarpInterpolation::bilinear>
+        <<<grid, block, 0, stream>>>(dst, dst_pitch, source, mesh);
+  else
+    warp_kernel<N, WarpInterpolation::bicubic>
+        <<<grid, block, 0, stream>>>(dst, dst_pitch, source, mesh);
+}
+} // namespace
+
+void warp_plane(unsigned char *dst, std::size_t dst_pitch,
+                const WarpSource &source, unsigned int pixel_size,
+                const MeshView &mesh, WarpInterpolation interpolation,
+                cudaStream_t stream) {
+  switch (pixel_size) {
+  case 1:
+    launch_warp<1>(dst, dst_pitch, source, mesh, interpolation, stream);
+    break;
+  case 2:
+    launch_warp<2>(dst, dst_pitch, source, mesh, interpolation, stream);
+    break;
+  case 3:
+    launch_warp<3>(dst, dst_pitch, source, mesh, interpolation, stream);
+    break;
+  }
+  throw_error(cudaGetLastError());
+}
@@ -0,0 +1,165 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "calculators/cuda/hdr/framework/thread_pool.h"
+
+#include "calculators/cuda/rotater/warp_pipeline_cpu.h"
+#include "calculators/cuda/rotater/warp_sample.h"
+
+namespace {
+// output pixels per side of the tiles to start with and of the smallest
+// ones, whatever their source
+constexpr int tile_pixels = 128;
+constexpr int min_tile_pixels = 16;
+
+// source bytes a tile may read, half of a small L2 cache, the other half
+// being left to the output and the mesh
+constexpr std::size_t source_budget = 256 * 1024;
+
+struct Tile {
+  int x0;
+  int y0;
+  int x1;
+  int y1;
+};
+
+// the bytes of the source rows the pixels of tile read. the positions are
+// bilinear between the nodes of the cells the tile covers, so they lie in
+// the box around those nodes, widened by the taps of the filter.
+std::size_t source_bytes(const WarpSource &source, const MeshView &mesh,
+                         std::size_t pixel_size, int taps, const Tile &tile) {
+  const float scale = static_cast<float>(source.subsampling);
+  auto node = [&](int pixel, int nodes) {
+    const float position = (pixel + 0.5f) * scale - 0.5f;
+    return std::clamp(static_cast<int>(position / mesh.cell), 0, nodes - 2);
+  };
+  const int i0 = node(tile.x0, mesh.columns);
+  const int i1 = node(tile.x1 - 1, mesh.columns) + 1;
+  const int j0 = node(tile.y0, mesh.rows);
+  const int j1 = node(tile.y1 - 1, mesh.rows) + 1;
+
+  float min_x = INFINITY;
+  float min_y = INFINITY;
+  float max_x = -INFINITY;
+  float max_y = -INFINITY;
+  for (int j = j0; j <= j1; ++j) {
+    for (int i = i0; i <= i1; ++i) {
+      const MeshPoint &p = mesh.points[j * mesh.columns + i];
+      min_x = std::fmin(min_x, p.x);
+      min_y = std::fmin(min_y, p.y);
+      max_x = std::fmax(max_x, p.x);
+      max_y = std::fmax(max_y, p.y);
+    }
+  }
+
+  auto plane = [scale](float v) { return (v + 0.5f) / scale - 0.5f; };
+  const float x0 = std::fmax(std::floor(plane(min_x)) - taps, 0.0f);
+  const float y0 = std::fmax(std::floor(plane(min_y)) - taps, 0.0f);
+  const float x1 = std::fmin(std::floor(plane(max_x)) + taps,
+                             source.width - 1.0f);
+  const float y1 = std::fmin(std::floor(plane(max_y)) + taps,
+                             source.height - 1.0f);
+  if (!(x0 <= x1 && y0 <= y1))
+    return 0;
+  // a cache line more per row for the row starting somewhere inside one
+  return static_cast<std::size_t>(y1 - y0 + 1) *
+         (static_cast<std::size_t>(x1 - x0 + 1) * pixel_size + 64);
+}
+
+// tile, or its quarters, or theirs, until their sources fit the budget
+void split_tile(const WarpSource &source, const MeshView &mesh,
+                std::size_t pixel_size, int taps, const Tile &tile,
+                std::vector<Tile> &tiles) {
+  const int width = tile.x1 - tile.x0;
+  const int height = tile.y1 - tile.y0;
+  if ((width <= min_tile_pixels && height <= min_tile_pixels) ||
+      source_bytes(source, mesh, pixel_size, taps, tile) <= source_budget) {
+    tiles.push_back(tile);
+    return;
+  }
+
+  const int xm = width > min_tile_pixels ? tile.x0 + width / 2 : tile.x1;
+  const int ym = height > min_tile_pixels ? tile.y0 + height / 2 : tile.y1;
+  for (const Tile &t : {Tile{tile.x0, tile.y0, xm, ym},
+                        Tile{xm, tile.y0, tile.x1, ym},
+                        Tile{tile.x0, ym, xm, tile.y1},
+                        Tile{xm, ym, tile.x1, tile.y1}})
+    if (t.x0 < t.x1 && t.y0 < t.y1)
+      split_tile(source, mesh, pixel_size, taps, t, tiles);
+}
+
+template <int N, WarpInterpolation interpolation>
+void warp(unsigned char *dst, std::size_t dst_pitch, const WarpSource &source,
+          const MeshView &mesh) {
+  const int taps = interpolation == WarpInterpolation::bilinear ? 1 : 2;
+  std::vector<Tile> tiles;
+  for (int y = 0; y < source.height; y += tile_pixels)
+    for (int x = 0; x < source.width; x += tile_pixels)
+      split_tile(source, mesh, N, taps,
+                 {x, y, std::min(x + tile_pixels, source.width),
+                  std::min(y + tile_pixels, source.height)},
+                 tiles);
+
+  ThreadPool::shared().parallel_for(tiles.size(), [&](std::size_t t) {
+    const Tile &tile = tiles[t];
+    for (int y = tile.y0; y < tile.y1; ++y) {
+      unsigned char *row = dst + y * dst_pitch;
+      for (int x = tile.x0; x < tile.x1; ++x)
+        warp_pixel<N, interpolation>(source, mesh, x, y, row + N * x);
+    }
+  });
+}
+
+template <int N>
+void warp(unsigned char *dst, std::size_t dst_pitch, const WarpSource &source,
+          const MeshView &mesh, WarpInterpolation interpolation) {
+  if (interpolation == WarpInterpolation::bilinear)
+    warp<N, WarpInterpolation::bilinear>(dst, dst_pitch, source, mesh);
+  else
+    warp<N, WarpInterpolation::bicubic>(dst, dst_pitch, source, mesh);
+}
+} // namespace
+
+namespace cpu {
+void warp_plane(unsigned char *dst, std::size_t dst_pitch,
+                const WarpSource &source, std::size_t pixel_size,
+                const MeshView &mesh, WarpInterpolation interpolation) {
+  switch (pixel_size) {
+  case 1:
+    warp<1>(dst, dst_pitch, source, mesh, interpolation);
+    break;
+  case 2:
+    warp<2>(dst, dst_pitch, source, mesh, interpolation);
+    break;
+  case 3:
+    warp<3>(dst, dst_pitch, source, mesh, interpolation);
+    break;
+  }
+}
+} // namespace cpu
@@ -0,0 +1,45 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef INCLUDED_WARP_PIPELINE_CPU
+#define INCLUDED_WARP_PIPELINE_CPU
+
+#pragma once
+
+#include <cstddef>
+
+#include "calculators/cuda/rotater/warp_sample.h"
+
+// host implementation of the kernel in warp_pipeline.cu, spread over
+// ThreadPool::shared()
+namespace cpu {
+// warps the plane of source, pixels of pixel_size bytes, into dst of the
+// same size. the output is cut into tiles whose source, the box around the
+// mesh nodes of their cells, fits into the L2 cache of a core.
+void warp_plane(unsigned char *dst, std::size_t dst_pitch,
+                const WarpSource &source, std::size_t pixel_size,
+                const MeshView &mesh, WarpInterpolation interpolation);
+} // namespace cpu
+
+#endif // INCLUDED_WARP_PIPELINE_CPU
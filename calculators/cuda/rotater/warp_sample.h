@@ -0,0 +1,174 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef INCLUDED_WARP_SAMPLE
+#define INCLUDED_WARP_SAMPLE
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+#include "calculators/cuda/rotater/orientation.h"
+#include "calculators/cuda/rotater/warp_mesh.h"
+
+// the filters the source of a warped pixel is sampled with, 2 x 2 and
+// 4 x 4 (Catmull-Rom) pixels around it
+enum class WarpInterpolation { bilinear, bicubic };
+
+// the nodes of a mesh in memory the kernels can read
+struct MeshView {
+  const MeshPoint *points;
+  int columns;
+  int rows;
+  int cell;
+};
+
+// a source plane of pixels of N bytes. the mesh maps the full resolution
+// of the frame, subsampled planes scale its positions. pixels whose source
+// lies outside of the plane are set to fill.
+struct WarpSource {
+  const unsigned char *plane;
+  std::size_t pitch;
+  int width;
+  int height;
+  int subsampling;
+  unsigned char fill;
+};
+
+ROTATE_HOST_DEVICE inline int warp_clamp(int v, int lo, int hi) {
+  return v < lo ? lo : v > hi ? hi : v;
+}
+
+// the source position of the point (x, y) of the output, bilinear between
+// the 4 nodes of its cell. points past the last nodes extrapolate the last
+// cells.
+ROTATE_HOST_DEVICE inline void mesh_source(const MeshView &mesh, float x,
+                                           float y, float &sx, float &sy) {
+  const float gx = x / mesh.cell;
+  const float gy = y / mesh.cell;
+  const int i = warp_clamp(static_cast<int>(gx), 0, mesh.columns - 2);
+  const int j = warp_clamp(static_cast<int>(gy), 0, mesh.rows - 2);
+  const float tx = gx - i;
+  const float ty = gy - j;
+  const MeshPoint *top = mesh.points + j * mesh.columns + i;
+  const MeshPoint *bottom = top + mesh.columns;
+  const float top_x = top[0].x + (top[1].x - top[0].x) * tx;
+  const float top_y = top[0].y + (top[1].y - top[0].y) * tx;
+  const float bottom_x = bottom[0].x + (bottom[1].x - bottom[0].x) * tx;
+  const float bottom_y = bottom[0].y + (bottom[1].y - bottom[0].y) * tx;
+  sx = top_x + (bottom_x - top_x) * ty;
+  sy = top_y + (bottom_y - top_y) * ty;
+}
+
+// the weights of the 4 pixels around a position t of the way from the
+// second to the third, Catmull-Rom
+ROTATE_HOST_DEVICE inline void cubic_weights(float t, float w[4]) {
+  const float t2 = t * t;
+  const float t3 = t2 * t;
+  w[0] = -0.5f * t3 + t2 - 0.5f * t;
+  w[1] = 1.5f * t3 - 2.5f * t2 + 1.0f;
+  w[2] = -1.5f * t3 + 2.0f * t2 + 0.5f * t;
+  w[3] = 0.5f * t3 - 0.5f * t2;
+}
+
+ROTATE_HOST_DEVICE inline unsigned char warp_round(float v) {
+  return static_cast<unsigned char>(v <= 0.0f     ? 0.0f
+                                    : v >= 255.0f ? 255.0f
+                                                  : v + 0.5f);
+}
+
+// the pixel at (sx, sy) of the plane, the taps beyond its edges repeat the
+// edge pixels
+template <int N, WarpInterpolation interpolation>
+ROTATE_HOST_DEVICE inline void sample_pixel(const WarpSource &source,
+                                            float sx, float sy,
+                                            unsigned char *out) {
+  const float fx = floorf(sx);
+  const float fy = floorf(sy);
+  const int x0 = static_cast<int>(fx);
+  const int y0 = static_cast<int>(fy);
+  const float tx = sx - fx;
+  const float ty = sy - fy;
+  const int last_x = source.width - 1;
+  const int last_y = source.height - 1;
+
+  if constexpr (interpolation == WarpInterpolation::bilinear) {
+    const int xa = N * warp_clamp(x0, 0, last_x);
+    const int xb = N * warp_clamp(x0 + 1, 0, last_x);
+    const unsigned char *ra =
+        source.plane + warp_clamp(y0, 0, last_y) * source.pitch;
+    const unsigned char *rb =
+        source.plane + warp_clamp(y0 + 1, 0, last_y) * source.pitch;
+    for (int c = 0; c < N; ++c) {
+      const float top = ra[xa + c] + (ra[xb + c] - ra[xa + c]) * tx;
+      const float bottom = rb[xa + c] + (rb[xb + c] - rb[xa + c]) * tx;
+      out[c] = warp_round(top + (bottom - top) * ty);
+    }
+  } else {
+    float wx[4];
+    float wy[4];
+    cubic_weights(tx, wx);
+    cubic_weights(ty, wy);
+    int xs[4];
+    for (int k = 0; k < 4; ++k)
+      xs[k] = N * warp_clamp(x0 - 1 + k, 0, last_x);
+    float v[N] = {};
+    for (int r = 0; r < 4; ++r) {
+      const unsigned char *row =
+          source.plane + warp_clamp(y0 - 1 + r, 0, last_y) * source.pitch;
+      for (int c = 0; c < N; ++c)
+        v[c] += wy[r] * (wx[0] * row[xs[0] + c] + wx[1] * row[xs[1] + c] +
+                         wx[2] * row[xs[2] + c] + wx[3] * row[xs[3] + c]);
+    }
+    for (int c = 0; c < N; ++c)
+      out[c] = warp_round(v[c]);
+  }
+}
+
+// the pixel (x, y) of the warped plane: its position in the full
+// resolution, the source position the mesh maps it to, the source sampled
+// there
+template <int N, WarpInterpolation interpolation>
+ROTATE_HOST_DEVICE inline void warp_pixel(const WarpSource &source,
+                                          const MeshView &mesh, int x, int y,
+                                          unsigned char *out) {
+  const float scale = static_cast<float>(source.subsampling);
+  float sx, sy;
+  mesh_source(mesh, (x + 0.5f) * scale - 0.5f, (y + 0.5f) * scale - 0.5f, sx,
+              sy);
+  sx = (sx + 0.5f) / scale - 0.5f;
+  sy = (sy + 0.5f) / scale - 0.5f;
+
+  // written so that NaN positions fill as well
+  if (!(sx >= -0.5f && sy >= -0.5f && sx <= source.width - 0.5f &&
+        sy <= source.height - 0.5f)) {
+    for (int c = 0; c < N; ++c)
+      out[c] = source.fill;
+    return;
+  }
+  sample_pixel<N, interpolation>(source, sx, sy, out);
+}
+
+#endif // INCLUDED_WARP_SAMPLE
@@ -0,0 +1,311 @@
+// MIT License
+
+// Copyright (c) 2025 Cui, Xin
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <cuda_runtime_api.h>
+#include <gtest/gtest.h>
+
+#include "calculators/cuda/rotater/ImageWarper.h"
+#include "calculators/cuda/rotater/warp_mesh.h"
+
+namespace {
+struct TestPlane {
+  std::size_t row;
+  unsigned int width;
+  unsigned int height;
+  unsigned int pixel_size;
+  unsigned int subsampling;
+};
+
+std::vector<TestPlane> test_planes(RotateFormat format, unsigned int width,
+                                   unsigned int height) {
+  switch (format) {
+  case RotateFormat::bgr24:
+    return {{0, width, height, 3, 1}};
+  case RotateFormat::gray8:
+    return {{0, width, height, 1, 1}};
+  case RotateFormat::nv12:
+    return {{0, width, height, 1, 1}, {height, width / 2, height / 2, 2, 2}};
+  }
+  return {};
+}
+
+std::size_t test_row_size(RotateFormat format, unsigned int width) {
+  return format == RotateFormat::bgr24 ? 3 * std::size_t{width} : width;
+}
+
+std::size_t test_rows(RotateFormat format, unsigned int height) {
+  return format == RotateFormat::nv12 ? height + height / 2 : height;
+}
+
+bool has_cuda_device() {
+  int count = 0;
+  return cudaGetDeviceCount(&count) == cudaSuccess && count > 0;
+}
+
+std::unique_ptr<ImageWarper> make_warper(unsigned int width,
+                                         unsigned int height,
+                                         RotateFormat format,
+                                         WarpBackend backend) {
+  if (backend == WarpBackend::cuda)
+    return std::make_unique<ImageWarper>(width, height, format);
+  return std::make_unique<ImageWarper>(width, height, format, backend);
+}
+
+const RotateFormat formats[] = {RotateFormat::bgr24, RotateFormat::gray8,
+                                RotateFormat::nv12};
+const WarpInterpolation interpolations[] = {WarpInterpolation::bilinear,
+                                            WarpInterpolation::bicubic};
+
+// the identity mesh of every warper returns the frame as it is
+void check_identity(WarpBackend backend) {
+  const unsigned int sizes[][2] = {{2, 2},   {6, 4},    {31, 17},
+                                   {64, 48}, {130, 34}, {200, 146}};
+  std::mt19937 random(11);
+  for (RotateFormat format : formats) {
+    for (const auto &size : sizes) {
+      const unsigned int width = size[0];
+      const unsigned int height = size[1];
+      if (format == RotateFormat::nv12 && (width % 2 || height % 2))
+        continue;
+      const std::size_t row_size = test_row_size(format, width);
+      const std::size_t pitch = row_size + 5;
+      std::vector<std::uint8_t> frame(pitch * test_rows(format, height));
+      for (std::uint8_t &byte : frame)
+        byte = static_cast<std::uint8_t>(random());
+
+      std::unique_ptr<ImageWarper> warper =
+          make_warper(width, height, format, backend);
+      for (WarpInterpolation interpolation : interpolations) {
+        SCOPED_TRACE(::testing::Message()
+                     << "format " << static_cast<int>(format) << " " << width
+                     << "x" << height << " interpolation "
+                     << static_cast<int>(interpolation));
+        warper->setInterpolation(interpolation);
+        std::vector<std::uint8_t> warped(frame.size());
+        warper->process(frame.data(), pitch, warped.data(), pitch);
+        for (std::size_t y = 0; y < test_rows(format, height); ++y)
+          ASSERT_TRUE(std::equal(frame.begin() + y * pitch,
+                                 frame.begin() + y * pitch + row_size,
+                                 warped.begin() + y * pitch))
+              << "row " << y;
+      }
+    }
+  }
+}
+
+// where the ray through the undistorted pixel (x, y) hits the frame
+void distorted(const LensModel &model, double x, double y, double &sx,
+               double &sy) {
+  const double nx = (x - model.cx) / model.fx;
+  const double ny = (y - model.cy) / model.fy;
+  const double r2 = nx * nx + ny * ny;
+  const double radial =
+      1.0 + r2 * (model.k1 + r2 * (model.k2 + r2 * model.k3));
+  const double dx =
+      nx * radial + 2.0 * model.p1 * nx * ny + model.p2 * (r2 + 2.0 * nx * nx);
+  const double dy =
+      ny * radial + model.p1 * (r2 + 2.0 * ny * ny) + 2.0 * model.p2 * nx * ny;
+  sx = dx * model.fx + model.cx;
+  sy = dy * model.fy + model.cy;
+}
+
+double catmull_rom(double t, int k) {
+  const double t2 = t * t;
+  const double t3 = t2 * t;
+  switch (k) {
+  case 0:
+    return -0.5 * t3 + t2 - 0.5 * t;
+  case 1:
+    return 1.5 * t3 - 2.5 * t2 + 1.0;
+  case 2:
+    return -1.5 * t3 + 2.0 * t2 + 0.5 * t;
+  default:
+    return 0.5 * t3 - 0.5 * t2;
+  }
+}
+
+// the frame corrected for model pixel by pixel in double precision, every
+// source position computed exactly instead of interpolated from a mesh
+std::vector<std::uint8_t>
+dense_reference(const std::vector<std::uint8_t> &frame, std::size_t pitch,
+                RotateFormat format, unsigned int width, unsigned int height,
+                const LensModel &model, WarpInterpolation interpolation) {
+  std::vector<std::uint8_t> out(frame.size());
+  for (const TestPlane &plane : test_planes(format, width, height)) {
+    const double s = plane.subsampling;
+    const int last_x = plane.width - 1;
+    const int last_y = plane.height - 1;
+    auto at = [&](int x, int y, unsigned int c) -> double {
+      x = std::min(std::max(x, 0), last_x);
+      y = std::min(std::max(y, 0), last_y);
+      return frame[(plane.row + y) * pitch + x * plane.pixel_size + c];
+    };
+    for (unsigned int y = 0; y < plane.height; ++y) {
+      for (unsigned int x = 0; x < plane.width; ++x) {
+        double sx, sy;
+        distorted(model, (x + 0.5) * s - 0.5, (y + 0.5) * s - 0.5, sx, sy);
+        sx = (sx + 0.5) / s - 0.5;
+        sy = (sy + 0.5) / s - 0.5;
+        const int x0 = static_cast<int>(std::floor(sx));
+        const int y0 = static_cast<int>(std::floor(sy));
+        const double tx = sx - x0;
+        const double ty = sy - y0;
+        for (unsigned int c = 0; c < plane.pixel_size; ++c) {
+          double v = 0.0;
+          if (interpolation == WarpInterpolation::bilinear) {
+            const double top =
+                (1 - tx) * at(x0, y0, c) + tx * at(x0 + 1, y0, c);
+            const double bottom =
+                (1 - tx) * at(x0, y0 + 1, c) + tx * at(x0 + 1, y0 + 1, c);
+            v = (1 - ty) * top + ty * bottom;
+          } else {
+            for (int r = 0; r < 4; ++r)
+              for (int k = 0; k < 4; ++k)
+                v += catmull_rom(ty, r) * catmull_rom(tx, k) *
+                     at(x0 - 1 + k, y0 - 1 + r, c);
+          }
+          out[(plane.row + y) * pitch + x * plane.pixel_size + c] =
+              static_cast<std::uint8_t>(
+                  std::lround(std::min(std::max(v, 0.0), 255.0)));
+        }
+      }
+    }
+  }
+  return out;
+}
+
+// a lens mesh of small cells corrects a smooth frame to within a level or
+// two of the dense reference. the barrel correction pulls every source
+// inside the frame, so no pixel is filled.
+void check_lens(WarpBackend backend) {
+  const unsigned int width = 160;
+  const unsigned int height = 120;
+  LensModel model;
+  model.fx = model.fy = 128.0f;
+  model.cx = 79.5f;
+  model.cy = 59.5f;
+  model.k1 = -0.2f;
+  model.k2 = 0.05f;
+  model.p1 = 0.001f;
+  model.p2 = -0.001f;
+
+  for (RotateFormat format : formats) {
+    const std::size_t pitch = test_row_size(format, width) + 3;
+    std::vector<std::uint8_t> frame(pitch * test_rows(format, height));
+    for (const TestPlane &plane : test_planes(format, width, height))
+      for (unsigned int y = 0; y < plane.height; ++y)
+        for (unsigned int x = 0; x < plane.width; ++x)
+          for (unsigned int c = 0; c < plane.pixel_size; ++c)
+            frame[(plane.row + y) * pitch + x * plane.pixel_size + c] =
+                static_cast<std::uint8_t>(
+                    128.0 + 100.0 * std::sin((x + 7.0 * c) / 9.0) *
+                                std::cos(y / 7.0));
+
+    std::unique_ptr<ImageWarper> warper =
+        make_warper(width, height, format, backend);
+    warper->setLensModel(model, 8);
+    for (WarpInterpolation interpolation : interpolations) {
+      SCOPED_TRACE(::testing::Message()
+                   << "format " << static_cast<int>(format)
+                   << " interpolation " << static_cast<int>(interpolation));
+      warper->setInterpolation(interpolation);
+      std::vector<std::uint8_t> warped(frame.size());
+      warper->process(frame.data(), pitch, warped.data(), pitch);
+      const std::vector<std::uint8_t> expected = dense_reference(
+          frame, pitch, format, width, height, model, interpolation);
+
+      int worst = 0;
+      for (const TestPlane &plane : test_planes(format, width, height))
+        for (unsigned int y = 0; y < plane.height; ++y)
+          for (std::size_t i = 0; i < plane.width * plane.pixel_size; ++i) {
+            const std::size_t at = (plane.row + y) * pitch + i;
+            worst = std::max(worst, std::abs(warped[at] - expected[at]));
+          }
+      EXPECT_LE(worst, 2);
+    }
+  }
+}
+} // namespace
+
+TEST(ImageWarper, CpuIdentity) { check_identity(WarpBackend::cpu); }
+
+TEST(ImageWarper, CpuLensMatchesDenseReference) {
+  check_lens(WarpBackend::cpu);
+}
+
+TEST(ImageWarper, CpuRejectsShortMesh) {
+  ImageWarper warper(64, 64, RotateFormat::gray8, WarpBackend::cpu);
+  EXPECT_THROW(warper.setMesh(std::make_shared<const WarpMesh>(16, 16, 4)),
+               std::invalid_argument);
+}
+
+TEST(WarpMeshCache, SharesMeshOnHit) {
+  WarpMeshCache cache(2);
+  LensModel model;
+  model.fx = model.fy = 100.0f;
+  model.k1 = 0.1f;
+  const std::shared_ptr<const WarpMesh> mesh =
+      cache.lensMesh(model, 64, 48, 16);
+  EXPECT_EQ(cache.lensMesh(model, 64, 48, 16), mesh);
+  EXPECT_NE(cache.lensMesh(model, 64, 48, 8), mesh);
+
+  // evicted once two others were made after it
+  LensModel other = model;
+  other.k1 = 0.2f;
+  cache.lensMesh(other, 64, 48, 16);
+  EXPECT_NE(cache.lensMesh(model, 64, 48, 16), mesh);
+}
+
+TEST(WarpMeshCache, WarpersShareTheMesh) {
+  LensModel model;
+  model.fx = model.fy = 90.0f;
+  model.cx = 32.0f;
+  model.cy = 24.0f;
+  model.k1 = -0.1f;
+  ImageWarper first(64, 48, RotateFormat::gray8, WarpBackend::cpu);
+  ImageWarper second(64, 48, RotateFormat::gray8, WarpBackend::cpu);
+  first.setLensModel(model);
+  second.setLensModel(model);
+  EXPECT_EQ(&first.getMesh(), &second.getMesh());
+}
+
+TEST(ImageWarper, CudaIdentity) {
+  if (!has_cuda_device())
+    GTEST_SKIP() << "no CUDA device";
+  check_identity(WarpBackend::cuda);
+}
+
+TEST(ImageWarper, CudaLensMatchesDenseReference) {
+  if (!has_cuda_device())
+    GTEST_SKIP() << "no CUDA device";
+  check_lens(WarpBackend::cuda);
+}